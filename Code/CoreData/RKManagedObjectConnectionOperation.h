@@ -0,0 +1,73 @@
+//
+//  RKManagedObjectConnectionOperation.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <CoreData/CoreData.h>
+
+@class RKManagedObjectStore;
+
+/**
+ Connects relationships of mapped objects to the objects found by primary key for a single
+ entity and primary key attribute. Connections are gathered while mapping and resolved
+ together when the operation executes, with one batched fetch for all of the primary key
+ values rather than a fetch per connection.
+
+ @see [RKManagedObjectMapping connectRelationship:withObjectForPrimaryKeyAttribute:]
+ */
+@interface RKManagedObjectConnectionOperation : NSOperation {
+    RKManagedObjectStore* _objectStore;
+    NSEntityDescription* _entity;
+    NSString* _primaryKeyAttribute;
+    NSMutableArray* _connections;
+}
+
+/**
+ The object store the related objects are found in
+ */
+@property (nonatomic, readonly) RKManagedObjectStore* objectStore;
+
+/**
+ The entity of the related objects
+ */
+@property (nonatomic, readonly) NSEntityDescription* entity;
+
+/**
+ The attribute of the related objects containing their primary key
+ */
+@property (nonatomic, readonly) NSString* primaryKeyAttribute;
+
+/**
+ The number of connections waiting to be made
+ */
+@property (nonatomic, readonly) NSUInteger connectionCount;
+
+/**
+ Returns the key identifying the connection operation for the entity and primary key
+ attribute within an RKMappingOperationQueue
+ */
++ (NSString*)operationKeyForEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute;
+
+- (id)initWithObjectStore:(RKManagedObjectStore*)objectStore entity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute;
+
+/**
+ Adds a connection of the relationship of the object to the related object with the primary key
+ value. The relationship is set to nil if no such object exists when the operation executes.
+ */
+- (void)connectRelationship:(NSString*)relationshipName ofObject:(NSManagedObject*)object toObjectWithPrimaryKeyValue:(id)primaryKeyValue;
+
+@end
@@ -0,0 +1,108 @@
+//
+//  RKManagedObjectConnectionOperation.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKManagedObjectConnectionOperation.h"
+#import "RKManagedObjectStore.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitCoreData
+
+static NSString* const RKManagedObjectConnectionObjectKey = @"object";
+static NSString* const RKManagedObjectConnectionRelationshipKey = @"relationship";
+static NSString* const RKManagedObjectConnectionPrimaryKeyValueKey = @"primaryKeyValue";
+
+@implementation RKManagedObjectConnectionOperation
+
+@synthesize objectStore = _objectStore;
+@synthesize entity = _entity;
+@synthesize primaryKeyAttribute = _primaryKeyAttribute;
+
++ (NSString*)operationKeyForEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute {
+    return [NSString stringWithFormat:@"%@:%@.%@", NSStringFromClass(self), entity.name, primaryKeyAttribute];
+}
+
+- (id)initWithObjectStore:(RKManagedObjectStore*)objectStore entity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute {
+    NSAssert(objectStore, @"Cannot connect relationships without an object store");
+    NSAssert(entity, @"Cannot connect relationships without the entity of the related objects");
+    NSAssert(primaryKeyAttribute, @"Cannot connect relationships without a primary key attribute");
+    self = [super init];
+    if (self) {
+        _objectStore = [objectStore retain];
+        _entity = [entity retain];
+        _primaryKeyAttribute = [primaryKeyAttribute retain];
+        _connections = [NSMutableArray new];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [_objectStore release];
+    [_entity release];
+    [_primaryKeyAttribute release];
+    [_connections release];
+    [super dealloc];
+}
+
+- (NSUInteger)connectionCount {
+    return [_connections count];
+}
+
+- (void)connectRelationship:(NSString*)relationshipName ofObject:(NSManagedObject*)object toObjectWithPrimaryKeyValue:(id)primaryKeyValue {
+    NSDictionary* connection = [NSDictionary dictionaryWithObjectsAndKeys:
+                                object, RKManagedObjectConnectionObjectKey,
+                                relationshipName, RKManagedObjectConnectionRelationshipKey,
+                                primaryKeyValue, RKManagedObjectConnectionPrimaryKeyValueKey,
+                                nil];
+    [_connections addObject:connection];
+}
+
+- (void)main {
+    if ([_connections count] == 0) {
+        return;
+    }
+    
+    NSMutableSet* primaryKeyValues = [NSMutableSet setWithCapacity:[_connections count]];
+    for (NSDictionary* connection in _connections) {
+        [primaryKeyValues addObject:[connection objectForKey:RKManagedObjectConnectionPrimaryKeyValueKey]];
+    }
+    [primaryKeyValues removeObject:[NSNull null]];
+    
+    NSDictionary* relatedObjects = [_objectStore findInstancesOfEntity:_entity withPrimaryKeyAttribute:_primaryKeyAttribute values:primaryKeyValues];
+    RKLogDebug(@"Connecting %lu relationships to %lu of %lu %@ objects by primary key attribute '%@'",
+               (unsigned long) [_connections count], (unsigned long) [relatedObjects count], (unsigned long) [primaryKeyValues count],
+               _entity.name, _primaryKeyAttribute);
+    for (NSDictionary* connection in _connections) {
+        id primaryKeyValue = [connection objectForKey:RKManagedObjectConnectionPrimaryKeyValueKey];
+        NSString* relationshipName = [connection objectForKey:RKManagedObjectConnectionRelationshipKey];
+        id relatedObject = [relatedObjects objectForKey:primaryKeyValue];
+        if (relatedObject) {
+            RKLogTrace(@"Connected relationship '%@' to object with primary key value '%@': %@", relationshipName, primaryKeyValue, relatedObject);
+        } else {
+            RKLogTrace(@"Failed to find object to connect relationship '%@' with primary key value '%@'", relationshipName, primaryKeyValue);
+        }
+        [[connection objectForKey:RKManagedObjectConnectionObjectKey] setValue:relatedObject forKey:relationshipName];
+    }
+    
+    [_connections removeAllObjects];
+}
+
+@end
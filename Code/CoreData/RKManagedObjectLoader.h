@@ -31,8 +31,49 @@
     NSManagedObjectID* _targetObjectID;	
     NSMutableSet* _managedObjectKeyPaths;
     BOOL _deleteObjectOnFailure;
+    NSUInteger _saveBatchSize;
+    NSUInteger _unsavedObjectCount;
+    BOOL _savingInBatches;
+    NSMutableDictionary* _unsavedObjectsByTemporaryID;
+    NSMutableDictionary* _permanentObjectIDsByTemporaryID;
+    NSError* _batchSaveError;
+    NSArray* _relationshipKeyPathsForPrefetching;
 }
 
 @property (nonatomic, readonly) RKManagedObjectStore* objectStore;
 
+/**
+ The number of managed objects mapped from a successful response between saves of the managed
+ object context while mapping is in progress. Objects nested beneath the objects at the key paths
+ of the response count towards the batch as well. After each intermediate save the objects in the
+ context are turned back into faults, and the mapping result holds the object IDs of the objects
+ mapped so far rather than the objects themselves, so that memory use is bounded by the batch size
+ rather than by the size of the response. The objects are materialized again on the main thread
+ when the result is delivered. The final save and the delegate callbacks happen once mapping has
+ finished, exactly as when saving in a single batch.
+ 
+ Objects are saved before relationships connected by primary key are set, so batched saves are
+ unsuitable for entities whose validation depends on those relationships. When an intermediate
+ save fails, the unsaved changes are rolled back and the delegate is sent
+ objectLoader:didFailWithError: with the error of the save.
+ 
+ Batches that have been saved are not rolled back when mapping or a later save fails. The objects
+ saved before the failure remain in the persistent store even though the delegate is told
+ that the load failed, so leave batching disabled when a response must be stored in full or
+ not at all.
+ 
+ **Default**: 0 (save once, after mapping has finished)
+ */
+@property (nonatomic, assign) NSUInteger saveBatchSize;
+
+/**
+ Key paths of the relationships to fetch along with the loaded objects when they are handed to
+ the delegate on the main thread. The related objects arrive materialized rather than as faults,
+ saving a round trip to the persistent store for each one the delegate touches. Key paths that
+ are not relationships of an object's entity are ignored for that entity.
+ 
+ **Default**: nil
+ */
+@property (nonatomic, retain) NSArray* relationshipKeyPathsForPrefetching;
+
 @end
@@ -22,14 +22,23 @@
 #import "RKManagedObjectLoader.h"
 #import "RKURL.h"
 #import "RKObjectMapper.h"
+#import "RKManagedObjectMapping.h"
+#import "RKDynamicObjectMapping.h"
 #import "RKManagedObjectThreadSafeInvocation.h"
 #import "NSManagedObject+ActiveRecord.h"
 #import "RKObjectLoader_Internals.h"
 #import "RKRequest_Internals.h"
+#import "RKRequestMetrics.h"
 #import "RKLog.h"
 
+// The number of orphaned objects fetched for deletion at a time
+static const NSUInteger RKManagedObjectLoaderOrphanDeletionBatchSize = 500;
+
 @implementation RKManagedObjectLoader
 
+@synthesize saveBatchSize = _saveBatchSize;
+@synthesize relationshipKeyPathsForPrefetching = _relationshipKeyPathsForPrefetching;
+
 - (id)init {
     self = [super init];
     if (self) {
@@ -43,6 +52,10 @@
     _targetObjectID = nil;
     _deleteObjectOnFailure = NO;
     [_managedObjectKeyPaths release];
+    [_unsavedObjectsByTemporaryID release];
+    [_permanentObjectIDsByTemporaryID release];
+    [_batchSaveError release];
+    [_relationshipKeyPathsForPrefetching release];
     
     [super dealloc];
 }
@@ -57,16 +70,174 @@
     return self.objectManager.objectStore;
 }
 
+#pragma mark - Batched Saves
+
+// Returns the object mapping the mapper picks for the data of a single object
+- (RKObjectMapping*)objectMappingForMapping:(id<RKObjectMappingDefinition>)mapping data:(NSDictionary*)mappableData {
+    if ([mapping isKindOfClass:[RKDynamicObjectMapping class]]) {
+        return [(RKDynamicObjectMapping*)mapping objectMappingForDictionary:mappableData];
+    } else if ([mapping isKindOfClass:[RKObjectMapping class]]) {
+        return (RKObjectMapping*)mapping;
+    }
+    
+    return nil;
+}
+
+// Counts the managed objects the relationships of a mapping will map from the data of a single object,
+// descending into the data the same way the mapper does
+- (NSUInteger)countOfManagedObjectsNestedInData:(NSDictionary*)mappableData usingMapping:(RKObjectMapping*)objectMapping {
+    NSUInteger count = 0;
+    for (RKObjectRelationshipMapping* relationshipMapping in objectMapping.relationshipMappings) {
+        id nestedValue = [mappableData valueForKeyPath:relationshipMapping.sourceKeyPath];
+        if (nil == nestedValue || nestedValue == [NSNull null]) {
+            continue;
+        }
+        
+        id<RKObjectMappingDefinition> mapping = relationshipMapping.mapping;
+        NSArray* nestedObjects = nil;
+        if (mapping.forceCollectionMapping && [nestedValue isKindOfClass:[NSDictionary class]]) {
+            nestedObjects = [NSMutableArray arrayWithCapacity:[nestedValue count]];
+            for (id key in nestedValue) {
+                [(NSMutableArray*)nestedObjects addObject:[NSDictionary dictionaryWithObject:[nestedValue valueForKey:key] forKey:key]];
+            }
+        } else if ([nestedValue isKindOfClass:[NSArray class]]) {
+            nestedObjects = nestedValue;
+        } else if ([nestedValue isKindOfClass:[NSSet class]]) {
+            nestedObjects = [nestedValue allObjects];
+        } else {
+            nestedObjects = [NSArray arrayWithObject:nestedValue];
+        }
+        
+        for (id nestedData in nestedObjects) {
+            if (NO == [nestedData isKindOfClass:[NSDictionary class]]) {
+                continue;
+            }
+            RKObjectMapping* nestedMapping = [self objectMappingForMapping:mapping data:nestedData];
+            if (nestedMapping) {
+                count += [nestedMapping isKindOfClass:[RKManagedObjectMapping class]] ? 1 : 0;
+                count += [self countOfManagedObjectsNestedInData:nestedData usingMapping:nestedMapping];
+            }
+        }
+    }
+    
+    return count;
+}
+
+// Inserted objects are saved under new object IDs: note the permanent ID of each object the result refers to
+- (void)recordPermanentObjectIDsOfSavedObjects {
+    if ([_unsavedObjectsByTemporaryID count] == 0) {
+        return;
+    }
+    
+    if (nil == _permanentObjectIDsByTemporaryID) {
+        _permanentObjectIDsByTemporaryID = [[NSMutableDictionary alloc] init];
+    }
+    for (NSManagedObjectID* temporaryID in _unsavedObjectsByTemporaryID) {
+        NSManagedObject* object = [_unsavedObjectsByTemporaryID objectForKey:temporaryID];
+        [_permanentObjectIDsByTemporaryID setObject:[object objectID] forKey:temporaryID];
+    }
+    [_unsavedObjectsByTemporaryID removeAllObjects];
+}
+
+- (NSManagedObjectID*)permanentObjectIDForObjectID:(NSManagedObjectID*)objectID {
+    NSManagedObjectID* permanentID = [_permanentObjectIDsByTemporaryID objectForKey:objectID];
+    return permanentID ? permanentID : objectID;
+}
+
+// Replaces the temporary object IDs held by a result mapped in batches with the IDs the objects were saved under
+- (NSDictionary*)resultDictionaryReplacingTemporaryObjectIDs:(NSDictionary*)dictionary {
+    NSMutableDictionary* resultDictionary = [NSMutableDictionary dictionaryWithCapacity:[dictionary count]];
+    for (NSString* keyPath in dictionary) {
+        id value = [dictionary objectForKey:keyPath];
+        if ([value isKindOfClass:[NSManagedObjectID class]]) {
+            value = [self permanentObjectIDForObjectID:value];
+        } else if ([value isKindOfClass:[NSArray class]] || [value isKindOfClass:[NSSet class]]) {
+            id collection = [value isKindOfClass:[NSSet class]] ? [NSMutableSet setWithCapacity:[value count]] : [NSMutableArray arrayWithCapacity:[value count]];
+            for (id object in value) {
+                [collection addObject:[object isKindOfClass:[NSManagedObjectID class]] ? [self permanentObjectIDForObjectID:object] : object];
+            }
+            value = collection;
+        }
+        [resultDictionary setObject:value forKey:keyPath];
+    }
+    
+    return resultDictionary;
+}
+
+// Saves the objects mapped so far and turns them back into faults. The objects stay registered with
+// the context, so the mapper and the primary key cache can keep referring to them while mapping continues
+- (void)saveBatchOfMappedObjects {
+    NSManagedObjectContext* managedObjectContext = [self.objectStore managedObjectContext];
+    NSError* error = [self.objectStore save];
+    if (error) {
+        // Mapping carries on to connect relationships, so the unsaved changes are rolled back once it has finished
+        RKLogError(@"Failed to save a batch of %lu mapped objects: %@", (unsigned long) _unsavedObjectCount, [error localizedDescription]);
+        [_batchSaveError release];
+        _batchSaveError = [error retain];
+        _savingInBatches = NO;
+        return;
+    }
+    
+    RKLogDebug(@"Saved a batch of %lu mapped objects", (unsigned long) _unsavedObjectCount);
+    [self recordPermanentObjectIDsOfSavedObjects];
+    for (NSManagedObject* object in [managedObjectContext registeredObjects]) {
+        if (! [object isFault]) {
+            [managedObjectContext refreshObject:object mergeChanges:NO];
+        }
+    }
+    _unsavedObjectCount = 0;
+}
+
 #pragma mark - RKObjectMapperDelegate methods
 
 - (void)objectMapper:(RKObjectMapper*)objectMapper didMapFromObject:(id)sourceObject toObject:(id)destinationObject atKeyPath:(NSString*)keyPath usingMapping:(RKObjectMapping*)objectMapping {
     if ([destinationObject isKindOfClass:[NSManagedObject class]]) {
         [_managedObjectKeyPaths addObject:keyPath];
+        
+        if (_savingInBatches) {
+            RKObjectMapping* mapping = [self objectMappingForMapping:objectMapping data:sourceObject];
+            _unsavedObjectCount += 1 + [self countOfManagedObjectsNestedInData:sourceObject usingMapping:mapping];
+            if (_unsavedObjectCount >= _saveBatchSize) {
+                [self saveBatchOfMappedObjects];
+            }
+        }
+    }
+}
+
+- (id)objectMapper:(RKObjectMapper*)objectMapper resultForMappedObject:(id)mappedObject atKeyPath:(NSString*)keyPath {
+    // Hold on to object IDs rather than objects, so that saved batches can be released
+    if (NO == _savingInBatches || NO == [mappedObject isKindOfClass:[NSManagedObject class]]) {
+        return mappedObject;
+    }
+    
+    NSManagedObjectID* objectID = [(NSManagedObject*)mappedObject objectID];
+    if ([objectID isTemporaryID]) {
+        if (nil == _unsavedObjectsByTemporaryID) {
+            _unsavedObjectsByTemporaryID = [[NSMutableDictionary alloc] init];
+        }
+        [_unsavedObjectsByTemporaryID setObject:mappedObject forKey:objectID];
     }
+    
+    return objectID;
 }
 
 #pragma mark - RKObjectLoader overrides
 
+- (RKObjectMappingResult*)performMapping:(NSError**)error {
+    // Mapping threads are long-lived: drop thread local objects made stale by saves on other threads
+    [self.objectStore resetThreadLocalStorageIfStale];
+    
+    // Intermediate saves would persist the objects mapped from an error response
+    _unsavedObjectCount = 0;
+    _savingInBatches = (_saveBatchSize > 0 && [self.response isSuccessful]);
+    [_unsavedObjectsByTemporaryID removeAllObjects];
+    [_permanentObjectIDsByTemporaryID removeAllObjects];
+    [_batchSaveError release];
+    _batchSaveError = nil;
+    
+    return [super performMapping:error];
+}
+
 // Overload the target object reader to return a thread-local copy of the target object
 - (id)targetObject {
     if ([NSThread isMainThread] == NO && _targetObjectID) {
@@ -111,32 +282,157 @@
     if ([self.URL isKindOfClass:[RKURL class]]) {
         RKURL* rkURL = (RKURL*)self.URL;
         
-        NSArray* results = [result asCollection];
-        NSArray* cachedObjects = [self.objectStore objectsForResourcePath:rkURL.resourcePath];
+        // Compare object IDs rather than objects, so that the cached objects need not be fetched
+        NSMutableSet* orphanedObjectIDs = [[[self.objectStore objectIDsForResourcePath:rkURL.resourcePath] mutableCopy] autorelease];
+        if ([orphanedObjectIDs count] == 0) {
+            return;
+        }
+        for (id object in [result asCollection]) {
+            if ([object isKindOfClass:[NSManagedObject class]]) {
+                [orphanedObjectIDs removeObject:[(NSManagedObject*)object objectID]];
+            } else if ([object isKindOfClass:[NSManagedObjectID class]]) {
+                // Results mapped in batches hold object IDs, which are temporary for the objects saved since
+                [orphanedObjectIDs removeObject:[self permanentObjectIDForObjectID:object]];
+            }
+        }
+        
+        // Fetch the orphans of each entity in batches: deleting them walks their relationships
+        NSMutableDictionary* orphanedObjectIDsByEntityName = [NSMutableDictionary dictionary];
+        for (NSManagedObjectID* objectID in orphanedObjectIDs) {
+            NSMutableArray* objectIDs = [orphanedObjectIDsByEntityName objectForKey:objectID.entity.name];
+            if (nil == objectIDs) {
+                objectIDs = [NSMutableArray array];
+                [orphanedObjectIDsByEntityName setObject:objectIDs forKey:objectID.entity.name];
+            }
+            [objectIDs addObject:objectID];
+        }
+        
+        NSManagedObjectContext* managedObjectContext = [self.objectStore managedObjectContext];
         NSObject<RKManagedObjectCache>* managedObjectCache = self.objectStore.managedObjectCache;
         BOOL queryForDeletion = [managedObjectCache respondsToSelector:@selector(shouldDeleteOrphanedObject:)];
-      
-        for (id object in cachedObjects) {
-            if (NO == [results containsObject:object]) {
-              if (queryForDeletion && [managedObjectCache shouldDeleteOrphanedObject:object] == NO)
-              {
-                RKLogTrace(@"Sparing orphaned object %@ even though not returned in result set", object);
-              }
-              else
-              {
-                RKLogTrace(@"Deleting orphaned object %@: not found in result set and expected at this resource path", object);
-                [[self.objectStore managedObjectContext] deleteObject:object];
-              }
+        NSUInteger deletedCount = 0;
+        NSUInteger sparedCount = 0;
+        for (NSString* entityName in orphanedObjectIDsByEntityName) {
+            NSArray* objectIDs = [orphanedObjectIDsByEntityName objectForKey:entityName];
+            NSEntityDescription* entity = [[objectIDs lastObject] entity];
+            for (NSUInteger location = 0; location < [objectIDs count]; location += RKManagedObjectLoaderOrphanDeletionBatchSize) {
+                NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+                NSRange range = NSMakeRange(location, MIN(RKManagedObjectLoaderOrphanDeletionBatchSize, [objectIDs count] - location));
+                NSFetchRequest* fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+                [fetchRequest setEntity:entity];
+                [fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", [objectIDs subarrayWithRange:range]]];
+                [fetchRequest setReturnsObjectsAsFaults:NO];
+                NSError* error = nil;
+                NSArray* orphanedObjects = [managedObjectContext executeFetchRequest:fetchRequest error:&error];
+                if (nil == orphanedObjects) {
+                    RKLogError(@"Failed to fetch orphaned %@ objects for deletion: %@", entityName, [error localizedDescription]);
+                }
+                
+                for (NSManagedObject* object in orphanedObjects) {
+                    if (queryForDeletion && [managedObjectCache shouldDeleteOrphanedObject:object] == NO) {
+                        RKLogTrace(@"Sparing orphaned object %@ even though not returned in result set", object);
+                        sparedCount++;
+                    } else {
+                        RKLogTrace(@"Deleting orphaned object %@: not found in result set and expected at this resource path", object);
+                        [managedObjectContext deleteObject:object];
+                        deletedCount++;
+                    }
+                }
+                [pool drain];
             }
         }
+        
+        RKLogDebug(@"Deleted %lu and spared %lu objects missing from the result at resource path '%@'",
+                   (unsigned long) deletedCount, (unsigned long) sparedCount, rkURL.resourcePath);
+        NSObject<RKManagedObjectStoreDelegate>* storeDelegate = self.objectStore.delegate;
+        if ([storeDelegate respondsToSelector:@selector(managedObjectStore:didDeleteOrphanedObjectCount:sparedObjectCount:forResourcePath:)]) {
+            [storeDelegate managedObjectStore:self.objectStore didDeleteOrphanedObjectCount:deletedCount sparedObjectCount:sparedCount forResourcePath:rkURL.resourcePath];
+        }
     } else {
         RKLogWarning(@"Unable to perform cleanup of server-side object deletions: unable to determine resource path.");
     } 
 }
 
+// Replaces the managed objects in a result dictionary with their object IDs, which may be handed between threads
+- (NSDictionary*)objectIDDictionaryForResultDictionary:(NSDictionary*)dictionary {
+    NSMutableDictionary* objectIDDictionary = [NSMutableDictionary dictionaryWithCapacity:[dictionary count]];
+    for (NSString* keyPath in dictionary) {
+        id value = [dictionary objectForKey:keyPath];
+        if ([value isKindOfClass:[NSManagedObject class]]) {
+            value = [(NSManagedObject*)value objectID];
+        } else if ([value isKindOfClass:[NSArray class]] || [value isKindOfClass:[NSSet class]]) {
+            id collection = [value isKindOfClass:[NSSet class]] ? [NSMutableSet setWithCapacity:[value count]] : [NSMutableArray arrayWithCapacity:[value count]];
+            for (id object in value) {
+                [collection addObject:[object isKindOfClass:[NSManagedObject class]] ? [(NSManagedObject*)object objectID] : object];
+            }
+            value = collection;
+        }
+        [objectIDDictionary setObject:value forKey:keyPath];
+    }
+    
+    return objectIDDictionary;
+}
+
+- (BOOL)processUnchangedResultDictionary:(NSDictionary*)dictionary {
+    // Map the body again when remembered objects have been deleted, rather than deliver a partial result
+    NSMutableSet* objectIDs = [NSMutableSet set];
+    for (id value in [dictionary allValues]) {
+        if ([value isKindOfClass:[NSManagedObjectID class]]) {
+            [objectIDs addObject:value];
+        } else if ([value isKindOfClass:[NSArray class]] || [value isKindOfClass:[NSSet class]]) {
+            for (id object in value) {
+                if ([object isKindOfClass:[NSManagedObjectID class]]) {
+                    [objectIDs addObject:object];
+                }
+            }
+        }
+    }
+    if ([[self.objectStore objectsByIDForObjectIDs:objectIDs prefetchingRelationshipKeyPaths:nil] count] < [objectIDs count]) {
+        RKLogDebug(@"Objects remembered for resource path '%@' have been deleted, mapping the content again", self.resourcePath);
+        [self.objectManager.mappingResultCache invalidateResourcePath:self.resourcePath];
+        return NO;
+    }
+    
+    // The remembered dictionary holds object IDs. Hand the delegate a copy to turn back into objects
+    NSMutableDictionary* resultDictionary = [[dictionary mutableCopy] autorelease];
+    if (self.delegate) {
+        NSMethodSignature* signature = [self methodSignatureForSelector:@selector(informDelegateOfObjectLoadWithResultDictionary:)];
+        RKManagedObjectThreadSafeInvocation* invocation = [RKManagedObjectThreadSafeInvocation invocationWithMethodSignature:signature];
+        [invocation setObjectStore:self.objectStore];
+        [invocation setTarget:self];
+        [invocation setSelector:@selector(informDelegateOfObjectLoadWithResultDictionary:)];
+        [invocation setArgument:&resultDictionary atIndex:2];
+        [invocation setManagedObjectKeyPaths:[NSSet setWithArray:[resultDictionary allKeys]] forArgument:2];
+        [invocation setRelationshipKeyPathsForPrefetching:self.relationshipKeyPathsForPrefetching];
+        [invocation invokeOnMainThreadWaitUntilDone:_sentSynchronously];
+    }
+    
+    return YES;
+}
+
+- (void)informDelegateOfError:(NSError*)error {
+	if (self.delegate)
+	{
+		NSMethodSignature* signature = [self.delegate methodSignatureForSelector:@selector(objectLoader:didFailWithError:)];
+		RKManagedObjectThreadSafeInvocation* invocation = [RKManagedObjectThreadSafeInvocation invocationWithMethodSignature:signature];
+		[invocation setTarget:self.delegate];
+		[invocation setSelector:@selector(objectLoader:didFailWithError:)];
+		[invocation setArgument:&self atIndex:2];
+		[invocation setArgument:&error atIndex:3];
+		[invocation invokeOnMainThreadWaitUntilDone:_sentSynchronously];
+	}
+}
+
 // NOTE: We are on the background thread here, be mindful of Core Data's threading needs
 - (void)processMappingResult:(RKObjectMappingResult*)result {
     NSAssert(_sentSynchronously || ![NSThread isMainThread], @"Mapping result processing should occur on a background thread");
+    if (_batchSaveError) {
+        // Discard what was mapped since the last saved batch, as the seeder does
+        [self.objectStore rollback];
+        [self informDelegateOfError:_batchSaveError];
+        return;
+    }
+    
     if (_targetObjectID && self.targetObject && self.method == RKRequestMethodDELETE) {
         NSManagedObject* backgroundThreadObject = [self.objectStore objectWithID:_targetObjectID];
         RKLogInfo(@"Deleting local object %@ due to DELETE request", backgroundThreadObject);
@@ -144,30 +440,31 @@
     }
     
     // If the response was successful, save the store...
+    NSDictionary* dictionary = [result asDictionary];
     if ([self.response isSuccessful]) {
         [self deleteCachedObjectsMissingFromResult:result];
+        self.metrics.saveStartTime = [NSDate timeIntervalSinceReferenceDate];
         NSError* error = [self.objectStore save];
+        self.metrics.saveEndTime = [NSDate timeIntervalSinceReferenceDate];
         if (error) {
             RKLogError(@"Failed to save managed object context after mapping completed: %@", [error localizedDescription]);
-            
-			if (self.delegate)
-			{
-				NSMethodSignature* signature = [self.delegate methodSignatureForSelector:@selector(objectLoader:didFailWithError:)];
-				RKManagedObjectThreadSafeInvocation* invocation = [RKManagedObjectThreadSafeInvocation invocationWithMethodSignature:signature];
-				[invocation setTarget:self.delegate];
-				[invocation setSelector:@selector(objectLoader:didFailWithError:)];
-				[invocation setArgument:&self atIndex:2];
-				[invocation setArgument:&error atIndex:3];
-				[invocation invokeOnMainThread];
-			}
-			
+            [self informDelegateOfError:error];
             return;
         }
+        
+        [self recordPermanentObjectIDsOfSavedObjects];
+        if ([_permanentObjectIDsByTemporaryID count] > 0) {
+            dictionary = [self resultDictionaryReplacingTemporaryObjectIDs:dictionary];
+        }
+        
+        // Object IDs are only permanent once the objects have been saved
+        if ([self canSkipMappingOfUnchangedContent]) {
+            [self rememberResultDictionary:[self objectIDDictionaryForResultDictionary:dictionary]];
+        }
     }
     
 	if (self.delegate)
 	{
-		NSDictionary* dictionary = [result asDictionary];
 		NSMethodSignature* signature = [self methodSignatureForSelector:@selector(informDelegateOfObjectLoadWithResultDictionary:)];
 		RKManagedObjectThreadSafeInvocation* invocation = [RKManagedObjectThreadSafeInvocation invocationWithMethodSignature:signature];
 		[invocation setObjectStore:self.objectStore];
@@ -175,7 +472,8 @@
 		[invocation setSelector:@selector(informDelegateOfObjectLoadWithResultDictionary:)];
 		[invocation setArgument:&dictionary atIndex:2];
 		[invocation setManagedObjectKeyPaths:_managedObjectKeyPaths forArgument:2];
-		[invocation invokeOnMainThread];
+		[invocation setRelationshipKeyPathsForPrefetching:self.relationshipKeyPathsForPrefetching];
+		[invocation invokeOnMainThreadWaitUntilDone:_sentSynchronously];
 	}
     
 }
@@ -25,6 +25,7 @@
     NSEntityDescription* _entity;
     NSString* _primaryKeyAttribute;
     NSMutableDictionary* _relationshipToPrimaryKeyMappings;
+    RKObjectAttributeMapping* _primaryKeyAttributeMapping;
 }
 
 /**
@@ -90,4 +91,15 @@
  */
 - (id)defaultValueForMissingAttribute:(NSString*)attributeName;
 
+/**
+ Returns the attribute mapping whose destination is the primaryKeyAttribute, or nil if
+ the primary key is not mapped. The lookup is remembered until the mappings change.
+ */
+- (RKObjectAttributeMapping*)primaryKeyAttributeMapping;
+
+/**
+ Returns the primary key value contained in the mappable data, or nil if there is none
+ */
+- (id)primaryKeyValueForMappableData:(id)mappableData;
+
 @end
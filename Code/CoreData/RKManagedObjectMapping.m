@@ -68,10 +68,69 @@
 
 - (void)dealloc {
     [_entity release];
+    [_primaryKeyAttribute release];
     [_relationshipToPrimaryKeyMappings release];
+    [_primaryKeyAttributeMapping release];
     [super dealloc];
 }
 
+- (void)setPrimaryKeyAttribute:(NSString*)primaryKeyAttribute {
+    [primaryKeyAttribute retain];
+    [_primaryKeyAttribute release];
+    _primaryKeyAttribute = primaryKeyAttribute;
+    
+    [_primaryKeyAttributeMapping release];
+    _primaryKeyAttributeMapping = nil;
+}
+
+- (void)addAttributeMapping:(RKObjectAttributeMapping*)mapping {
+    [super addAttributeMapping:mapping];
+    [_primaryKeyAttributeMapping release];
+    _primaryKeyAttributeMapping = nil;
+}
+
+- (void)removeAllMappings {
+    [super removeAllMappings];
+    [_primaryKeyAttributeMapping release];
+    _primaryKeyAttributeMapping = nil;
+}
+
+- (void)removeMapping:(RKObjectAttributeMapping*)attributeOrRelationshipMapping {
+    [super removeMapping:attributeOrRelationshipMapping];
+    [_primaryKeyAttributeMapping release];
+    _primaryKeyAttributeMapping = nil;
+}
+
+- (RKObjectAttributeMapping*)primaryKeyAttributeMapping {
+    // Mappings are shared between the threads mapping payloads, so guard the lazy lookup
+    @synchronized(self) {
+        if (nil == _primaryKeyAttributeMapping && self.primaryKeyAttribute) {
+            for (RKObjectAttributeMapping* attributeMapping in self.attributeMappings) {
+                if ([attributeMapping.destinationKeyPath isEqualToString:self.primaryKeyAttribute]) {
+                    _primaryKeyAttributeMapping = [attributeMapping retain];
+                    break;
+                }
+            }
+        }
+    }
+    
+    return _primaryKeyAttributeMapping;
+}
+
+- (id)primaryKeyValueForMappableData:(id)mappableData {
+    RKObjectAttributeMapping* primaryKeyAttributeMapping = [self primaryKeyAttributeMapping];
+    if ([primaryKeyAttributeMapping isMappingForKeyOfNestedDictionary]) {
+        return [[mappableData allKeys] lastObject];
+    }
+    
+    NSString* keyPathForPrimaryKeyElement = primaryKeyAttributeMapping.sourceKeyPath;
+    if (keyPathForPrimaryKeyElement) {
+        return [mappableData valueForKeyPath:keyPathForPrimaryKeyElement];
+    }
+    
+    return nil;
+}
+
 - (NSDictionary*)relationshipsAndPrimaryKeyAttributes {
     return _relationshipToPrimaryKeyMappings;
 }
@@ -116,34 +175,11 @@
 	}
     
     id object = nil;
-    id primaryKeyValue = nil;
-    NSString* primaryKeyAttribute;
-    
     NSEntityDescription* entity = [self entity];
-    RKObjectAttributeMapping* primaryKeyAttributeMapping = nil;
+    NSString* primaryKeyAttribute = [self primaryKeyAttribute];
     
-    primaryKeyAttribute = [self primaryKeyAttribute];
-    if (primaryKeyAttribute) {
-        // If a primary key has been set on the object mapping, find the attribute mapping
-        // so that we can extract any existing primary key from the mappable data
-        for (RKObjectAttributeMapping* attributeMapping in self.attributeMappings) {
-            if ([attributeMapping.destinationKeyPath isEqualToString:primaryKeyAttribute]) {
-                primaryKeyAttributeMapping = attributeMapping;
-                break;
-            }
-        }
-        
-        // Get the primary key value out of the mappable data (if any)        
-        if ([primaryKeyAttributeMapping isMappingForKeyOfNestedDictionary]) {
-            RKLogDebug(@"Detected use of nested dictionary key as primaryKey attribute...");
-            primaryKeyValue = [[mappableData allKeys] lastObject];
-        } else {
-            NSString* keyPathForPrimaryKeyElement = primaryKeyAttributeMapping.sourceKeyPath;
-            if (keyPathForPrimaryKeyElement) {
-                primaryKeyValue = [mappableData valueForKeyPath:keyPathForPrimaryKeyElement];
-            }
-        }        
-    }
+    // Get the primary key value out of the mappable data (if any)
+    id primaryKeyValue = primaryKeyAttribute ? [self primaryKeyValueForMappableData:mappableData] : nil;
     
     // If we have found the primary key attribute & value, try to find an existing instance to update
     if (primaryKeyAttribute && primaryKeyValue) {                
@@ -157,6 +193,26 @@
     return object;
 }
 
+- (void)prepareToMapObjectsForData:(NSArray*)mappableDataArray {
+    RKManagedObjectStore* objectStore = [RKObjectManager sharedManager].objectStore;
+    if (nil == objectStore || nil == [self primaryKeyAttributeMapping]) {
+        return;
+    }
+    
+    NSMutableSet* primaryKeyValues = [NSMutableSet setWithCapacity:[mappableDataArray count]];
+    for (id mappableData in mappableDataArray) {
+        id primaryKeyValue = [self primaryKeyValueForMappableData:mappableData];
+        if (primaryKeyValue && primaryKeyValue != [NSNull null]) {
+            [primaryKeyValues addObject:primaryKeyValue];
+        }
+    }
+    
+    if ([primaryKeyValues count] > 0) {
+        RKLogDebug(@"Resolving %lu primary key values for entity '%@' ahead of mapping", (unsigned long) [primaryKeyValues count], self.entity.name);
+        [objectStore prefetchInstancesOfEntity:self.entity withPrimaryKeyAttribute:self.primaryKeyAttribute values:primaryKeyValues];
+    }
+}
+
 - (Class)classForProperty:(NSString*)propertyName {
     Class propertyClass = [super classForProperty:propertyName];
     if (! propertyClass) {
@@ -21,6 +21,8 @@
 #import "RKManagedObjectMappingOperation.h"
 #import "RKManagedObjectMapping.h"
 #import "NSManagedObject+ActiveRecord.h"
+#import "RKManagedObjectConnectionOperation.h"
+#import "RKObjectManager.h"
 #import "RKLog.h"
 
 // Set Logging Component
@@ -58,16 +60,33 @@
     NSAssert(primaryKeyAttributeOfRelatedObject, @"Cannot connect relationship: mapping for %@ has no primary key attribute specified", NSStringFromClass(objectMapping.objectClass));
     id valueOfLocalPrimaryKeyAttribute = [self.destinationObject valueForKey:primaryKeyAttribute];
     RKLogDebug(@"Connecting relationship at keyPath '%@' to object with primaryKey attribute '%@'", relationshipName, primaryKeyAttributeOfRelatedObject);
-    if (valueOfLocalPrimaryKeyAttribute) {
-        id relatedObject = [objectMapping.objectClass findFirstByAttribute:primaryKeyAttributeOfRelatedObject withValue:valueOfLocalPrimaryKeyAttribute];
-        if (relatedObject) {                
-            RKLogTrace(@"Connected relationship '%@' to object with primary key value '%@': %@", relationshipName, valueOfLocalPrimaryKeyAttribute, relatedObject);
-        } else {
-            RKLogTrace(@"Failed to find object to connect relationship '%@' with primary key value '%@'", relationshipName, valueOfLocalPrimaryKeyAttribute);
-        }
-        [self.destinationObject setValue:relatedObject forKey:relationshipName];
-    } else {
+    if (nil == valueOfLocalPrimaryKeyAttribute) {
         RKLogTrace(@"Failed to find primary key value for attribute '%@'", primaryKeyAttribute);
+        return;
+    }
+    
+    RKManagedObjectStore* objectStore = [RKObjectManager sharedManager].objectStore;
+    if (nil == objectStore) {
+        RKLogWarning(@"Unable to connect relationship '%@' without an object store", relationshipName);
+        return;
+    }
+    
+    // Connections to the same entity by the same key are gathered into a single operation on
+    // the queue, so that the related objects are found with one batched fetch once mapping is done
+    NSEntityDescription* entity = [(RKManagedObjectMapping*)objectMapping entity];
+    NSString* operationKey = [RKManagedObjectConnectionOperation operationKeyForEntity:entity primaryKeyAttribute:primaryKeyAttributeOfRelatedObject];
+    RKManagedObjectConnectionOperation* connectionOperation = (RKManagedObjectConnectionOperation*) [self.queue operationForKey:operationKey];
+    if (nil == connectionOperation) {
+        connectionOperation = [[[RKManagedObjectConnectionOperation alloc] initWithObjectStore:objectStore entity:entity primaryKeyAttribute:primaryKeyAttributeOfRelatedObject] autorelease];
+        if (self.queue) {
+            RKLogTrace(@"Enqueueing relationship connections for %@ objects using operation queue", entity.name);
+            [self.queue addOperation:connectionOperation forKey:operationKey];
+        }
+    }
+    
+    [connectionOperation connectRelationship:relationshipName ofObject:self.destinationObject toObjectWithPrimaryKeyValue:valueOfLocalPrimaryKeyAttribute];
+    if (nil == self.queue) {
+        [connectionOperation start];
     }
 }
 
@@ -75,14 +94,7 @@
     if ([self.objectMapping isKindOfClass:[RKManagedObjectMapping class]]) {
         NSDictionary* relationshipsAndPrimaryKeyAttributes = [(RKManagedObjectMapping*)self.objectMapping relationshipsAndPrimaryKeyAttributes];
         for (NSString* relationshipName in relationshipsAndPrimaryKeyAttributes) {
-            if (self.queue) {
-                RKLogTrace(@"Enqueueing relationship connection using operation queue");
-                [self.queue addOperationWithBlock:^{
-                    [self connectRelationship:relationshipName];
-                }];
-            } else {
-                [self connectRelationship:relationshipName];
-            }
+            [self connectRelationship:relationshipName];
         }
     }
 }
@@ -0,0 +1,95 @@
+//
+//  RKManagedObjectPrimaryKeyIndex.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <CoreData/CoreData.h>
+#import <pthread.h>
+
+/**
+ A store-wide index from the primary key values of managed objects to their object IDs, shared
+ by the contexts of every thread using an RKManagedObjectStore.
+
+ The index is kept per entity and primary key attribute. Entries are added from batched fetches
+ and brought up to date from the did save notifications of the store's contexts, so the index
+ only ever describes saved objects: objects inserted but not yet saved are tracked by the thread
+ that created them. Each value maps to the NSManagedObjectID of the object with that primary key,
+ or to NSNull when the value is known not to exist in the store.
+
+ Lookups take a shared read lock and may proceed concurrently on any number of threads. Fetches
+ and saves take the write lock briefly to record their results.
+
+ Each table is held to a budget of entries. When a table fills, its entries become the older of
+ two generations and a new generation is started; the older generation is discarded the next
+ time the table fills. Evicted values are simply unknown again and are fetched on their next lookup.
+ */
+@interface RKManagedObjectPrimaryKeyIndex : NSObject {
+    pthread_rwlock_t _lock;
+    NSMutableDictionary* _tablesByEntityName;
+    NSUInteger _capacity;
+}
+
+/**
+ The number of entries each table holds before it starts a new generation and discards
+ the oldest one. A table holds at most twice this many entries. Zero disables eviction.
+
+ **Default**: 10000
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ Returns the total number of entries in the index
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ Returns the value primary keys are indexed by. Values are coerced to strings where possible, so
+ that primary keys expressed as numbers and as strings are looked up interchangeably.
+ */
++ (id)lookupValueForPrimaryKeyValue:(id)primaryKeyValue;
+
+/**
+ Returns the object ID indexed for the primary key lookup value. Returns NSNull if the value is
+ known not to exist in the store, and nil if the index knows nothing about the value.
+ */
+- (id)objectIDForEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute lookupValue:(id)lookupValue;
+
+/**
+ Records the results of a fetch, keyed by lookup value, for values the index does not already know.
+ Values the index knows about were recorded by a save, which is never older than the fetch.
+ When loadedEntity is YES the results describe every instance of the entity, so values missing from
+ them are known not to exist for as long as the table stays within its capacity.
+ */
+- (void)addObjectIDs:(NSDictionary*)objectIDsByLookupValue forEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute loadedEntity:(BOOL)loadedEntity;
+
+/**
+ Returns YES once every instance of the entity has been added to the index
+ */
+- (BOOL)hasLoadedEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute;
+
+/**
+ Updates the index with the objects inserted, updated and deleted by a save. Must be sent on the
+ thread of the context that saved, while its objects may still be read.
+ */
+- (void)updateWithContextDidSaveNotification:(NSNotification*)notification;
+
+/**
+ Discards every entry in the index
+ */
+- (void)removeAllObjectIDs;
+
+@end
@@ -0,0 +1,306 @@
+//
+//  RKManagedObjectPrimaryKeyIndex.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKManagedObjectPrimaryKeyIndex.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitCoreData
+
+static const NSUInteger RKManagedObjectPrimaryKeyIndexDefaultCapacity = 10000;
+
+/**
+ The entries of the index for a single entity and primary key attribute
+ */
+@interface RKManagedObjectPrimaryKeyIndexTable : NSObject {
+    NSMutableDictionary* _objectIDsByLookupValue;
+    NSMutableDictionary* _lookupValuesByObjectID;
+    NSMutableDictionary* _previousObjectIDsByLookupValue;
+    NSMutableDictionary* _previousLookupValuesByObjectID;
+    BOOL _loadedEntity;
+    BOOL _complete;
+}
+
+// YES once every instance of the entity has been added
+@property (nonatomic, assign) BOOL loadedEntity;
+
+// YES while the table still holds every instance of the entity
+@property (nonatomic, assign) BOOL complete;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (id)objectIDForLookupValue:(id)lookupValue;
+- (id)lookupValueForObjectID:(NSManagedObjectID*)objectID;
+- (void)setObjectID:(id)objectID forLookupValue:(id)lookupValue capacity:(NSUInteger)capacity;
+- (void)removeLookupValue:(id)lookupValue;
+
+@end
+
+@implementation RKManagedObjectPrimaryKeyIndexTable
+
+@synthesize loadedEntity = _loadedEntity;
+@synthesize complete = _complete;
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _objectIDsByLookupValue = [[NSMutableDictionary alloc] init];
+        _lookupValuesByObjectID = [[NSMutableDictionary alloc] init];
+        _previousObjectIDsByLookupValue = [[NSMutableDictionary alloc] init];
+        _previousLookupValuesByObjectID = [[NSMutableDictionary alloc] init];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [_objectIDsByLookupValue release];
+    [_lookupValuesByObjectID release];
+    [_previousObjectIDsByLookupValue release];
+    [_previousLookupValuesByObjectID release];
+    
+    [super dealloc];
+}
+
+- (NSUInteger)count {
+    return [_objectIDsByLookupValue count] + [_previousObjectIDsByLookupValue count];
+}
+
+- (id)objectIDForLookupValue:(id)lookupValue {
+    id objectID = [_objectIDsByLookupValue objectForKey:lookupValue];
+    return objectID ? objectID : [_previousObjectIDsByLookupValue objectForKey:lookupValue];
+}
+
+- (id)lookupValueForObjectID:(NSManagedObjectID*)objectID {
+    id lookupValue = [_lookupValuesByObjectID objectForKey:objectID];
+    return lookupValue ? lookupValue : [_previousLookupValuesByObjectID objectForKey:objectID];
+}
+
+- (void)removeLookupValue:(id)lookupValue {
+    id objectID = [_objectIDsByLookupValue objectForKey:lookupValue];
+    if ([objectID isKindOfClass:[NSManagedObjectID class]]) {
+        [_lookupValuesByObjectID removeObjectForKey:objectID];
+    }
+    [_objectIDsByLookupValue removeObjectForKey:lookupValue];
+    
+    objectID = [_previousObjectIDsByLookupValue objectForKey:lookupValue];
+    if ([objectID isKindOfClass:[NSManagedObjectID class]]) {
+        [_previousLookupValuesByObjectID removeObjectForKey:objectID];
+    }
+    [_previousObjectIDsByLookupValue removeObjectForKey:lookupValue];
+}
+
+- (void)setObjectID:(id)objectID forLookupValue:(id)lookupValue capacity:(NSUInteger)capacity {
+    [self removeLookupValue:lookupValue];
+    if ([objectID isKindOfClass:[NSManagedObjectID class]]) {
+        // The object's primary key changed: its old value is no longer known
+        id previousLookupValue = [self lookupValueForObjectID:objectID];
+        if (previousLookupValue) {
+            [self removeLookupValue:previousLookupValue];
+        }
+    }
+    
+    if (capacity > 0 && [_objectIDsByLookupValue count] >= capacity) {
+        [_previousObjectIDsByLookupValue release];
+        [_previousLookupValuesByObjectID release];
+        _previousObjectIDsByLookupValue = _objectIDsByLookupValue;
+        _previousLookupValuesByObjectID = _lookupValuesByObjectID;
+        _objectIDsByLookupValue = [[NSMutableDictionary alloc] init];
+        _lookupValuesByObjectID = [[NSMutableDictionary alloc] init];
+        _complete = NO;
+    }
+    
+    [_objectIDsByLookupValue setObject:objectID forKey:lookupValue];
+    if ([objectID isKindOfClass:[NSManagedObjectID class]]) {
+        [_lookupValuesByObjectID setObject:lookupValue forKey:objectID];
+    }
+}
+
+@end
+
+@interface RKManagedObjectPrimaryKeyIndex (Private)
+- (RKManagedObjectPrimaryKeyIndexTable*)tableForEntityName:(NSString*)entityName primaryKeyAttribute:(NSString*)primaryKeyAttribute create:(BOOL)create;
+@end
+
+@implementation RKManagedObjectPrimaryKeyIndex
+
++ (id)lookupValueForPrimaryKeyValue:(id)primaryKeyValue {
+    return [primaryKeyValue respondsToSelector:@selector(stringValue)] ? [primaryKeyValue stringValue] : primaryKeyValue;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        pthread_rwlock_init(&_lock, NULL);
+        _tablesByEntityName = [[NSMutableDictionary alloc] init];
+        _capacity = RKManagedObjectPrimaryKeyIndexDefaultCapacity;
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [_tablesByEntityName release];
+    _tablesByEntityName = nil;
+    pthread_rwlock_destroy(&_lock);
+    
+    [super dealloc];
+}
+
+- (NSUInteger)capacity {
+    pthread_rwlock_rdlock(&_lock);
+    NSUInteger capacity = _capacity;
+    pthread_rwlock_unlock(&_lock);
+    return capacity;
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+    pthread_rwlock_wrlock(&_lock);
+    _capacity = capacity;
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (NSUInteger)count {
+    NSUInteger count = 0;
+    pthread_rwlock_rdlock(&_lock);
+    for (NSDictionary* tablesByAttribute in [_tablesByEntityName allValues]) {
+        for (RKManagedObjectPrimaryKeyIndexTable* table in [tablesByAttribute allValues]) {
+            count += table.count;
+        }
+    }
+    pthread_rwlock_unlock(&_lock);
+    return count;
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p capacity=%lu count=%lu>",
+            NSStringFromClass([self class]), self, (unsigned long) self.capacity, (unsigned long) self.count];
+}
+
+// Must be sent holding the lock, and holding it for writing if create is YES
+- (RKManagedObjectPrimaryKeyIndexTable*)tableForEntityName:(NSString*)entityName primaryKeyAttribute:(NSString*)primaryKeyAttribute create:(BOOL)create {
+    NSMutableDictionary* tablesByAttribute = [_tablesByEntityName objectForKey:entityName];
+    if (nil == tablesByAttribute && create) {
+        tablesByAttribute = [NSMutableDictionary dictionary];
+        [_tablesByEntityName setObject:tablesByAttribute forKey:entityName];
+    }
+    
+    RKManagedObjectPrimaryKeyIndexTable* table = [tablesByAttribute objectForKey:primaryKeyAttribute];
+    if (nil == table && create) {
+        table = [[RKManagedObjectPrimaryKeyIndexTable new] autorelease];
+        [tablesByAttribute setObject:table forKey:primaryKeyAttribute];
+    }
+    
+    return table;
+}
+
+- (id)objectIDForEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute lookupValue:(id)lookupValue {
+    pthread_rwlock_rdlock(&_lock);
+    RKManagedObjectPrimaryKeyIndexTable* table = [self tableForEntityName:entity.name primaryKeyAttribute:primaryKeyAttribute create:NO];
+    id objectID = [table objectIDForLookupValue:lookupValue];
+    if (nil == objectID && table.complete) {
+        objectID = [NSNull null];
+    }
+    [[objectID retain] autorelease];
+    pthread_rwlock_unlock(&_lock);
+    
+    return objectID;
+}
+
+- (void)addObjectIDs:(NSDictionary*)objectIDsByLookupValue forEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute loadedEntity:(BOOL)loadedEntity {
+    pthread_rwlock_wrlock(&_lock);
+    RKManagedObjectPrimaryKeyIndexTable* table = [self tableForEntityName:entity.name primaryKeyAttribute:primaryKeyAttribute create:YES];
+    for (id lookupValue in objectIDsByLookupValue) {
+        if (nil == [table objectIDForLookupValue:lookupValue]) {
+            [table setObjectID:[objectIDsByLookupValue objectForKey:lookupValue] forLookupValue:lookupValue capacity:_capacity];
+        }
+    }
+    if (loadedEntity) {
+        table.loadedEntity = YES;
+        table.complete = (_capacity == 0 || [objectIDsByLookupValue count] <= _capacity);
+        if (!table.complete) {
+            RKLogInfo(@"All %lu %@ objects do not fit in the primary key index, which holds %lu per generation. Unknown keys will be fetched as they are looked up",
+                      (unsigned long) [objectIDsByLookupValue count], entity.name, (unsigned long) _capacity);
+        }
+    }
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (BOOL)hasLoadedEntity:(NSEntityDescription*)entity primaryKeyAttribute:(NSString*)primaryKeyAttribute {
+    pthread_rwlock_rdlock(&_lock);
+    BOOL loadedEntity = [self tableForEntityName:entity.name primaryKeyAttribute:primaryKeyAttribute create:NO].loadedEntity;
+    pthread_rwlock_unlock(&_lock);
+    return loadedEntity;
+}
+
+- (void)updateWithContextDidSaveNotification:(NSNotification*)notification {
+    NSDictionary* userInfo = [notification userInfo];
+    NSMutableSet* savedObjects = [NSMutableSet setWithSet:[userInfo objectForKey:NSInsertedObjectsKey]];
+    [savedObjects unionSet:[userInfo objectForKey:NSUpdatedObjectsKey]];
+    NSSet* deletedObjects = [userInfo objectForKey:NSDeletedObjectsKey];
+    
+    pthread_rwlock_wrlock(&_lock);
+    if ([_tablesByEntityName count] == 0) {
+        pthread_rwlock_unlock(&_lock);
+        return;
+    }
+    
+    // Objects are indexed under their entity and every superentity, as fetches of an entity include its subentities
+    for (NSManagedObject* object in savedObjects) {
+        for (NSEntityDescription* entity = [object entity]; entity; entity = [entity superentity]) {
+            NSDictionary* tablesByAttribute = [_tablesByEntityName objectForKey:entity.name];
+            for (NSString* primaryKeyAttribute in tablesByAttribute) {
+                RKManagedObjectPrimaryKeyIndexTable* table = [tablesByAttribute objectForKey:primaryKeyAttribute];
+                id lookupValue = [RKManagedObjectPrimaryKeyIndex lookupValueForPrimaryKeyValue:[object valueForKey:primaryKeyAttribute]];
+                if (lookupValue) {
+                    [table setObjectID:[object objectID] forLookupValue:lookupValue capacity:_capacity];
+                } else {
+                    id previousLookupValue = [table lookupValueForObjectID:[object objectID]];
+                    if (previousLookupValue) {
+                        [table removeLookupValue:previousLookupValue];
+                    }
+                }
+            }
+        }
+    }
+    
+    for (NSManagedObject* object in deletedObjects) {
+        for (NSEntityDescription* entity = [object entity]; entity; entity = [entity superentity]) {
+            NSDictionary* tablesByAttribute = [_tablesByEntityName objectForKey:entity.name];
+            for (NSString* primaryKeyAttribute in tablesByAttribute) {
+                RKManagedObjectPrimaryKeyIndexTable* table = [tablesByAttribute objectForKey:primaryKeyAttribute];
+                id lookupValue = [table lookupValueForObjectID:[object objectID]];
+                if (lookupValue) {
+                    [table setObjectID:[NSNull null] forLookupValue:lookupValue capacity:_capacity];
+                }
+            }
+        }
+    }
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (void)removeAllObjectIDs {
+    pthread_rwlock_wrlock(&_lock);
+    RKLogDebug(@"Removing every entry from primary key index %p", self);
+    [_tablesByEntityName removeAllObjects];
+    pthread_rwlock_unlock(&_lock);
+}
+
+@end
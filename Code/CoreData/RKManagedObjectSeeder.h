@@ -23,11 +23,19 @@
 // The default seed database filename. Used when the object store has not been initialized
 extern NSString* const RKDefaultSeedDatabaseFileName;
 
+@class RKManagedObjectSeeder;
+
 @protocol RKManagedObjectSeederDelegate
 @required
 
 // Invoked when the seeder creates a new object
 - (void)didSeedObject:(NSManagedObject*)object fromFile:(NSString*)fileName;
+
+@optional
+
+// Invoked after each batch saved by seedObjectsFromFileNames:withObjectMapping:bundle:, with the number of objects
+// saved from the file so far and the time elapsed since seeding began
+- (void)objectSeeder:(RKManagedObjectSeeder*)objectSeeder didSaveObjectCount:(NSUInteger)objectCount fromFile:(NSString*)fileName elapsedTime:(NSTimeInterval)elapsedTime;
 @end
 
 /**
@@ -41,6 +49,8 @@ extern NSString* const RKDefaultSeedDatabaseFileName;
 @interface RKManagedObjectSeeder : NSObject {
 	RKObjectManager* _manager;
     NSObject<RKManagedObjectSeederDelegate>* _delegate;
+    NSUInteger _batchSize;
+    NSUInteger _seededObjectCount;
 }
 
 // Delegate for seeding operations
@@ -49,6 +59,17 @@ extern NSString* const RKDefaultSeedDatabaseFileName;
 // Path to the generated seed database on disk
 @property (nonatomic, readonly) NSString* pathToSeedDatabase;
 
+/**
+ * The number of records mapped and saved together by seedObjectsFromFileNames:withObjectMapping:bundle:.
+ * The context is saved and reset after each batch, which bounds the number of objects held in memory.
+ *
+ * **Default**: 1000
+ */
+@property (nonatomic, assign) NSUInteger batchSize;
+
+// The number of objects seeded from files in bulk so far
+@property (nonatomic, readonly) NSUInteger seededObjectCount;
+
 /**
  * Generates a seed database using an object manager and a null terminated list of files. Exits
  * the seeding process and outputs an informational message
@@ -75,6 +96,16 @@ extern NSString* const RKDefaultSeedDatabaseFileName;
  */
 - (void)seedObjectsFromFile:(NSString *)fileName withObjectMapping:(RKObjectMapping *)nilOrObjectMapping bundle:(NSBundle *)nilOrBundle;
 
+/**
+ * Seeds the database in bulk from the specified files, from the specified bundle, using the supplied object mapping.
+ * The files are read and parsed in parallel, no more than one file per core ahead of the file being mapped,
+ * then mapped in the order given, batchSize records at a time. Each batch is saved and the context reset
+ * before the next is mapped: objects seeded by earlier batches are still found by primary key through the
+ * object store's primary key index. A batch that fails to map or save is logged and rolled back, and seeding
+ * continues with the next batch. Progress and throughput are logged after each batch.
+ */
+- (void)seedObjectsFromFileNames:(NSArray*)fileNames withObjectMapping:(RKObjectMapping*)nilOrObjectMapping bundle:(NSBundle*)nilOrBundle;
+
 /**
  * Completes a seeding session by persisting the store, outputing an informational message
  * and exiting the process
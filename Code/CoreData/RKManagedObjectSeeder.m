@@ -31,16 +31,24 @@
 #undef RKLogComponent
 #define RKLogComponent lcl_cRestKitCoreData
 
-@interface RKManagedObjectSeeder (Private)
+// The number of files parsed ahead of the one being mapped, per active processor
+static const NSUInteger RKManagedObjectSeederParseAheadFilesPerProcessor = 1;
+
+@interface RKManagedObjectSeeder (Private) <RKObjectMapperDelegate>
 - (id)initWithObjectManager:(RKObjectManager*)manager;
-- (void)seedObjectsFromFileNames:(NSArray*)fileNames;
+- (id)parsedObjectFromFile:(NSString*)fileName bundle:(NSBundle*)bundle;
+- (NSOperation*)parseOperationForFileAtIndex:(NSUInteger)index ofFileNames:(NSArray*)fileNames bundle:(NSBundle*)bundle intoArray:(NSMutableArray*)parsedObjects;
+- (void)seedObjectsFromParsedObject:(id)parsedObject ofFile:(NSString*)fileName withMappingProvider:(RKObjectMappingProvider*)mappingProvider startTime:(NSTimeInterval)startTime;
 @end
 
 NSString* const RKDefaultSeedDatabaseFileName = @"RKSeedDatabase.sqlite";
+static const NSUInteger RKManagedObjectSeederDefaultBatchSize = 1000;
 
 @implementation RKManagedObjectSeeder
 
 @synthesize delegate = _delegate;
+@synthesize batchSize = _batchSize;
+@synthesize seededObjectCount = _seededObjectCount;
 
 + (void)generateSeedDatabaseWithObjectManager:(RKObjectManager*)objectManager fromFiles:(NSString*)firstFileName, ... {
     RKManagedObjectSeeder* seeder = [RKManagedObjectSeeder objectSeederWithObjectManager:objectManager];
@@ -69,6 +77,7 @@ NSString* const RKDefaultSeedDatabaseFileName = @"RKSeedDatabase.sqlite";
     self = [self init];
 	if (self) {
 		_manager = [manager retain];
+        _batchSize = RKManagedObjectSeederDefaultBatchSize;
         
         // If the user hasn't configured an object store, set one up for them
         if (nil == _manager.objectStore) {
@@ -162,6 +171,162 @@ NSString* const RKDefaultSeedDatabaseFileName = @"RKSeedDatabase.sqlite";
 	}
 }
 
+#pragma mark - Bulk Seeding
+
+// Reads and parses a seed file. Sent on the parsing threads, so touches no shared state
+- (id)parsedObjectFromFile:(NSString*)fileName bundle:(NSBundle*)bundle {
+    NSError* error = nil;
+    NSString* filePath = [bundle pathForResource:fileName ofType:nil];
+    NSData* data = filePath ? [NSData dataWithContentsOfFile:filePath options:NSDataReadingMapped error:&error] : nil;
+    if (nil == data) {
+        RKLogError(@"Unable to read file %@: %@", fileName, [error localizedDescription]);
+        return nil;
+    }
+    
+    NSString* MIMEType = [fileName MIMETypeForPathExtension];
+    if (MIMEType == nil) {
+        MIMEType = _manager.acceptMIMEType;
+    }
+    id<RKParser> parser = [[RKParserRegistry sharedRegistry] parserForMIMEType:MIMEType];
+    if (nil == parser) {
+        RKLogError(@"Could not find a parser for the MIME Type '%@' of file %@", MIMEType, fileName);
+        return nil;
+    }
+    
+    // Parsers only accept strings. Let go of the decoded copy of the file as soon as it has been parsed
+    NSString* payload = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    id parsedObject = [parser objectFromString:payload error:&error];
+    [payload release];
+    if (nil == parsedObject) {
+        RKLogError(@"Unable to parse file %@: %@", fileName, [error localizedDescription]);
+    }
+    
+    return parsedObject;
+}
+
+// Returns an operation that parses the file at the index and stores the result at the same index of parsedObjects
+- (NSOperation*)parseOperationForFileAtIndex:(NSUInteger)index ofFileNames:(NSArray*)fileNames bundle:(NSBundle*)bundle intoArray:(NSMutableArray*)parsedObjects {
+    NSString* fileName = [fileNames objectAtIndex:index];
+    return [NSBlockOperation blockOperationWithBlock:^{
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        id parsedObject = [self parsedObjectFromFile:fileName bundle:bundle];
+        if (parsedObject) {
+            @synchronized(parsedObjects) {
+                [parsedObjects replaceObjectAtIndex:index withObject:parsedObject];
+            }
+        }
+        [pool drain];
+    }];
+}
+
+- (void)seedObjectsFromParsedObject:(id)parsedObject ofFile:(NSString*)fileName withMappingProvider:(RKObjectMappingProvider*)mappingProvider startTime:(NSTimeInterval)startTime {
+    RKManagedObjectStore* objectStore = _manager.objectStore;
+    
+    // Collections are mapped a batch of records at a time. Anything else is mapped as a whole
+    NSArray* records = [parsedObject isKindOfClass:[NSArray class]] ? parsedObject : [NSArray arrayWithObject:parsedObject];
+    NSUInteger batchSize = (_batchSize > 0) ? _batchSize : [records count];
+    NSUInteger objectCount = 0;
+    for (NSUInteger location = 0; location < [records count]; location += batchSize) {
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        NSRange range = NSMakeRange(location, MIN(batchSize, [records count] - location));
+        id batch = (parsedObject == records) ? [records subarrayWithRange:range] : parsedObject;
+        RKObjectMapper* mapper = [RKObjectMapper mapperWithObject:batch mappingProvider:mappingProvider];
+        mapper.delegate = self;
+        RKObjectMappingResult* result = [mapper performMapping];
+        if (result == nil) {
+            // Discard whatever was mapped before the failure, rather than saving it with the next batch
+            RKLogError(@"Database seeding of records %lu to %lu from file '%@' failed due to object mapping errors: %@",
+                       (unsigned long) range.location, (unsigned long) NSMaxRange(range), fileName, mapper.errors);
+            [objectStore rollback];
+            [pool drain];
+            continue;
+        }
+        
+        NSArray* mappedObjects = [result asCollection];
+        if (self.delegate) {
+            for (NSManagedObject* object in mappedObjects) {
+                [self.delegate didSeedObject:object fromFile:fileName];
+            }
+        }
+        
+        // A batch that fails to save is rolled back, so that its invalid objects do not fail
+        // the saves of every batch after it
+        NSError* error = [objectStore save];
+        if (error) {
+            RKLogError(@"Failed to save records %lu to %lu seeded from file '%@', skipping them: %@",
+                       (unsigned long) range.location, (unsigned long) NSMaxRange(range), fileName, [error localizedDescription]);
+            [objectStore rollback];
+        } else {
+            objectCount += [mappedObjects count];
+            _seededObjectCount += [mappedObjects count];
+            [[objectStore managedObjectContext] reset];
+        }
+        
+        NSTimeInterval elapsedTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
+        RKLogInfo(@"Seeded %lu of %lu records from %@ (%.0f objects/sec overall)...",
+                  (unsigned long) NSMaxRange(range), (unsigned long) [records count], fileName,
+                  (elapsedTime > 0) ? _seededObjectCount / elapsedTime : 0);
+        if ([self.delegate respondsToSelector:@selector(objectSeeder:didSaveObjectCount:fromFile:elapsedTime:)]) {
+            [self.delegate objectSeeder:self didSaveObjectCount:objectCount fromFile:fileName elapsedTime:elapsedTime];
+        }
+        [pool drain];
+    }
+}
+
+- (void)seedObjectsFromFileNames:(NSArray*)fileNames withObjectMapping:(RKObjectMapping*)nilOrObjectMapping bundle:(NSBundle*)nilOrBundle {
+    NSBundle* bundle = nilOrBundle ? nilOrBundle : [NSBundle mainBundle];
+    NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+    NSUInteger initialObjectCount = _seededObjectCount;
+    
+    RKObjectMappingProvider* mappingProvider = nil;
+    if (nilOrObjectMapping) {
+        mappingProvider = [[RKObjectMappingProvider new] autorelease];
+        [mappingProvider setMapping:nilOrObjectMapping forKeyPath:@""];
+    } else {
+        mappingProvider = _manager.mappingProvider;
+    }
+    
+    // Files are parsed on as many threads as there are cores, a few files ahead of the one being
+    // mapped. Mapping waits for each file in turn, so it starts as soon as the first is parsed,
+    // and no more parsed files are held in memory than the parse window allows
+    NSMutableArray* parsedObjects = [NSMutableArray arrayWithCapacity:[fileNames count]];
+    NSMutableArray* parseOperations = [NSMutableArray arrayWithCapacity:[fileNames count]];
+    NSOperationQueue* parseQueue = [[[NSOperationQueue alloc] init] autorelease];
+    NSUInteger processorCount = [[NSProcessInfo processInfo] activeProcessorCount];
+    NSUInteger parseWindow = MAX(processorCount * RKManagedObjectSeederParseAheadFilesPerProcessor, (NSUInteger) 1);
+    [parseQueue setMaxConcurrentOperationCount:processorCount];
+    for (NSUInteger index = 0; index < [fileNames count]; index++) {
+        [parsedObjects addObject:[NSNull null]];
+    }
+    
+    for (NSUInteger index = 0; index < [fileNames count]; index++) {
+        // Keep the window full: the files up to parseWindow past this one are parsing or parsed
+        while ([parseOperations count] < [fileNames count] && [parseOperations count] <= index + parseWindow) {
+            NSOperation* operation = [self parseOperationForFileAtIndex:[parseOperations count] ofFileNames:fileNames bundle:bundle intoArray:parsedObjects];
+            [parseOperations addObject:operation];
+            [parseQueue addOperation:operation];
+        }
+        
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        [[parseOperations objectAtIndex:index] waitUntilFinished];
+        id parsedObject = nil;
+        @synchronized(parsedObjects) {
+            parsedObject = [[[parsedObjects objectAtIndex:index] retain] autorelease];
+            // Let go of each file's parsed records once it has been seeded
+            [parsedObjects replaceObjectAtIndex:index withObject:[NSNull null]];
+        }
+        if (parsedObject != [NSNull null]) {
+            [self seedObjectsFromParsedObject:parsedObject ofFile:[fileNames objectAtIndex:index] withMappingProvider:mappingProvider startTime:startTime];
+        }
+        [pool drain];
+    }
+    
+    NSTimeInterval elapsedTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
+    NSUInteger objectCount = _seededObjectCount - initialObjectCount;
+    RKLogInfo(@"Seeded %lu objects from %lu files in %.2f seconds (%.0f objects/sec)", (unsigned long) objectCount,
+              (unsigned long) [fileNames count], elapsedTime, (elapsedTime > 0) ? objectCount / elapsedTime : 0);
+}
+
 - (void)finalizeSeedingAndExit {
 	NSError* error = [[_manager objectStore] save];
 	if (error != nil) {
@@ -20,6 +20,7 @@
 
 #import <CoreData/CoreData.h>
 #import "RKManagedObjectCache.h"
+#import "RKManagedObjectPrimaryKeyIndex.h"
 
 @class RKManagedObjectStore;
 
@@ -27,6 +28,7 @@
  * Notifications
  */
 extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
+extern NSString* const RKManagedObjectStoreDidDeletePersistentStoreNotification;
 
 ///////////////////////////////////////////////////////////////////
 
@@ -41,10 +43,26 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
 
 - (void)managedObjectStore:(RKManagedObjectStore *)objectStore didFailToSaveContext:(NSManagedObjectContext *)context error:(NSError *)error exception:(NSException *)exception;
 
+/**
+ * Sent on the thread that mapped a response once objects cached at its resource path but missing from
+ * the response have been deleted. Spared objects are those the managed object cache declined to delete.
+ */
+- (void)managedObjectStore:(RKManagedObjectStore *)objectStore didDeleteOrphanedObjectCount:(NSUInteger)deletedCount sparedObjectCount:(NSUInteger)sparedCount forResourcePath:(NSString *)resourcePath;
+
 @end
 
 ///////////////////////////////////////////////////////////////////
 
+/**
+ * Determines how findOrCreateInstanceOfEntity:withPrimaryKeyAttribute:andValue: finds existing objects
+ */
+typedef enum {
+    RKManagedObjectStorePrimaryKeyLookupTargeted,       // Fetch the object IDs of only the primary keys being looked up
+    RKManagedObjectStorePrimaryKeyLookupWholeEntity     // Fetch every instance of the entity the first time it is looked up
+} RKManagedObjectStorePrimaryKeyLookup;
+
+///////////////////////////////////////////////////////////////////
+
 @interface RKManagedObjectStore : NSObject {
 	NSObject<RKManagedObjectStoreDelegate>* _delegate;
 	NSString* _storeFilename;
@@ -52,6 +70,13 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
     NSManagedObjectModel* _managedObjectModel;
 	NSPersistentStoreCoordinator* _persistentStoreCoordinator;
 	NSObject<RKManagedObjectCache>* _managedObjectCache;
+    NSUInteger _saveGeneration;
+    RKManagedObjectStorePrimaryKeyLookup _primaryKeyLookup;
+    NSMutableDictionary* _primaryKeyLookupsByEntityName;
+    RKManagedObjectPrimaryKeyIndex* _primaryKeyIndex;
+    NSMutableArray* _pendingMergeNotifications;
+    BOOL _mergeScheduled;
+    BOOL _mergesChangesForRegisteredObjectsOnly;
 }
 
 // The delegate for this object store
@@ -73,6 +98,47 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
  */
 @property (nonatomic, retain) NSObject<RKManagedObjectCache>* managedObjectCache;
 
+/**
+ * Determines how existing objects are found by primary key. Targeted lookups fetch only the
+ * primary keys they are asked about, in batches of IN fetches returning object IDs, so the cost
+ * of a lookup scales with the size of the payload rather than the size of the table. Whole entity
+ * lookups fetch the object IDs of every instance of the entity the first time it is looked up,
+ * which suits small reference tables that are looked up over and over. Either way the results are
+ * kept in the primaryKeyIndex shared by every thread.
+ *
+ * **Default**: RKManagedObjectStorePrimaryKeyLookupTargeted
+ */
+@property (nonatomic, assign) RKManagedObjectStorePrimaryKeyLookup primaryKeyLookup;
+
+/**
+ * The index of primary key values to object IDs shared by the contexts of every thread. The index
+ * is brought up to date when a context saves and is emptied when the persistent store is deleted.
+ * Its capacity bounds the memory spent on each entity and primary key attribute.
+ */
+@property (nonatomic, readonly) RKManagedObjectPrimaryKeyIndex* primaryKeyIndex;
+
+/**
+ * Saves on background threads are merged into the main thread's context without blocking the
+ * saving thread. Saves that happen before the main thread gets around to merging are coalesced
+ * into a single merge. When this is YES, updates and deletions are only merged for objects the
+ * main thread's context has registered; insertions are always merged. Merges are delivered
+ * through the shared RKMainThreadInvocationQueue, so they happen before any callbacks that were
+ * enqueued after the save, such as an object loader informing its delegate.
+ *
+ * **Default**: NO
+ */
+@property (nonatomic, assign) BOOL mergesChangesForRegisteredObjectsOnly;
+
+/**
+ * Overrides the primaryKeyLookup for a single entity
+ */
+- (void)setPrimaryKeyLookup:(RKManagedObjectStorePrimaryKeyLookup)primaryKeyLookup forEntity:(NSEntityDescription*)entity;
+
+/**
+ * Returns the primary key lookup used for the entity
+ */
+- (RKManagedObjectStorePrimaryKeyLookup)primaryKeyLookupForEntity:(NSEntityDescription*)entity;
+
 /*
  * This returns an appropriate managed object context for this object store.
  * Because of the intrecacies of how Core Data works across threads it returns
@@ -113,6 +179,12 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
  */
 - (NSError*)save;
 
+/**
+ * Discards the unsaved changes of the current thread's managed object context, along with the
+ * unsaved objects the thread tracks for lookups by primary key
+ */
+- (void)rollback;
+
 /**
  * This deletes and recreates the managed object context and 
  * persistant store, effectively clearing all data
@@ -127,17 +199,57 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
 
 /**
  *	Retrieves a array of model objects from the appropriate context using
- *	an array of NSManagedObjectIDs
+ *	an array of NSManagedObjectIDs. Objects that no longer exist in the store
+ *	are left out.
  */
 - (NSArray*)objectsWithIDs:(NSArray*)objectIDs;
 
+/**
+ * Retrieves the model objects for a set of NSManagedObjectIDs from the appropriate context, keyed
+ * by object ID. Objects the context has not already materialized are fetched together, with one
+ * batched fetch per entity that fires their faults and prefetches the given relationship key
+ * paths, rather than being faulted in one at a time. Object IDs whose objects have been deleted
+ * from the store are left out of the dictionary.
+ */
+- (NSDictionary*)objectsByIDForObjectIDs:(id<NSFastEnumeration>)objectIDs prefetchingRelationshipKeyPaths:(NSArray*)relationshipKeyPaths;
+
 /**
  * Retrieves a model object from the object store given a Core Data entity and
- * the primary key attribute and value for the desired object. Internally, this method
- * constructs a thread-local cache of managed object instances to avoid repeated fetches from the store
+ * the primary key attribute and value for the desired object. Existing objects are found
+ * through the primaryKeyIndex shared by every thread, so each primary key is fetched from the store
+ * at most once. Objects created by this method are tracked by the current thread until its context saves.
+ *
+ * @see primaryKeyLookup
  */
 - (NSManagedObject*)findOrCreateInstanceOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute andValue:(id)primaryKeyValue;
 
+/**
+ * Resolves the primary key values into the primaryKeyIndex used by
+ * findOrCreateInstanceOfEntity:withPrimaryKeyAttribute:andValue: ahead of looking them up,
+ * with one IN fetch of object IDs per batch of values not already known to the index.
+ * Values that do not exist in the store are remembered as missing, so looking them up
+ * creates the object without fetching again.
+ */
+- (void)prefetchInstancesOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute values:(id<NSFastEnumeration>)primaryKeyValues;
+
+/**
+ * Returns the existing instances of the entity for the primary key values, keyed by the value
+ * each was found for. Values are resolved through the same primary key index and batched
+ * fetches as prefetchInstancesOfEntity:withPrimaryKeyAttribute:values:, and no objects are
+ * created for values that are not found.
+ */
+- (NSDictionary*)findInstancesOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute values:(id<NSFastEnumeration>)primaryKeyValues;
+
+/**
+ * Resets the managed object context and the unsaved objects tracked by the current thread if a context on
+ * another thread has saved since this thread last created, saved or reset its context.
+ *
+ * Long-lived background threads (such as the mapping threads of RKObjectManager) call this before
+ * each unit of work so that reusing their thread local storage never hands out stale objects.
+ * Does nothing on the main thread, whose context receives merges from every background save.
+ */
+- (void)resetThreadLocalStorageIfStale;
+
 /**
  * Returns an array of objects that the 'live' at the specified resource path. Usage of this
  * method requires that you have provided an implementation of the managed object cache
@@ -146,4 +258,13 @@ extern NSString* const RKManagedObjectStoreDidFailSaveNotification;
  */
 - (NSArray*)objectsForResourcePath:(NSString*)resourcePath;
 
+/**
+ * Returns the set of object IDs for the objects that live at the specified resource path. The
+ * fetch requests of the managed object cache are executed for object IDs only, so no objects
+ * are instantiated.
+ *
+ * See managedObjectCache above
+ */
+- (NSSet*)objectIDsForResourcePath:(NSString*)resourcePath;
+
 @end
@@ -23,20 +23,63 @@
 #import "NSManagedObject+ActiveRecord.h"
 #import "RKLog.h"
 #import "RKDirectory.h"
+#import "RKMainThreadInvocationQueue.h"
 
 // Set Logging Component
 #undef RKLogComponent
 #define RKLogComponent lcl_cRestKitCoreData
 
 NSString* const RKManagedObjectStoreDidFailSaveNotification = @"RKManagedObjectStoreDidFailSaveNotification";
+NSString* const RKManagedObjectStoreDidDeletePersistentStoreNotification = @"RKManagedObjectStoreDidDeletePersistentStoreNotification";
 static NSString* const RKManagedObjectStoreThreadDictionaryContextKey = @"RKManagedObjectStoreThreadDictionaryContextKey";
 static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RKManagedObjectStoreThreadDictionaryEntityCacheKey";
+static NSString* const RKManagedObjectStoreThreadDictionarySaveGenerationKey = @"RKManagedObjectStoreThreadDictionarySaveGenerationKey";
+
+// Keeps IN predicates well under SQLite's limit on the number of bound variables
+static const NSUInteger RKManagedObjectStorePrimaryKeyFetchBatchSize = 500;
+
+static id RKManagedObjectStorePrimaryKeyLookupValue(id primaryKeyValue) {
+    return [RKManagedObjectPrimaryKeyIndex lookupValueForPrimaryKeyValue:primaryKeyValue];
+}
+
+// Converts a primary key value to the type of the attribute, so that fetches compare like with like
+static id RKManagedObjectStorePrimaryKeyFetchValue(id primaryKeyValue, NSAttributeType attributeType) {
+    switch (attributeType) {
+        case NSInteger16AttributeType:
+        case NSInteger32AttributeType:
+        case NSInteger64AttributeType:
+        case NSBooleanAttributeType:
+            if ([primaryKeyValue respondsToSelector:@selector(longLongValue)]) {
+                return [NSNumber numberWithLongLong:[primaryKeyValue longLongValue]];
+            }
+            break;
+        case NSDoubleAttributeType:
+        case NSFloatAttributeType:
+            if ([primaryKeyValue respondsToSelector:@selector(doubleValue)]) {
+                return [NSNumber numberWithDouble:[primaryKeyValue doubleValue]];
+            }
+            break;
+        case NSDecimalAttributeType:
+            return [NSDecimalNumber decimalNumberWithString:[primaryKeyValue description]];
+        case NSStringAttributeType:
+            return RKManagedObjectStorePrimaryKeyLookupValue(primaryKeyValue);
+        default:
+            break;
+    }
+    
+    return primaryKeyValue;
+}
 
 @interface RKManagedObjectStore (Private)
 - (id)initWithStoreFilename:(NSString *)storeFilename inDirectory:(NSString *)nilOrDirectoryPath usingSeedDatabaseName:(NSString *)nilOrNameOfSeedDatabaseInMainBundle managedObjectModel:(NSManagedObjectModel*)nilOrManagedObjectModel delegate:(id)delegate;
 - (void)createPersistentStoreCoordinator;
 - (void)createStoreIfNecessaryUsingSeedDatabase:(NSString*)seedDatabase;
 - (NSManagedObjectContext*)newManagedObjectContext;
+- (NSMutableDictionary*)unsavedObjectsForEntity:(NSEntityDescription*)entity;
+- (NSDictionary*)fetchObjectIDsOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSAttributeDescription*)attribute predicate:(NSPredicate*)predicate;
+- (id)objectIDForEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute lookupValue:(id)lookupValue;
+- (NSNotification*)objectIDNotificationForNotification:(NSNotification*)notification;
+- (NSSet*)objectsWithIDs:(NSSet*)objectIDs inContext:(NSManagedObjectContext*)context;
 @end
 
 @implementation RKManagedObjectStore
@@ -47,6 +90,9 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 @synthesize managedObjectModel = _managedObjectModel;
 @synthesize persistentStoreCoordinator = _persistentStoreCoordinator;
 @synthesize managedObjectCache = _managedObjectCache;
+@synthesize primaryKeyLookup = _primaryKeyLookup;
+@synthesize primaryKeyIndex = _primaryKeyIndex;
+@synthesize mergesChangesForRegisteredObjectsOnly = _mergesChangesForRegisteredObjectsOnly;
 
 + (RKManagedObjectStore*)objectStoreWithStoreFilename:(NSString*)storeFilename {
     return [self objectStoreWithStoreFilename:storeFilename usingSeedDatabaseName:nil managedObjectModel:nil delegate:nil];
@@ -68,6 +114,10 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
     self = [self init];
 	if (self) {
 		_storeFilename = [storeFilename retain];
+        _primaryKeyLookup = RKManagedObjectStorePrimaryKeyLookupTargeted;
+        _primaryKeyLookupsByEntityName = [[NSMutableDictionary alloc] init];
+        _primaryKeyIndex = [[RKManagedObjectPrimaryKeyIndex alloc] init];
+        _pendingMergeNotifications = [[NSMutableArray alloc] init];
 		
 		if (nilOrDirectoryPath == nil) {
 			nilOrDirectoryPath = [RKDirectory applicationDataDirectory];
@@ -110,6 +160,7 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
     if ([threadDictionary objectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey]) {
         [threadDictionary removeObjectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
     }
+    [threadDictionary removeObjectForKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
 }
 
 - (void)dealloc {
@@ -127,6 +178,11 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 	_persistentStoreCoordinator = nil;
 	[_managedObjectCache release];
 	_managedObjectCache = nil;
+    [_primaryKeyLookupsByEntityName release];
+    _primaryKeyLookupsByEntityName = nil;
+    [_primaryKeyIndex release];
+    _primaryKeyIndex = nil;
+    [_pendingMergeNotifications release];
     
 	[super dealloc];
 }
@@ -190,16 +246,17 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 	return nil;
 }
 
+- (void)rollback {
+    [[self managedObjectContext] rollback];
+    [[[NSThread currentThread] threadDictionary] removeObjectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
+}
+
 - (NSManagedObjectContext*)newManagedObjectContext {
 	NSManagedObjectContext* managedObjectContext = [[NSManagedObjectContext alloc] init];
 	[managedObjectContext setPersistentStoreCoordinator:self.persistentStoreCoordinator];
 	[managedObjectContext setUndoManager:nil];
 	[managedObjectContext setMergePolicy:NSOverwriteMergePolicy];
 	
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(objectsDidChange:)
-												 name:NSManagedObjectContextObjectsDidChangeNotification
-											   object:managedObjectContext];
 	return managedObjectContext;
 }
 
@@ -281,12 +338,15 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 	_persistentStoreCoordinator = nil;
 	
 	[self clearThreadLocalStorage];
+    [_primaryKeyIndex removeAllObjectIDs];
 	
 	if (seedFile) {
         [self createStoreIfNecessaryUsingSeedDatabase:seedFile];
     }
 
 	[self createPersistentStoreCoordinator];
+	
+	[[NSNotificationCenter defaultCenter] postNotificationName:RKManagedObjectStoreDidDeletePersistentStoreNotification object:self];
 }
 
 - (void)deletePersistantStore {
@@ -306,6 +366,9 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 		backgroundThreadContext = [self newManagedObjectContext];
 		[threadDictionary setObject:backgroundThreadContext forKey:RKManagedObjectStoreThreadDictionaryContextKey];
 		[backgroundThreadContext release];
+        @synchronized(self) {
+            [threadDictionary setObject:[NSNumber numberWithUnsignedInteger:_saveGeneration] forKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
+        }
 
 		[[NSNotificationCenter defaultCenter] addObserver:self
                                                  selector:@selector(mergeChanges:)
@@ -315,35 +378,150 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 	return backgroundThreadContext;
 }
 
-- (void)mergeChangesOnMainThreadWithNotification:(NSNotification*)notification {
-	assert([NSThread isMainThread]);
-	[self.managedObjectContext performSelectorOnMainThread:@selector(mergeChangesFromContextDidSaveNotification:)
-												withObject:notification
-											 waitUntilDone:YES];
+// Replaces the saved objects in a save notification with their object IDs. The objects belong to
+// the saving thread's context, but their IDs may be handed to the main thread
+- (NSNotification*)objectIDNotificationForNotification:(NSNotification*)notification {
+    NSDictionary* userInfo = [notification userInfo];
+    NSMutableDictionary* objectIDUserInfo = [NSMutableDictionary dictionaryWithCapacity:3];
+    for (NSString* key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, nil]) {
+        NSSet* objects = [userInfo objectForKey:key];
+        NSMutableSet* objectIDs = [NSMutableSet setWithCapacity:[objects count]];
+        for (NSManagedObject* object in objects) {
+            [objectIDs addObject:[object objectID]];
+        }
+        [objectIDUserInfo setObject:objectIDs forKey:key];
+    }
+    
+    return [NSNotification notificationWithName:[notification name] object:[notification object] userInfo:objectIDUserInfo];
+}
+
+- (NSSet*)objectsWithIDs:(NSSet*)objectIDs inContext:(NSManagedObjectContext*)context {
+    NSMutableSet* objects = [NSMutableSet setWithCapacity:[objectIDs count]];
+    for (NSManagedObjectID* objectID in objectIDs) {
+        [objects addObject:[context objectWithID:objectID]];
+    }
+    
+    return objects;
+}
+
+// Combines the pending object ID notifications, in the order the saves happened, into one save
+// notification containing the main thread's objects for the net insertions, updates and deletions
+- (NSNotification*)mergeNotificationForNotifications:(NSArray*)notifications {
+    NSManagedObjectContext* mainContext = self.managedObjectContext;
+    NSMutableSet* insertedObjectIDs = [NSMutableSet set];
+    NSMutableSet* updatedObjectIDs = [NSMutableSet set];
+    NSMutableSet* deletedObjectIDs = [NSMutableSet set];
+    for (NSNotification* notification in notifications) {
+        NSDictionary* userInfo = [notification userInfo];
+        [insertedObjectIDs unionSet:[userInfo objectForKey:NSInsertedObjectsKey]];
+        for (NSManagedObjectID* objectID in [userInfo objectForKey:NSUpdatedObjectsKey]) {
+            if (! [insertedObjectIDs containsObject:objectID]) {
+                [updatedObjectIDs addObject:objectID];
+            }
+        }
+        for (NSManagedObjectID* objectID in [userInfo objectForKey:NSDeletedObjectsKey]) {
+            [updatedObjectIDs removeObject:objectID];
+            if ([insertedObjectIDs containsObject:objectID]) {
+                // Never seen by the main context
+                [insertedObjectIDs removeObject:objectID];
+            } else {
+                [deletedObjectIDs addObject:objectID];
+            }
+        }
+    }
+    
+    if (_mergesChangesForRegisteredObjectsOnly) {
+        for (NSMutableSet* objectIDs in [NSArray arrayWithObjects:updatedObjectIDs, deletedObjectIDs, nil]) {
+            for (NSManagedObjectID* objectID in [[objectIDs copy] autorelease]) {
+                if (nil == [mainContext objectRegisteredForID:objectID]) {
+                    [objectIDs removeObject:objectID];
+                }
+            }
+        }
+    }
+    
+    NSDictionary* userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [self objectsWithIDs:insertedObjectIDs inContext:mainContext], NSInsertedObjectsKey,
+                              [self objectsWithIDs:updatedObjectIDs inContext:mainContext], NSUpdatedObjectsKey,
+                              [self objectsWithIDs:deletedObjectIDs inContext:mainContext], NSDeletedObjectsKey,
+                              nil];
+    return [NSNotification notificationWithName:NSManagedObjectContextDidSaveNotification object:[[notifications lastObject] object] userInfo:userInfo];
+}
+
+- (void)mergePendingChanges {
+	NSAssert([NSThread isMainThread], @"Changes must be merged into the main thread's context on the main thread");
+    NSArray* notifications = nil;
+    @synchronized(self) {
+        notifications = [[_pendingMergeNotifications copy] autorelease];
+        [_pendingMergeNotifications removeAllObjects];
+        _mergeScheduled = NO;
+    }
+    if ([notifications count] == 0) {
+        return;
+    }
+    
+    RKLogTrace(@"Merging %lu saves into the main thread's context", (unsigned long) [notifications count]);
+    [self.managedObjectContext mergeChangesFromContextDidSaveNotification:[self mergeNotificationForNotifications:notifications]];
 }
 
 - (void)mergeChanges:(NSNotification *)notification {
-	// Merge changes into the main context on the main thread
-	[self performSelectorOnMainThread:@selector(mergeChangesOnMainThreadWithNotification:) withObject:notification waitUntilDone:YES];
+    // Delivered on the saving thread, while the saved objects can still be read. The objects
+    // this thread inserted are now found through the primary key index
+    NSMutableDictionary* threadDictionary = [[NSThread currentThread] threadDictionary];
+    [_primaryKeyIndex updateWithContextDidSaveNotification:notification];
+    [threadDictionary removeObjectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
+    
+    // If this thread had seen every prior save, it remains current after its own save;
+    // otherwise it stays stale until it is reset
+    @synchronized(self) {
+        NSNumber* seenGeneration = [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
+        BOOL wasCurrent = (seenGeneration && [seenGeneration unsignedIntegerValue] == _saveGeneration);
+        _saveGeneration++;
+        if (wasCurrent) {
+            [threadDictionary setObject:[NSNumber numberWithUnsignedInteger:_saveGeneration] forKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
+        }
+    }
+    
+    // The main thread's own saves need no merging
+    if ([NSThread isMainThread]) {
+        return;
+    }
+    
+	// Merge changes into the main context on the main thread, along with any other saves
+    // that happen before it gets there. Only the object IDs are handed over
+    NSNotification* objectIDNotification = [self objectIDNotificationForNotification:notification];
+    @synchronized(self) {
+        [_pendingMergeNotifications addObject:objectIDNotification];
+        if (_mergeScheduled) {
+            return;
+        }
+        _mergeScheduled = YES;
+    }
+    [[RKMainThreadInvocationQueue sharedQueue] performSelector:@selector(mergePendingChanges) onTarget:self withObject:nil];
 }
 
-- (void)objectsDidChange:(NSNotification*)notification {
-	NSDictionary* userInfo = notification.userInfo;
-	NSSet* insertedObjects = [userInfo objectForKey:NSInsertedObjectsKey];
-	NSMutableDictionary* threadDictionary = [[NSThread currentThread] threadDictionary];
-	
-	for (NSManagedObject* object in insertedObjects) {
-		if ([object respondsToSelector:@selector(primaryKeyProperty)]) {
-			Class theClass = [object class];
-			NSString* primaryKey = [theClass performSelector:@selector(primaryKeyProperty)];
-			id primaryKeyValue = [object valueForKey:primaryKey];
-			
-			NSMutableDictionary* classCache = [threadDictionary objectForKey:theClass];
-			if (classCache && primaryKeyValue && [classCache objectForKey:primaryKeyValue] == nil) {
-				[classCache setObject:object forKey:primaryKeyValue];
-			}
-		}
-	}
+- (void)resetThreadLocalStorageIfStale {
+    if ([NSThread isMainThread]) {
+        return;
+    }
+    
+    NSMutableDictionary* threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSManagedObjectContext* context = [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionaryContextKey];
+    if (nil == context) {
+        return;
+    }
+    
+    @synchronized(self) {
+        NSNumber* seenGeneration = [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
+        if (seenGeneration && [seenGeneration unsignedIntegerValue] == _saveGeneration) {
+            return;
+        }
+        [threadDictionary setObject:[NSNumber numberWithUnsignedInteger:_saveGeneration] forKey:RKManagedObjectStoreThreadDictionarySaveGenerationKey];
+    }
+    
+    RKLogDebug(@"Another context has saved since thread %@ last used its context. Resetting thread local storage", [NSThread currentThread]);
+    [context reset];
+    [threadDictionary removeObjectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
 }
 
 #pragma mark -
@@ -354,9 +532,13 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 }
 
 - (NSArray*)objectsWithIDs:(NSArray*)objectIDs {
-	NSMutableArray* objects = [[NSMutableArray alloc] init];
+    NSDictionary* objectsByID = [self objectsByIDForObjectIDs:objectIDs prefetchingRelationshipKeyPaths:nil];
+	NSMutableArray* objects = [[NSMutableArray alloc] initWithCapacity:[objectIDs count]];
 	for (NSManagedObjectID* objectID in objectIDs) {
-		[objects addObject:[self.managedObjectContext objectWithID:objectID]];
+		NSManagedObject* object = [objectsByID objectForKey:objectID];
+		if (object) {
+			[objects addObject:object];
+		}
 	}
 	NSArray* objectArray = [NSArray arrayWithArray:objects];
 	[objects release];
@@ -364,52 +546,249 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
 	return objectArray;
 }
 
-- (NSManagedObject*)findOrCreateInstanceOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute andValue:(id)primaryKeyValue {
-    NSAssert(entity, @"Cannot instantiate managed object without a target class");
-    NSAssert(primaryKeyAttribute, @"Cannot find existing managed object instance without a primary key attribute");
-    NSAssert(primaryKeyValue, @"Cannot find existing managed object by primary key without a value");
-	NSManagedObject* object = nil;
+- (NSDictionary*)objectsByIDForObjectIDs:(id<NSFastEnumeration>)objectIDs prefetchingRelationshipKeyPaths:(NSArray*)relationshipKeyPaths {
+    NSManagedObjectContext* context = self.managedObjectContext;
+    NSMutableDictionary* objectsByID = [NSMutableDictionary dictionary];
+    NSMutableDictionary* unfetchedObjectIDsByEntityName = [NSMutableDictionary dictionary];
+    for (NSManagedObjectID* objectID in objectIDs) {
+        if ([objectsByID objectForKey:objectID]) {
+            continue;
+        }
+        
+        NSManagedObject* object = [context objectRegisteredForID:objectID];
+        if (object && [object isDeleted]) {
+            continue;
+        }
+        if ((object && ![object isFault]) || [objectID isTemporaryID]) {
+            // Already materialized, or never saved so there is nothing to fetch
+            [objectsByID setObject:(object ? object : [context objectWithID:objectID]) forKey:objectID];
+            continue;
+        }
+        
+        NSString* entityName = [[objectID entity] name];
+        NSMutableArray* entityObjectIDs = [unfetchedObjectIDsByEntityName objectForKey:entityName];
+        if (nil == entityObjectIDs) {
+            entityObjectIDs = [NSMutableArray array];
+            [unfetchedObjectIDsByEntityName setObject:entityObjectIDs forKey:entityName];
+        }
+        [entityObjectIDs addObject:objectID];
+    }
+    
+    for (NSString* entityName in unfetchedObjectIDsByEntityName) {
+        NSArray* entityObjectIDs = [unfetchedObjectIDsByEntityName objectForKey:entityName];
+        NSEntityDescription* entity = [[entityObjectIDs lastObject] entity];
+        NSMutableArray* entityRelationshipKeyPaths = [NSMutableArray array];
+        for (NSString* keyPath in relationshipKeyPaths) {
+            NSString* relationshipName = [[keyPath componentsSeparatedByString:@"."] objectAtIndex:0];
+            if ([[entity relationshipsByName] objectForKey:relationshipName]) {
+                [entityRelationshipKeyPaths addObject:keyPath];
+            }
+        }
+        
+        for (NSUInteger location = 0; location < [entityObjectIDs count]; location += RKManagedObjectStorePrimaryKeyFetchBatchSize) {
+            NSRange range = NSMakeRange(location, MIN(RKManagedObjectStorePrimaryKeyFetchBatchSize, [entityObjectIDs count] - location));
+            NSArray* batch = [entityObjectIDs subarrayWithRange:range];
+            NSFetchRequest* fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+            [fetchRequest setEntity:entity];
+            [fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", batch]];
+            [fetchRequest setReturnsObjectsAsFaults:NO];
+            [fetchRequest setIncludesSubentities:YES];
+            if ([entityRelationshipKeyPaths count] > 0) {
+                [fetchRequest setRelationshipKeyPathsForPrefetching:entityRelationshipKeyPaths];
+            }
+            
+            NSError* error = nil;
+            NSArray* objects = [context executeFetchRequest:fetchRequest error:&error];
+            if (nil == objects) {
+                // Fall back to faults, which fire one at a time as objectWithID: would
+                RKLogError(@"Failed to fetch %lu %@ objects by object ID: %@", (unsigned long) [batch count], entityName, [error localizedDescription]);
+                for (NSManagedObjectID* objectID in batch) {
+                    [objectsByID setObject:[context objectWithID:objectID] forKey:objectID];
+                }
+                continue;
+            }
+            
+            // Object IDs missing from the fetch belong to deleted objects and are left out
+            for (NSManagedObject* object in objects) {
+                [objectsByID setObject:object forKey:[object objectID]];
+            }
+        }
+    }
     
-    // NOTE: We coerce the primary key into a string (if possible) for convenience. Generally
-    // primary keys are expressed either as a number of a string, so this lets us support either case interchangeably
-    id lookupValue = [primaryKeyValue respondsToSelector:@selector(stringValue)] ? [primaryKeyValue stringValue] : primaryKeyValue;
-    NSArray* objects = nil;
-    NSString* entityName = entity.name;
+    return objectsByID;
+}
+
+#pragma mark - Primary Key Lookup
+
+- (void)setPrimaryKeyLookup:(RKManagedObjectStorePrimaryKeyLookup)primaryKeyLookup forEntity:(NSEntityDescription*)entity {
+    @synchronized(self) {
+        [_primaryKeyLookupsByEntityName setObject:[NSNumber numberWithInt:primaryKeyLookup] forKey:entity.name];
+    }
+}
+
+- (RKManagedObjectStorePrimaryKeyLookup)primaryKeyLookupForEntity:(NSEntityDescription*)entity {
+    @synchronized(self) {
+        NSNumber* primaryKeyLookup = [_primaryKeyLookupsByEntityName objectForKey:entity.name];
+        return primaryKeyLookup ? (RKManagedObjectStorePrimaryKeyLookup) [primaryKeyLookup intValue] : _primaryKeyLookup;
+    }
+}
+
+// Returns the objects the current thread has created for the entity since its context last saved,
+// keyed by primary key lookup value. Saved objects are found through the primary key index instead
+- (NSMutableDictionary*)unsavedObjectsForEntity:(NSEntityDescription*)entity {
     NSMutableDictionary* threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSMutableDictionary* entityCache = [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
+    if (nil == entityCache) {
+        entityCache = [NSMutableDictionary dictionary];
+        [threadDictionary setObject:entityCache forKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
+    }
     
-    if (nil == [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey]) {
-        [threadDictionary setObject:[NSMutableDictionary dictionary] forKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
+    NSMutableDictionary* dictionary = [entityCache objectForKey:entity.name];
+    if (nil == dictionary) {
+        dictionary = [NSMutableDictionary dictionary];
+        [entityCache setObject:dictionary forKey:entity.name];
     }
     
-    // Construct the cache if necessary
-    NSMutableDictionary* entityCache = [threadDictionary objectForKey:RKManagedObjectStoreThreadDictionaryEntityCacheKey];
-    if (nil == [entityCache objectForKey:entityName]) {
-        NSFetchRequest* fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
-        [fetchRequest setEntity:entity];
-        [fetchRequest setReturnsObjectsAsFaults:NO];
-        objects = [NSManagedObject executeFetchRequest:fetchRequest];
-        RKLogInfo(@"Caching all %lu %@ objects to thread local storage", (unsigned long) [objects count], entity.name);
-        NSMutableDictionary* dictionary = [NSMutableDictionary dictionary];
-        BOOL coerceToString = [[[objects lastObject] valueForKey:primaryKeyAttribute] respondsToSelector:@selector(stringValue)];
-        for (id theObject in objects) {			
-            id attributeValue = [theObject valueForKey:primaryKeyAttribute];
-            // Coerce to a string if possible
-            attributeValue = coerceToString ? [attributeValue stringValue] : attributeValue;
-            if (attributeValue) {
-                [dictionary setObject:theObject forKey:attributeValue];
-            }
+    return dictionary;
+}
+
+// Fetches just the primary key and object ID of each matching row, keyed by lookup value. Returns nil if the fetch fails
+- (NSDictionary*)fetchObjectIDsOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSAttributeDescription*)attribute predicate:(NSPredicate*)predicate {
+    NSExpressionDescription* objectIDDescription = [[[NSExpressionDescription alloc] init] autorelease];
+    [objectIDDescription setName:@"objectID"];
+    [objectIDDescription setExpression:[NSExpression expressionForEvaluatedObject]];
+    [objectIDDescription setExpressionResultType:NSObjectIDAttributeType];
+    
+    NSFetchRequest* fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+    [fetchRequest setEntity:entity];
+    [fetchRequest setPredicate:predicate];
+    [fetchRequest setResultType:NSDictionaryResultType];
+    [fetchRequest setPropertiesToFetch:[NSArray arrayWithObjects:attribute, objectIDDescription, nil]];
+    
+    NSError* error = nil;
+    NSArray* rows = [self.managedObjectContext executeFetchRequest:fetchRequest error:&error];
+    if (nil == rows) {
+        RKLogError(@"Failed to fetch %@ objects by primary key: %@", entity.name, [error localizedDescription]);
+        return nil;
+    }
+    
+    NSMutableDictionary* objectIDs = [NSMutableDictionary dictionaryWithCapacity:[rows count]];
+    for (NSDictionary* row in rows) {
+        id lookupValue = RKManagedObjectStorePrimaryKeyLookupValue([row objectForKey:[attribute name]]);
+        if (lookupValue) {
+            [objectIDs setObject:[row objectForKey:@"objectID"] forKey:lookupValue];
+        }
+    }
+    
+    return objectIDs;
+}
+
+// Returns the object created on this thread or the object ID indexed for the lookup value, NSNull
+// if it is known not to exist, or nil if it has yet to be fetched
+- (id)objectIDForEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute lookupValue:(id)lookupValue {
+    NSManagedObject* unsavedObject = [[self unsavedObjectsForEntity:entity] objectForKey:lookupValue];
+    if (unsavedObject) {
+        return unsavedObject;
+    }
+    
+    return [_primaryKeyIndex objectIDForEntity:entity primaryKeyAttribute:primaryKeyAttribute lookupValue:lookupValue];
+}
+
+- (void)prefetchInstancesOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute values:(id<NSFastEnumeration>)primaryKeyValues {
+    NSAssert(entity, @"Cannot prefetch managed objects without an entity");
+    NSAssert(primaryKeyAttribute, @"Cannot prefetch managed objects without a primary key attribute");
+    NSAttributeDescription* attribute = [[entity attributesByName] objectForKey:primaryKeyAttribute];
+    NSAssert2(attribute, @"Entity %@ has no primary key attribute named %@", entity.name, primaryKeyAttribute);
+    
+    if ([self primaryKeyLookupForEntity:entity] == RKManagedObjectStorePrimaryKeyLookupWholeEntity &&
+        NO == [_primaryKeyIndex hasLoadedEntity:entity primaryKeyAttribute:primaryKeyAttribute]) {
+        NSDictionary* objectIDs = [self fetchObjectIDsOfEntity:entity withPrimaryKeyAttribute:attribute predicate:nil];
+        if (objectIDs) {
+            RKLogInfo(@"Adding all %lu %@ objects to the primary key index", (unsigned long) [objectIDs count], entity.name);
+            [_primaryKeyIndex addObjectIDs:objectIDs forEntity:entity primaryKeyAttribute:primaryKeyAttribute loadedEntity:YES];
+        }
+    }
+    
+    NSMutableDictionary* unresolvedValues = [NSMutableDictionary dictionary];
+    for (id primaryKeyValue in primaryKeyValues) {
+        id lookupValue = RKManagedObjectStorePrimaryKeyLookupValue(primaryKeyValue);
+        if (lookupValue && nil == [self objectIDForEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute lookupValue:lookupValue]) {
+            [unresolvedValues setObject:RKManagedObjectStorePrimaryKeyFetchValue(primaryKeyValue, [attribute attributeType]) forKey:lookupValue];
+        }
+    }
+    if ([unresolvedValues count] == 0) {
+        return;
+    }
+    
+    // Fetch just the key and object ID of each row: the objects are faulted in when looked up
+    NSArray* lookupValues = [unresolvedValues allKeys];
+    NSUInteger fetchedCount = 0;
+    for (NSUInteger location = 0; location < [lookupValues count]; location += RKManagedObjectStorePrimaryKeyFetchBatchSize) {
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        NSRange range = NSMakeRange(location, MIN(RKManagedObjectStorePrimaryKeyFetchBatchSize, [lookupValues count] - location));
+        NSArray* batch = [lookupValues subarrayWithRange:range];
+        NSPredicate* predicate = [NSPredicate predicateWithFormat:@"%K IN %@", primaryKeyAttribute, [unresolvedValues objectsForKeys:batch notFoundMarker:[NSNull null]]];
+        NSDictionary* fetchedObjectIDs = [self fetchObjectIDsOfEntity:entity withPrimaryKeyAttribute:attribute predicate:predicate];
+        if (nil == fetchedObjectIDs) {
+            // Leave the batch unresolved so that each lookup falls back to its own fetch
+            [pool drain];
+            continue;
         }
         
-        [entityCache setObject:dictionary forKey:entityName];
+        NSMutableDictionary* objectIDs = [NSMutableDictionary dictionaryWithCapacity:[batch count]];
+        for (id lookupValue in batch) {
+            [objectIDs setObject:[NSNull null] forKey:lookupValue];
+        }
+        [objectIDs addEntriesFromDictionary:fetchedObjectIDs];
+        [_primaryKeyIndex addObjectIDs:objectIDs forEntity:entity primaryKeyAttribute:primaryKeyAttribute loadedEntity:NO];
+        fetchedCount += [fetchedObjectIDs count];
+        [pool drain];
     }
     
-    NSMutableDictionary* dictionary = [entityCache objectForKey:entityName];
-    NSAssert1(dictionary, @"Thread local cache of %@ objects should not be nil", entityName);
-    object = [dictionary objectForKey:lookupValue];
+    RKLogDebug(@"Prefetched %lu of %lu %@ objects by primary key to the primary key index",
+               (unsigned long) fetchedCount, (unsigned long) [lookupValues count], entity.name);
+}
+
+- (NSDictionary*)findInstancesOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute values:(id<NSFastEnumeration>)primaryKeyValues {
+    [self prefetchInstancesOfEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute values:primaryKeyValues];
+    
+    NSMutableDictionary* objects = [NSMutableDictionary dictionary];
+    for (id primaryKeyValue in primaryKeyValues) {
+        id lookupValue = RKManagedObjectStorePrimaryKeyLookupValue(primaryKeyValue);
+        id cachedValue = lookupValue ? [self objectIDForEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute lookupValue:lookupValue] : nil;
+        if ([cachedValue isKindOfClass:[NSManagedObjectID class]]) {
+            cachedValue = [self.managedObjectContext objectWithID:cachedValue];
+        }
+        if ([cachedValue isKindOfClass:[NSManagedObject class]]) {
+            [objects setObject:cachedValue forKey:primaryKeyValue];
+        }
+    }
+    
+    return objects;
+}
+
+- (NSManagedObject*)findOrCreateInstanceOfEntity:(NSEntityDescription*)entity withPrimaryKeyAttribute:(NSString*)primaryKeyAttribute andValue:(id)primaryKeyValue {
+    NSAssert(entity, @"Cannot instantiate managed object without a target class");
+    NSAssert(primaryKeyAttribute, @"Cannot find existing managed object instance without a primary key attribute");
+    NSAssert(primaryKeyValue, @"Cannot find existing managed object by primary key without a value");
+    
+    id lookupValue = RKManagedObjectStorePrimaryKeyLookupValue(primaryKeyValue);
+    id cachedValue = [self objectIDForEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute lookupValue:lookupValue];
+    if (nil == cachedValue) {
+        [self prefetchInstancesOfEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute values:[NSArray arrayWithObject:primaryKeyValue]];
+        cachedValue = [self objectIDForEntity:entity withPrimaryKeyAttribute:primaryKeyAttribute lookupValue:lookupValue];
+    }
+    
+    NSManagedObject* object = nil;
+    if ([cachedValue isKindOfClass:[NSManagedObjectID class]]) {
+        object = [self.managedObjectContext objectWithID:cachedValue];
+    } else if ([cachedValue isKindOfClass:[NSManagedObject class]]) {
+        object = cachedValue;
+    }
     
     if (object == nil) {
         object = [[[NSManagedObject alloc] initWithEntity:entity insertIntoManagedObjectContext:self.managedObjectContext] autorelease];
-        [dictionary setObject:object forKey:lookupValue];
+        [[self unsavedObjectsForEntity:entity] setObject:object forKey:lookupValue];
     }
         
 	return object;
@@ -426,4 +805,25 @@ static NSString* const RKManagedObjectStoreThreadDictionaryEntityCacheKey = @"RK
     return cachedObjects;
 }
 
+- (NSSet*)objectIDsForResourcePath:(NSString*)resourcePath {
+    if (nil == self.managedObjectCache) {
+        return nil;
+    }
+    
+    NSMutableSet* objectIDs = [NSMutableSet set];
+    for (NSFetchRequest* cacheFetchRequest in [self.managedObjectCache fetchRequestsForResourcePath:resourcePath]) {
+        NSFetchRequest* fetchRequest = [[cacheFetchRequest copy] autorelease];
+        [fetchRequest setResultType:NSManagedObjectIDResultType];
+        NSError* error = nil;
+        NSArray* fetchedObjectIDs = [self.managedObjectContext executeFetchRequest:fetchRequest error:&error];
+        if (fetchedObjectIDs) {
+            [objectIDs addObjectsFromArray:fetchedObjectIDs];
+        } else {
+            RKLogError(@"Failed to fetch object IDs for resource path '%@': %@", resourcePath, [error localizedDescription]);
+        }
+    }
+    
+    return objectIDs;
+}
+
 @end
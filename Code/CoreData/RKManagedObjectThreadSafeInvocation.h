@@ -23,16 +23,27 @@
 @interface RKManagedObjectThreadSafeInvocation : NSInvocation {
     NSMutableDictionary* _argumentKeyPaths;
     RKManagedObjectStore* _objectStore;
+    NSArray* _relationshipKeyPathsForPrefetching;
+    NSMutableArray* _serializedCollections;
 }
 
 @property (nonatomic, retain) RKManagedObjectStore* objectStore;
 
+// Relationship key paths prefetched along with the objects materialized on the main thread
+@property (nonatomic, retain) NSArray* relationshipKeyPathsForPrefetching;
+
 + (RKManagedObjectThreadSafeInvocation*)invocationWithMethodSignature:(NSMethodSignature*)methodSignature;
 - (void)setManagedObjectKeyPaths:(NSSet*)keyPaths forArgument:(NSInteger)index;
 - (void)invokeOnMainThread;
 
+// Blocks the calling thread until the invocation has been performed when waitUntilDone is YES,
+// after the main thread has performed every invocation already pending on RKMainThreadInvocationQueue
+- (void)invokeOnMainThreadWaitUntilDone:(BOOL)waitUntilDone;
+
 // Private
 - (void)serializeManagedObjectsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths;
 - (void)deserializeManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths;
+- (void)collectManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths intoSet:(NSMutableSet*)objectIDs;
+- (void)deserializeManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths usingObjects:(NSDictionary*)objectsByID;
 
 @end
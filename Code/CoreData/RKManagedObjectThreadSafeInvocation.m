@@ -19,10 +19,12 @@
 //
 
 #import "RKManagedObjectThreadSafeInvocation.h"
+#import "RKMainThreadInvocationQueue.h"
 
 @implementation RKManagedObjectThreadSafeInvocation
 
 @synthesize objectStore = _objectStore;
+@synthesize relationshipKeyPathsForPrefetching = _relationshipKeyPathsForPrefetching;
 
 + (RKManagedObjectThreadSafeInvocation*)invocationWithMethodSignature:(NSMethodSignature*)methodSignature {
     return (RKManagedObjectThreadSafeInvocation*) [super invocationWithMethodSignature:methodSignature];
@@ -37,13 +39,29 @@
     [_argumentKeyPaths setObject:keyPaths forKey:argumentIndex];
 }
 
+// Returns YES if the value is a collection whose members are serialized individually
+static BOOL RKManagedObjectThreadSafeInvocationIsCollection(id value) {
+    return [value isKindOfClass:[NSArray class]] || [value isKindOfClass:[NSSet class]] || [value respondsToSelector:@selector(allObjects)];
+}
+
+// Returns an empty mutable collection of the same kind as the collection
+static id RKManagedObjectThreadSafeInvocationNewCollection(id collection) {
+    if ([collection isKindOfClass:[NSArray class]]) {
+        return [[NSMutableArray alloc] initWithCapacity:[collection count]];
+    } else if ([collection isKindOfClass:[NSSet class]]) {
+        return [[NSMutableSet alloc] initWithCapacity:[collection count]];
+    }
+    
+    return [[[[[collection class] alloc] init] autorelease] mutableCopy];
+}
+
 - (void)serializeManagedObjectsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths {
     for (NSString* keyPath in keyPaths) {
         id value = [argument valueForKeyPath:keyPath];
         if ([value isKindOfClass:[NSManagedObject class]]) {
             [argument setValue:[(NSManagedObject*)value objectID] forKeyPath:keyPath];
-        } else if ([value respondsToSelector:@selector(allObjects)]) {
-            id collection = [[[[[value class] alloc] init] autorelease] mutableCopy];
+        } else if (RKManagedObjectThreadSafeInvocationIsCollection(value)) {
+            id collection = RKManagedObjectThreadSafeInvocationNewCollection(value);
             for (id subObject in value) {
                 if ([subObject isKindOfClass:[NSManagedObject class]]) {
                     [collection addObject:[(NSManagedObject*)subObject objectID]];
@@ -52,42 +70,93 @@
                 }
             }
             
-			if (collection)
+			if (collection) {
 				[argument setValue:collection forKeyPath:keyPath];
+                
+                // The collection belongs to the invocation, so its object IDs are replaced in place on the main thread
+                if (nil == _serializedCollections) {
+                    _serializedCollections = [[NSMutableArray alloc] init];
+                }
+                [_serializedCollections addObject:collection];
+            }
             [collection release];
         }
     }
 }
 
-- (void)deserializeManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths {   
+- (void)collectManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths intoSet:(NSMutableSet*)objectIDs {
     for (NSString* keyPath in keyPaths) {
         id value = [argument valueForKeyPath:keyPath];
         if ([value isKindOfClass:[NSManagedObjectID class]]) {
-            //NSAssert(self.objectStore, @"Object store cannot be nil");
-            NSManagedObject* managedObject = [self.objectStore objectWithID:(NSManagedObjectID*)value];
-            //NSAssert(managedObject, @"Expected managed object for ID %@, got nil", value);
+            [objectIDs addObject:value];
+        } else if (RKManagedObjectThreadSafeInvocationIsCollection(value)) {
+            for (id subObject in value) {
+                if ([subObject isKindOfClass:[NSManagedObjectID class]]) {
+                    [objectIDs addObject:subObject];
+                }
+            }
+        }
+    }
+}
+
+- (void)deserializeManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths usingObjects:(NSDictionary*)objectsByID {
+    for (NSString* keyPath in keyPaths) {
+        id value = [argument valueForKeyPath:keyPath];
+        if ([value isKindOfClass:[NSManagedObjectID class]]) {
+            NSManagedObject* managedObject = [objectsByID objectForKey:value];
 			if (managedObject)
 				[argument setValue:managedObject forKeyPath:keyPath];
-        } else if ([value respondsToSelector:@selector(allObjects)]) {
-            id collection = [[[[[value class] alloc] init] autorelease] mutableCopy];
+			else if ([argument isKindOfClass:[NSMutableDictionary class]])
+				[argument setValue:nil forKeyPath:keyPath];
+        } else if ([value isKindOfClass:[NSMutableArray class]] && [_serializedCollections indexOfObjectIdenticalTo:value] != NSNotFound) {
+            NSMutableArray* array = (NSMutableArray*)value;
+            for (NSInteger index = [array count] - 1; index >= 0; index--) {
+                id subObject = [array objectAtIndex:index];
+                if ([subObject isKindOfClass:[NSManagedObjectID class]]) {
+                    NSManagedObject* managedObject = [objectsByID objectForKey:subObject];
+                    if (managedObject) {
+                        [array replaceObjectAtIndex:index withObject:managedObject];
+                    } else {
+                        [array removeObjectAtIndex:index];
+                    }
+                }
+            }
+        } else if (RKManagedObjectThreadSafeInvocationIsCollection(value)) {
+            NSMutableArray* objects = [NSMutableArray arrayWithCapacity:[value count]];
             for (id subObject in value) {
                 if ([subObject isKindOfClass:[NSManagedObjectID class]]) {
-                    NSManagedObject* managedObject = [self.objectStore objectWithID:(NSManagedObjectID*)subObject];
+                    NSManagedObject* managedObject = [objectsByID objectForKey:subObject];
 					if (managedObject)
-						[collection addObject:managedObject];
+						[objects addObject:managedObject];
                 } else {
 					if (subObject)
-						[collection addObject:subObject];
+						[objects addObject:subObject];
                 }
             }
             
-			if (collection)
-				[argument setValue:collection forKeyPath:keyPath];
-            [collection release];
+            if ([value isKindOfClass:[NSMutableSet class]] && [_serializedCollections indexOfObjectIdenticalTo:value] != NSNotFound) {
+                [value removeAllObjects];
+                [value addObjectsFromArray:objects];
+            } else {
+                id collection = RKManagedObjectThreadSafeInvocationNewCollection(value);
+                for (id object in objects) {
+                    [collection addObject:object];
+                }
+                if (collection)
+                    [argument setValue:collection forKeyPath:keyPath];
+                [collection release];
+            }
         }
     }
 }
 
+- (void)deserializeManagedObjectIDsForArgument:(id)argument withKeyPaths:(NSSet*)keyPaths {
+    NSMutableSet* objectIDs = [NSMutableSet set];
+    [self collectManagedObjectIDsForArgument:argument withKeyPaths:keyPaths intoSet:objectIDs];
+    NSDictionary* objectsByID = [self.objectStore objectsByIDForObjectIDs:objectIDs prefetchingRelationshipKeyPaths:self.relationshipKeyPathsForPrefetching];
+    [self deserializeManagedObjectIDsForArgument:argument withKeyPaths:keyPaths usingObjects:objectsByID];
+}
+
 - (void)serializeManagedObjects {
     for (NSNumber* argumentIndex in _argumentKeyPaths) {        
         NSSet* managedKeyPaths = [_argumentKeyPaths objectForKey:argumentIndex];
@@ -100,12 +169,27 @@
 }
 
 - (void)deserializeManagedObjects {
+    // Materialize the objects of every argument together, so that each entity is fetched once
+    NSMutableSet* objectIDs = [NSMutableSet set];
     for (NSNumber* argumentIndex in _argumentKeyPaths) {        
         NSSet* managedKeyPaths = [_argumentKeyPaths objectForKey:argumentIndex];
         id argument = nil;
         [self getArgument:&argument atIndex:[argumentIndex intValue]];
         if (argument) {
-            [self deserializeManagedObjectIDsForArgument:argument withKeyPaths:managedKeyPaths];
+            [self collectManagedObjectIDsForArgument:argument withKeyPaths:managedKeyPaths intoSet:objectIDs];
+        }
+    }
+    if ([objectIDs count] == 0) {
+        return;
+    }
+    
+    NSDictionary* objectsByID = [self.objectStore objectsByIDForObjectIDs:objectIDs prefetchingRelationshipKeyPaths:self.relationshipKeyPathsForPrefetching];
+    for (NSNumber* argumentIndex in _argumentKeyPaths) {        
+        NSSet* managedKeyPaths = [_argumentKeyPaths objectForKey:argumentIndex];
+        id argument = nil;
+        [self getArgument:&argument atIndex:[argumentIndex intValue]];
+        if (argument) {
+            [self deserializeManagedObjectIDsForArgument:argument withKeyPaths:managedKeyPaths usingObjects:objectsByID];
         }
     }
 }
@@ -115,16 +199,31 @@
     [self invoke];
 }
 
+- (void)performInvocationOnMainThreadAfterPendingInvocations {
+    // Anything already handed to the queue, such as merges of the saves being delivered, goes first
+    [[RKMainThreadInvocationQueue sharedQueue] flush];
+    [self performInvocationOnMainThread];
+}
+
 - (void)invokeOnMainThread {
-    [self retain];
+    [self invokeOnMainThreadWaitUntilDone:NO];
+}
+
+- (void)invokeOnMainThreadWaitUntilDone:(BOOL)waitUntilDone {
     [self serializeManagedObjects];
-    [self performSelectorOnMainThread:@selector(performInvocationOnMainThread) withObject:nil waitUntilDone:YES];
-    [self release];
+    [self retainArguments];
+    if (waitUntilDone) {
+        [self performSelectorOnMainThread:@selector(performInvocationOnMainThreadAfterPendingInvocations) withObject:nil waitUntilDone:YES];
+    } else {
+        [[RKMainThreadInvocationQueue sharedQueue] performSelector:@selector(performInvocationOnMainThread) onTarget:self withObject:nil];
+    }
 }
 
 - (void)dealloc {
     [_argumentKeyPaths release];
     [_objectStore release];
+    [_relationshipKeyPathsForPrefetching release];
+    [_serializedCollections release];
     [super dealloc];
 }
 
@@ -25,5 +25,9 @@
 #import "RKRequestSerializable.h"
 #import "RKReachabilityObserver.h"
 #import "RKRequestQueue.h"
+#import "RKRequestTimeoutWheel.h"
+#import "RKRequestMetrics.h"
+#import "RKRequestMetricsCollector.h"
+#import "RKNetworkThread.h"
 #import "RKNotifications.h"
 #import "RKOAuthClient.h"
@@ -0,0 +1,43 @@
+//
+//  RKNetworkThread.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A long-lived thread with its own run loop for driving NSURLConnection.
+
+ Request queues configured with usesNetworkThread schedule their connections and
+ perform their bookkeeping on this thread, so a busy main thread does not hold up
+ reading data off the network. Delegate callbacks are still delivered on the main thread.
+
+ @see [RKRequestQueue usesNetworkThread]
+ */
+@interface RKNetworkThread : NSObject
+
+/**
+ Returns the network thread, starting it if necessary
+ */
++ (NSThread *)sharedThread;
+
+/**
+ Returns YES when invoked on the network thread. Never starts the thread.
+ */
++ (BOOL)isNetworkThread;
+
+@end
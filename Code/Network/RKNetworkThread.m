@@ -0,0 +1,86 @@
+//
+//  RKNetworkThread.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKNetworkThread.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetwork
+
+static NSThread* sharedThread = nil;
+static NSCondition* sharedThreadStartedCondition = nil;
+static BOOL sharedThreadStarted = NO;
+
+@interface RKNetworkThread (Private)
++ (void)networkThreadMain:(NSCondition*)startedCondition;
+@end
+
+@implementation RKNetworkThread
+
++ (void)initialize {
+    if (self == [RKNetworkThread class]) {
+        sharedThreadStartedCondition = [NSCondition new];
+    }
+}
+
++ (NSThread*)sharedThread {
+    [sharedThreadStartedCondition lock];
+    if (nil == sharedThread) {
+        sharedThread = [[NSThread alloc] initWithTarget:self selector:@selector(networkThreadMain:) object:sharedThreadStartedCondition];
+        [sharedThread setName:@"org.restkit.network"];
+        [sharedThread start];
+
+        // Messages cannot be performed on the thread until its run loop is up
+        while (NO == sharedThreadStarted) {
+            [sharedThreadStartedCondition wait];
+        }
+        RKLogDebug(@"Started network thread %@", sharedThread);
+    }
+    [sharedThreadStartedCondition unlock];
+
+    return sharedThread;
+}
+
++ (BOOL)isNetworkThread {
+    return sharedThread != nil && [NSThread currentThread] == sharedThread;
+}
+
++ (void)networkThreadMain:(NSCondition*)startedCondition {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+    // A port keeps the run loop alive while there are no connections scheduled on it
+    NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+    [runLoop addPort:[NSMachPort port] forMode:NSDefaultRunLoopMode];
+
+    [startedCondition lock];
+    sharedThreadStarted = YES;
+    [startedCondition broadcast];
+    [startedCondition unlock];
+
+    [pool drain];
+
+    while (YES) {
+        pool = [[NSAutoreleasePool alloc] init];
+        [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+        [pool drain];
+    }
+}
+
+@end
@@ -31,6 +31,7 @@
 extern NSString* const RKRequestSentNotification;
 extern NSString* const RKRequestDidLoadResponseNotification;
 extern NSString* const RKRequestDidLoadResponseNotificationUserInfoResponseKey;
+extern NSString* const RKRequestDidLoadResponseNotificationUserInfoMetricsKey;
 extern NSString* const RKRequestDidFailWithErrorNotification;
 extern NSString* const RKRequestDidFailWithErrorNotificationUserInfoErrorKey;
 extern NSString* const RKServiceDidBecomeUnavailableNotification;
@@ -25,4 +25,5 @@ NSString* const RKRequestDidFailWithErrorNotification = @"RKRequestDidFailWithEr
 NSString* const RKRequestDidFailWithErrorNotificationUserInfoErrorKey = @"error";
 NSString* const RKRequestDidLoadResponseNotification = @"RKRequestDidLoadResponseNotification";
 NSString* const RKRequestDidLoadResponseNotificationUserInfoResponseKey = @"response";
+NSString* const RKRequestDidLoadResponseNotificationUserInfoMetricsKey = @"metrics";
 NSString* const RKServiceDidBecomeUnavailableNotification = @"RKServiceDidBecomeUnavailableNotification";
\ No newline at end of file
@@ -35,6 +35,8 @@
 	NSUInteger _length;
 	NSUInteger _footerLength;
 	NSUInteger _currentPart;
+    BOOL _fingerprintsFileAttachments;
+    NSUInteger _mutationCount;
 }
 
 /**
@@ -42,6 +44,24 @@
  */
 @property (nonatomic, readonly) NSMutableArray *attachments;
 
+/**
+ When YES, attached files contribute a fingerprint of their path, size and modification date
+ to the MD5 checksum instead of a digest of their full contents. Enable this when attaching
+ large files to cacheable requests, so that computing the request's cache key does not read
+ every attached file.
+ 
+ **Default**: NO
+ 
+ @see [RKParamsAttachment fingerprint]
+ */
+@property (nonatomic, assign) BOOL fingerprintsFileAttachments;
+
+/**
+ The number of times the params have been mutated by adding an attachment or changing
+ fingerprintsFileAttachments. Used to tell whether a checksum computed earlier is still current.
+ */
+@property (nonatomic, readonly) NSUInteger mutationCount;
+
 /**
  Returns an empty params object ready for population
  */
@@ -114,6 +134,8 @@
 
 /**
  Return a composite MD5 checksum value for all attachments
+ 
+ @see fingerprintsFileAttachments
  */
 - (NSString *)MD5;
 
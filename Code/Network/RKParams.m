@@ -38,6 +38,9 @@ NSString* const kRKStringBoundary = @"0xKhTmLbOuNdArY";
 
 @implementation RKParams
 
+@synthesize fingerprintsFileAttachments = _fingerprintsFileAttachments;
+@synthesize mutationCount = _mutationCount;
+
 + (RKParams*)params {
 	RKParams* params = [[[RKParams alloc] init] autorelease];
 	return params;
@@ -85,10 +88,18 @@ NSString* const kRKStringBoundary = @"0xKhTmLbOuNdArY";
 	RKParamsAttachment *attachment = [[RKParamsAttachment alloc] initWithName:param value:value];
 	[_attachments addObject:attachment];
 	[attachment release];
+    _mutationCount++;
 	
 	return attachment;
 }
 
+- (void)setFingerprintsFileAttachments:(BOOL)fingerprintsFileAttachments {
+    if (fingerprintsFileAttachments != _fingerprintsFileAttachments) {
+        _fingerprintsFileAttachments = fingerprintsFileAttachments;
+        _mutationCount++;
+    }
+}
+
 - (NSDictionary *)dictionaryOfPlainTextParams {
     NSMutableDictionary *result = [NSMutableDictionary dictionary];
     for (RKParamsAttachment *attachment in _attachments)
@@ -101,6 +112,7 @@ NSString* const kRKStringBoundary = @"0xKhTmLbOuNdArY";
 	RKParamsAttachment *attachment = [[RKParamsAttachment alloc] initWithName:param file:filePath];
 	[_attachments addObject:attachment];
 	[attachment release];
+    _mutationCount++;
 	
 	return attachment;
 }
@@ -109,6 +121,7 @@ NSString* const kRKStringBoundary = @"0xKhTmLbOuNdArY";
 	RKParamsAttachment *attachment = [[RKParamsAttachment alloc] initWithName:param data:data];
 	[_attachments addObject:attachment];
 	[attachment release];
+    _mutationCount++;
 	
 	return attachment;
 }
@@ -261,7 +274,8 @@ NSString* const kRKStringBoundary = @"0xKhTmLbOuNdArY";
 - (NSString *)MD5 {
     NSMutableString *attachmentsMD5 = [[NSMutableString new] autorelease];
     for (RKParamsAttachment *attachment in self.attachments) {
-        [attachmentsMD5 appendString:[attachment MD5]];
+        NSString *attachmentMD5 = _fingerprintsFileAttachments ? [attachment fingerprint] : [attachment MD5];
+        [attachmentsMD5 appendString:attachmentMD5];
     }
     
     return [attachmentsMD5 MD5];
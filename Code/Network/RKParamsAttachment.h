@@ -40,6 +40,9 @@
 	NSUInteger		_length;
 	NSUInteger		_delivered;
     id<NSObject>    _value;
+    NSString        *_MD5;
+    unsigned long long _MD5FileSize;
+    NSTimeInterval  _MD5FileModificationTime;
 }
 
 /**
@@ -109,7 +112,20 @@
  Calculate and return an MD5 checksum for the body of this attachment. This works
  for simple values, NSData structures in memory, or by efficiently streaming a file
  and calculating an MD5.
+ 
+ The checksum is calculated once. Checksums of attached files are only recalculated
+ when the size or modification date of the file changes.
  */
 - (NSString *)MD5;
 
+/**
+ Returns a cheap checksum identifying the body of this attachment. For attached files this is
+ calculated from the path, size and modification date of the file rather than its contents,
+ so it is constant time regardless of the size of the file. For all other attachments it is
+ the MD5 of the body.
+ 
+ @see [RKParams fingerprintsFileAttachments]
+ */
+- (NSString *)fingerprint;
+
 @end
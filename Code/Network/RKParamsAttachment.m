@@ -21,6 +21,7 @@
 #import "RKParamsAttachment.h"
 #import "RKLog.h"
 #import "NSData+MD5.h"
+#import "NSString+MD5.h"
 #import "FileMD5Hash.h"
 #import "NSString+RestKit.h"
 
@@ -109,6 +110,7 @@ extern NSString* const kRKStringBoundary;
     [_filePath release];
     [_fileName release];
     [_MIMEType release];
+    [_MD5 release];
 
     [_MIMEHeader release];
     _MIMEHeader = nil;
@@ -209,15 +211,39 @@ extern NSString* const kRKStringBoundary;
 // NOTE: Cannot handle MD5 for files. We don't want to read the contents into memory
 - (NSString *)MD5 {
     if (_body) {
-        return [_body MD5];
+        if (! _MD5) {
+            _MD5 = [[_body MD5] retain];
+        }
+        return _MD5;
     } else if (_filePath) {
-        CFStringRef fileAttachmentMD5 = FileMD5HashCreateWithPath((CFStringRef)_filePath, 
-                                                                  FileHashDefaultChunkSizeForReadingData);
-        return [(NSString *)fileAttachmentMD5 autorelease];
+        // Only stream the file through the digest again if it has changed since it was last hashed
+        NSDictionary* attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:_filePath error:nil];
+        unsigned long long fileSize = [attributes fileSize];
+        NSTimeInterval modificationTime = [[attributes fileModificationDate] timeIntervalSinceReferenceDate];
+        if (! _MD5 || fileSize != _MD5FileSize || modificationTime != _MD5FileModificationTime) {
+            CFStringRef fileAttachmentMD5 = FileMD5HashCreateWithPath((CFStringRef)_filePath, 
+                                                                      FileHashDefaultChunkSizeForReadingData);
+            [_MD5 release];
+            _MD5 = (NSString *)fileAttachmentMD5;
+            _MD5FileSize = fileSize;
+            _MD5FileModificationTime = modificationTime;
+        }
+        return [[_MD5 retain] autorelease];
     } else {
         RKLogWarning(@"Failed to generate MD5 for attachment: unknown data type.");
         return nil;
     }
 }
 
+- (NSString *)fingerprint {
+    if (_filePath) {
+        NSDictionary* attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:_filePath error:nil];
+        NSString* fingerprint = [NSString stringWithFormat:@"%@-%llu-%f", _filePath, [attributes fileSize],
+                                 [[attributes fileModificationDate] timeIntervalSinceReferenceDate]];
+        return [fingerprint MD5];
+    }
+    
+    return [self MD5];
+}
+
 @end
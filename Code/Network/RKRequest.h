@@ -26,7 +26,7 @@
 #import <CoreData/CoreData.h>
 #import "RKRequestSerializable.h"
 
-@class RKRequestCache;
+@class RKRequestCache, RKRequestTimeoutWheel, RKRequestMetrics;
 
 /**
  * HTTP methods for requests
@@ -52,7 +52,9 @@ typedef enum {
 	// Load from the cache if we encounter an error
     RKRequestCachePolicyLoadOnError = 1 << 1,
 
-	// Load from the cache if we have data stored and the server returns a 304 (not modified) response
+	// Load from the cache if we have data stored and the server returns a 304 (not modified) response.
+    // Requests are made conditional with the ETag (If-None-Match) and Last-Modified (If-Modified-Since)
+    // of the cached response
     RKRequestCachePolicyEtag = 1 << 2,
     
     // Load from the cache if we have data stored
@@ -60,6 +62,11 @@ typedef enum {
     
     // Load from the cache if we are within the timeout window
     RKRequestCachePolicyTimeout = 1 << 4,
+    
+    // Load from the cache if we have data stored, revalidating it in the background once it has expired
+    // and loading again if the content has changed. Expiry is determined by the Cache-Control and Expires
+    // headers of the cached response, falling back to the timeout window
+    RKRequestCachePolicyStaleWhileRevalidate = 1 << 5,
 
     RKRequestCachePolicyDefault = RKRequestCachePolicyEtag | RKRequestCachePolicyTimeout
 } RKRequestCachePolicy;
@@ -121,7 +128,19 @@ typedef enum {
     NSTimeInterval _cacheTimeoutInterval;
     RKRequestQueue *_queue;
     RKReachabilityObserver *_reachabilityObserver;
-    NSTimer *_timeoutTimer;
+    NSTimeInterval _idleTimeoutInterval;
+    NSTimeInterval _totalTimeoutInterval;
+    RKRequestTimeoutWheel *_timeoutWheel;
+    RKRequestMetrics *_metrics;
+    BOOL _loadingOnNetworkThread;
+    BOOL _URLRequestPrepared;
+    BOOL _retainedForNetworkThread;
+    NSString *_cacheKey;
+    NSUInteger _cacheKeyParamsMutationCount;
+    NSDictionary *_cacheKeyParamsSnapshot;
+    BOOL _needsRevalidation;
+    BOOL _revalidating;
+    RKRequestQueue *_revalidationQueue;
     
     #if TARGET_OS_IPHONE
     RKRequestBackgroundPolicy _backgroundPolicy;
@@ -192,6 +211,40 @@ typedef enum {
  */
 @property (nonatomic, assign) NSTimeInterval timeoutInterval;
 
+/**
+ * The interval within which the request should be cancelled if no data
+ * has been received since the previous chunk. The deadline is pushed back
+ * each time data arrives. A value of zero disables the idle timeout.
+ *
+ * @default 0
+ */
+@property (nonatomic, assign) NSTimeInterval idleTimeoutInterval;
+
+/**
+ * The interval within which the request must complete, measured from the
+ * time it was dispatched. A value of zero disables the total timeout.
+ *
+ * @default 0
+ */
+@property (nonatomic, assign) NSTimeInterval totalTimeoutInterval;
+
+/**
+ * The timeout wheel tracking the deadlines of this request while it is loading.
+ * Requests sent through a queue use the queue's wheel, otherwise the default wheel is used.
+ *
+ * @see RKRequestTimeoutWheel
+ */
+@property (nonatomic, readonly) RKRequestTimeoutWheel *timeoutWheel;
+
+/**
+ * Timestamps recorded as the request moves through the queue, the network, the cache
+ * and (for object loaders) parsing, mapping and saving. A fresh metrics object is
+ * created each time the request is reset.
+ *
+ * @see RKRequestMetrics
+ */
+@property (nonatomic, readonly) RKRequestMetrics *metrics;
+
 /**
  * The policy to take on transition to the background (iOS 4.x and higher only)
  *
@@ -280,7 +333,13 @@ typedef enum {
  in the cache.
  
  The cacheKey is an MD5 value computed by hashing a combination of the destination
- URL, the HTTP verb, and the request body (if possible)
+ URL, the HTTP verb, and the request body (if possible). It is computed once and
+ recomputed after the URL, method or params of the request are assigned, or after
+ RKParams or dictionary params are mutated in place. Params of any other type are
+ rehashed every time the key is requested.
+ 
+ Bodies are hashed as raw bytes. RKParams contribute their composite MD5, which reads
+ the contents of attached files unless [RKParams fingerprintsFileAttachments] is enabled.
  */
 @property (nonatomic, readonly) NSString *cacheKey;
 
@@ -318,10 +377,25 @@ typedef enum {
 /**
  * The timeout interval within which the request should not be sent
  * and the cached response should be used. Used if the cache policy
- * includes RKRequestCachePolicyTimeout
+ * includes RKRequestCachePolicyTimeout, and by RKRequestCachePolicyStaleWhileRevalidate
+ * for cached responses that did not specify their own expiration
  */
 @property (nonatomic, assign) NSTimeInterval cacheTimeoutInterval;
 
+/**
+ Returns YES while the request is revalidating a cached response in the background.
+ 
+ When the cache policy includes RKRequestCachePolicyStaleWhileRevalidate, an expired cached
+ response is delivered to the delegate immediately and the request is then sent again at
+ background priority with the cached validators. The delegate is only sent the response again
+ if its content has changed; a 304 (not modified), an identical body or a failure simply
+ refreshes or keeps the cached response. requestDidStartLoad: is not sent for the revalidation.
+ 
+ Requests sent synchronously never revalidate in the background; expired cached responses
+ are reloaded from the network instead.
+ */
+@property (nonatomic, readonly, getter = isRevalidating) BOOL revalidating;
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -390,7 +464,7 @@ typedef enum {
 - (void)cancel;
 
 /**
- * Creates a timeoutTimer to trigger the timeout method
+ * Registers the request with its timeout wheel to trigger the timeout method
  * This is mainly used so we can test that the timer is only being created once.
  */
 - (void)createTimeoutTimer;
@@ -402,8 +476,8 @@ typedef enum {
 - (void)timeout;
 
 /**
- * Invalidates the timeout timer.
- * Called by RKResponse when the NSURLConnection begins receiving data.
+ * Removes the request from its timeout wheel.
+ * Called by RKResponse when the NSURLConnection finishes or fails.
  */
 - (void)invalidateTimeoutTimer;
 
@@ -26,6 +26,7 @@
 #import "RKURL.h"
 #import "NSData+MD5.h"
 #import "NSString+MD5.h"
+#import <CommonCrypto/CommonDigest.h>
 #import "RKLog.h"
 #import "RKRequestCache.h"
 #import "GCOAuth.h"
@@ -33,6 +34,10 @@
 #import "RKReachabilityObserver.h"
 #import "RKRequestQueue.h"
 #import "RKParams.h"
+#import "RKRequestTimeoutWheel.h"
+#import "RKRequestMetrics.h"
+#import "RKNetworkThread.h"
+#import "RKRequest_Internals.h"
 
 // Set Logging Component
 #undef RKLogComponent
@@ -51,6 +56,7 @@
 @synthesize username = _username;
 @synthesize password = _password;
 @synthesize method = _method;
+@synthesize revalidating = _revalidating;
 @synthesize cachePolicy = _cachePolicy;
 @synthesize cache = _cache;
 @synthesize cacheTimeoutInterval = _cacheTimeoutInterval;
@@ -62,6 +68,9 @@
 @synthesize OAuth2RefreshToken = _OAuth2RefreshToken;
 @synthesize queue = _queue;
 @synthesize timeoutInterval = _timeoutInterval;
+@synthesize idleTimeoutInterval = _idleTimeoutInterval;
+@synthesize totalTimeoutInterval = _totalTimeoutInterval;
+@synthesize metrics = _metrics;
 @synthesize reachabilityObserver = _reachabilityObserver;
 
 #if TARGET_OS_IPHONE
@@ -110,7 +119,7 @@
 }
 
 - (void)reset {
-    if (_isLoading) {
+    if ([self isLoading]) {
         RKLogWarning(@"Request was reset while loading: %@. Canceling.", self);
         [self cancel];
     }
@@ -119,8 +128,14 @@
     [_URLRequest setCachePolicy:NSURLRequestReloadIgnoringCacheData];
     [_connection release];
     _connection = nil;
-    _isLoading = NO;
+    [self setLoading:NO];
     _isLoaded = NO;
+    _URLRequestPrepared = NO;
+    _needsRevalidation = NO;
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(revalidateCachedResponse) object:nil];
+    [self stopTrackingRevalidation];
+    [_metrics release];
+    _metrics = [RKRequestMetrics new];
 }
 
 - (void)cleanupBackgroundTask {
@@ -153,6 +168,10 @@
     _URLRequest = nil;
     [_params release];
     _params = nil;
+    [_cacheKey release];
+    _cacheKey = nil;
+    [_cacheKeyParamsSnapshot release];
+    _cacheKeyParamsSnapshot = nil;
     [_additionalHTTPHeaders release];
     _additionalHTTPHeaders = nil;
     [_username release];
@@ -174,8 +193,10 @@
     [_OAuth2RefreshToken release];
     _OAuth2RefreshToken = nil;
     [self invalidateTimeoutTimer];
-    [_timeoutTimer release];
-    _timeoutTimer = nil;
+    [_revalidationQueue release];
+    _revalidationQueue = nil;
+    [_metrics release];
+    _metrics = nil;
     
     // Cleanup a background task if there is any
     [self cleanupBackgroundTask];
@@ -306,11 +327,16 @@
         [_URLRequest setValue:authorizationString forHTTPHeaderField:@"Authorization"];
     }
     
-    if (self.cachePolicy & RKRequestCachePolicyEtag) {
+    if ((self.cachePolicy & RKRequestCachePolicyEtag) || _revalidating) {
         NSString* etag = [self.cache etagForRequest:self];
         if (etag) {
             [_URLRequest setValue:etag forHTTPHeaderField:@"If-None-Match"];
         }
+        // Many services only send Last-Modified, so validate against it as well
+        NSDate* lastModifiedDate = [self.cache lastModifiedDateForRequest:self];
+        if (lastModifiedDate) {
+            [_URLRequest setValue:[[RKRequestCache rfc1123DateFormatter] stringFromDate:lastModifiedDate] forHTTPHeaderField:@"If-Modified-Since"];
+        }
     }
 }
 
@@ -327,12 +353,53 @@
     return YES;
 }
 
+- (void)cancelConnectionOnNetworkThread:(NSURLConnection*)connection {
+    [connection cancel];
+    [self networkThreadConnectionDidFinish];
+}
+
+- (void)networkThreadConnectionDidFinish {
+    NSAssert([RKNetworkThread isNetworkThread], @"Network thread connections must be finished on the network thread");
+    if (_retainedForNetworkThread) {
+        _retainedForNetworkThread = NO;
+        [self autorelease];
+    }
+}
+
 - (void)cancelAndInformDelegate:(BOOL)informDelegate {
-	[_connection cancel];
-	[_connection release];
-	_connection = nil;
+    if (_revalidationQueue && NO == _revalidating && NO == [self isLoading]) {
+        // Only a scheduled revalidation is outstanding. The delegate already has the cached response
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(revalidateCachedResponse) object:nil];
+        [self stopTrackingRevalidation];
+        return;
+    }
+    
+    // The connection is created on the network thread while a cancel may come from any thread
+    NSURLConnection* connection = nil;
+    @synchronized(self) {
+        connection = _connection;
+        _connection = nil;
+        _isLoading = NO;
+    }
+    if (_loadingOnNetworkThread) {
+        // Connections must be cancelled on the thread whose run loop they are scheduled on
+        if ([RKNetworkThread isNetworkThread]) {
+            [self cancelConnectionOnNetworkThread:connection];
+        } else {
+            [self performSelector:@selector(cancelConnectionOnNetworkThread:) onThread:[RKNetworkThread sharedThread] withObject:connection waitUntilDone:NO];
+        }
+    } else {
+        [connection cancel];
+    }
+	[connection release];
     [self invalidateTimeoutTimer];
-	_isLoading = NO;
+    
+    if (_revalidating) {
+        // The delegate has already been sent the cached response and is not told about the revalidation
+        _isLoaded = YES;
+        [self finishRevalidation];
+        return;
+    }
     
     if (informDelegate && [_delegate respondsToSelector:@selector(requestDidCancelLoad:)]) {
         [_delegate requestDidCancelLoad:self];
@@ -365,7 +432,7 @@
 // TODO: We may want to eliminate the coupling between the request queue and individual queue instances.
 // We could factor the knowledge about the queue out of RKRequest entirely, but it will break behavior.
 - (void)send {
-    NSAssert(NO == _isLoading || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
+    NSAssert(NO == [self isLoading] || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
     if (self.queue) {
         [self.queue addRequest:self];
     } else {
@@ -373,43 +440,271 @@
     }
 }
 
+// Requests dispatched from the network thread deliver their results on the main thread
+- (void)finishLoadOnMainThread:(RKResponse*)response {
+    if ([RKNetworkThread isNetworkThread]) {
+        [self performSelectorOnMainThread:@selector(didFinishLoad:) withObject:response waitUntilDone:NO];
+    } else {
+        [self didFinishLoad:response];
+    }
+}
+
+- (void)failLoadOnMainThreadWithError:(NSError*)error {
+    if ([RKNetworkThread isNetworkThread]) {
+        [self performSelectorOnMainThread:@selector(didFailLoadWithError:) withObject:error waitUntilDone:NO];
+    } else {
+        [self didFailLoadWithError:error];
+    }
+}
+
+- (BOOL)prepareURLRequestForDispatch {
+    _URLRequestPrepared = [self prepareURLRequest];
+    return _URLRequestPrepared;
+}
+
+- (BOOL)isPreparedForDispatch {
+    return _URLRequestPrepared;
+}
+
+// Only reached by requests handed to the network thread without having been prepared beforehand.
+// Queues and revalidation prepare on the main thread before dispatching to the network thread
+- (BOOL)prepareURLRequestOnMainThread {
+    // Preparing the request may serialize objects that belong to the main thread (such as managed objects)
+    BOOL prepared = NO;
+    NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:[self methodSignatureForSelector:@selector(prepareURLRequest)]];
+    [invocation setTarget:self];
+    [invocation setSelector:@selector(prepareURLRequest)];
+    [invocation performSelectorOnMainThread:@selector(invoke) withObject:nil waitUntilDone:YES];
+    [invocation getReturnValue:&prepared];
+    
+    return prepared;
+}
+
 - (void)fireAsynchronousRequest {
     RKLogDebug(@"Sending asynchronous %@ request to URL %@.", [self HTTPMethod], [[self URL] absoluteString]);
-    if (![self prepareURLRequest]) {
+    _loadingOnNetworkThread = [RKNetworkThread isNetworkThread];
+    BOOL prepared = _URLRequestPrepared;
+    if (! prepared) {
+        prepared = _loadingOnNetworkThread ? [self prepareURLRequestOnMainThread] : [self prepareURLRequest];
+    }
+    _URLRequestPrepared = NO;
+    if (! prepared) {
         // TODO: Logging
         return;
     }
     
-    _isLoading = YES;    
+    [self setLoading:YES];    
     
-    if ([self.delegate respondsToSelector:@selector(requestDidStartLoad:)]) {
-        [self.delegate requestDidStartLoad:self];
+    if (! _revalidating && [self.delegate respondsToSelector:@selector(requestDidStartLoad:)]) {
+        if (_loadingOnNetworkThread) {
+            [self.delegate performSelectorOnMainThread:@selector(requestDidStartLoad:) withObject:self waitUntilDone:NO];
+        } else {
+            [self.delegate requestDidStartLoad:self];
+        }
     }
     
     RKResponse* response = [[[RKResponse alloc] initWithRequest:self] autorelease];
     
-    _connection = [[NSURLConnection connectionWithRequest:_URLRequest delegate:response] retain];
+    if (_loadingOnNetworkThread && NO == _retainedForNetworkThread) {
+        // The response does not retain the request, so keep it alive until the connection
+        // has finished or been cancelled on the network thread
+        [self retain];
+        _retainedForNetworkThread = YES;
+    }
+    
+    _metrics.dispatchTime = [NSDate timeIntervalSinceReferenceDate];
+    @synchronized(self) {
+        if (NO == _isLoading) {
+            // Cancelled from another thread while starting. The cancel releases the network thread's retain
+            RKLogDebug(@"Request %@ was cancelled before its connection was created", self);
+            return;
+        }
+        _connection = [[NSURLConnection connectionWithRequest:_URLRequest delegate:response] retain];
+    }
     
     [[NSNotificationCenter defaultCenter] postNotificationName:RKRequestSentNotification object:self userInfo:nil];
 }
 
 - (BOOL)shouldLoadFromCache {
+    BOOL shouldLoadFromCache = NO;
+    _metrics.cacheLookupStartTime = [NSDate timeIntervalSinceReferenceDate];
+    
     // if RKRequestCachePolicyEnabled or if RKRequestCachePolicyTimeout and we are in the timeout
     if ([self.cache hasResponseForRequest:self]) {
         if (self.cachePolicy & RKRequestCachePolicyEnabled) {
-            return YES;
+            shouldLoadFromCache = YES;
+        } else if (self.cachePolicy & RKRequestCachePolicyStaleWhileRevalidate) {
+            // Expired responses are served while they are revalidated, unless we are blocking the caller anyway
+            BOOL isFresh = [self isCachedResponseFresh];
+            shouldLoadFromCache = (isFresh || NO == _sentSynchronously);
+            _needsRevalidation = (NO == isFresh && shouldLoadFromCache);
         } else if (self.cachePolicy & RKRequestCachePolicyTimeout) {
             NSDate* date = [self.cache cacheDateForRequest:self];
             NSTimeInterval interval = [[NSDate date] timeIntervalSinceDate:date];
-            return interval <= self.cacheTimeoutInterval;
+            shouldLoadFromCache = (interval <= self.cacheTimeoutInterval);
+        }
+    }
+    
+    _metrics.cacheLookupEndTime = [NSDate timeIntervalSinceReferenceDate];
+    return shouldLoadFromCache;
+}
+
+// Determines freshness from the expiration recorded from the cached response's headers, or the cacheTimeoutInterval
+- (BOOL)isCachedResponseFresh {
+    NSDate* expirationDate = [self.cache expirationDateForRequest:self];
+    if (expirationDate) {
+        return [expirationDate timeIntervalSinceNow] > 0;
+    }
+    
+    NSDate* cacheDate = [self.cache cacheDateForRequest:self];
+    return (cacheDate && [[NSDate date] timeIntervalSinceDate:cacheDate] <= self.cacheTimeoutInterval);
+}
+
+#pragma mark - Revalidation
+
+- (void)revalidateCachedResponseIfNecessaryOnQueue:(RKRequestQueue*)queue {
+    if (_needsRevalidation) {
+        _needsRevalidation = NO;
+        // The request has left the queue by now. It is tracked by the queue until the revalidation
+        // finishes, so that cancelling the delegate's requests also cancels the revalidation
+        if (queue != _revalidationQueue) {
+            [_revalidationQueue removeRevalidatingRequest:self];
+            [_revalidationQueue release];
+            _revalidationQueue = [queue retain];
+        }
+        [_revalidationQueue addRevalidatingRequest:self];
+        // Let the delivery of the cached response unwind before going back to the network
+        [self performSelector:@selector(revalidateCachedResponse) withObject:nil afterDelay:0];
+    }
+}
+
+- (void)stopTrackingRevalidation {
+    RKRequestQueue* queue = _revalidationQueue;
+    _revalidationQueue = nil;
+    [queue removeRevalidatingRequest:self];
+    [queue release];
+}
+
+- (void)fireRevalidationRequest {
+    [self createTimeoutTimer];
+    [self fireAsynchronousRequest];
+    if (NO == [self isLoading]) {
+        // The request could not be prepared
+        _isLoaded = YES;
+        if ([RKNetworkThread isNetworkThread]) {
+            [self performSelectorOnMainThread:@selector(finishRevalidation) withObject:nil waitUntilDone:NO];
+        } else {
+            [self finishRevalidation];
+        }
+    }
+}
+
+- (void)revalidateCachedResponse {
+    if (_revalidating) {
+        return;
+    }
+    if ([self isLoading]) {
+        [self stopTrackingRevalidation];
+        return;
+    }
+    if (NO == [self shouldDispatchRequest]) {
+        RKLogTrace(@"Declined to revalidate cached response for request %@: the network is not available.", self);
+        [self stopTrackingRevalidation];
+        return;
+    }
+    
+    RKLogDebug(@"Revalidating cached response in the background for request %@", self);
+    // Nothing else holds the request once it has delivered the cached response. Released in finishRevalidation
+    [self retain];
+    _revalidating = YES;
+    _isLoaded = NO;
+    [_metrics release];
+    _metrics = [RKRequestMetrics new];
+    if ([_URLRequest respondsToSelector:@selector(setNetworkServiceType:)]) {
+        [_URLRequest setNetworkServiceType:NSURLNetworkServiceTypeBackground];
+    }
+    
+    // Revalidate on the same thread the queue dispatches its requests on, preparing here so that
+    // the network thread does not have to wait on the main thread
+    if (_revalidationQueue.usesNetworkThread && NO == [RKNetworkThread isNetworkThread]) {
+        if (NO == [self prepareURLRequestForDispatch]) {
+            _isLoaded = YES;
+            [self finishRevalidation];
+            return;
+        }
+        [self performSelector:@selector(fireRevalidationRequest) onThread:[RKNetworkThread sharedThread] withObject:nil waitUntilDone:NO];
+    } else {
+        [self fireRevalidationRequest];
+    }
+}
+
+- (void)finishRevalidation {
+    if (NO == _revalidating) {
+        return;
+    }
+    
+    _revalidating = NO;
+    if ([_URLRequest respondsToSelector:@selector(setNetworkServiceType:)]) {
+        [_URLRequest setNetworkServiceType:NSURLNetworkServiceTypeDefault];
+    }
+    [self stopTrackingRevalidation];
+    [self autorelease];
+}
+
+// Returns YES when the response confirms the cached content, in which case the delegate is not informed again
+- (BOOL)finishRevalidationWithResponse:(RKResponse*)response {
+    if (NO == _revalidating) {
+        return NO;
+    }
+    
+    [self setLoading:NO];
+    _isLoaded = YES;
+    BOOL unchanged = YES;
+    if ([response isNotModified]) {
+        NSDate* date = [NSDate date];
+        [self.cache setCacheDate:date
+                  expirationDate:[RKRequestCache expirationDateForResponseHeaders:[response allHeaderFields] fromDate:date]
+                      forRequest:self];
+    } else if ([response isSuccessful]) {
+        RKResponse* cachedResponse = [self.cache responseForRequest:self];
+        unchanged = [[cachedResponse body] isEqualToData:[response body]];
+        if (unchanged) {
+            // Replace the entry so that the expiration and validators of the new response are picked up
+            [self.cache storeResponse:response forRequest:self];
         }
+    } else {
+        RKLogWarning(@"Revalidation of cached response for %@ failed with status code %ld, continuing to use the cached response",
+                     self, (long) [response statusCode]);
+    }
+    
+    RKLogDebug(@"Revalidated cached response for request %@: %@", self, unchanged ? @"unchanged" : @"content has changed");
+    [self finishRevalidation];
+    return unchanged;
+}
+
+- (BOOL)finishRevalidationWithError:(NSError*)error {
+    if (NO == _revalidating) {
+        return NO;
     }
-    return NO;
+    
+    RKLogWarning(@"Failed to revalidate cached response for %@, continuing to use the cached response: %@", self, [error localizedDescription]);
+    [self setLoading:NO];
+    _isLoaded = YES;
+    [self finishRevalidation];
+    return YES;
 }
 
 - (RKResponse*)loadResponseFromCache {
     RKLogDebug(@"Found cached content, loading...");
-    return [self.cache responseForRequest:self];
+    NSTimeInterval lookupStartTime = [NSDate timeIntervalSinceReferenceDate];
+    RKResponse* response = [self.cache responseForRequest:self];
+    _metrics.loadedFromCache = YES;
+    if (_metrics.cacheLookupStartTime == 0) {
+        _metrics.cacheLookupStartTime = lookupStartTime;
+    }
+    _metrics.cacheLookupEndTime = [NSDate timeIntervalSinceReferenceDate];
+    
+    return response;
 }
 
 - (BOOL)shouldDispatchRequest {
@@ -421,12 +716,12 @@
 }
 
 - (void)sendAsynchronously {
-    NSAssert(NO == _isLoading || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
+    NSAssert(NO == [self isLoading] || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
     _sentSynchronously = NO;    
     if ([self shouldLoadFromCache]) {
         RKResponse* response = [self loadResponseFromCache];
-        _isLoading = YES;
-        [self didFinishLoad:response];
+        [self setLoading:YES];
+        [self finishLoadOnMainThread:response];
     } else if ([self shouldDispatchRequest]) {
         [self createTimeoutTimer];
 #if TARGET_OS_IPHONE
@@ -470,8 +765,8 @@
 	    if (_cachePolicy & RKRequestCachePolicyLoadIfOffline &&
 			[self.cache hasResponseForRequest:self]) {
 
-			_isLoading = YES;
-			[self didFinishLoad:[self loadResponseFromCache]];
+			[self setLoading:YES];
+			[self finishLoadOnMainThread:[self loadResponseFromCache]];
 
 		} else {
             RKLogError(@"Failed to send request to %@ due to unreachable network. Reachability observer = %@", [[self URL] absoluteString], self.reachabilityObserver);
@@ -480,13 +775,13 @@
     								  errorMessage, NSLocalizedDescriptionKey,
     								  nil];
     		NSError* error = [NSError errorWithDomain:RKRestKitErrorDomain code:RKRequestBaseURLOfflineError userInfo:userInfo];
-    		[self didFailLoadWithError:error];
+    		[self failLoadOnMainThreadWithError:error];
         }
 	}
 }
 
 - (RKResponse*)sendSynchronously {
-    NSAssert(NO == _isLoading || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
+    NSAssert(NO == [self isLoading] || NO == _isLoaded, @"Cannot send a request that is loading or loaded without resetting it first.");
 	NSHTTPURLResponse* URLResponse = nil;
 	NSError* error;
 	NSData* payload = nil;
@@ -495,25 +790,33 @@
 
 	if ([self shouldLoadFromCache]) {
         response = [self loadResponseFromCache];
-        _isLoading = YES;
+        [self setLoading:YES];
         [self didFinishLoad:response];
     } else if ([self shouldDispatchRequest]) {
         RKLogDebug(@"Sending synchronous %@ request to URL %@.", [self HTTPMethod], [[self URL] absoluteString]);
-        [self createTimeoutTimer];
         
         if (![self prepareURLRequest]) {
             // TODO: Logging
             return nil;
         }
+        
+        // Synchronous sends are not tracked on a timeout wheel: it ticks on the main run loop and would
+        // time the request out from the main thread while this thread is still blocked sending it
+        if (self.timeoutInterval > 0) {
+            [_URLRequest setTimeoutInterval:self.timeoutInterval];
+        }
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:RKRequestSentNotification object:self userInfo:nil];
 
-		_isLoading = YES;
+		[self setLoading:YES];
         if ([self.delegate respondsToSelector:@selector(requestDidStartLoad:)]) {
             [self.delegate requestDidStartLoad:self];
         }
         
+        _metrics.dispatchTime = [NSDate timeIntervalSinceReferenceDate];
 		payload = [NSURLConnection sendSynchronousRequest:_URLRequest returningResponse:&URLResponse error:&error];
+        _metrics.firstByteTime = _metrics.lastByteTime = [NSDate timeIntervalSinceReferenceDate];
+        _metrics.bytesReceived = [payload length];
 		if (payload != nil) error = nil;
 		
 		response = [[[RKResponse alloc] initWithSynchronousRequest:self URLResponse:URLResponse body:payload error:error] autorelease];
@@ -548,8 +851,30 @@
     [self cancelAndInformDelegate:YES];
 }
 
+- (RKRequestTimeoutWheel*)timeoutWheel {
+    @synchronized(self) {
+        if (_timeoutWheel) {
+            return [[_timeoutWheel retain] autorelease];
+        }
+    }
+    
+    return self.queue ? self.queue.timeoutWheel : [RKRequestTimeoutWheel defaultTimeoutWheel];
+}
+
 - (void)createTimeoutTimer {
-    _timeoutTimer = [NSTimer scheduledTimerWithTimeInterval:self.timeoutInterval target:self selector:@selector(timeout) userInfo:nil repeats:NO];
+    // Retain the wheel we registered with so that we unregister from the same one
+    // even if the request is moved to another queue while loading. The wheel is read
+    // from the queue each time, as the request may have moved since it was last sent
+    RKRequestTimeoutWheel* timeoutWheel = self.queue ? self.queue.timeoutWheel : [RKRequestTimeoutWheel defaultTimeoutWheel];
+    // Timers are armed on the thread that sends the request and invalidated on whichever thread cancels it
+    @synchronized(self) {
+        if (_timeoutWheel != timeoutWheel) {
+            [_timeoutWheel removeRequest:self];
+            [_timeoutWheel release];
+            _timeoutWheel = [timeoutWheel retain];
+        }
+        [_timeoutWheel addRequest:self];
+    }
 }
 
 - (void)timeout {
@@ -564,17 +889,24 @@
 }
 
 - (void)invalidateTimeoutTimer {
-    [_timeoutTimer invalidate];
-    _timeoutTimer = nil;
+    @synchronized(self) {
+        [_timeoutWheel removeRequest:self];
+        [_timeoutWheel release];
+        _timeoutWheel = nil;
+    }
 }
 
 - (void)didFailLoadWithError:(NSError*)error {
+    if ([self finishRevalidationWithError:error]) {
+        return;
+    }
+    
 	if (_cachePolicy & RKRequestCachePolicyLoadOnError &&
 		[self.cache hasResponseForRequest:self]) {
 
 		[self didFinishLoad:[self loadResponseFromCache]];
 	} else {
-		_isLoading = NO;
+		[self setLoading:NO];
 
 		if ([_delegate respondsToSelector:@selector(request:didFailLoadWithError:)]) {
 			[_delegate request:self didFailLoadWithError:error];
@@ -587,6 +919,26 @@
 	}
 }
 
+- (void)didFinishLoadFromNetworkThread:(RKResponse*)response {
+    [self invalidateTimeoutTimer];
+    if (NO == [self isLoading]) {
+        RKLogDebug(@"Discarding response for request %@: it was cancelled before the response reached the main thread", self);
+        return;
+    }
+    
+    [self didFinishLoad:response];
+}
+
+- (void)didFailLoadFromNetworkThreadWithError:(NSError*)error {
+    [self invalidateTimeoutTimer];
+    if (NO == [self isLoading]) {
+        RKLogDebug(@"Discarding error for request %@: it was cancelled before the error reached the main thread", self);
+        return;
+    }
+    
+    [self didFailLoadWithError:error];
+}
+
 - (void)updateInternalCacheDate {
     NSDate* date = [NSDate date];
     RKLogInfo(@"Updating cache date for request %@ to %@", self, date);
@@ -594,7 +946,11 @@
 }
 
 - (void)didFinishLoad:(RKResponse*)response {
-  	_isLoading = NO;
+    if ([self finishRevalidationWithResponse:response]) {
+        return;
+    }
+    
+  	[self setLoading:NO];
   	_isLoaded = YES;
     
     RKLogInfo(@"Status Code: %ld", (long) [response statusCode]);
@@ -621,11 +977,16 @@
     
     // NOTE: This notification must be posted last as the request queue releases the request when it
     // receives the notification
-    NSDictionary* userInfo = [NSDictionary dictionaryWithObject:finalResponse 
-                                                         forKey:RKRequestDidLoadResponseNotificationUserInfoResponseKey];
+    NSDictionary* userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+                              finalResponse, RKRequestDidLoadResponseNotificationUserInfoResponseKey,
+                              _metrics, RKRequestDidLoadResponseNotificationUserInfoMetricsKey,
+                              nil];
+    RKRequestQueue* queue = [[self.queue retain] autorelease];
     [[NSNotificationCenter defaultCenter] postNotificationName:RKRequestDidLoadResponseNotification 
                                                         object:self 
                                                       userInfo:userInfo];
+    
+    [self revalidateCachedResponseIfNecessaryOnQueue:queue];
 }
 
 - (BOOL)isGET {
@@ -648,8 +1009,18 @@
 	return _method == RKRequestMethodHEAD;
 }
 
+// Requests dispatched from the network thread start loading there and finish on the main thread,
+// so the loading flag is read and written under a lock
+- (void)setLoading:(BOOL)loading {
+    @synchronized(self) {
+        _isLoading = loading;
+    }
+}
+
 - (BOOL)isLoading {
-	return _isLoading;
+    @synchronized(self) {
+        return _isLoading;
+    }
 }
 
 - (BOOL)isLoaded {
@@ -657,7 +1028,7 @@
 }
 
 - (BOOL)isUnsent {
-    return _isLoading == NO && _isLoaded == NO;
+    return [self isLoading] == NO && _isLoaded == NO;
 }
 
 - (NSString*)resourcePath {
@@ -669,11 +1040,56 @@
 	return resourcePath;
 }
 
+// The cache key is memoized. Invoked whenever the URL, method or params change
+- (void)invalidateCacheKey {
+    [_cacheKey release];
+    _cacheKey = nil;
+    [_cacheKeyParamsSnapshot release];
+    _cacheKeyParamsSnapshot = nil;
+}
+
+// Params can be mutated in place after they are assigned. RKParams count their mutations and
+// dictionaries are compared against a copy taken when the key was computed. Any other params
+// can't be checked, so their key is never reused
+- (BOOL)paramsChangedSinceCacheKeyWasComputed {
+    if (nil == _params) {
+        return NO;
+    } else if ([_params isKindOfClass:[RKParams class]]) {
+        return [(RKParams *)_params mutationCount] != _cacheKeyParamsMutationCount;
+    } else if ([_params isKindOfClass:[NSDictionary class]]) {
+        return ! [_cacheKeyParamsSnapshot isEqualToDictionary:(NSDictionary *)_params];
+    }
+    
+    return YES;
+}
+
+- (void)rememberParamsForCacheKey {
+    if ([_params isKindOfClass:[RKParams class]]) {
+        _cacheKeyParamsMutationCount = [(RKParams *)_params mutationCount];
+    } else if ([_params isKindOfClass:[NSDictionary class]]) {
+        [_cacheKeyParamsSnapshot release];
+        _cacheKeyParamsSnapshot = [(NSDictionary *)_params copy];
+    }
+}
+
 - (void)setURL:(NSURL *)URL {
     [URL retain];
     [_URL release];
     _URL = URL;
     _URLRequest.URL = URL;
+    [self invalidateCacheKey];
+}
+
+- (void)setMethod:(RKRequestMethod)method {
+    _method = method;
+    [self invalidateCacheKey];
+}
+
+- (void)setParams:(NSObject<RKRequestSerializable> *)params {
+    [params retain];
+    [_params release];
+    _params = params;
+    [self invalidateCacheKey];
 }
 
 - (void)setResourcePath:(NSString *)resourcePath {
@@ -714,20 +1130,51 @@
     if (! [self isCacheable]) {
         return nil;
     }
+    if (_cacheKey) {
+        if (! [self paramsChangedSinceCacheKeyWasComputed]) {
+            return [[_cacheKey retain] autorelease];
+        }
+        [self invalidateCacheKey];
+    }
     
+    // The key is the MD5 of "<URL>-<method>", followed by "-<body>" when there is one.
     // Use [_params HTTPBody] because the URLRequest body may not have been set up yet.
-    NSString* compositeCacheKey = nil;
+    // Bodies are fed to the digest as raw bytes rather than formatted into a string first.
+    NSData* prefix = [[NSString stringWithFormat:@"%@-%d", self.URL, _method] dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* body = nil;
     if (_params) {
         if ([_params respondsToSelector:@selector(HTTPBody)]) {
-            compositeCacheKey = [NSString stringWithFormat:@"%@-%d-%@", self.URL, _method, [_params HTTPBody]];
+            body = [_params HTTPBody];
         } else if ([_params isKindOfClass:[RKParams class]]) {
-            compositeCacheKey = [NSString stringWithFormat:@"%@-%d-%@", self.URL, _method, [(RKParams *)_params MD5]];
+            body = [[(RKParams *)_params MD5] dataUsingEncoding:NSUTF8StringEncoding];
+        }
+        NSAssert(body, @"Expected a cacheKey to be generated for request %@, but got nil", self);
+    }
+    
+    CC_MD5_CTX context;
+    CC_MD5_Init(&context);
+    CC_MD5_Update(&context, [prefix bytes], (CC_LONG) [prefix length]);
+    if (body) {
+        CC_MD5_Update(&context, "-", 1);
+        const uint8_t* bytes = [body bytes];
+        NSUInteger remaining = [body length];
+        while (remaining > 0) {
+            CC_LONG chunkLength = (CC_LONG) MIN(remaining, (NSUInteger) UINT32_MAX);
+            CC_MD5_Update(&context, bytes, chunkLength);
+            bytes += chunkLength;
+            remaining -= chunkLength;
         }
-    } else {
-        compositeCacheKey = [NSString stringWithFormat:@"%@-%d", self.URL, _method];
     }
-    NSAssert(compositeCacheKey, @"Expected a cacheKey to be generated for request %@, but got nil", compositeCacheKey);
-    return [compositeCacheKey MD5];
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5_Final(digest, &context);
+    
+    NSMutableString* cacheKey = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [cacheKey appendFormat:@"%02x", digest[i]];
+    }
+    _cacheKey = [cacheKey copy];
+    [self rememberParamsForCacheKey];
+    
+    return [[_cacheKey retain] autorelease];
 }
-
 @end
@@ -20,6 +20,9 @@
 
 #import "RKRequest.h"
 #import "RKResponse.h"
+#import "RKRequestMemoryCache.h"
+
+@class RKRequestCacheIndex;
 
 /**
  * Storage policy. Determines if we clear the cache out when the app is shut down.
@@ -31,20 +34,126 @@ typedef enum {
     RKRequestCacheStoragePolicyPermanently				// Cache data permanently, until explicitly expired or flushed
 } RKRequestCacheStoragePolicy;
 
+/**
+ Eviction policy. Determines which permanently stored entries are removed first
+ when the permanent store grows past its configured limits.
+ */
+typedef enum {
+    RKRequestCacheEvictionPolicyLeastRecentlyUsed,      // Evict the entries that have gone unused the longest
+    RKRequestCacheEvictionPolicyLeastFrequentlyUsed     // Evict the entries that have been used the fewest times, oldest first
+} RKRequestCacheEvictionPolicy;
+
 /**
  Stores and retrieves cache entries for RestKit request objects.
+ 
+ The cache keeps a persistent index of its entries alongside the stores, recording the
+ validators (ETag, Last-Modified, cache date and expiration), size and usage of each one.
+ hasResponseForRequest: and the validator accessors, such as etagForRequest:, are answered from the
+ index without touching the filesystem, and the permanent store limits are enforced from
+ it without scanning the store. The index is rebuilt from the permanent store when the
+ cache is opened without one.
+ 
+ The index is loaded when the cache is opened, so a cache directory should be owned by a
+ single cache instance at a time.
  */
 @interface RKRequestCache : NSObject {
     NSString* _cachePath;
     RKRequestCacheStoragePolicy _storagePolicy;
 	NSRecursiveLock* _cacheLock;
+    RKRequestMemoryCache* _memoryCache;
+    unsigned long long _maximumPermanentStoreSize;
+    NSUInteger _maximumPermanentStoreEntryCount;
+    RKRequestCacheEvictionPolicy _evictionPolicy;
+    RKRequestCacheIndex* _index;
+    BOOL _indexSynchronizationPending;
+    NSOperationQueue* _writeQueue;
+    NSMutableDictionary* _pendingEntries;
+    NSCountedSet* _pendingRemovals;
+    BOOL _cachesParsedObjects;
 }
 
 @property (nonatomic, readonly) NSString* cachePath; // Full path to the cache
 @property (nonatomic, assign) RKRequestCacheStoragePolicy storagePolicy; // User can change storage policy.
 
+/**
+ In-memory tier holding the most recently used entries in front of the disk store.
+ Hits are answered without touching the filesystem. Entries are written through to
+ disk on store, so the memory tier can be resized or emptied at any time without
+ losing data. It is emptied automatically on memory warnings.
+ 
+ Configure the byte budget with memoryCache.capacity (zero disables the memory tier)
+ and the largest body held in memory with memoryCache.maximumBodySize.
+ */
+@property (nonatomic, readonly) RKRequestMemoryCache* memoryCache;
+
+/**
+ The number of bytes the permanent store may occupy on disk before entries are evicted.
+ When either limit is exceeded, entries are evicted according to the evictionPolicy until
+ the store is back under 90% of its limits. A value of zero places no limit on the size.
+ 
+ Permanently stored entries are kept in a two level directory tree keyed by the leading
+ characters of their cache key, so no single directory grows large.
+ 
+ **Default**: 0 (unlimited)
+ */
+@property (nonatomic, assign) unsigned long long maximumPermanentStoreSize;
+
+/**
+ The number of entries the permanent store may hold before entries are evicted.
+ A value of zero places no limit on the number of entries.
+ 
+ **Default**: 0 (unlimited)
+ */
+@property (nonatomic, assign) NSUInteger maximumPermanentStoreEntryCount;
+
+/**
+ Determines which entries are evicted first once the permanent store exceeds its limits.
+ Access times and counts are kept in the cache index and persisted each time it is compacted.
+ 
+ **Default**: RKRequestCacheEvictionPolicyLeastRecentlyUsed
+ */
+@property (nonatomic, assign) RKRequestCacheEvictionPolicy evictionPolicy;
+
+/**
+ When YES, the cache keeps a second tier holding the parsed form of cached response bodies,
+ so that loading a cached response for mapping does not have to parse the body again.
+ 
+ Parsed objects are stored next to their entry as a binary property list, falling back to a
+ keyed archive for object graphs that are not property lists (such as those containing NSNull).
+ Each one is stamped with the validator of the body it was parsed from (its ETag, Last-Modified
+ date or, failing those, its cache date and size) and is discarded once the entry is replaced.
+ Parsed objects are not counted against the permanent store limits.
+ 
+ **Default**: NO
+ */
+@property (nonatomic, assign) BOOL cachesParsedObjects;
+
+/**
+ The number of bytes occupied by the permanent store
+ */
+@property (nonatomic, readonly) unsigned long long permanentStoreSize;
+
+/**
+ The number of entries in the permanent store
+ */
+@property (nonatomic, readonly) NSUInteger permanentStoreEntryCount;
+
+/**
+ Returns a formatter for RFC 1123 dates, as used in HTTP headers. Formatters are not
+ thread-safe, so each thread is given its own; do not hand the result to another thread.
+ */
 + (NSDateFormatter*)rfc1123DateFormatter;
 
+/**
+ Returns the date after which a response with the headers must be revalidated, from its
+ Cache-Control max-age directive or, failing that, its Expires header. Responses marked
+ no-cache or no-store expire immediately. Returns nil when the headers do not say.
+ 
+ @param headers The headers of the response
+ @param date The date the response was received
+ */
++ (NSDate*)expirationDateForResponseHeaders:(NSDictionary*)headers fromDate:(NSDate*)date;
+
 - (id)initWithCachePath:(NSString*)cachePath storagePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
 
 - (NSString*)pathForRequest:(RKRequest*)request;
@@ -59,14 +168,69 @@ typedef enum {
 
 - (NSString*)etagForRequest:(RKRequest*)request;
 
+/**
+ Returns the Last-Modified date of the cached response for the request, or nil
+ if the server did not send one.
+ */
+- (NSDate*)lastModifiedDateForRequest:(RKRequest*)request;
+
 - (NSDate*)cacheDateForRequest:(RKRequest*)request;
 
+/**
+ Returns the parsed object stored for the cached response of the request, or nil when
+ cachesParsedObjects is NO or there is no parsed object for the current version of the
+ cached response.
+ */
+- (id)parsedObjectForRequest:(RKRequest*)request;
+
+/**
+ Stores the parsed form of the cached response body for the request. The parsed object must
+ have been produced from the response currently cached for the request. Does nothing unless
+ cachesParsedObjects is YES. The parsed object is serialized on the calling thread and written
+ in the background.
+ */
+- (void)storeParsedObject:(id)parsedObject forRequest:(RKRequest*)request;
+
 - (void)setCacheDate:(NSDate*)date forRequest:(RKRequest*)request;
 
+/**
+ Returns the date after which the cached response for the request must be revalidated,
+ as determined by its Cache-Control and Expires headers, or nil if the server did not say.
+ */
+- (NSDate*)expirationDateForRequest:(RKRequest*)request;
+
+/**
+ Updates the cache date and expiration date of the cached response for the request.
+ Invoked when a revalidation confirms that the cached response is still current.
+ */
+- (void)setCacheDate:(NSDate*)date expirationDate:(NSDate*)expirationDate forRequest:(RKRequest*)request;
+
 - (void)invalidateRequest:(RKRequest*)request;
 
 - (void)invalidateWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
 
 - (void)invalidateAll;
 
+/**
+ Returns the number of stored responses that have not yet been written to disk
+ */
+@property (nonatomic, readonly) NSUInteger pendingWriteCount;
+
+/**
+ Blocks until every stored response and invalidated entry has been written to or removed from disk.
+ 
+ Responses are written to disk by a background writer after storeResponse:forRequest: returns.
+ Entries waiting to be written are held in memory and served to readers in the meantime, so
+ flushing is never needed for correctness within a process. Flush before handing the cache
+ directory to other code, or when the process is about to exit; on iOS the cache flushes itself
+ when the application is backgrounded or terminated.
+ */
+- (void)flush;
+
+/**
+ Evicts permanently stored entries until the store is within its configured limits.
+ Invoked automatically after each response is stored.
+ */
+- (void)evictPermanentEntriesIfNecessary;
+
 @end
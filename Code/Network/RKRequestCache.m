@@ -19,6 +19,9 @@
 //
 
 #import "RKRequestCache.h"
+#import "RKRequestCacheEntry.h"
+#import "RKRequestCacheIndex.h"
+#import "RKRequestCacheCoding.h"
 #import "RKLog.h"
 
 // Set Logging Component
@@ -28,24 +31,103 @@
 static NSString* sessionCacheFolder = @"SessionStore";
 static NSString* permanentCacheFolder = @"PermanentStore";
 static NSString* headersExtension = @"headers";
+static NSString* parsedObjectExtension = @"parsed";
 static NSString* cacheDateHeaderKey = @"X-RESTKIT-CACHEDATE";
 NSString* cacheResponseCodeKey = @"X-RESTKIT-CACHED-RESPONSE-CODE";
 NSString* cacheMIMETypeKey = @"X-RESTKIT-CACHED-MIME-TYPE";
 NSString* cacheURLKey = @"X-RESTKIT-CACHED-URL";
 
-static NSDateFormatter* __rfc1123DateFormatter;
+static NSString* indexFileName = @"CacheIndex";
+
+// NSDateFormatter is not thread-safe, so each thread formats HTTP dates with its own instance
+static NSString* const RKRequestCacheThreadDictionaryDateFormatterKey = @"RKRequestCacheThreadDictionaryDateFormatterKey";
+
+// Spreads entries across a two level directory tree, ie. ab/cd/abcdef..., keeping directories small
+static NSString* RKRequestCacheShardedPathForKey(NSString* cacheKey) {
+    if ([cacheKey length] < 4) {
+        return cacheKey;
+    }
+    
+    return [NSString pathWithComponents:[NSArray arrayWithObjects:
+                                         [cacheKey substringToIndex:2],
+                                         [cacheKey substringWithRange:NSMakeRange(2, 2)],
+                                         cacheKey, nil]];
+}
+
+@interface RKRequestCache (Private)
+- (BOOL)isPermanentStoreLimited;
+- (void)migrateFlatPermanentStore;
+- (void)rebuildIndex;
+- (NSString*)cachePathForKey:(NSString*)cacheKey storagePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
+- (RKRequestCacheStoragePolicy)storagePolicyForCachePath:(NSString*)cachePath;
+- (RKRequestCacheIndexEntry*)indexEntryForRequest:(RKRequest*)request;
+- (void)indexEntry:(RKRequestCacheEntry*)entry atCachePath:(NSString*)cachePath;
+- (RKRequestCacheEntry*)entryAtCachePath:(NSString*)cachePath;
+- (void)removeEntryAtCachePath:(NSString*)cachePath;
+- (void)enqueueWriteForCachePath:(NSString*)cachePath;
+- (void)enqueueRemovalForCachePath:(NSString*)cachePath;
+- (void)evictPermanentEntriesExcludingKey:(NSString*)cacheKey;
+- (void)enqueueIndexSynchronization;
+- (void)setCacheDate:(NSDate*)date expirationDate:(NSDate*)expirationDate updatingExpiration:(BOOL)updateExpiration forRequest:(RKRequest*)request;
+- (NSString*)parsedObjectValidatorForIndexEntry:(RKRequestCacheIndexEntry*)indexEntry;
+@end
 
 @implementation RKRequestCache
 
 @synthesize storagePolicy = _storagePolicy;
+@synthesize memoryCache = _memoryCache;
+@synthesize maximumPermanentStoreSize = _maximumPermanentStoreSize;
+@synthesize maximumPermanentStoreEntryCount = _maximumPermanentStoreEntryCount;
+@synthesize evictionPolicy = _evictionPolicy;
+@synthesize cachesParsedObjects = _cachesParsedObjects;
 
 + (NSDateFormatter*)rfc1123DateFormatter {
-	if (__rfc1123DateFormatter == nil) {
-		__rfc1123DateFormatter = [[NSDateFormatter alloc] init];
-		[__rfc1123DateFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
-		[__rfc1123DateFormatter setDateFormat:@"EEE, dd MMM yyyy HH:mm:ss 'GMT'"];
+	NSMutableDictionary* threadDictionary = [[NSThread currentThread] threadDictionary];
+	NSDateFormatter* dateFormatter = [threadDictionary objectForKey:RKRequestCacheThreadDictionaryDateFormatterKey];
+	if (dateFormatter == nil) {
+		dateFormatter = [[NSDateFormatter alloc] init];
+		// The POSIX locale keeps English day and month names whatever the user's region settings
+		NSLocale* locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+		[dateFormatter setLocale:locale];
+		[locale release];
+		[dateFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+		[dateFormatter setDateFormat:@"EEE, dd MMM yyyy HH:mm:ss 'GMT'"];
+		[threadDictionary setObject:dateFormatter forKey:RKRequestCacheThreadDictionaryDateFormatterKey];
+		[dateFormatter release];
 	}
-	return __rfc1123DateFormatter;
+	return dateFormatter;
+}
+
++ (NSDate*)expirationDateForResponseHeaders:(NSDictionary*)headers fromDate:(NSDate*)date {
+    NSString* cacheControl = nil;
+    NSString* expires = nil;
+    for (NSString* key in headers) {
+        NSString* uppercaseKey = [key uppercaseString];
+        if ([uppercaseKey isEqualToString:@"CACHE-CONTROL"]) {
+            cacheControl = [headers objectForKey:key];
+        } else if ([uppercaseKey isEqualToString:@"EXPIRES"]) {
+            expires = [headers objectForKey:key];
+        }
+    }
+    
+    // A max-age directive takes precedence over Expires. no-cache means the response must always be revalidated
+    for (NSString* directive in [[cacheControl lowercaseString] componentsSeparatedByString:@","]) {
+        directive = [directive stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([directive isEqualToString:@"no-cache"] || [directive isEqualToString:@"no-store"]) {
+            return date;
+        } else if ([directive hasPrefix:@"max-age="]) {
+            NSTimeInterval maxAge = [[directive substringFromIndex:[@"max-age=" length]] doubleValue];
+            return [date dateByAddingTimeInterval:maxAge];
+        }
+    }
+    
+    if (expires) {
+        // An invalid Expires value, such as "0", means the response is already expired
+        NSDate* expirationDate = [[RKRequestCache rfc1123DateFormatter] dateFromString:expires];
+        return expirationDate ? expirationDate : date;
+    }
+    
+    return nil;
 }
 
 - (id)initWithCachePath:(NSString*)cachePath storagePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
@@ -53,6 +135,11 @@ static NSDateFormatter* __rfc1123DateFormatter;
 	if (self) {
 		_cachePath = [cachePath copy];
 		_cacheLock = [[NSRecursiveLock alloc] init];
+        _memoryCache = [[RKRequestMemoryCache alloc] init];
+        _pendingEntries = [[NSMutableDictionary alloc] init];
+        _pendingRemovals = [[NSCountedSet alloc] init];
+        _writeQueue = [[NSOperationQueue alloc] init];
+        [_writeQueue setMaxConcurrentOperationCount:1];
 
 		NSFileManager* fileManager = [NSFileManager defaultManager];
 		NSArray* pathArray = [NSArray arrayWithObjects:
@@ -82,20 +169,64 @@ static NSDateFormatter* __rfc1123DateFormatter;
 			}
 		}
 
+        [self migrateFlatPermanentStore];
+        // The index must be in place before the storage policy is applied, so that
+        // discarding the previous session also discards its index entries
+        _index = [[RKRequestCacheIndex alloc] initWithPath:[_cachePath stringByAppendingPathComponent:indexFileName]];
+        if (! [_index load]) {
+            [self rebuildIndex];
+        }
+
 		self.storagePolicy = storagePolicy;
+        _evictionPolicy = RKRequestCacheEvictionPolicyLeastRecentlyUsed;
+
+#if TARGET_OS_IPHONE
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(didReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(flush)
+                                                     name:UIApplicationWillTerminateNotification
+                                                   object:nil];
+        BOOL backgroundOK = &UIApplicationDidEnterBackgroundNotification != NULL;
+        if (backgroundOK) {
+            [[NSNotificationCenter defaultCenter] addObserver:self
+                                                     selector:@selector(flush)
+                                                         name:UIApplicationDidEnterBackgroundNotification
+                                                       object:nil];
+        }
+#endif
 	}
     
 	return self;
 }
 
 - (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [_writeQueue waitUntilAllOperationsAreFinished];
+    [_writeQueue release];
+    _writeQueue = nil;
+    [_pendingEntries release];
+    _pendingEntries = nil;
+    [_pendingRemovals release];
+    _pendingRemovals = nil;
 	[_cachePath release];
 	_cachePath = nil;
 	[_cacheLock release];
 	_cacheLock = nil;
+    [_memoryCache release];
+    _memoryCache = nil;
+    [_index release];
+    _index = nil;
 	[super dealloc];
 }
 
+- (void)didReceiveMemoryWarning:(NSNotification*)notification {
+    RKLogDebug(@"Received memory warning: emptying memory cache %@", _memoryCache);
+    [_memoryCache removeAllEntries];
+}
+
 - (NSString*)cachePath {
 	return _cachePath;
 }
@@ -107,16 +238,7 @@ static NSDateFormatter* __rfc1123DateFormatter;
     
 	[_cacheLock lock];
 
-	NSString* pathForRequest = nil;
-
-	if (_storagePolicy == RKRequestCacheStoragePolicyForDurationOfSession) {
-		pathForRequest = [[_cachePath stringByAppendingPathComponent:sessionCacheFolder]
-						  stringByAppendingPathComponent:[request cacheKey]];
-
-	} else if (_storagePolicy == RKRequestCacheStoragePolicyPermanently) {
-		pathForRequest = [[_cachePath stringByAppendingPathComponent:permanentCacheFolder]
-						  stringByAppendingPathComponent:[request cacheKey]];
-	}
+	NSString* pathForRequest = [self cachePathForKey:[request cacheKey] storagePolicy:_storagePolicy];
 
 	[_cacheLock unlock];
     RKLogTrace(@"Found cachePath '%@' for %@", pathForRequest, request);
@@ -131,78 +253,203 @@ static NSDateFormatter* __rfc1123DateFormatter;
     
 	[_cacheLock lock];
 
-	BOOL hasEntryForRequest = NO;
-	NSFileManager* fileManager = [NSFileManager defaultManager];
-
-	NSString* cachePath = [self pathForRequest:request];
-	hasEntryForRequest = ([fileManager fileExistsAtPath:cachePath] &&
-						  [fileManager fileExistsAtPath:
-						   [cachePath stringByAppendingPathExtension:headersExtension]]);
+	// Every stored entry, whether pending or on disk, is indexed, so the filesystem is never consulted
+	BOOL hasEntryForRequest = (nil != [self indexEntryForRequest:request]);
 
 	[_cacheLock unlock];
     RKLogTrace(@"Determined hasResponseForRequest: %@ => %@", request, hasEntryForRequest ? @"YES" : @"NO");
 	return hasEntryForRequest;
 }
 
-- (void)writeHeaders:(NSDictionary*)headers toCachePath:(NSString*)cachePath {
-    RKLogTrace(@"Writing headers to cache path: '%@'", cachePath);
-    BOOL success = [headers writeToFile:[cachePath
-                                         stringByAppendingPathExtension:headersExtension]
-                             atomically:YES];
-    if (success) {
-        RKLogTrace(@"Wrote cached response header to path '%@'", cachePath);
-        
+#pragma mark - Cache Entries
+
+// Builds an entry from headers carrying our X-RESTKIT bookkeeping keys, as written by storeResponse:forRequest:
+// and by earlier versions of the cache
+- (RKRequestCacheEntry*)entryWithResponseHeaders:(NSDictionary*)responseHeaders body:(NSData*)body {
+    NSDateFormatter* dateFormatter = [RKRequestCache rfc1123DateFormatter];
+    RKRequestCacheEntry* entry = [[RKRequestCacheEntry new] autorelease];
+    NSMutableDictionary* headers = [NSMutableDictionary dictionaryWithCapacity:[responseHeaders count]];
+    
+    for (NSString* key in responseHeaders) {
+        id value = [responseHeaders objectForKey:key];
+        if ([key isEqualToString:cacheDateHeaderKey]) {
+            entry.cacheDate = [dateFormatter dateFromString:value];
+        } else if ([key isEqualToString:cacheResponseCodeKey]) {
+            entry.statusCode = [value integerValue];
+        } else if ([key isEqualToString:cacheMIMETypeKey]) {
+            entry.MIMEType = value;
+        } else if ([key isEqualToString:cacheURLKey]) {
+            entry.URL = value;
+        } else {
+            [headers setObject:value forKey:key];
+            NSString* uppercaseKey = [key uppercaseString];
+            if ([uppercaseKey isEqualToString:@"ETAG"]) {
+                entry.ETag = value;
+            } else if ([uppercaseKey isEqualToString:@"LAST-MODIFIED"]) {
+                entry.lastModifiedDate = [dateFormatter dateFromString:value];
+            }
+        }
+    }
+    entry.expirationDate = [RKRequestCache expirationDateForResponseHeaders:headers
+                                                                   fromDate:(entry.cacheDate ? entry.cacheDate : [NSDate date])];
+    entry.headers = headers;
+    entry.body = body;
+    
+    return entry;
+}
+
+// Returns the headers of the entry along with our X-RESTKIT bookkeeping keys, as expected by RKResponse
+- (NSDictionary*)responseHeadersForEntry:(RKRequestCacheEntry*)entry {
+    NSMutableDictionary* responseHeaders = [NSMutableDictionary dictionaryWithDictionary:entry.headers];
+    if (entry.cacheDate) {
+        [responseHeaders setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:entry.cacheDate]
+                            forKey:cacheDateHeaderKey];
+    }
+    [responseHeaders setObject:[NSNumber numberWithInteger:entry.statusCode] forKey:cacheResponseCodeKey];
+    if (entry.MIMEType) {
+        [responseHeaders setObject:entry.MIMEType forKey:cacheMIMETypeKey];
+    }
+    if (entry.URL) {
+        [responseHeaders setObject:entry.URL forKey:cacheURLKey];
+    }
+    
+    return responseHeaders;
+}
+
+- (NSString*)cachePathForKey:(NSString*)cacheKey storagePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
+    if (nil == cacheKey) {
+        return nil;
+    }
+    
+    if (storagePolicy == RKRequestCacheStoragePolicyForDurationOfSession) {
+        return [[_cachePath stringByAppendingPathComponent:sessionCacheFolder] stringByAppendingPathComponent:cacheKey];
+    } else if (storagePolicy == RKRequestCacheStoragePolicyPermanently) {
+        return [[_cachePath stringByAppendingPathComponent:permanentCacheFolder]
+                stringByAppendingPathComponent:RKRequestCacheShardedPathForKey(cacheKey)];
+    }
+    
+    return nil;
+}
+
+- (RKRequestCacheStoragePolicy)storagePolicyForCachePath:(NSString*)cachePath {
+    if ([cachePath hasPrefix:[_cachePath stringByAppendingPathComponent:permanentCacheFolder]]) {
+        return RKRequestCacheStoragePolicyPermanently;
+    } else if ([cachePath hasPrefix:[_cachePath stringByAppendingPathComponent:sessionCacheFolder]]) {
+        return RKRequestCacheStoragePolicyForDurationOfSession;
+    }
+    
+    return RKRequestCacheStoragePolicyDisabled;
+}
+
+// Returns the index entry for the request under the current storage policy
+- (RKRequestCacheIndexEntry*)indexEntryForRequest:(RKRequest*)request {
+    if (_storagePolicy == RKRequestCacheStoragePolicyDisabled) {
+        return nil;
+    }
+    
+    RKRequestCacheIndexEntry* indexEntry = [_index entryForKey:[request cacheKey]];
+    return (indexEntry.storagePolicy == _storagePolicy) ? indexEntry : nil;
+}
+
+- (void)indexEntry:(RKRequestCacheEntry*)entry atCachePath:(NSString*)cachePath {
+    RKRequestCacheIndexEntry* indexEntry = [[RKRequestCacheIndexEntry new] autorelease];
+    indexEntry.cacheKey = [cachePath lastPathComponent];
+    indexEntry.storagePolicy = [self storagePolicyForCachePath:cachePath];
+    indexEntry.ETag = entry.ETag;
+    indexEntry.lastModifiedDate = entry.lastModifiedDate;
+    indexEntry.cacheDate = entry.cacheDate;
+    indexEntry.expirationDate = entry.expirationDate;
+    indexEntry.size = [entry encodedLength];
+    // Under least frequently used eviction new entries start at the frequency age, so that entries
+    // which were popular long ago do not outrank them forever
+    indexEntry.accessCount = (_evictionPolicy == RKRequestCacheEvictionPolicyLeastFrequentlyUsed) ? _index.frequencyAge + 1 : 1;
+    indexEntry.lastAccessTime = [NSDate timeIntervalSinceReferenceDate];
+    [_index setEntry:indexEntry];
+    [self enqueueIndexSynchronization];
+}
+
+// Reads the entry at the cache path, rewriting entries stored as a body and headers plist pair into the single file format
+- (RKRequestCacheEntry*)entryAtCachePath:(NSString*)cachePath {
+    RKRequestCacheEntry* entry = [_pendingEntries objectForKey:cachePath];
+    if (entry) {
+        return [[entry retain] autorelease];
+    }
+    if ([_pendingRemovals containsObject:cachePath]) {
+        return nil;
+    }
+    
+    entry = [RKRequestCacheEntry entryWithContentsOfFile:cachePath];
+    if (entry) {
+        return entry;
+    }
+    
+    NSString* headersPath = [cachePath stringByAppendingPathExtension:headersExtension];
+    NSDictionary* legacyHeaders = [NSDictionary dictionaryWithContentsOfFile:headersPath];
+    NSData* legacyBody = [NSData dataWithContentsOfFile:cachePath];
+    if (nil == legacyHeaders || nil == legacyBody) {
+        return nil;
+    }
+    
+    entry = [self entryWithResponseHeaders:legacyHeaders body:legacyBody];
+    NSError* error = nil;
+    if ([entry writeToFile:cachePath error:&error]) {
+        [[NSFileManager defaultManager] removeItemAtPath:headersPath error:nil];
+        RKLogDebug(@"Migrated legacy cache entry at path '%@'", cachePath);
     } else {
-        RKLogError(@"Failed to write cached response headers to path '%@'", cachePath);
+        RKLogWarning(@"Failed to migrate legacy cache entry at path '%@': %@", cachePath, [error localizedDescription]);
     }
+    
+    return entry;
 }
 
+#pragma mark - Storing and Loading
+
 - (void)storeResponse:(RKResponse*)response forRequest:(RKRequest*)request {
     if (! [request isCacheable]) {
         return;
     }
     
 	[_cacheLock lock];
-    
-	if ([self hasResponseForRequest:request]) {
-		[self invalidateRequest:request];
-	}
 
 	if (_storagePolicy != RKRequestCacheStoragePolicyDisabled) {
 		NSString* cachePath = [self pathForRequest:request];
-		if (cachePath) {
-			NSData* body = response.body;
-			if (body) {
-                NSError* error = nil;
-                BOOL success = [body writeToFile:cachePath options:NSDataWritingAtomic error:&error];
-                if (success) {
-                    RKLogTrace(@"Wrote cached response body to path '%@'", cachePath);                    
-                } else {
-                    RKLogError(@"Failed to write cached response body to path '%@': %@", cachePath, [error localizedDescription]);
-                }
-			}
-
-			NSMutableDictionary* headers = [response.allHeaderFields mutableCopy];
-			if (headers) {
-                NSHTTPURLResponse* urlResponse = [response valueForKey:@"_httpURLResponse"];
-                // Cache Loaded Time
-				[headers setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:[NSDate date]]
-							forKey:cacheDateHeaderKey];
-                // Cache status code
-                [headers setObject:[NSNumber numberWithInteger:urlResponse.statusCode]
-							forKey:cacheResponseCodeKey];
-                // Cache MIME Type
-                [headers setObject:urlResponse.MIMEType
-							forKey:cacheMIMETypeKey];
-                // Cache URL
-                [headers setObject:[urlResponse.URL absoluteString]
-							forKey:cacheURLKey];
-                // Save
-                [self writeHeaders:headers toCachePath:cachePath];
-			}
+		NSData* body = response.body;
+		NSMutableDictionary* headers = [response.allHeaderFields mutableCopy];
+		if (cachePath && body && headers) {
+            NSHTTPURLResponse* urlResponse = [response valueForKey:@"_httpURLResponse"];
+            // Cache Loaded Time
+            [headers setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:[NSDate date]]
+                        forKey:cacheDateHeaderKey];
+            // Cache status code
+            [headers setObject:[NSNumber numberWithInteger:urlResponse.statusCode]
+                        forKey:cacheResponseCodeKey];
+            // Cache MIME Type
+            [headers setObject:urlResponse.MIMEType
+                        forKey:cacheMIMETypeKey];
+            // Cache URL
+            [headers setObject:[urlResponse.URL absoluteString]
+                        forKey:cacheURLKey];
+            
+            // The entry is served from the pending table until the writer has put it on disk
+            RKRequestCacheEntry* entry = [self entryWithResponseHeaders:headers body:body];
+            [_pendingEntries setObject:entry forKey:cachePath];
+            [_memoryCache setHeaders:headers body:body forKey:cachePath];
+            
+            // An entry stored for the same key under the other storage policy is superseded
+            RKRequestCacheIndexEntry* previousEntry = [_index entryForKey:[request cacheKey]];
+            if (previousEntry && previousEntry.storagePolicy != _storagePolicy) {
+                [self removeEntryAtCachePath:[self cachePathForKey:previousEntry.cacheKey storagePolicy:previousEntry.storagePolicy]];
+            }
+            [self enqueueWriteForCachePath:cachePath];
+            [self indexEntry:entry atCachePath:cachePath];
             
-			[headers release];
+            if (_storagePolicy == RKRequestCacheStoragePolicyPermanently) {
+                // The entry just stored has had no chance to be used yet, so it is never the one evicted
+                [self evictPermanentEntriesExcludingKey:[request cacheKey]];
+            }
 		}
+        
+        [headers release];
 	}
 
 	[_cacheLock unlock];
@@ -219,12 +466,27 @@ static NSDateFormatter* __rfc1123DateFormatter;
 
 	NSString* cachePath = [self pathForRequest:request];
 	if (cachePath) {
-		NSData* responseData = [NSData dataWithContentsOfFile:cachePath];
-
-		NSDictionary* responseHeaders = [NSDictionary dictionaryWithContentsOfFile:
-										 [cachePath stringByAppendingPathExtension:headersExtension]];
+        NSDictionary* responseHeaders = [_memoryCache headersForKey:cachePath];
+        NSData* responseData = [_memoryCache bodyForKey:cachePath];
+        if (nil == responseHeaders || nil == responseData) {
+            RKRequestCacheEntry* entry = [self entryAtCachePath:cachePath];
+            if (entry) {
+                responseData = entry.body;
+                if (nil == responseHeaders) {
+                    responseHeaders = [self responseHeadersForEntry:entry];
+                    [_memoryCache setHeaders:responseHeaders body:responseData forKey:cachePath];
+                }
+            } else if ([self indexEntryForRequest:request]) {
+                RKLogWarning(@"Cache entry indexed for '%@' could not be read from path '%@', removing it", request, cachePath);
+                [self removeEntryAtCachePath:cachePath];
+                responseHeaders = nil;
+            }
+        }
 
-		response = [[[RKResponse alloc] initWithRequest:request body:responseData headers:responseHeaders] autorelease];
+        if (responseHeaders) {
+            response = [[[RKResponse alloc] initWithRequest:request body:responseData headers:responseHeaders] autorelease];
+            [_index recordAccessForKey:[request cacheKey]];
+        }
 	}
 
 	[_cacheLock unlock];
@@ -240,14 +502,18 @@ static NSDateFormatter* __rfc1123DateFormatter;
     
     [_cacheLock lock];
     
-    NSDictionary* headers = nil;
-    if (cachePath) {
-        NSString* headersPath = [cachePath stringByAppendingPathExtension:headersExtension];
-        headers = [NSDictionary dictionaryWithContentsOfFile:headersPath];
-        if (headers) {
-            RKLogDebug(@"Read cached headers '%@' from cachePath '%@' for '%@'", headers, headersPath, request);
+    NSDictionary* headers = [_memoryCache headersForKey:cachePath];
+    if (headers) {
+        RKLogTrace(@"Found cached headers in memory for '%@'", request);
+    } else if (cachePath) {
+        RKRequestCacheEntry* entry = [self entryAtCachePath:cachePath];
+        if (entry) {
+            headers = [self responseHeadersForEntry:entry];
+            RKLogDebug(@"Read cached headers '%@' from cachePath '%@' for '%@'", headers, cachePath, request);
+            // Hold the headers in memory, leaving the body on disk until the response is loaded
+            [_memoryCache setHeaders:headers body:nil forKey:cachePath];
         } else {
-            RKLogDebug(@"Read nil cached headers from cachePath '%@' for '%@'", headersPath, request);
+            RKLogDebug(@"Read nil cached headers from cachePath '%@' for '%@'", cachePath, request);
         }
     } else {
         RKLogDebug(@"Unable to read cached headers for '%@': cachePath not found", request);
@@ -261,61 +527,215 @@ static NSDateFormatter* __rfc1123DateFormatter;
     if (! [request isCacheable]) {
         return nil;
     }
-	NSString* etag = nil;
-
-    NSDictionary* responseHeaders = [self headersForRequest:request];
-    
     [_cacheLock lock];
-    if (responseHeaders) {
-        for (NSString* responseHeader in responseHeaders) {
-            if ([[responseHeader uppercaseString] isEqualToString:[@"ETag" uppercaseString]]) {
-                etag = [responseHeaders objectForKey:responseHeader];
-            }
-        }
-    }
-
+	NSString* etag = [self indexEntryForRequest:request].ETag;
 	[_cacheLock unlock];
     RKLogDebug(@"Found cached ETag '%@' for '%@'", etag, request);
 	return etag;
 }
 
+- (NSDate*)lastModifiedDateForRequest:(RKRequest*)request {
+    if (! [request isCacheable]) {
+        return nil;
+    }
+    [_cacheLock lock];
+	NSDate* date = [self indexEntryForRequest:request].lastModifiedDate;
+	[_cacheLock unlock];
+    RKLogDebug(@"Found cached Last-Modified date '%@' for '%@'", date, request);
+	return date;
+}
+
 - (void)setCacheDate:(NSDate*)date forRequest:(RKRequest*)request {
+    [self setCacheDate:date expirationDate:nil updatingExpiration:NO forRequest:request];
+}
+
+- (void)setCacheDate:(NSDate*)date expirationDate:(NSDate*)expirationDate forRequest:(RKRequest*)request {
+    [self setCacheDate:date expirationDate:expirationDate updatingExpiration:YES forRequest:request];
+}
+
+- (void)setCacheDate:(NSDate*)date expirationDate:(NSDate*)expirationDate updatingExpiration:(BOOL)updateExpiration forRequest:(RKRequest*)request {
     if (! [request isCacheable]) {
         return;
     }
-    NSMutableDictionary* responseHeaders = [[self headersForRequest:request] mutableCopy];
+    NSString* cachePath = [self pathForRequest:request];
     
-    [responseHeaders setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:date]
-                                 forKey:cacheDateHeaderKey];
-    [self writeHeaders:responseHeaders toCachePath:[self pathForRequest:request]];
+    [_cacheLock lock];
+    
+    BOOL updated = NO;
+    RKRequestCacheEntry* pendingEntry = [_pendingEntries objectForKey:cachePath];
+    if (pendingEntry) {
+        // The writer may be encoding the pending entry, so replace it rather than mutating it
+        RKRequestCacheEntry* entry = [[pendingEntry copy] autorelease];
+        entry.cacheDate = date;
+        if (updateExpiration) {
+            entry.expirationDate = expirationDate;
+        }
+        [_pendingEntries setObject:entry forKey:cachePath];
+        [self enqueueWriteForCachePath:cachePath];
+        updated = YES;
+    } else if (! [_pendingRemovals containsObject:cachePath]) {
+        // The cache date lives at a fixed offset in the entry header, so it is patched in place
+        updated = [RKRequestCacheEntry setCacheDate:date forEntryAtPath:cachePath];
+        if (! updated && [self entryAtCachePath:cachePath]) {
+            updated = [RKRequestCacheEntry setCacheDate:date forEntryAtPath:cachePath];
+        }
+        if (updated && updateExpiration) {
+            updated = [RKRequestCacheEntry setExpirationDate:expirationDate forEntryAtPath:cachePath];
+        }
+    }
+    
+    RKRequestCacheIndexEntry* indexEntry = [self indexEntryForRequest:request];
+    if (updated && indexEntry) {
+        indexEntry.cacheDate = date;
+        if (updateExpiration) {
+            indexEntry.expirationDate = expirationDate;
+        }
+        [_index setEntry:indexEntry];
+        [self enqueueIndexSynchronization];
+    }
     
-    [responseHeaders release];
+    NSDictionary* headers = [_memoryCache headersForKey:cachePath];
+    if (updated && headers) {
+        NSMutableDictionary* responseHeaders = [[headers mutableCopy] autorelease];
+        [responseHeaders setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:date]
+                            forKey:cacheDateHeaderKey];
+        [_memoryCache updateHeaders:responseHeaders forKey:cachePath];
+    } else if (! updated) {
+        RKLogError(@"Failed to update cache date of cache entry at path '%@'", cachePath);
+        [_memoryCache removeEntryForKey:cachePath];
+    }
+    
+    [_cacheLock unlock];
 }
 
-- (NSDate*)cacheDateForRequest:(RKRequest*)request {
+- (NSDate*)expirationDateForRequest:(RKRequest*)request {
     if (! [request isCacheable]) {
         return nil;
     }
-	NSDate* date = nil;
-    NSString* dateString = nil;
-    
-    NSDictionary* responseHeaders = [self headersForRequest:request];
     
     [_cacheLock lock];
-    if (responseHeaders) {
-        for (NSString* responseHeader in responseHeaders) {
-            if ([[responseHeader uppercaseString] isEqualToString:[cacheDateHeaderKey uppercaseString]]) {
-                dateString = [responseHeaders objectForKey:responseHeader];
-            }
-        }
+	NSDate* date = [self indexEntryForRequest:request].expirationDate;
+	[_cacheLock unlock];
+    
+    RKLogDebug(@"Found cached expiration date '%@' for '%@'", date, request);
+	return date;
+}
+
+- (NSDate*)cacheDateForRequest:(RKRequest*)request {
+    if (! [request isCacheable]) {
+        return nil;
     }
+    [_cacheLock lock];
+	NSDate* date = [self indexEntryForRequest:request].cacheDate;
 	[_cacheLock unlock];
-    date = [[RKRequestCache rfc1123DateFormatter] dateFromString:dateString];
     
     RKLogDebug(@"Found cached date '%@' for '%@'", date, request);
 	return date;
 }
 
+#pragma mark - Parsed Objects
+
+// Identifies the version of the cached body a parsed object was made from
+- (NSString*)parsedObjectValidatorForIndexEntry:(RKRequestCacheIndexEntry*)indexEntry {
+    if (indexEntry.ETag) {
+        return [@"E" stringByAppendingString:indexEntry.ETag];
+    } else if (indexEntry.lastModifiedDate) {
+        return [NSString stringWithFormat:@"M%f", [indexEntry.lastModifiedDate timeIntervalSinceReferenceDate]];
+    }
+    
+    return [NSString stringWithFormat:@"D%f-%llu", [indexEntry.cacheDate timeIntervalSinceReferenceDate], indexEntry.size];
+}
+
+- (id)parsedObjectForRequest:(RKRequest*)request {
+    if (! _cachesParsedObjects || ! [request isCacheable]) {
+        return nil;
+    }
+    
+    [_cacheLock lock];
+    NSString* cachePath = [self pathForRequest:request];
+    RKRequestCacheIndexEntry* indexEntry = [self indexEntryForRequest:request];
+    NSString* validator = indexEntry ? [self parsedObjectValidatorForIndexEntry:indexEntry] : nil;
+    [_cacheLock unlock];
+    if (nil == cachePath || nil == validator) {
+        return nil;
+    }
+    
+    // Parsed object files hold the validator, a format byte and the serialized object
+    NSData* data = [NSData dataWithContentsOfFile:[cachePath stringByAppendingPathExtension:parsedObjectExtension]
+                                          options:NSDataReadingMappedIfSafe
+                                            error:nil];
+    const uint8_t* bytes = [data bytes];
+    NSUInteger length = [data length];
+    if (length < 5) {
+        return nil;
+    }
+    NSUInteger validatorLength = RKCacheReadUInt32(bytes);
+    if (validatorLength > length - 5) {
+        return nil;
+    }
+    NSString* storedValidator = [RKCacheCreateString(bytes + 4, validatorLength) autorelease];
+    if (! [storedValidator isEqualToString:validator]) {
+        RKLogTrace(@"Discarding parsed object for '%@': it was parsed from a previous version of the response", request);
+        return nil;
+    }
+    
+    uint8_t format = bytes[4 + validatorLength];
+    NSData* payload = [data subdataWithRange:NSMakeRange(5 + validatorLength, length - 5 - validatorLength)];
+    id parsedObject = nil;
+    if (format == 0) {
+        parsedObject = [NSPropertyListSerialization propertyListWithData:payload options:NSPropertyListImmutable format:NULL error:nil];
+    } else {
+        @try {
+            parsedObject = [NSKeyedUnarchiver unarchiveObjectWithData:payload];
+        }
+        @catch (NSException* exception) {
+            RKLogWarning(@"Failed to unarchive parsed object for '%@': %@", request, [exception reason]);
+        }
+    }
+    
+    RKLogDebug(@"Found cached parsed object for '%@'", request);
+    return parsedObject;
+}
+
+- (void)storeParsedObject:(id)parsedObject forRequest:(RKRequest*)request {
+    if (! _cachesParsedObjects || nil == parsedObject || ! [request isCacheable]) {
+        return;
+    }
+    
+    [_cacheLock lock];
+    NSString* cachePath = [self pathForRequest:request];
+    RKRequestCacheIndexEntry* indexEntry = [self indexEntryForRequest:request];
+    NSString* validator = indexEntry ? [self parsedObjectValidatorForIndexEntry:indexEntry] : nil;
+    [_cacheLock unlock];
+    if (nil == cachePath || nil == validator) {
+        return;
+    }
+    
+    uint8_t format = 0;
+    NSData* payload = [NSPropertyListSerialization dataWithPropertyList:parsedObject
+                                                                 format:NSPropertyListBinaryFormat_v1_0
+                                                                options:0
+                                                                  error:nil];
+    if (nil == payload) {
+        format = 1;
+        payload = [NSKeyedArchiver archivedDataWithRootObject:parsedObject];
+    }
+    
+    NSMutableData* data = [NSMutableData dataWithCapacity:[payload length] + [validator length] + 5];
+    RKCacheAppendString(data, validator);
+    RKCacheAppendUInt8(data, format);
+    [data appendData:payload];
+    
+    NSDictionary* write = [NSDictionary dictionaryWithObjectsAndKeys:
+                           data, @"data",
+                           [cachePath stringByAppendingPathExtension:parsedObjectExtension], @"path", nil];
+    NSInvocationOperation* operation = [[NSInvocationOperation alloc] initWithTarget:self
+                                                                            selector:@selector(writeParsedObject:)
+                                                                              object:write];
+    [_writeQueue addOperation:operation];
+    [operation release];
+}
+
 - (void)invalidateRequest:(RKRequest*)request {
     if (! [request isCacheable]) {
         return;
@@ -326,10 +746,7 @@ static NSDateFormatter* __rfc1123DateFormatter;
     
 	NSString* cachePath = [self pathForRequest:request];
 	if (cachePath) {
-		NSFileManager* fileManager = [NSFileManager defaultManager];
-		[fileManager removeItemAtPath:cachePath error:NULL];
-		[fileManager removeItemAtPath:[cachePath stringByAppendingPathExtension:headersExtension]
-																		  error:NULL];
+        [self removeEntryAtCachePath:cachePath];
         RKLogTrace(@"Removed cache entry at path '%@' for '%@'", cachePath, request);
 	}
 
@@ -337,8 +754,6 @@ static NSDateFormatter* __rfc1123DateFormatter;
 }
 
 - (void)invalidateWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
-	[_cacheLock lock];
-
 	if (_cachePath && storagePolicy != RKRequestCacheStoragePolicyDisabled) {
 		NSString* cachePath = nil;
 		if (storagePolicy == RKRequestCacheStoragePolicyForDurationOfSession) {
@@ -347,43 +762,47 @@ static NSDateFormatter* __rfc1123DateFormatter;
 			cachePath = [_cachePath stringByAppendingPathComponent:permanentCacheFolder];
 		}
         
+        // Drop the pending writes into the store and let the writer drain, so that no write
+        // already in flight lands after the store has been removed. The writer needs the cache
+        // lock, so this must happen before taking it.
+        [_cacheLock lock];
+        for (NSString* pendingPath in [_pendingEntries allKeys]) {
+            if ([pendingPath hasPrefix:cachePath]) {
+                [_pendingEntries removeObjectForKey:pendingPath];
+            }
+        }
+        [_cacheLock unlock];
+        [self flush];
+        
+        [_cacheLock lock];
         RKLogInfo(@"Invalidating cache at path: %@", cachePath);
+        [_memoryCache removeEntriesWithKeyPrefix:cachePath];
 		NSFileManager* fileManager = [NSFileManager defaultManager];
 
 		BOOL isDirectory = NO;
 		BOOL fileExists = [fileManager fileExistsAtPath:cachePath isDirectory:&isDirectory];
 
 		if (fileExists && isDirectory) {
+            // Entries may be nested in shard directories, so remove the store wholesale and start afresh
 			NSError* error = nil;
-			NSArray* cacheEntries = [fileManager contentsOfDirectoryAtPath:cachePath error:&error];
-
-			if (nil == error) {
-				for (NSString* cacheEntry in cacheEntries) {
-					NSString* cacheEntryPath = [cachePath stringByAppendingPathComponent:cacheEntry];
-					[fileManager removeItemAtPath:cacheEntryPath error:&error];
-					[fileManager removeItemAtPath:[cacheEntryPath stringByAppendingPathExtension:headersExtension]
-											error:&error];
-					if (nil != error) {
-						RKLogError(@"Failed to delete cache entry for file: %@", cacheEntryPath);
-					}
-				}
-			} else {
-				RKLogWarning(@"Failed to fetch list of cache entries for cache path: %@", cachePath);
-			}
+            if (! [fileManager removeItemAtPath:cachePath error:&error]) {
+                RKLogError(@"Failed to delete cache entries at cache path %@: %@", cachePath, [error localizedDescription]);
+            }
+            if (! [fileManager createDirectoryAtPath:cachePath withIntermediateDirectories:YES attributes:nil error:&error]) {
+                RKLogError(@"Failed to recreate cache directory at path %@: %@", cachePath, [error localizedDescription]);
+            }
 		}
+        
+        [_index removeEntriesWithStoragePolicy:storagePolicy];
+        [self enqueueIndexSynchronization];
+        [_cacheLock unlock];
 	}
-
-	[_cacheLock unlock];
 }
 
 - (void)invalidateAll {
-	[_cacheLock lock];
-    
     RKLogInfo(@"Invalidating all cache entries...");
 	[self invalidateWithStoragePolicy:RKRequestCacheStoragePolicyForDurationOfSession];
 	[self invalidateWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
-
-	[_cacheLock unlock];
 }
 
 - (void)setStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
@@ -394,4 +813,292 @@ static NSDateFormatter* __rfc1123DateFormatter;
 	_storagePolicy = storagePolicy;
 }
 
+#pragma mark - Background Writer
+
+- (NSUInteger)pendingWriteCount {
+    [_cacheLock lock];
+    NSUInteger count = [_pendingEntries count];
+    [_cacheLock unlock];
+    return count;
+}
+
+- (void)flush {
+    [_writeQueue waitUntilAllOperationsAreFinished];
+}
+
+- (void)enqueueWriteForCachePath:(NSString*)cachePath {
+    NSInvocationOperation* operation = [[NSInvocationOperation alloc] initWithTarget:self
+                                                                            selector:@selector(writePendingEntryForCachePath:)
+                                                                              object:cachePath];
+    [_writeQueue addOperation:operation];
+    [operation release];
+}
+
+- (void)enqueueRemovalForCachePath:(NSString*)cachePath {
+    // Readers treat the entry as gone from the moment it is invalidated, not when the files are unlinked
+    [_pendingRemovals addObject:cachePath];
+    NSInvocationOperation* operation = [[NSInvocationOperation alloc] initWithTarget:self
+                                                                            selector:@selector(removeFilesForCachePath:)
+                                                                              object:cachePath];
+    [_writeQueue addOperation:operation];
+    [operation release];
+}
+
+// Index changes are appended to the journal once the entry writes queued ahead of them have landed
+- (void)enqueueIndexSynchronization {
+    if (_indexSynchronizationPending) {
+        return;
+    }
+    
+    _indexSynchronizationPending = YES;
+    NSInvocationOperation* operation = [[NSInvocationOperation alloc] initWithTarget:self
+                                                                            selector:@selector(synchronizeIndex)
+                                                                              object:nil];
+    [_writeQueue addOperation:operation];
+    [operation release];
+}
+
+// Invoked on the writer
+- (void)synchronizeIndex {
+    [_cacheLock lock];
+    _indexSynchronizationPending = NO;
+    [_cacheLock unlock];
+    
+    [_index synchronize];
+}
+
+// Invoked on the writer. Writes the entry currently pending for the cache path, if any
+- (void)writePendingEntryForCachePath:(NSString*)cachePath {
+    [_cacheLock lock];
+    RKRequestCacheEntry* entry = [[_pendingEntries objectForKey:cachePath] retain];
+    [_cacheLock unlock];
+    if (nil == entry) {
+        // Invalidated, or an earlier write already flushed the latest entry
+        return;
+    }
+    
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    [fileManager createDirectoryAtPath:[cachePath stringByDeletingLastPathComponent]
+           withIntermediateDirectories:YES
+                            attributes:nil
+                                 error:nil];
+    NSData* entryData = [entry data];
+    NSError* error = nil;
+    if ([entryData writeToFile:cachePath options:NSDataWritingAtomic error:&error]) {
+        RKLogTrace(@"Wrote cache entry of %lu bytes to path '%@'", (unsigned long) [entryData length], cachePath);
+        [fileManager removeItemAtPath:[cachePath stringByAppendingPathExtension:headersExtension] error:nil];
+        // Anything parsed from the previous body is stale. Parsed objects for this body are queued behind us
+        [fileManager removeItemAtPath:[cachePath stringByAppendingPathExtension:parsedObjectExtension] error:nil];
+    } else {
+        RKLogError(@"Failed to write cache entry to path '%@': %@", cachePath, [error localizedDescription]);
+    }
+    
+    [_cacheLock lock];
+    // Leave the entry pending if it was replaced while we were writing; the newer write is queued behind us
+    if ([_pendingEntries objectForKey:cachePath] == entry) {
+        [_pendingEntries removeObjectForKey:cachePath];
+    }
+    [_cacheLock unlock];
+    [entry release];
+}
+
+// Invoked on the writer
+- (void)writeParsedObject:(NSDictionary*)write {
+    NSString* path = [write objectForKey:@"path"];
+    NSData* data = [write objectForKey:@"data"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+    NSError* error = nil;
+    if ([data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+        RKLogTrace(@"Wrote parsed object of %lu bytes to path '%@'", (unsigned long) [data length], path);
+    } else {
+        RKLogError(@"Failed to write parsed object to path '%@': %@", path, [error localizedDescription]);
+    }
+}
+
+// Invoked on the writer
+- (void)removeFilesForCachePath:(NSString*)cachePath {
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtPath:cachePath error:NULL];
+    [fileManager removeItemAtPath:[cachePath stringByAppendingPathExtension:headersExtension] error:NULL];
+    [fileManager removeItemAtPath:[cachePath stringByAppendingPathExtension:parsedObjectExtension] error:NULL];
+    
+    [_cacheLock lock];
+    [_pendingRemovals removeObject:cachePath];
+    [_cacheLock unlock];
+}
+
+#pragma mark - Permanent Store Eviction
+
+- (BOOL)isPermanentStoreLimited {
+    return (_maximumPermanentStoreSize > 0 || _maximumPermanentStoreEntryCount > 0);
+}
+
+- (void)setMaximumPermanentStoreSize:(unsigned long long)maximumPermanentStoreSize {
+    [_cacheLock lock];
+    _maximumPermanentStoreSize = maximumPermanentStoreSize;
+    [self evictPermanentEntriesIfNecessary];
+    [_cacheLock unlock];
+}
+
+- (void)setMaximumPermanentStoreEntryCount:(NSUInteger)maximumPermanentStoreEntryCount {
+    [_cacheLock lock];
+    _maximumPermanentStoreEntryCount = maximumPermanentStoreEntryCount;
+    [self evictPermanentEntriesIfNecessary];
+    [_cacheLock unlock];
+}
+
+- (unsigned long long)permanentStoreSize {
+    return [_index sizeOfEntriesWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
+}
+
+- (NSUInteger)permanentStoreEntryCount {
+    return [_index countOfEntriesWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
+}
+
+// Entries written before the store was sharded live directly in the store directory. Move them into place.
+- (void)migrateFlatPermanentStore {
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    NSString* storePath = [_cachePath stringByAppendingPathComponent:permanentCacheFolder];
+    NSArray* contents = [fileManager contentsOfDirectoryAtPath:storePath error:nil];
+    NSUInteger migratedCount = 0;
+    
+    for (NSString* fileName in contents) {
+        NSString* filePath = [storePath stringByAppendingPathComponent:fileName];
+        BOOL isDirectory = NO;
+        if (! [fileManager fileExistsAtPath:filePath isDirectory:&isDirectory] || isDirectory) {
+            continue;
+        }
+        
+        NSString* cacheKey = [fileName stringByDeletingPathExtension];
+        NSString* shardedPath = [storePath stringByAppendingPathComponent:RKRequestCacheShardedPathForKey(cacheKey)];
+        if ([[fileName pathExtension] isEqualToString:headersExtension]) {
+            shardedPath = [shardedPath stringByAppendingPathExtension:headersExtension];
+        }
+        if ([shardedPath isEqualToString:filePath]) {
+            continue;
+        }
+        
+        [fileManager createDirectoryAtPath:[shardedPath stringByDeletingLastPathComponent]
+               withIntermediateDirectories:YES
+                                attributes:nil
+                                     error:nil];
+        [fileManager removeItemAtPath:shardedPath error:nil];
+        NSError* error = nil;
+        if ([fileManager moveItemAtPath:filePath toPath:shardedPath error:&error]) {
+            migratedCount++;
+        } else {
+            RKLogWarning(@"Failed to migrate cache file '%@' into sharded store: %@", filePath, [error localizedDescription]);
+        }
+    }
+    
+    if (migratedCount > 0) {
+        RKLogInfo(@"Migrated %lu cache files in '%@' to the sharded directory layout", (unsigned long) migratedCount, storePath);
+    }
+}
+
+// Indexes the entries in the permanent store. Invoked when the cache is opened without an index,
+// either for the first time or after the index has been deleted. Session entries never outlive
+// the session, so only the permanent store needs scanning.
+- (void)rebuildIndex {
+    NSString* storePath = [_cachePath stringByAppendingPathComponent:permanentCacheFolder];
+    NSDirectoryEnumerator* enumerator = [[NSFileManager defaultManager] enumeratorAtPath:storePath];
+    NSString* relativePath = nil;
+    NSUInteger entryCount = 0;
+    while ((relativePath = [enumerator nextObject])) {
+        if (! [[[enumerator fileAttributes] fileType] isEqualToString:NSFileTypeRegular] ||
+            [[relativePath pathExtension] isEqualToString:headersExtension] ||
+            [[relativePath pathExtension] isEqualToString:parsedObjectExtension]) {
+            continue;
+        }
+        
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        NSString* cachePath = [storePath stringByAppendingPathComponent:relativePath];
+        RKRequestCacheEntry* entry = [self entryAtCachePath:cachePath];
+        if (entry) {
+            [self indexEntry:entry atCachePath:cachePath];
+            entryCount++;
+        } else {
+            RKLogWarning(@"Removing unreadable cache file at path '%@'", cachePath);
+            [[NSFileManager defaultManager] removeItemAtPath:cachePath error:nil];
+        }
+        [pool drain];
+    }
+    
+    RKLogInfo(@"Rebuilt cache index for '%@' with %lu entries", _cachePath, (unsigned long) entryCount);
+    NSInvocationOperation* operation = [[NSInvocationOperation alloc] initWithTarget:_index selector:@selector(compact) object:nil];
+    [_writeQueue addOperation:operation];
+    [operation release];
+}
+
+- (void)removeEntryAtCachePath:(NSString*)cachePath {
+    [_memoryCache removeEntryForKey:cachePath];
+    RKRequestCacheIndexEntry* indexEntry = [_index entryForKey:[cachePath lastPathComponent]];
+    if (indexEntry.storagePolicy == [self storagePolicyForCachePath:cachePath]) {
+        [_index removeEntryForKey:indexEntry.cacheKey];
+        [self enqueueIndexSynchronization];
+    }
+    [_pendingEntries removeObjectForKey:cachePath];
+    [self enqueueRemovalForCachePath:cachePath];
+}
+
+- (void)setEvictionPolicy:(RKRequestCacheEvictionPolicy)evictionPolicy {
+    [_cacheLock lock];
+    _evictionPolicy = evictionPolicy;
+    _index.evictionPolicy = evictionPolicy;
+    [_cacheLock unlock];
+}
+
+- (void)evictPermanentEntriesIfNecessary {
+    [self evictPermanentEntriesExcludingKey:nil];
+}
+
+- (void)evictPermanentEntriesExcludingKey:(NSString*)cacheKey {
+    if (! [self isPermanentStoreLimited]) {
+        return;
+    }
+    
+    [_cacheLock lock];
+    unsigned long long size = [_index sizeOfEntriesWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
+    NSUInteger count = [_index countOfEntriesWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
+    
+    BOOL overSize = (_maximumPermanentStoreSize > 0 && size > _maximumPermanentStoreSize);
+    BOOL overCount = (_maximumPermanentStoreEntryCount > 0 && count > _maximumPermanentStoreEntryCount);
+    if (overSize || overCount) {
+        // Evict down to a low water mark so that every subsequent store does not trigger another pass
+        unsigned long long targetSize = _maximumPermanentStoreSize - (_maximumPermanentStoreSize / 10);
+        NSUInteger targetCount = _maximumPermanentStoreEntryCount - (_maximumPermanentStoreEntryCount / 10);
+        NSUInteger evictedCount = 0;
+        
+        while (YES) {
+            BOOL sizeSatisfied = (_maximumPermanentStoreSize == 0 || size <= targetSize);
+            BOOL countSatisfied = (_maximumPermanentStoreEntryCount == 0 || count <= targetCount);
+            if (sizeSatisfied && countSatisfied) {
+                break;
+            }
+            
+            // The index keeps permanent entries in eviction order, so the next candidate is always at the front
+            RKRequestCacheIndexEntry* indexEntry = [_index nextEntryToEvictExcludingKey:cacheKey];
+            if (nil == indexEntry) {
+                break;
+            }
+            
+            NSString* cachePath = [self cachePathForKey:indexEntry.cacheKey storagePolicy:RKRequestCacheStoragePolicyPermanently];
+            RKLogTrace(@"Evicting permanent cache entry at path '%@'", cachePath);
+            [_index recordEvictionOfEntry:indexEntry];
+            [self removeEntryAtCachePath:cachePath];
+            size -= indexEntry.size;
+            count--;
+            evictedCount++;
+        }
+        
+        RKLogDebug(@"Evicted %lu permanent cache entries, %llu bytes in %lu entries remain", 
+                   (unsigned long) evictedCount, size, (unsigned long) count);
+    }
+    
+    [_cacheLock unlock];
+}
+
 @end
@@ -0,0 +1,96 @@
+//
+//  RKRequestCacheCoding.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+/**
+ Little endian encoding helpers shared by the request cache's on-disk formats:
+ the cache entry files and the cache index. Internal to RestKit.
+ */
+
+#import <Foundation/Foundation.h>
+
+#pragma mark - Encoding
+
+static inline void RKCacheAppendUInt8(NSMutableData* data, uint8_t value) {
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static inline void RKCacheAppendUInt16(NSMutableData* data, uint16_t value) {
+    value = CFSwapInt16HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static inline void RKCacheAppendUInt32(NSMutableData* data, uint32_t value) {
+    value = CFSwapInt32HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static inline void RKCacheAppendUInt64(NSMutableData* data, uint64_t value) {
+    value = CFSwapInt64HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+// Dates are stored as seconds since the reference date, with zero standing in for nil
+static inline void RKCacheAppendDate(NSMutableData* data, NSDate* date) {
+    CFSwappedFloat64 value = CFConvertDoubleHostToSwapped(date ? [date timeIntervalSinceReferenceDate] : 0);
+    // CFSwappedFloat64 is big endian; store little endian like every other field
+    RKCacheAppendUInt64(data, CFSwapInt64BigToHost(value.v));
+}
+
+// Strings are stored as a 32 bit length followed by their UTF-8 bytes
+static inline void RKCacheAppendString(NSMutableData* data, NSString* string) {
+    NSData* bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+    RKCacheAppendUInt32(data, (uint32_t) [bytes length]);
+    [data appendData:bytes];
+}
+
+#pragma mark - Decoding
+
+static inline uint16_t RKCacheReadUInt16(const uint8_t* bytes) {
+    uint16_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt16LittleToHost(value);
+}
+
+static inline uint32_t RKCacheReadUInt32(const uint8_t* bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t RKCacheReadUInt64(const uint8_t* bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt64LittleToHost(value);
+}
+
+static inline NSDate* RKCacheReadDate(const uint8_t* bytes) {
+    CFSwappedFloat64 value;
+    value.v = CFSwapInt64HostToBig(RKCacheReadUInt64(bytes));
+    double interval = CFConvertDoubleSwappedToHost(value);
+    return (interval == 0) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate:interval];
+}
+
+// Returns a retained string, or nil for an empty one
+static inline NSString* RKCacheCreateString(const uint8_t* bytes, NSUInteger length) {
+    if (length == 0) {
+        return nil;
+    }
+
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+}
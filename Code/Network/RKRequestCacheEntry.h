@@ -0,0 +1,121 @@
+//
+//  RKRequestCacheEntry.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A cached response as stored on disk by RKRequestCache.
+
+ Each entry is a single file: a fixed size header, followed by the MIME type, URL and
+ ETag as UTF-8 strings, the HTTP headers as length prefixed UTF-8 key/value pairs and
+ finally the raw body. All integers and dates are stored little endian; dates are seconds
+ since the reference date, with zero meaning absent.
+
+    offset  size  field
+    0       4     magic 'RKCE'
+    4       2     format version
+    6       2     flags (reserved)
+    8       4     HTTP status code
+    12      4     number of HTTP headers
+    16      8     cache date
+    24      8     Last-Modified date
+    32      8     expiration date
+    40      4     MIME type length
+    44      4     URL length
+    48      4     ETag length
+    52      4     HTTP headers length
+    56      8     body length
+    64            variable length sections
+
+ Entries are read through a memory mapping. The body of an entry read from disk references
+ the mapped file directly, so it can be handed to an RKResponse without being copied.
+ */
+@interface RKRequestCacheEntry : NSObject <NSCopying> {
+    NSInteger _statusCode;
+    NSString *_MIMEType;
+    NSString *_URL;
+    NSString *_ETag;
+    NSDate *_cacheDate;
+    NSDate *_lastModifiedDate;
+    NSDate *_expirationDate;
+    NSDictionary *_headers;
+    NSData *_body;
+}
+
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, copy) NSString *MIMEType;
+@property (nonatomic, copy) NSString *URL;
+@property (nonatomic, copy) NSString *ETag;
+@property (nonatomic, retain) NSDate *cacheDate;
+@property (nonatomic, retain) NSDate *lastModifiedDate;
+@property (nonatomic, retain) NSDate *expirationDate;
+
+/**
+ The HTTP headers of the cached response
+ */
+@property (nonatomic, copy) NSDictionary *headers;
+
+/**
+ The body of the cached response
+ */
+@property (nonatomic, retain) NSData *body;
+
+/**
+ Returns YES when the file at the path begins with the entry format's magic number
+ */
++ (BOOL)isEntryAtPath:(NSString *)path;
+
+/**
+ Reads an entry from the file at the path. Returns nil if there is no file at the
+ path or it is not a complete entry.
+ */
++ (RKRequestCacheEntry *)entryWithContentsOfFile:(NSString *)path;
+
+/**
+ Initializes an entry by decoding data in the entry format. Returns nil if the data is not a complete entry.
+ */
+- (id)initWithData:(NSData *)data;
+
+/**
+ Returns the entry encoded in the entry format
+ */
+- (NSData *)data;
+
+/**
+ Returns the number of bytes the entry occupies when encoded, without encoding it
+ */
+- (unsigned long long)encodedLength;
+
+/**
+ Atomically writes the entry to the file at the path
+ */
+- (BOOL)writeToFile:(NSString *)path error:(NSError **)error;
+
+/**
+ Rewrites the cache date in the header of the entry at the path in place,
+ without reading or rewriting the rest of the entry.
+ */
++ (BOOL)setCacheDate:(NSDate *)cacheDate forEntryAtPath:(NSString *)path;
+
+/**
+ Rewrites the expiration date in the header of the entry at the path in place
+ */
++ (BOOL)setExpirationDate:(NSDate *)expirationDate forEntryAtPath:(NSString *)path;
+
+@end
@@ -0,0 +1,275 @@
+//
+//  RKRequestCacheEntry.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestCacheEntry.h"
+#import "RKRequestCacheCoding.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetworkCache
+
+static const char kEntryMagic[4] = { 'R', 'K', 'C', 'E' };
+static const uint16_t kEntryVersion = 1;
+static const NSUInteger kEntryHeaderLength = 64;
+static const NSUInteger kEntryCacheDateOffset = 16;
+static const NSUInteger kEntryExpirationDateOffset = 32;
+
+// Releases the data backing a slice once the slice is deallocated
+static void RKEntrySliceDeallocate(void* ptr, void* info) {
+    CFRelease((CFTypeRef) info);
+}
+
+/**
+ Returns an immutable data object referencing a range of the bytes of data without copying them.
+ The slice keeps data alive until it is deallocated itself.
+ */
+static NSData* RKEntryCreateSlice(NSData* data, NSRange range) {
+    if (range.length == 0) {
+        return [[NSData alloc] init];
+    }
+
+    CFAllocatorContext context = { 0, [data retain], NULL, NULL, NULL, NULL, NULL, RKEntrySliceDeallocate, NULL };
+    CFAllocatorRef deallocator = CFAllocatorCreate(kCFAllocatorDefault, &context);
+    CFDataRef slice = CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, (const UInt8*)[data bytes] + range.location, range.length, deallocator);
+    CFRelease(deallocator);
+
+    return (NSData*) slice;
+}
+
+@implementation RKRequestCacheEntry
+
+@synthesize statusCode = _statusCode;
+@synthesize MIMEType = _MIMEType;
+@synthesize URL = _URL;
+@synthesize ETag = _ETag;
+@synthesize cacheDate = _cacheDate;
+@synthesize lastModifiedDate = _lastModifiedDate;
+@synthesize expirationDate = _expirationDate;
+@synthesize headers = _headers;
+@synthesize body = _body;
+
++ (BOOL)isEntryAtPath:(NSString*)path {
+    NSFileHandle* fileHandle = [NSFileHandle fileHandleForReadingAtPath:path];
+    NSData* magic = [fileHandle readDataOfLength:sizeof(kEntryMagic)];
+    [fileHandle closeFile];
+
+    return ([magic length] == sizeof(kEntryMagic) && memcmp([magic bytes], kEntryMagic, sizeof(kEntryMagic)) == 0);
+}
+
++ (RKRequestCacheEntry*)entryWithContentsOfFile:(NSString*)path {
+    NSError* error = nil;
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMapped error:&error];
+    if (nil == data) {
+        return nil;
+    }
+
+    RKRequestCacheEntry* entry = [[[self alloc] initWithData:data] autorelease];
+    if (nil == entry) {
+        RKLogTrace(@"File at path '%@' is not a cache entry", path);
+    }
+
+    return entry;
+}
+
+- (id)initWithData:(NSData*)data {
+    const uint8_t* bytes = [data bytes];
+    NSUInteger length = [data length];
+    if (length < kEntryHeaderLength || memcmp(bytes, kEntryMagic, sizeof(kEntryMagic)) != 0) {
+        [self release];
+        return nil;
+    }
+
+    uint16_t version = RKCacheReadUInt16(bytes + 4);
+    if (version != kEntryVersion) {
+        RKLogWarning(@"Unable to read cache entry with unsupported format version %u", version);
+        [self release];
+        return nil;
+    }
+
+    uint32_t headerCount = RKCacheReadUInt32(bytes + 12);
+    uint64_t MIMETypeLength = RKCacheReadUInt32(bytes + 40);
+    uint64_t URLLength = RKCacheReadUInt32(bytes + 44);
+    uint64_t ETagLength = RKCacheReadUInt32(bytes + 48);
+    uint64_t headersLength = RKCacheReadUInt32(bytes + 52);
+    uint64_t bodyLength = RKCacheReadUInt64(bytes + 56);
+    if (kEntryHeaderLength + MIMETypeLength + URLLength + ETagLength + headersLength + bodyLength != length) {
+        RKLogWarning(@"Unable to read truncated or corrupt cache entry");
+        [self release];
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _statusCode = (int32_t) RKCacheReadUInt32(bytes + 8);
+        _cacheDate = [RKCacheReadDate(bytes + 16) retain];
+        _lastModifiedDate = [RKCacheReadDate(bytes + 24) retain];
+        _expirationDate = [RKCacheReadDate(bytes + 32) retain];
+
+        const uint8_t* cursor = bytes + kEntryHeaderLength;
+        _MIMEType = RKCacheCreateString(cursor, (NSUInteger) MIMETypeLength);
+        cursor += MIMETypeLength;
+        _URL = RKCacheCreateString(cursor, (NSUInteger) URLLength);
+        cursor += URLLength;
+        _ETag = RKCacheCreateString(cursor, (NSUInteger) ETagLength);
+        cursor += ETagLength;
+
+        const uint8_t* headersEnd = cursor + headersLength;
+        NSMutableDictionary* headers = [NSMutableDictionary dictionaryWithCapacity:headerCount];
+        for (uint32_t i = 0; i < headerCount; i++) {
+            NSString* strings[2] = { nil, nil };
+            for (int j = 0; j < 2; j++) {
+                if (cursor + 4 > headersEnd) {
+                    break;
+                }
+                uint32_t stringLength = RKCacheReadUInt32(cursor);
+                cursor += 4;
+                if (cursor + stringLength > headersEnd) {
+                    break;
+                }
+                strings[j] = [RKCacheCreateString(cursor, stringLength) autorelease];
+                cursor += stringLength;
+            }
+            if (strings[0]) {
+                [headers setObject:(strings[1] ? strings[1] : @"") forKey:strings[0]];
+            }
+        }
+        _headers = [headers copy];
+
+        _body = RKEntryCreateSlice(data, NSMakeRange((NSUInteger) (headersEnd - bytes), (NSUInteger) bodyLength));
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_MIMEType release];
+    [_URL release];
+    [_ETag release];
+    [_cacheDate release];
+    [_lastModifiedDate release];
+    [_expirationDate release];
+    [_headers release];
+    [_body release];
+
+    [super dealloc];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p statusCode=%ld URL=%@ ETag=%@ cacheDate=%@ bodyLength=%lu>",
+            NSStringFromClass([self class]), self, (long) _statusCode, _URL, _ETag, _cacheDate, (unsigned long) [_body length]];
+}
+
+- (id)copyWithZone:(NSZone*)zone {
+    RKRequestCacheEntry* copy = [[[self class] allocWithZone:zone] init];
+    copy.statusCode = _statusCode;
+    copy.MIMEType = _MIMEType;
+    copy.URL = _URL;
+    copy.ETag = _ETag;
+    copy.cacheDate = _cacheDate;
+    copy.lastModifiedDate = _lastModifiedDate;
+    copy.expirationDate = _expirationDate;
+    copy.headers = _headers;
+    copy.body = _body;
+
+    return copy;
+}
+
+- (unsigned long long)encodedLength {
+    unsigned long long length = kEntryHeaderLength;
+    length += [_MIMEType lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    length += [_URL lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    length += [_ETag lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    for (id key in _headers) {
+        length += 8 + [[key description] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        length += [[[_headers objectForKey:key] description] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+
+    return length + [_body length];
+}
+
+- (NSData*)data {
+    NSMutableData* headersData = [NSMutableData data];
+    for (id key in _headers) {
+        RKCacheAppendString(headersData, [key description]);
+        RKCacheAppendString(headersData, [[_headers objectForKey:key] description]);
+    }
+
+    NSData* MIMETypeData = [_MIMEType dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* URLData = [_URL dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* ETagData = [_ETag dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSUInteger length = kEntryHeaderLength + [MIMETypeData length] + [URLData length] + [ETagData length] + [headersData length] + [_body length];
+    NSMutableData* data = [NSMutableData dataWithCapacity:length];
+    [data appendBytes:kEntryMagic length:sizeof(kEntryMagic)];
+    RKCacheAppendUInt16(data, kEntryVersion);
+    RKCacheAppendUInt16(data, 0);
+    RKCacheAppendUInt32(data, (uint32_t) _statusCode);
+    RKCacheAppendUInt32(data, (uint32_t) [_headers count]);
+    RKCacheAppendDate(data, _cacheDate);
+    RKCacheAppendDate(data, _lastModifiedDate);
+    RKCacheAppendDate(data, _expirationDate);
+    RKCacheAppendUInt32(data, (uint32_t) [MIMETypeData length]);
+    RKCacheAppendUInt32(data, (uint32_t) [URLData length]);
+    RKCacheAppendUInt32(data, (uint32_t) [ETagData length]);
+    RKCacheAppendUInt32(data, (uint32_t) [headersData length]);
+    RKCacheAppendUInt64(data, [_body length]);
+    NSAssert([data length] == kEntryHeaderLength, @"Cache entry header must be %lu bytes", (unsigned long) kEntryHeaderLength);
+
+    if (MIMETypeData) [data appendData:MIMETypeData];
+    if (URLData) [data appendData:URLData];
+    if (ETagData) [data appendData:ETagData];
+    [data appendData:headersData];
+    if (_body) [data appendData:_body];
+
+    return data;
+}
+
+- (BOOL)writeToFile:(NSString*)path error:(NSError**)error {
+    return [[self data] writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
++ (BOOL)setDate:(NSDate*)date atOffset:(unsigned long long)offset forEntryAtPath:(NSString*)path {
+    if (! [self isEntryAtPath:path]) {
+        return NO;
+    }
+
+    NSFileHandle* fileHandle = [NSFileHandle fileHandleForUpdatingAtPath:path];
+    if (nil == fileHandle) {
+        return NO;
+    }
+
+    NSMutableData* dateData = [NSMutableData dataWithCapacity:8];
+    RKCacheAppendDate(dateData, date);
+    [fileHandle seekToFileOffset:offset];
+    [fileHandle writeData:dateData];
+    [fileHandle closeFile];
+
+    return YES;
+}
+
++ (BOOL)setCacheDate:(NSDate*)cacheDate forEntryAtPath:(NSString*)path {
+    return [self setDate:cacheDate atOffset:kEntryCacheDateOffset forEntryAtPath:path];
+}
+
++ (BOOL)setExpirationDate:(NSDate*)expirationDate forEntryAtPath:(NSString*)path {
+    return [self setDate:expirationDate atOffset:kEntryExpirationDateOffset forEntryAtPath:path];
+}
+
+@end
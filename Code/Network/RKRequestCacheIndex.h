@@ -0,0 +1,204 @@
+//
+//  RKRequestCacheIndex.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "RKRequestCache.h"
+
+/**
+ The metadata of a single cache entry as recorded in the cache index
+ */
+@interface RKRequestCacheIndexEntry : NSObject <NSCopying> {
+    NSString *_cacheKey;
+    RKRequestCacheStoragePolicy _storagePolicy;
+    NSString *_ETag;
+    NSDate *_lastModifiedDate;
+    NSDate *_cacheDate;
+    NSDate *_expirationDate;
+    unsigned long long _size;
+    NSUInteger _accessCount;
+    NSTimeInterval _lastAccessTime;
+}
+
+@property (nonatomic, copy) NSString *cacheKey;
+@property (nonatomic, assign) RKRequestCacheStoragePolicy storagePolicy;
+@property (nonatomic, copy) NSString *ETag;
+@property (nonatomic, retain) NSDate *lastModifiedDate;
+@property (nonatomic, retain) NSDate *cacheDate;
+@property (nonatomic, retain) NSDate *expirationDate;
+
+/**
+ The number of bytes the entry occupies on disk
+ */
+@property (nonatomic, assign) unsigned long long size;
+
+/**
+ The number of times the entry has been loaded, plus one for the store. Under least
+ frequently used eviction the count of a new entry starts at the index's frequency age
+ instead, so that it is not evicted ahead of entries that have merely been around longer.
+ */
+@property (nonatomic, assign) NSUInteger accessCount;
+
+/**
+ When the entry was last stored or loaded, in seconds since the reference date
+ */
+@property (nonatomic, assign) NSTimeInterval lastAccessTime;
+
+/**
+ Orders entries from least to most recently used
+ */
+- (NSComparisonResult)compareRecency:(RKRequestCacheIndexEntry *)otherEntry;
+
+/**
+ Orders entries from least to most frequently used, then by recency
+ */
+- (NSComparisonResult)compareFrequency:(RKRequestCacheIndexEntry *)otherEntry;
+
+@end
+
+/**
+ A persistent index of the entries held by an RKRequestCache, keyed by cache key.
+
+ The index is a dictionary held in memory, so existence checks and validator lookups
+ (ETag, Last-Modified, cache date and expiration) never touch the filesystem. It is
+ persisted as a snapshot file plus an append-only journal of changes: mutations are
+ buffered in memory and appended to the journal by synchronize, and the journal is
+ folded into a fresh snapshot once it grows larger than the index itself. A journal
+ cut short by a crash is replayed up to its last complete record.
+
+ Access counts and times are updated in memory only; they are persisted whenever the
+ entry is next journaled and by every snapshot.
+
+ The index is safe to use from any thread.
+ */
+@interface RKRequestCacheIndex : NSObject {
+    NSString *_path;
+    NSMutableDictionary *_entries;
+    NSMutableData *_journalBuffer;
+    NSUInteger _journalRecordCount;
+    unsigned long long _sizes[3];
+    NSUInteger _counts[3];
+    NSMutableArray *_evictionOrder;
+    RKRequestCacheEvictionPolicy _evictionPolicy;
+    NSUInteger _frequencyAge;
+}
+
+/**
+ The path of the snapshot file. The journal is kept alongside it with a .journal extension.
+ */
+@property (nonatomic, readonly) NSString *path;
+
+/**
+ The number of entries in the index
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ The order in which permanently stored entries are offered for eviction.
+
+ **Default**: RKRequestCacheEvictionPolicyLeastRecentlyUsed
+ */
+@property (nonatomic, assign) RKRequestCacheEvictionPolicy evictionPolicy;
+
+/**
+ The access count of the most frequently used entry evicted so far. Entries stored
+ under least frequently used eviction start counting from one above it.
+ */
+@property (nonatomic, readonly) NSUInteger frequencyAge;
+
+/**
+ Returns YES when there are changes that have not yet been appended to the journal
+ */
+@property (nonatomic, readonly) BOOL hasUnsynchronizedChanges;
+
+/**
+ Initializes an empty index persisted at the path
+ */
+- (id)initWithPath:(NSString *)path;
+
+/**
+ Loads the snapshot and replays the journal. Returns NO when neither exists, in which
+ case the index should be rebuilt from the entries on disk.
+ */
+- (BOOL)load;
+
+/**
+ Returns the entry for the cache key, or nil
+ */
+- (RKRequestCacheIndexEntry *)entryForKey:(NSString *)cacheKey;
+
+/**
+ Adds or replaces the entry for its cache key and journals the change. The index keeps a copy of the entry.
+ */
+- (void)setEntry:(RKRequestCacheIndexEntry *)entry;
+
+/**
+ Removes the entry for the cache key and journals the change
+ */
+- (void)removeEntryForKey:(NSString *)cacheKey;
+
+/**
+ Removes every entry with the storage policy and journals the change
+ */
+- (void)removeEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
+
+/**
+ Records a use of the entry for the cache key, in memory only
+ */
+- (void)recordAccessForKey:(NSString *)cacheKey;
+
+/**
+ Returns copies of the entries with the storage policy
+ */
+- (NSArray *)entriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
+
+/**
+ Returns the number of bytes occupied by the entries with the storage policy
+ */
+- (unsigned long long)sizeOfEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
+
+/**
+ Returns the number of entries with the storage policy
+ */
+- (NSUInteger)countOfEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy;
+
+/**
+ Returns a copy of the permanently stored entry that should be evicted next under the
+ eviction policy, skipping the entry for the cache key, or nil when there is none.
+ Permanent entries are kept in eviction order as they change, so this never sorts.
+ */
+- (RKRequestCacheIndexEntry *)nextEntryToEvictExcludingKey:(NSString *)cacheKey;
+
+/**
+ Raises the frequency age to the access count of an entry that is being evicted. The
+ entry itself is removed with removeEntryForKey:.
+ */
+- (void)recordEvictionOfEntry:(RKRequestCacheIndexEntry *)entry;
+
+/**
+ Appends buffered changes to the journal, compacting the journal into a new snapshot
+ when it has grown larger than the index. Performs file I/O; call it off the main thread.
+ */
+- (void)synchronize;
+
+/**
+ Writes a new snapshot of the whole index and empties the journal. Performs file I/O.
+ */
+- (void)compact;
+
+@end
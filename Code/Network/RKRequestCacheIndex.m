@@ -0,0 +1,614 @@
+//
+//  RKRequestCacheIndex.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestCacheIndex.h"
+#import "RKRequestCacheCoding.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetworkCache
+
+static const char kIndexMagic[4] = { 'R', 'K', 'C', 'I' };
+static const uint16_t kIndexVersion = 1;
+static NSString* const kJournalExtension = @"journal";
+
+// Journals shorter than this are never compacted
+static const NSUInteger kMinimumCompactionRecordCount = 256;
+
+typedef enum {
+    RKRequestCacheIndexRecordPut = 1,
+    RKRequestCacheIndexRecordRemove = 2,
+    RKRequestCacheIndexRecordRemoveStoragePolicy = 3
+} RKRequestCacheIndexRecordType;
+
+/**
+ Bounds checked cursor over a snapshot or journal. Reads past the end set overrun
+ and return zero values, so a truncated trailing record is detected once it has been read.
+ */
+typedef struct {
+    const uint8_t* bytes;
+    NSUInteger length;
+    NSUInteger offset;
+    BOOL overrun;
+} RKRequestCacheIndexReader;
+
+static BOOL RKIndexReaderHasBytes(RKRequestCacheIndexReader* reader, NSUInteger count) {
+    if (reader->overrun || reader->length - reader->offset < count) {
+        reader->overrun = YES;
+        return NO;
+    }
+
+    return YES;
+}
+
+static uint8_t RKIndexReadUInt8(RKRequestCacheIndexReader* reader) {
+    if (! RKIndexReaderHasBytes(reader, 1)) return 0;
+    uint8_t value = reader->bytes[reader->offset];
+    reader->offset += 1;
+    return value;
+}
+
+static uint32_t RKIndexReadUInt32(RKRequestCacheIndexReader* reader) {
+    if (! RKIndexReaderHasBytes(reader, 4)) return 0;
+    uint32_t value = RKCacheReadUInt32(reader->bytes + reader->offset);
+    reader->offset += 4;
+    return value;
+}
+
+static uint64_t RKIndexReadUInt64(RKRequestCacheIndexReader* reader) {
+    if (! RKIndexReaderHasBytes(reader, 8)) return 0;
+    uint64_t value = RKCacheReadUInt64(reader->bytes + reader->offset);
+    reader->offset += 8;
+    return value;
+}
+
+static NSDate* RKIndexReadDate(RKRequestCacheIndexReader* reader) {
+    if (! RKIndexReaderHasBytes(reader, 8)) return nil;
+    NSDate* date = RKCacheReadDate(reader->bytes + reader->offset);
+    reader->offset += 8;
+    return date;
+}
+
+static NSString* RKIndexReadString(RKRequestCacheIndexReader* reader) {
+    uint32_t length = RKIndexReadUInt32(reader);
+    if (! RKIndexReaderHasBytes(reader, length)) return nil;
+    NSString* string = [RKCacheCreateString(reader->bytes + reader->offset, length) autorelease];
+    reader->offset += length;
+    return string;
+}
+
+@implementation RKRequestCacheIndexEntry
+
+@synthesize cacheKey = _cacheKey;
+@synthesize storagePolicy = _storagePolicy;
+@synthesize ETag = _ETag;
+@synthesize lastModifiedDate = _lastModifiedDate;
+@synthesize cacheDate = _cacheDate;
+@synthesize expirationDate = _expirationDate;
+@synthesize size = _size;
+@synthesize accessCount = _accessCount;
+@synthesize lastAccessTime = _lastAccessTime;
+
+- (void)dealloc {
+    [_cacheKey release];
+    [_ETag release];
+    [_lastModifiedDate release];
+    [_cacheDate release];
+    [_expirationDate release];
+
+    [super dealloc];
+}
+
+- (id)copyWithZone:(NSZone*)zone {
+    RKRequestCacheIndexEntry* copy = [[[self class] allocWithZone:zone] init];
+    copy.cacheKey = _cacheKey;
+    copy.storagePolicy = _storagePolicy;
+    copy.ETag = _ETag;
+    copy.lastModifiedDate = _lastModifiedDate;
+    copy.cacheDate = _cacheDate;
+    copy.expirationDate = _expirationDate;
+    copy.size = _size;
+    copy.accessCount = _accessCount;
+    copy.lastAccessTime = _lastAccessTime;
+
+    return copy;
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p cacheKey=%@ storagePolicy=%d ETag=%@ cacheDate=%@ size=%llu>",
+            NSStringFromClass([self class]), self, _cacheKey, _storagePolicy, _ETag, _cacheDate, _size];
+}
+
+- (NSComparisonResult)compareRecency:(RKRequestCacheIndexEntry*)otherEntry {
+    if (_lastAccessTime < otherEntry.lastAccessTime) {
+        return NSOrderedAscending;
+    } else if (_lastAccessTime > otherEntry.lastAccessTime) {
+        return NSOrderedDescending;
+    }
+
+    return NSOrderedSame;
+}
+
+- (NSComparisonResult)compareFrequency:(RKRequestCacheIndexEntry*)otherEntry {
+    if (_accessCount < otherEntry.accessCount) {
+        return NSOrderedAscending;
+    } else if (_accessCount > otherEntry.accessCount) {
+        return NSOrderedDescending;
+    }
+
+    return [self compareRecency:otherEntry];
+}
+
+@end
+
+@interface RKRequestCacheIndex (Private)
+- (NSString*)journalPath;
+- (void)appendRecordForEntry:(RKRequestCacheIndexEntry*)entry toData:(NSMutableData*)data;
+- (NSUInteger)replayRecordsWithReader:(RKRequestCacheIndexReader*)reader;
+- (void)addEntry:(RKRequestCacheIndexEntry*)entry;
+- (void)removeEntry:(RKRequestCacheIndexEntry*)entry;
+- (NSComparisonResult)compareEvictionOrderOfEntry:(RKRequestCacheIndexEntry*)entry toEntry:(RKRequestCacheIndexEntry*)otherEntry;
+- (NSUInteger)evictionOrderInsertionIndexForEntry:(RKRequestCacheIndexEntry*)entry;
+- (NSUInteger)evictionOrderIndexOfEntry:(RKRequestCacheIndexEntry*)entry;
+- (BOOL)appendBufferedRecordsToJournal;
+- (BOOL)writeSnapshot;
+@end
+
+@implementation RKRequestCacheIndex
+
+@synthesize path = _path;
+@synthesize evictionPolicy = _evictionPolicy;
+
+- (id)initWithPath:(NSString*)path {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        _entries = [[NSMutableDictionary alloc] init];
+        _journalBuffer = [[NSMutableData alloc] init];
+        _evictionOrder = [[NSMutableArray alloc] init];
+        _evictionPolicy = RKRequestCacheEvictionPolicyLeastRecentlyUsed;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_path release];
+    _path = nil;
+    [_entries release];
+    _entries = nil;
+    [_journalBuffer release];
+    _journalBuffer = nil;
+    [_evictionOrder release];
+    _evictionOrder = nil;
+
+    [super dealloc];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p path=%@ count=%lu>",
+            NSStringFromClass([self class]), self, _path, (unsigned long) [self count]];
+}
+
+- (NSString*)journalPath {
+    return [_path stringByAppendingPathExtension:kJournalExtension];
+}
+
+- (NSUInteger)count {
+    @synchronized(self) {
+        return [_entries count];
+    }
+}
+
+- (void)setEvictionPolicy:(RKRequestCacheEvictionPolicy)evictionPolicy {
+    @synchronized(self) {
+        if (evictionPolicy != _evictionPolicy) {
+            _evictionPolicy = evictionPolicy;
+            SEL comparator = (_evictionPolicy == RKRequestCacheEvictionPolicyLeastFrequentlyUsed) ? @selector(compareFrequency:) : @selector(compareRecency:);
+            [_evictionOrder sortUsingSelector:comparator];
+        }
+    }
+}
+
+- (NSUInteger)frequencyAge {
+    @synchronized(self) {
+        return _frequencyAge;
+    }
+}
+
+- (BOOL)hasUnsynchronizedChanges {
+    @synchronized(self) {
+        return [_journalBuffer length] > 0;
+    }
+}
+
+#pragma mark - Entries
+
+- (void)addEntry:(RKRequestCacheIndexEntry*)entry {
+    [self removeEntry:[_entries objectForKey:entry.cacheKey]];
+    [_entries setObject:entry forKey:entry.cacheKey];
+    _sizes[entry.storagePolicy % 3] += entry.size;
+    _counts[entry.storagePolicy % 3]++;
+    if (entry.storagePolicy == RKRequestCacheStoragePolicyPermanently) {
+        [_evictionOrder insertObject:entry atIndex:[self evictionOrderInsertionIndexForEntry:entry]];
+    }
+}
+
+- (void)removeEntry:(RKRequestCacheIndexEntry*)entry {
+    if (entry) {
+        _sizes[entry.storagePolicy % 3] -= entry.size;
+        _counts[entry.storagePolicy % 3]--;
+        if (entry.storagePolicy == RKRequestCacheStoragePolicyPermanently) {
+            [_evictionOrder removeObjectAtIndex:[self evictionOrderIndexOfEntry:entry]];
+        }
+        // The dictionary may hold the last reference to the entry and its key
+        NSString* cacheKey = [[entry.cacheKey retain] autorelease];
+        [_entries removeObjectForKey:cacheKey];
+    }
+}
+
+- (RKRequestCacheIndexEntry*)entryForKey:(NSString*)cacheKey {
+    if (nil == cacheKey) {
+        return nil;
+    }
+
+    @synchronized(self) {
+        return [[[_entries objectForKey:cacheKey] copy] autorelease];
+    }
+}
+
+- (void)setEntry:(RKRequestCacheIndexEntry*)entry {
+    NSAssert(entry.cacheKey, @"Cannot index a cache entry without a cache key");
+    RKRequestCacheIndexEntry* indexedEntry = [[entry copy] autorelease];
+
+    @synchronized(self) {
+        [self addEntry:indexedEntry];
+        [self appendRecordForEntry:indexedEntry toData:_journalBuffer];
+        _journalRecordCount++;
+    }
+}
+
+- (void)removeEntryForKey:(NSString*)cacheKey {
+    if (nil == cacheKey) {
+        return;
+    }
+
+    @synchronized(self) {
+        RKRequestCacheIndexEntry* entry = [_entries objectForKey:cacheKey];
+        if (entry) {
+            [self removeEntry:entry];
+            RKCacheAppendUInt8(_journalBuffer, RKRequestCacheIndexRecordRemove);
+            RKCacheAppendString(_journalBuffer, cacheKey);
+            _journalRecordCount++;
+        }
+    }
+}
+
+- (void)removeEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
+    @synchronized(self) {
+        for (RKRequestCacheIndexEntry* entry in [_entries allValues]) {
+            if (entry.storagePolicy == storagePolicy) {
+                [self removeEntry:entry];
+            }
+        }
+        RKCacheAppendUInt8(_journalBuffer, RKRequestCacheIndexRecordRemoveStoragePolicy);
+        RKCacheAppendUInt8(_journalBuffer, (uint8_t) storagePolicy);
+        _journalRecordCount++;
+    }
+}
+
+- (void)recordAccessForKey:(NSString*)cacheKey {
+    if (nil == cacheKey) {
+        return;
+    }
+
+    @synchronized(self) {
+        RKRequestCacheIndexEntry* entry = [_entries objectForKey:cacheKey];
+        if (nil == entry) {
+            return;
+        }
+
+        // Permanent entries are moved to their new place in the eviction order
+        BOOL permanent = (entry.storagePolicy == RKRequestCacheStoragePolicyPermanently);
+        if (permanent) {
+            [_evictionOrder removeObjectAtIndex:[self evictionOrderIndexOfEntry:entry]];
+        }
+        entry.accessCount = entry.accessCount + 1;
+        entry.lastAccessTime = [NSDate timeIntervalSinceReferenceDate];
+        if (permanent) {
+            [_evictionOrder insertObject:entry atIndex:[self evictionOrderInsertionIndexForEntry:entry]];
+        }
+    }
+}
+
+- (NSArray*)entriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
+    @synchronized(self) {
+        NSMutableArray* entries = [NSMutableArray arrayWithCapacity:[_entries count]];
+        for (RKRequestCacheIndexEntry* entry in [_entries objectEnumerator]) {
+            if (entry.storagePolicy == storagePolicy) {
+                [entries addObject:[[entry copy] autorelease]];
+            }
+        }
+
+        return entries;
+    }
+}
+
+- (unsigned long long)sizeOfEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
+    @synchronized(self) {
+        return _sizes[storagePolicy % 3];
+    }
+}
+
+- (NSUInteger)countOfEntriesWithStoragePolicy:(RKRequestCacheStoragePolicy)storagePolicy {
+    @synchronized(self) {
+        return _counts[storagePolicy % 3];
+    }
+}
+
+#pragma mark - Eviction Order
+
+- (NSComparisonResult)compareEvictionOrderOfEntry:(RKRequestCacheIndexEntry*)entry toEntry:(RKRequestCacheIndexEntry*)otherEntry {
+    if (_evictionPolicy == RKRequestCacheEvictionPolicyLeastFrequentlyUsed) {
+        return [entry compareFrequency:otherEntry];
+    }
+
+    return [entry compareRecency:otherEntry];
+}
+
+// Binary searches for the position after every entry ordered at or before the entry. Sent holding the lock
+- (NSUInteger)evictionOrderInsertionIndexForEntry:(RKRequestCacheIndexEntry*)entry {
+    NSUInteger low = 0;
+    NSUInteger high = [_evictionOrder count];
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        if ([self compareEvictionOrderOfEntry:[_evictionOrder objectAtIndex:middle] toEntry:entry] == NSOrderedDescending) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+// Binary searches for the first entry ordered alongside the entry, then steps through any ties. Sent holding the lock
+- (NSUInteger)evictionOrderIndexOfEntry:(RKRequestCacheIndexEntry*)entry {
+    NSUInteger low = 0;
+    NSUInteger high = [_evictionOrder count];
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        if ([self compareEvictionOrderOfEntry:[_evictionOrder objectAtIndex:middle] toEntry:entry] == NSOrderedAscending) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (NSUInteger index = low; index < [_evictionOrder count]; index++) {
+        RKRequestCacheIndexEntry* candidate = [_evictionOrder objectAtIndex:index];
+        if (candidate == entry) {
+            return index;
+        }
+        if ([self compareEvictionOrderOfEntry:candidate toEntry:entry] != NSOrderedSame) {
+            break;
+        }
+    }
+
+    // Only reached if an entry was mutated without being reordered
+    return [_evictionOrder indexOfObjectIdenticalTo:entry];
+}
+
+- (RKRequestCacheIndexEntry*)nextEntryToEvictExcludingKey:(NSString*)cacheKey {
+    @synchronized(self) {
+        for (RKRequestCacheIndexEntry* entry in _evictionOrder) {
+            if (! [entry.cacheKey isEqualToString:cacheKey]) {
+                return [[entry copy] autorelease];
+            }
+        }
+
+        return nil;
+    }
+}
+
+- (void)recordEvictionOfEntry:(RKRequestCacheIndexEntry*)entry {
+    @synchronized(self) {
+        if (_evictionPolicy == RKRequestCacheEvictionPolicyLeastFrequentlyUsed) {
+            _frequencyAge = MAX(_frequencyAge, entry.accessCount);
+        }
+    }
+}
+
+#pragma mark - Persistence
+
+- (void)appendRecordForEntry:(RKRequestCacheIndexEntry*)entry toData:(NSMutableData*)data {
+    RKCacheAppendUInt8(data, RKRequestCacheIndexRecordPut);
+    RKCacheAppendString(data, entry.cacheKey);
+    RKCacheAppendUInt8(data, (uint8_t) entry.storagePolicy);
+    RKCacheAppendString(data, entry.ETag);
+    RKCacheAppendDate(data, entry.lastModifiedDate);
+    RKCacheAppendDate(data, entry.cacheDate);
+    RKCacheAppendDate(data, entry.expirationDate);
+    RKCacheAppendUInt64(data, entry.size);
+    RKCacheAppendUInt32(data, (uint32_t) entry.accessCount);
+    RKCacheAppendDate(data, [NSDate dateWithTimeIntervalSinceReferenceDate:entry.lastAccessTime]);
+}
+
+// Applies records until the reader is exhausted or hits a truncated or unknown record. Returns the number of records applied.
+- (NSUInteger)replayRecordsWithReader:(RKRequestCacheIndexReader*)reader {
+    NSUInteger recordCount = 0;
+    while (reader->offset < reader->length) {
+        RKRequestCacheIndexRecordType type = RKIndexReadUInt8(reader);
+        if (type == RKRequestCacheIndexRecordPut) {
+            RKRequestCacheIndexEntry* entry = [[RKRequestCacheIndexEntry new] autorelease];
+            entry.cacheKey = RKIndexReadString(reader);
+            entry.storagePolicy = RKIndexReadUInt8(reader);
+            entry.ETag = RKIndexReadString(reader);
+            entry.lastModifiedDate = RKIndexReadDate(reader);
+            entry.cacheDate = RKIndexReadDate(reader);
+            entry.expirationDate = RKIndexReadDate(reader);
+            entry.size = RKIndexReadUInt64(reader);
+            entry.accessCount = RKIndexReadUInt32(reader);
+            entry.lastAccessTime = [RKIndexReadDate(reader) timeIntervalSinceReferenceDate];
+            if (reader->overrun || nil == entry.cacheKey) {
+                break;
+            }
+            [self addEntry:entry];
+        } else if (type == RKRequestCacheIndexRecordRemove) {
+            NSString* cacheKey = RKIndexReadString(reader);
+            if (reader->overrun) {
+                break;
+            }
+            [self removeEntry:[_entries objectForKey:cacheKey]];
+        } else if (type == RKRequestCacheIndexRecordRemoveStoragePolicy) {
+            RKRequestCacheStoragePolicy storagePolicy = RKIndexReadUInt8(reader);
+            if (reader->overrun) {
+                break;
+            }
+            for (RKRequestCacheIndexEntry* entry in [_entries allValues]) {
+                if (entry.storagePolicy == storagePolicy) {
+                    [self removeEntry:entry];
+                }
+            }
+        } else {
+            RKLogWarning(@"Encountered unknown record type %d in cache index %@, ignoring the remainder", type, _path);
+            break;
+        }
+        recordCount++;
+    }
+
+    return recordCount;
+}
+
+- (BOOL)load {
+    NSData* snapshot = [NSData dataWithContentsOfFile:_path options:NSDataReadingMapped error:nil];
+    NSData* journal = [NSData dataWithContentsOfFile:[self journalPath] options:NSDataReadingMapped error:nil];
+    if (nil == snapshot && nil == journal) {
+        return NO;
+    }
+
+    @synchronized(self) {
+        [_entries removeAllObjects];
+        [_evictionOrder removeAllObjects];
+        memset(_sizes, 0, sizeof(_sizes));
+        memset(_counts, 0, sizeof(_counts));
+
+        if ([snapshot length] >= 8 && memcmp([snapshot bytes], kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+            RKCacheReadUInt16((const uint8_t*)[snapshot bytes] + 4) == kIndexVersion) {
+            RKRequestCacheIndexReader reader = { [snapshot bytes], [snapshot length], 8, NO };
+            [self replayRecordsWithReader:&reader];
+        } else if (snapshot) {
+            RKLogWarning(@"Ignoring unreadable cache index snapshot at %@", _path);
+        }
+
+        if (journal) {
+            RKRequestCacheIndexReader reader = { [journal bytes], [journal length], 0, NO };
+            _journalRecordCount = [self replayRecordsWithReader:&reader];
+        }
+
+        // The frequency age is not persisted. Resume it just below the least used permanent entry,
+        // so that entries stored from now on are not ranked beneath every surviving entry
+        NSUInteger leastAccessCount = NSUIntegerMax;
+        for (RKRequestCacheIndexEntry* entry in _evictionOrder) {
+            leastAccessCount = MIN(leastAccessCount, entry.accessCount);
+        }
+        _frequencyAge = ([_evictionOrder count] > 0 && leastAccessCount > 0) ? leastAccessCount - 1 : 0;
+
+        RKLogDebug(@"Loaded cache index %@ with %lu entries", _path, (unsigned long) [_entries count]);
+    }
+
+    return YES;
+}
+
+// Appends the buffered records to the journal. Sent holding the lock. The buffer is only
+// emptied once the records are on disk, so a failed write is retried by the next synchronize
+- (BOOL)appendBufferedRecordsToJournal {
+    NSString* journalPath = [self journalPath];
+    if (! [[NSFileManager defaultManager] fileExistsAtPath:journalPath]) {
+        [[NSFileManager defaultManager] createFileAtPath:journalPath contents:nil attributes:nil];
+    }
+    NSFileHandle* fileHandle = [NSFileHandle fileHandleForWritingAtPath:journalPath];
+    if (nil == fileHandle) {
+        RKLogError(@"Failed to open cache index journal at %@", journalPath);
+        return NO;
+    }
+
+    @try {
+        [fileHandle seekToEndOfFile];
+        [fileHandle writeData:_journalBuffer];
+    }
+    @catch (NSException* exception) {
+        RKLogError(@"Failed to append to cache index journal at %@: %@", journalPath, [exception reason]);
+        [fileHandle closeFile];
+        return NO;
+    }
+    [fileHandle closeFile];
+    RKLogTrace(@"Appended %lu bytes to cache index journal %@", (unsigned long) [_journalBuffer length], journalPath);
+    [_journalBuffer setLength:0];
+    return YES;
+}
+
+// Writes a snapshot of every entry and empties the journal. Sent holding the lock
+- (BOOL)writeSnapshot {
+    NSMutableData* snapshot = [NSMutableData data];
+    [snapshot appendBytes:kIndexMagic length:sizeof(kIndexMagic)];
+    RKCacheAppendUInt16(snapshot, kIndexVersion);
+    RKCacheAppendUInt16(snapshot, 0);
+    for (RKRequestCacheIndexEntry* entry in [_entries objectEnumerator]) {
+        [self appendRecordForEntry:entry toData:snapshot];
+    }
+
+    // Everything buffered is captured by the snapshot
+    NSError* error = nil;
+    if (! [snapshot writeToFile:_path options:NSDataWritingAtomic error:&error]) {
+        RKLogError(@"Failed to write cache index snapshot to %@: %@", _path, [error localizedDescription]);
+        return NO;
+    }
+
+    [_journalBuffer setLength:0];
+    [[NSFileManager defaultManager] removeItemAtPath:[self journalPath] error:nil];
+    _journalRecordCount = 0;
+    RKLogDebug(@"Compacted cache index %@ to %lu entries", _path, (unsigned long) [_entries count]);
+    return YES;
+}
+
+- (void)synchronize {
+    // Hold the lock across the file operations so that records are written once, in order,
+    // and none can be buffered between writing them and emptying the buffer
+    @synchronized(self) {
+        if ([_journalBuffer length] == 0) {
+            return;
+        }
+
+        BOOL needsCompaction = (_journalRecordCount > kMinimumCompactionRecordCount && _journalRecordCount > 2 * [_entries count]);
+        if (needsCompaction && [self writeSnapshot]) {
+            return;
+        }
+
+        [self appendBufferedRecordsToJournal];
+    }
+}
+
+- (void)compact {
+    @synchronized(self) {
+        [self writeSnapshot];
+    }
+}
+
+@end
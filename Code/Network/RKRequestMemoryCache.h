@@ -0,0 +1,120 @@
+//
+//  RKRequestMemoryCache.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RKRequestMemoryCacheEntry;
+
+/**
+ A byte budgeted, least recently used store of cache entries held in memory.
+
+ RKRequestCache keeps its most recently used entries here so that cache decisions
+ (existence, ETag and cache date lookups) and loads of hot resources are answered
+ without touching the filesystem. Each entry holds the response headers as they were
+ written to disk and, optionally, the response body. The cost of an entry is an
+ estimate of the bytes it holds; once the total cost exceeds the capacity the least
+ recently used entries are evicted.
+
+ The memory cache is only ever a copy of what is on disk: evicting an entry never loses data.
+ All methods are safe to call from any thread.
+ */
+@interface RKRequestMemoryCache : NSObject {
+    NSMutableDictionary *_entries;
+    RKRequestMemoryCacheEntry *_head;
+    RKRequestMemoryCacheEntry *_tail;
+    NSUInteger _capacity;
+    NSUInteger _maximumBodySize;
+    NSUInteger _currentSize;
+}
+
+/**
+ The number of bytes the memory cache may hold. Lowering the capacity evicts
+ entries immediately. A capacity of zero disables the memory cache.
+
+ **Default**: 1 MB
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ The largest response body that is held in memory. Entries for larger responses keep
+ only their headers in memory and read their body from disk. A maximum body size of
+ zero keeps only headers in memory.
+
+ **Default**: 128 KB
+ */
+@property (nonatomic, assign) NSUInteger maximumBodySize;
+
+/**
+ The estimated number of bytes currently held
+ */
+@property (nonatomic, readonly) NSUInteger currentSize;
+
+/**
+ The number of entries currently held
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ Initializes a memory cache holding up to capacity bytes
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ Returns YES when an entry exists for the key. Does not affect the eviction order.
+ */
+- (BOOL)containsEntryForKey:(NSString *)key;
+
+/**
+ Returns the headers of the entry for the key and marks it as recently used
+ */
+- (NSDictionary *)headersForKey:(NSString *)key;
+
+/**
+ Returns the body of the entry for the key, or nil if the body is not held
+ in memory, and marks the entry as recently used
+ */
+- (NSData *)bodyForKey:(NSString *)key;
+
+/**
+ Stores an entry for the key, replacing any existing entry. The body is
+ discarded when it is larger than maximumBodySize.
+ */
+- (void)setHeaders:(NSDictionary *)headers body:(NSData *)body forKey:(NSString *)key;
+
+/**
+ Replaces the headers of an existing entry, keeping its body. Does nothing if there is no entry for the key.
+ */
+- (void)updateHeaders:(NSDictionary *)headers forKey:(NSString *)key;
+
+/**
+ Removes the entry for the key
+ */
+- (void)removeEntryForKey:(NSString *)key;
+
+/**
+ Removes every entry whose key begins with the prefix
+ */
+- (void)removeEntriesWithKeyPrefix:(NSString *)prefix;
+
+/**
+ Removes every entry
+ */
+- (void)removeAllEntries;
+
+@end
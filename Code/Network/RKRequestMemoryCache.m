@@ -0,0 +1,311 @@
+//
+//  RKRequestMemoryCache.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestMemoryCache.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetworkCache
+
+static const NSUInteger kDefaultCapacity = 1024 * 1024;
+static const NSUInteger kDefaultMaximumBodySize = 128 * 1024;
+
+// Fixed allowance for the entry, dictionary and list bookkeeping
+static const NSUInteger kEntryOverhead = 128;
+
+/**
+ An entry on the memory cache's recency list. The list runs from the most recently
+ used entry at the head to the least recently used at the tail.
+ */
+@interface RKRequestMemoryCacheEntry : NSObject {
+    NSString* _key;
+    NSDictionary* _headers;
+    NSData* _body;
+    NSUInteger _cost;
+    RKRequestMemoryCacheEntry* _previous;
+    RKRequestMemoryCacheEntry* _next;
+}
+
+@property (nonatomic, copy) NSString* key;
+@property (nonatomic, retain) NSDictionary* headers;
+@property (nonatomic, retain) NSData* body;
+@property (nonatomic, assign) NSUInteger cost;
+@property (nonatomic, assign) RKRequestMemoryCacheEntry* previous;
+@property (nonatomic, assign) RKRequestMemoryCacheEntry* next;
+
+@end
+
+@implementation RKRequestMemoryCacheEntry
+
+@synthesize key = _key;
+@synthesize headers = _headers;
+@synthesize body = _body;
+@synthesize cost = _cost;
+@synthesize previous = _previous;
+@synthesize next = _next;
+
+- (void)dealloc {
+    [_key release];
+    [_headers release];
+    [_body release];
+    [super dealloc];
+}
+
+@end
+
+@interface RKRequestMemoryCache (Private)
+- (void)unlinkEntry:(RKRequestMemoryCacheEntry*)entry;
+- (void)linkEntryAtHead:(RKRequestMemoryCacheEntry*)entry;
+- (void)removeEntry:(RKRequestMemoryCacheEntry*)entry;
+- (void)evictToCapacity;
+- (NSUInteger)costForHeaders:(NSDictionary*)headers body:(NSData*)body key:(NSString*)key;
+@end
+
+@implementation RKRequestMemoryCache
+
+@synthesize capacity = _capacity;
+@synthesize maximumBodySize = _maximumBodySize;
+
+- (id)init {
+    return [self initWithCapacity:kDefaultCapacity];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        _entries = [NSMutableDictionary new];
+        _capacity = capacity;
+        _maximumBodySize = kDefaultMaximumBodySize;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_entries release];
+    _entries = nil;
+    _head = nil;
+    _tail = nil;
+
+    [super dealloc];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p capacity=%lu currentSize=%lu count=%lu>",
+            NSStringFromClass([self class]), self, (unsigned long) _capacity, (unsigned long) [self currentSize], (unsigned long) [self count]];
+}
+
+- (NSUInteger)currentSize {
+    @synchronized(self) {
+        return _currentSize;
+    }
+}
+
+- (NSUInteger)count {
+    @synchronized(self) {
+        return [_entries count];
+    }
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+    @synchronized(self) {
+        _capacity = capacity;
+        [self evictToCapacity];
+    }
+}
+
+#pragma mark - Recency List
+
+- (void)unlinkEntry:(RKRequestMemoryCacheEntry*)entry {
+    if (entry.previous) {
+        entry.previous.next = entry.next;
+    } else {
+        _head = entry.next;
+    }
+    if (entry.next) {
+        entry.next.previous = entry.previous;
+    } else {
+        _tail = entry.previous;
+    }
+    entry.previous = nil;
+    entry.next = nil;
+}
+
+- (void)linkEntryAtHead:(RKRequestMemoryCacheEntry*)entry {
+    entry.previous = nil;
+    entry.next = _head;
+    if (_head) {
+        _head.previous = entry;
+    }
+    _head = entry;
+    if (nil == _tail) {
+        _tail = entry;
+    }
+}
+
+- (void)removeEntry:(RKRequestMemoryCacheEntry*)entry {
+    [self unlinkEntry:entry];
+    _currentSize -= entry.cost;
+    // The dictionary holds the only strong reference to the entry
+    [_entries removeObjectForKey:entry.key];
+}
+
+- (void)evictToCapacity {
+    while (_tail && _currentSize > _capacity) {
+        RKLogTrace(@"Evicting memory cache entry for key '%@'", _tail.key);
+        [self removeEntry:_tail];
+    }
+}
+
+- (NSUInteger)costForHeaders:(NSDictionary*)headers body:(NSData*)body key:(NSString*)key {
+    NSUInteger cost = kEntryOverhead + [key length];
+    for (id headerKey in headers) {
+        cost += [[headerKey description] length] + [[[headers objectForKey:headerKey] description] length];
+    }
+
+    return cost + [body length];
+}
+
+#pragma mark - Entries
+
+- (BOOL)containsEntryForKey:(NSString*)key {
+    if (nil == key) {
+        return NO;
+    }
+
+    @synchronized(self) {
+        return (nil != [_entries objectForKey:key]);
+    }
+}
+
+- (NSDictionary*)headersForKey:(NSString*)key {
+    if (nil == key) {
+        return nil;
+    }
+
+    @synchronized(self) {
+        RKRequestMemoryCacheEntry* entry = [_entries objectForKey:key];
+        if (entry && entry != _head) {
+            [self unlinkEntry:entry];
+            [self linkEntryAtHead:entry];
+        }
+
+        return [[entry.headers retain] autorelease];
+    }
+}
+
+- (NSData*)bodyForKey:(NSString*)key {
+    if (nil == key) {
+        return nil;
+    }
+
+    @synchronized(self) {
+        RKRequestMemoryCacheEntry* entry = [_entries objectForKey:key];
+        if (entry && entry != _head) {
+            [self unlinkEntry:entry];
+            [self linkEntryAtHead:entry];
+        }
+
+        return [[entry.body retain] autorelease];
+    }
+}
+
+- (void)setHeaders:(NSDictionary*)headers body:(NSData*)body forKey:(NSString*)key {
+    if (nil == key || nil == headers) {
+        return;
+    }
+
+    if ([body length] > _maximumBodySize) {
+        body = nil;
+    }
+
+    @synchronized(self) {
+        RKRequestMemoryCacheEntry* existingEntry = [_entries objectForKey:key];
+        if (existingEntry) {
+            [self removeEntry:existingEntry];
+        }
+
+        NSUInteger cost = [self costForHeaders:headers body:body key:key];
+        if (cost > _capacity) {
+            return;
+        }
+
+        RKRequestMemoryCacheEntry* entry = [[RKRequestMemoryCacheEntry alloc] init];
+        entry.key = key;
+        entry.headers = [[headers copy] autorelease];
+        entry.body = body;
+        entry.cost = cost;
+        [_entries setObject:entry forKey:entry.key];
+        [self linkEntryAtHead:entry];
+        _currentSize += cost;
+        [entry release];
+
+        [self evictToCapacity];
+    }
+}
+
+- (void)updateHeaders:(NSDictionary*)headers forKey:(NSString*)key {
+    if (nil == key) {
+        return;
+    }
+
+    @synchronized(self) {
+        RKRequestMemoryCacheEntry* entry = [_entries objectForKey:key];
+        if (entry) {
+            // Replacing the entry releases it, so hold on to the body across the swap
+            NSData* body = [[entry.body retain] autorelease];
+            [self setHeaders:headers body:body forKey:key];
+        }
+    }
+}
+
+- (void)removeEntryForKey:(NSString*)key {
+    if (nil == key) {
+        return;
+    }
+
+    @synchronized(self) {
+        RKRequestMemoryCacheEntry* entry = [_entries objectForKey:key];
+        if (entry) {
+            [self removeEntry:entry];
+        }
+    }
+}
+
+- (void)removeEntriesWithKeyPrefix:(NSString*)prefix {
+    @synchronized(self) {
+        for (NSString* key in [_entries allKeys]) {
+            if ([key hasPrefix:prefix]) {
+                [self removeEntry:[_entries objectForKey:key]];
+            }
+        }
+    }
+}
+
+- (void)removeAllEntries {
+    @synchronized(self) {
+        [_entries removeAllObjects];
+        _head = nil;
+        _tail = nil;
+        _currentSize = 0;
+    }
+}
+
+@end
@@ -0,0 +1,117 @@
+//
+//  RKRequestMetrics.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Timestamps recorded over the lifecycle of a single request.
+
+ Every timestamp is an absolute time as returned by [NSDate timeIntervalSinceReferenceDate].
+ A timestamp of zero means that the request never passed through that phase (i.e. a response
+ loaded from the cache has no first byte time, a plain RKRequest is never mapped). The
+ duration accessors return zero when either end of the phase was not recorded.
+
+ Metrics are available from the request itself and in the userInfo of the
+ RKRequestDidLoadResponseNotification under RKRequestDidLoadResponseNotificationUserInfoMetricsKey.
+
+ @see RKRequestMetricsCollector
+ */
+@interface RKRequestMetrics : NSObject {
+    NSTimeInterval _enqueueTime;
+    NSTimeInterval _dispatchTime;
+    NSTimeInterval _firstByteTime;
+    NSTimeInterval _lastByteTime;
+    NSTimeInterval _cacheLookupStartTime;
+    NSTimeInterval _cacheLookupEndTime;
+    NSTimeInterval _parseStartTime;
+    NSTimeInterval _parseEndTime;
+    NSTimeInterval _mappingStartTime;
+    NSTimeInterval _mappingEndTime;
+    NSTimeInterval _saveStartTime;
+    NSTimeInterval _saveEndTime;
+    unsigned long long _bytesReceived;
+    BOOL _loadedFromCache;
+}
+
+/// The request was added to an RKRequestQueue
+@property (nonatomic, assign) NSTimeInterval enqueueTime;
+
+/// The request was handed to NSURLConnection
+@property (nonatomic, assign) NSTimeInterval dispatchTime;
+
+/// The response headers or the first chunk of the body arrived
+@property (nonatomic, assign) NSTimeInterval firstByteTime;
+
+/// The connection finished loading
+@property (nonatomic, assign) NSTimeInterval lastByteTime;
+
+/// The request cache was consulted for a response
+@property (nonatomic, assign) NSTimeInterval cacheLookupStartTime;
+@property (nonatomic, assign) NSTimeInterval cacheLookupEndTime;
+
+/// The response body was parsed
+@property (nonatomic, assign) NSTimeInterval parseStartTime;
+@property (nonatomic, assign) NSTimeInterval parseEndTime;
+
+/// The parsed payload was object mapped
+@property (nonatomic, assign) NSTimeInterval mappingStartTime;
+@property (nonatomic, assign) NSTimeInterval mappingEndTime;
+
+/// The managed object context was saved after mapping
+@property (nonatomic, assign) NSTimeInterval saveStartTime;
+@property (nonatomic, assign) NSTimeInterval saveEndTime;
+
+/// The number of body bytes received over the network
+@property (nonatomic, assign) unsigned long long bytesReceived;
+
+/// YES when the response was served from the request cache
+@property (nonatomic, assign, getter = wasLoadedFromCache) BOOL loadedFromCache;
+
+/**
+ Time spent waiting in the request queue before being dispatched
+ */
+- (NSTimeInterval)queueDuration;
+
+/**
+ Time from dispatch until the first byte of the response arrived
+ */
+- (NSTimeInterval)timeToFirstByte;
+
+/**
+ Time from the first byte until the last byte of the response arrived
+ */
+- (NSTimeInterval)transferDuration;
+
+- (NSTimeInterval)cacheLookupDuration;
+- (NSTimeInterval)parseDuration;
+- (NSTimeInterval)mappingDuration;
+- (NSTimeInterval)saveDuration;
+
+/**
+ Time from the earliest to the latest recorded timestamp
+ */
+- (NSTimeInterval)totalDuration;
+
+/**
+ Returns the durations of all recorded phases keyed by phase name, in seconds.
+ Phases that were not recorded are omitted.
+ */
+- (NSDictionary *)durations;
+
+@end
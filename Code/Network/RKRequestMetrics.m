@@ -0,0 +1,113 @@
+//
+//  RKRequestMetrics.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestMetrics.h"
+
+static inline NSTimeInterval RKRequestMetricsDuration(NSTimeInterval start, NSTimeInterval end) {
+    return (start > 0 && end >= start) ? end - start : 0;
+}
+
+static void RKRequestMetricsSetDuration(NSMutableDictionary* durations, NSString* phase, NSTimeInterval duration) {
+    if (duration > 0) {
+        [durations setObject:[NSNumber numberWithDouble:duration] forKey:phase];
+    }
+}
+
+@implementation RKRequestMetrics
+
+@synthesize enqueueTime = _enqueueTime;
+@synthesize dispatchTime = _dispatchTime;
+@synthesize firstByteTime = _firstByteTime;
+@synthesize lastByteTime = _lastByteTime;
+@synthesize cacheLookupStartTime = _cacheLookupStartTime;
+@synthesize cacheLookupEndTime = _cacheLookupEndTime;
+@synthesize parseStartTime = _parseStartTime;
+@synthesize parseEndTime = _parseEndTime;
+@synthesize mappingStartTime = _mappingStartTime;
+@synthesize mappingEndTime = _mappingEndTime;
+@synthesize saveStartTime = _saveStartTime;
+@synthesize saveEndTime = _saveEndTime;
+@synthesize bytesReceived = _bytesReceived;
+@synthesize loadedFromCache = _loadedFromCache;
+
+- (NSTimeInterval)queueDuration {
+    return RKRequestMetricsDuration(_enqueueTime, _dispatchTime);
+}
+
+- (NSTimeInterval)timeToFirstByte {
+    return RKRequestMetricsDuration(_dispatchTime, _firstByteTime);
+}
+
+- (NSTimeInterval)transferDuration {
+    return RKRequestMetricsDuration(_firstByteTime, _lastByteTime);
+}
+
+- (NSTimeInterval)cacheLookupDuration {
+    return RKRequestMetricsDuration(_cacheLookupStartTime, _cacheLookupEndTime);
+}
+
+- (NSTimeInterval)parseDuration {
+    return RKRequestMetricsDuration(_parseStartTime, _parseEndTime);
+}
+
+- (NSTimeInterval)mappingDuration {
+    return RKRequestMetricsDuration(_mappingStartTime, _mappingEndTime);
+}
+
+- (NSTimeInterval)saveDuration {
+    return RKRequestMetricsDuration(_saveStartTime, _saveEndTime);
+}
+
+- (NSTimeInterval)totalDuration {
+    NSTimeInterval timestamps[12] = {
+        _enqueueTime, _dispatchTime, _firstByteTime, _lastByteTime,
+        _cacheLookupStartTime, _cacheLookupEndTime, _parseStartTime, _parseEndTime,
+        _mappingStartTime, _mappingEndTime, _saveStartTime, _saveEndTime
+    };
+    NSTimeInterval earliest = 0;
+    NSTimeInterval latest = 0;
+    for (int i = 0; i < 12; i++) {
+        if (timestamps[i] <= 0) continue;
+        if (earliest == 0 || timestamps[i] < earliest) earliest = timestamps[i];
+        if (timestamps[i] > latest) latest = timestamps[i];
+    }
+
+    return latest - earliest;
+}
+
+- (NSDictionary*)durations {
+    NSMutableDictionary* durations = [NSMutableDictionary dictionary];
+    RKRequestMetricsSetDuration(durations, @"queue", [self queueDuration]);
+    RKRequestMetricsSetDuration(durations, @"timeToFirstByte", [self timeToFirstByte]);
+    RKRequestMetricsSetDuration(durations, @"transfer", [self transferDuration]);
+    RKRequestMetricsSetDuration(durations, @"cacheLookup", [self cacheLookupDuration]);
+    RKRequestMetricsSetDuration(durations, @"parse", [self parseDuration]);
+    RKRequestMetricsSetDuration(durations, @"mapping", [self mappingDuration]);
+    RKRequestMetricsSetDuration(durations, @"save", [self saveDuration]);
+    RKRequestMetricsSetDuration(durations, @"total", [self totalDuration]);
+
+    return durations;
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p loadedFromCache=%@ bytesReceived=%llu durations=%@>",
+            NSStringFromClass([self class]), self, _loadedFromCache ? @"YES" : @"NO", _bytesReceived, [self durations]];
+}
+
+@end
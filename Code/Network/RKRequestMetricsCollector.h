@@ -0,0 +1,166 @@
+//
+//  RKRequestMetricsCollector.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "RKRequestMetrics.h"
+
+/**
+ A latency histogram with fixed, roughly logarithmic buckets ranging from
+ one millisecond to one minute. Recording a sample is constant time and the
+ histogram never grows, so it is cheap to keep one per resource path and phase.
+ */
+@interface RKLatencyHistogram : NSObject {
+    NSUInteger *_bucketCounts;
+    NSUInteger _count;
+    NSTimeInterval _sum;
+    NSTimeInterval _min;
+    NSTimeInterval _max;
+}
+
+/// The number of samples recorded
+@property (nonatomic, readonly) NSUInteger count;
+
+/// The smallest and largest samples recorded, in seconds
+@property (nonatomic, readonly) NSTimeInterval min;
+@property (nonatomic, readonly) NSTimeInterval max;
+
+/// The mean of all samples recorded, in seconds
+@property (nonatomic, readonly) NSTimeInterval mean;
+
+/**
+ Returns the upper bounds of the buckets in seconds. The last bucket is unbounded.
+ */
++ (NSArray *)bucketBounds;
+
+/**
+ Records a sample, in seconds
+ */
+- (void)recordDuration:(NSTimeInterval)duration;
+
+/**
+ Returns the number of samples that fell into each bucket, in the order of bucketBounds
+ */
+- (NSArray *)bucketCounts;
+
+/**
+ Returns an estimate of the given percentile (0 to 100): the upper bound of the
+ bucket containing it, clamped to the largest sample recorded.
+ */
+- (NSTimeInterval)percentile:(double)percentile;
+
+/**
+ Returns the count, min, mean, max, p50, p90 and p99 of the histogram. Durations are in milliseconds.
+ */
+- (NSDictionary *)summary;
+
+@end
+
+/**
+ The resource path that metrics are recorded against once maximumResourcePathCount
+ distinct resource paths have been seen
+ */
+extern NSString * const RKRequestMetricsCollectorOtherResourcePaths;
+
+/**
+ Aggregates RKRequestMetrics per resource path into latency histograms.
+
+ When enabled, the collector observes RKRequestDidLoadResponseNotification and records the
+ duration of every phase of each loaded request. Object loaders post the notification
+ once mapping has finished, so their histograms include the parse, mapping and save phases.
+ Resource paths containing identifiers, such as /users/123, can be recorded together by adding
+ a resource path pattern such as /users/:userID. The number of distinct resource paths recorded
+ is capped, so that metrics use bounded memory in long-lived applications.
+ The aggregate can be dumped to the log or retrieved as a dictionary at any time:
+
+    [RKRequestMetricsCollector sharedCollector].enabled = YES;
+    ...
+    [[RKRequestMetricsCollector sharedCollector] logReport];
+ */
+@interface RKRequestMetricsCollector : NSObject {
+    NSMutableDictionary *_histogramsByResourcePath;
+    NSMutableArray *_resourcePathPatterns;
+    NSUInteger _maximumResourcePathCount;
+    BOOL _enabled;
+}
+
+/**
+ Returns the shared collector
+ */
++ (RKRequestMetricsCollector *)sharedCollector;
+
+/**
+ When YES, the metrics of every loaded request are recorded
+
+ **Default**: NO
+ */
+@property (nonatomic, assign, getter = isEnabled) BOOL enabled;
+
+/**
+ The maximum number of distinct resource paths recorded. Once reached, the metrics of any
+ other resource path are recorded against RKRequestMetricsCollectorOtherResourcePaths.
+
+ **Default**: 100
+ */
+@property (nonatomic, assign) NSUInteger maximumResourcePathCount;
+
+/**
+ Returns the resource paths that have recorded metrics
+ */
+@property (nonatomic, readonly) NSArray *resourcePaths;
+
+/**
+ Records the metrics of every resource path matching the pattern against the pattern itself.
+ Patterns are matched in the order they were added.
+
+ @param pattern A resource path pattern, such as /users/:userID
+ @see RKPathMatcher
+ */
+- (void)addResourcePathPattern:(NSString *)pattern;
+
+/**
+ Records every phase of the metrics against the resource path, or against the first
+ resource path pattern it matches
+ */
+- (void)recordMetrics:(RKRequestMetrics *)metrics forResourcePath:(NSString *)resourcePath;
+
+/**
+ Returns the histograms recorded for the resource path, keyed by phase name
+ (queue, timeToFirstByte, transfer, cacheLookup, parse, mapping, save and total)
+
+ @see [RKRequestMetrics durations]
+ */
+- (NSDictionary *)histogramsForResourcePath:(NSString *)resourcePath;
+
+/**
+ Returns a summary of every histogram, keyed by resource path and then by phase. Each summary is
+ a dictionary containing the count, min, mean, max, p50, p90 and p99 in milliseconds.
+ */
+- (NSDictionary *)report;
+
+/**
+ Writes the report to the log at the info level
+ */
+- (void)logReport;
+
+/**
+ Discards all recorded metrics
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,293 @@
+//
+//  RKRequestMetricsCollector.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestMetricsCollector.h"
+#import "RKRequest.h"
+#import "RKNotifications.h"
+#import "RKPathMatcher.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetwork
+
+// Upper bounds of the histogram buckets, in seconds. The final bucket catches everything slower.
+static const NSTimeInterval RKLatencyHistogramBounds[] = {
+    0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10, 30, 60
+};
+static const NSUInteger RKLatencyHistogramBucketCount = (sizeof(RKLatencyHistogramBounds) / sizeof(NSTimeInterval)) + 1;
+
+static const NSUInteger RKRequestMetricsCollectorDefaultMaximumResourcePathCount = 100;
+
+NSString* const RKRequestMetricsCollectorOtherResourcePaths = @"(other)";
+
+static RKRequestMetricsCollector* sharedCollector = nil;
+
+@implementation RKLatencyHistogram
+
+@synthesize count = _count;
+@synthesize min = _min;
+@synthesize max = _max;
+
++ (NSArray*)bucketBounds {
+    NSMutableArray* bounds = [NSMutableArray arrayWithCapacity:RKLatencyHistogramBucketCount];
+    for (NSUInteger i = 0; i < RKLatencyHistogramBucketCount - 1; i++) {
+        [bounds addObject:[NSNumber numberWithDouble:RKLatencyHistogramBounds[i]]];
+    }
+    [bounds addObject:[NSNumber numberWithDouble:HUGE_VAL]];
+
+    return bounds;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _bucketCounts = calloc(RKLatencyHistogramBucketCount, sizeof(NSUInteger));
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    free(_bucketCounts);
+    _bucketCounts = NULL;
+
+    [super dealloc];
+}
+
+- (void)recordDuration:(NSTimeInterval)duration {
+    NSUInteger bucket = 0;
+    while (bucket < RKLatencyHistogramBucketCount - 1 && duration > RKLatencyHistogramBounds[bucket]) {
+        bucket++;
+    }
+
+    _bucketCounts[bucket]++;
+    if (_count == 0 || duration < _min) _min = duration;
+    if (_count == 0 || duration > _max) _max = duration;
+    _sum += duration;
+    _count++;
+}
+
+- (NSTimeInterval)mean {
+    return (_count > 0) ? _sum / _count : 0;
+}
+
+- (NSArray*)bucketCounts {
+    NSMutableArray* counts = [NSMutableArray arrayWithCapacity:RKLatencyHistogramBucketCount];
+    for (NSUInteger i = 0; i < RKLatencyHistogramBucketCount; i++) {
+        [counts addObject:[NSNumber numberWithUnsignedInteger:_bucketCounts[i]]];
+    }
+
+    return counts;
+}
+
+- (NSTimeInterval)percentile:(double)percentile {
+    if (_count == 0) {
+        return 0;
+    }
+
+    NSUInteger rank = (NSUInteger) ceil((percentile / 100.0) * _count);
+    if (rank == 0) rank = 1;
+    NSUInteger seen = 0;
+    for (NSUInteger i = 0; i < RKLatencyHistogramBucketCount - 1; i++) {
+        seen += _bucketCounts[i];
+        if (seen >= rank) {
+            return MIN(RKLatencyHistogramBounds[i], _max);
+        }
+    }
+
+    return _max;
+}
+
+- (NSDictionary*)summary {
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+            [NSNumber numberWithUnsignedInteger:_count], @"count",
+            [NSNumber numberWithDouble:_min * 1000], @"min",
+            [NSNumber numberWithDouble:[self mean] * 1000], @"mean",
+            [NSNumber numberWithDouble:_max * 1000], @"max",
+            [NSNumber numberWithDouble:[self percentile:50] * 1000], @"p50",
+            [NSNumber numberWithDouble:[self percentile:90] * 1000], @"p90",
+            [NSNumber numberWithDouble:[self percentile:99] * 1000], @"p99",
+            nil];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p count=%lu min=%.1fms mean=%.1fms p90=%.1fms max=%.1fms>",
+            NSStringFromClass([self class]), self, (unsigned long) _count,
+            _min * 1000, [self mean] * 1000, [self percentile:90] * 1000, _max * 1000];
+}
+
+@end
+
+@implementation RKRequestMetricsCollector
+
+@synthesize enabled = _enabled;
+@synthesize maximumResourcePathCount = _maximumResourcePathCount;
+
++ (RKRequestMetricsCollector*)sharedCollector {
+    @synchronized(self) {
+        if (nil == sharedCollector) {
+            sharedCollector = [RKRequestMetricsCollector new];
+        }
+    }
+
+    return sharedCollector;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _histogramsByResourcePath = [NSMutableDictionary new];
+        _resourcePathPatterns = [NSMutableArray new];
+        _maximumResourcePathCount = RKRequestMetricsCollectorDefaultMaximumResourcePathCount;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [_histogramsByResourcePath release];
+    _histogramsByResourcePath = nil;
+    [_resourcePathPatterns release];
+    _resourcePathPatterns = nil;
+
+    [super dealloc];
+}
+
+- (void)setEnabled:(BOOL)enabled {
+    if (enabled == _enabled) {
+        return;
+    }
+
+    _enabled = enabled;
+    if (enabled) {
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(requestDidLoadResponse:)
+                                                     name:RKRequestDidLoadResponseNotification
+                                                   object:nil];
+    } else {
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:RKRequestDidLoadResponseNotification object:nil];
+    }
+}
+
+- (void)requestDidLoadResponse:(NSNotification*)notification {
+    RKRequestMetrics* metrics = [[notification userInfo] objectForKey:RKRequestDidLoadResponseNotificationUserInfoMetricsKey];
+    if (nil == metrics) {
+        return;
+    }
+
+    RKRequest* request = (RKRequest*) [notification object];
+    NSString* resourcePath = [request resourcePath];
+    if (nil == resourcePath) {
+        resourcePath = [[request URL] path];
+    }
+
+    [self recordMetrics:metrics forResourcePath:resourcePath];
+}
+
+- (void)addResourcePathPattern:(NSString*)pattern {
+    @synchronized(self) {
+        [_resourcePathPatterns addObject:pattern];
+    }
+}
+
+// Returns the pattern the resource path matches, or the resource path itself. Sent holding the lock
+- (NSString*)keyForResourcePath:(NSString*)resourcePath {
+    for (NSString* pattern in _resourcePathPatterns) {
+        RKPathMatcher* matcher = [RKPathMatcher matcherWithPath:resourcePath];
+        if ([matcher matchesPattern:pattern tokenizeQueryStrings:NO parsedArguments:nil]) {
+            return pattern;
+        }
+    }
+
+    return resourcePath;
+}
+
+- (void)recordMetrics:(RKRequestMetrics*)metrics forResourcePath:(NSString*)resourcePath {
+    if (nil == resourcePath) {
+        resourcePath = @"";
+    }
+
+    NSDictionary* durations = [metrics durations];
+    @synchronized(self) {
+        resourcePath = [self keyForResourcePath:resourcePath];
+        NSMutableDictionary* histograms = [_histogramsByResourcePath objectForKey:resourcePath];
+        if (nil == histograms && [_histogramsByResourcePath count] >= _maximumResourcePathCount) {
+            resourcePath = RKRequestMetricsCollectorOtherResourcePaths;
+            histograms = [_histogramsByResourcePath objectForKey:resourcePath];
+        }
+        if (nil == histograms) {
+            histograms = [NSMutableDictionary dictionary];
+            [_histogramsByResourcePath setObject:histograms forKey:resourcePath];
+        }
+
+        for (NSString* phase in durations) {
+            RKLatencyHistogram* histogram = [histograms objectForKey:phase];
+            if (nil == histogram) {
+                histogram = [[RKLatencyHistogram new] autorelease];
+                [histograms setObject:histogram forKey:phase];
+            }
+            [histogram recordDuration:[[durations objectForKey:phase] doubleValue]];
+        }
+    }
+}
+
+- (NSArray*)resourcePaths {
+    @synchronized(self) {
+        return [_histogramsByResourcePath allKeys];
+    }
+}
+
+- (NSDictionary*)histogramsForResourcePath:(NSString*)resourcePath {
+    @synchronized(self) {
+        return [[[_histogramsByResourcePath objectForKey:resourcePath] copy] autorelease];
+    }
+}
+
+- (NSDictionary*)report {
+    NSMutableDictionary* report = [NSMutableDictionary dictionary];
+    @synchronized(self) {
+        for (NSString* resourcePath in _histogramsByResourcePath) {
+            NSDictionary* histograms = [_histogramsByResourcePath objectForKey:resourcePath];
+            NSMutableDictionary* summaries = [NSMutableDictionary dictionaryWithCapacity:[histograms count]];
+            for (NSString* phase in histograms) {
+                [summaries setObject:[[histograms objectForKey:phase] summary] forKey:phase];
+            }
+            [report setObject:summaries forKey:resourcePath];
+        }
+    }
+
+    return report;
+}
+
+- (void)logReport {
+    NSDictionary* report = [self report];
+    for (NSString* resourcePath in [[report allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        RKLogInfo(@"Request metrics for resource path '%@': %@", resourcePath, [report objectForKey:resourcePath]);
+    }
+}
+
+- (void)reset {
+    @synchronized(self) {
+        [_histogramsByResourcePath removeAllObjects];
+    }
+}
+
+@end
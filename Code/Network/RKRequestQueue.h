@@ -20,6 +20,7 @@
 
 #import <Foundation/Foundation.h>
 #import "RKRequest.h"
+#import "RKRequestTimeoutWheel.h"
 
 @protocol RKRequestQueueDelegate;
 
@@ -30,13 +31,16 @@
 @interface RKRequestQueue : NSObject {
     NSString *_name;
 	NSMutableArray *_requests;
+    NSMutableArray *_revalidatingRequests;
     NSObject<RKRequestQueueDelegate> *_delegate;
 	NSUInteger _loadingCount;
     NSUInteger _concurrentRequestsLimit;
 	NSUInteger _requestTimeout;
 	NSTimer *_queueTimer;
+    RKRequestTimeoutWheel *_timeoutWheel;
 	BOOL _suspended;
     BOOL _showsNetworkActivityIndicatorWhenBusy;
+    BOOL _usesNetworkThread;
 }
 
 /**
@@ -65,6 +69,28 @@
  */
 @property (nonatomic, assign) NSUInteger requestTimeout;
 
+/**
+ * The timeout wheel tracking connect, idle and total deadlines for every
+ * request dispatched by this queue. A single timer drives the wheel
+ * regardless of the number of requests in flight.
+ */
+@property (nonatomic, readonly) RKRequestTimeoutWheel *timeoutWheel;
+
+/**
+ * When YES, requests are dispatched and their connections serviced on a dedicated
+ * network thread with its own run loop, and the queue's bookkeeping happens on that thread
+ * as well. Data keeps flowing off the network while the main thread is busy. Request and
+ * queue delegate callbacks are still delivered on the main thread. Requests are prepared
+ * on the main thread as they are added, rather than when they are dispatched.
+ *
+ * Should be configured before any requests are added to the queue.
+ *
+ * *Default*: NO
+ *
+ * @see RKNetworkThread
+ */
+@property (nonatomic, assign) BOOL usesNetworkThread;
+
 /**
  * Gets the flag that determines if new load requests are allowed to reach the network.
  *
@@ -146,15 +172,28 @@
 - (void)cancelRequest:(RKRequest *)request;
 
 /**
- * Cancel all requests with a given delegate
+ * Cancel all requests with a given delegate, including background revalidations
+ * of cached responses already delivered to it
  */
 - (void)cancelRequestsWithDelegate:(NSObject<RKRequestDelegate> *)delegate;
 
 /**
- * Cancel all active or pending requests.
+ * Cancel all active or pending requests, including background revalidations
  */
 - (void)cancelAllRequests;
 
+/**
+ * Tracks a request that has left the queue after delivering a cached response, while it
+ * revalidates that response in the background, so that it can still be cancelled.
+ * Sent by the request; the queue retains it until removeRevalidatingRequest: is sent.
+ */
+- (void)addRevalidatingRequest:(RKRequest *)request;
+
+/**
+ * Stops tracking a request once its revalidation has finished or been cancelled
+ */
+- (void)removeRevalidatingRequest:(RKRequest *)request;
+
 /**
  * Start checking for and processing requests
  */
@@ -195,7 +234,8 @@
 - (void)requestQueueDidFinishLoading:(RKRequestQueue *)queue;
 
 /**
- * Sent before queue sends a request
+ * Sent before queue sends a request. When the queue uses the network thread this
+ * arrives asynchronously, and the request has already been prepared when it was added.
  */
 - (void)requestQueue:(RKRequestQueue *)queue willSendRequest:(RKRequest *)request;
 
@@ -26,6 +26,9 @@
 #import "RKRequestQueue.h"
 #import "RKResponse.h"
 #import "RKNotifications.h"
+#import "RKRequestMetrics.h"
+#import "RKNetworkThread.h"
+#import "RKRequest_Internals.h"
 #import "RKLog.h"
 #import "RKFixCategoryBug.h"
 
@@ -45,6 +48,9 @@ static const NSTimeInterval kFlushDelay = 0.3;
 
 // Declare the loading count read-write
 @property (nonatomic, assign, readwrite) NSUInteger loadingCount;
+
+- (NSThread*)queueThread;
+- (void)informDelegateWithSelector:(SEL)selector object:(id)object object:(id)otherObject waitUntilDone:(BOOL)waitUntilDone;
 @end
 
 @implementation RKRequestQueue
@@ -55,6 +61,8 @@ static const NSTimeInterval kFlushDelay = 0.3;
 @synthesize requestTimeout = _requestTimeout;
 @synthesize suspended = _suspended;
 @synthesize loadingCount = _loadingCount;
+@synthesize timeoutWheel = _timeoutWheel;
+@synthesize usesNetworkThread = _usesNetworkThread;
 
 #if TARGET_OS_IPHONE
 @synthesize showsNetworkActivityIndicatorWhenBusy = _showsNetworkActivityIndicatorWhenBusy;
@@ -126,10 +134,12 @@ static const NSTimeInterval kFlushDelay = 0.3;
 - (id)init {
 	if ((self = [super init])) {
 		_requests = [[NSMutableArray alloc] init];
+        _revalidatingRequests = [[NSMutableArray alloc] init];
 		_suspended = YES;
 		_loadingCount = 0;
 		_concurrentRequestsLimit = 5;
 		_requestTimeout = 300;
+        _timeoutWheel = [RKRequestTimeoutWheel new];
         _showsNetworkActivityIndicatorWhenBusy = NO;
 
 #if TARGET_OS_IPHONE
@@ -170,6 +180,10 @@ static const NSTimeInterval kFlushDelay = 0.3;
     [_queueTimer invalidate];
     [_requests release];
     _requests = nil;
+    [_revalidatingRequests release];
+    _revalidatingRequests = nil;
+    [_timeoutWheel release];
+    _timeoutWheel = nil;
 
     [super dealloc];
 }
@@ -184,31 +198,75 @@ static const NSTimeInterval kFlushDelay = 0.3;
             self.count, self.loadingCount, self.concurrentRequestsLimit];
 }
 
+/**
+ * The thread that dispatches requests and processes their completion: the main thread
+ * unless the queue uses the network thread
+ */
+- (NSThread*)queueThread {
+    return _usesNetworkThread ? [RKNetworkThread sharedThread] : [NSThread mainThread];
+}
+
+/**
+ * Sends a message taking the queue and up to two further arguments to the delegate on the main thread.
+ * Invoked directly when already on the main thread.
+ */
+- (void)informDelegateWithSelector:(SEL)selector object:(id)object object:(id)otherObject waitUntilDone:(BOOL)waitUntilDone {
+    if (! [_delegate respondsToSelector:selector]) {
+        return;
+    }
+    
+    NSMethodSignature* signature = [_delegate methodSignatureForSelector:selector];
+    NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:signature];
+    [invocation setTarget:_delegate];
+    [invocation setSelector:selector];
+    [invocation setArgument:&self atIndex:2];
+    if ([signature numberOfArguments] > 3) [invocation setArgument:&object atIndex:3];
+    if ([signature numberOfArguments] > 4) [invocation setArgument:&otherObject atIndex:4];
+    
+    if ([NSThread isMainThread]) {
+        [invocation invoke];
+    } else {
+        [invocation retainArguments];
+        [invocation performSelectorOnMainThread:@selector(invoke) withObject:nil waitUntilDone:waitUntilDone];
+    }
+}
+
+#if TARGET_OS_IPHONE
+/**
+ * Pushes or pops network activity on the main thread. The loading count changes on the
+ * network thread when the queue uses one, and UIKit must only be used from the main thread.
+ */
+- (void)performNetworkActivitySelectorOnMainThread:(SEL)selector {
+    UIApplication* application = [UIApplication sharedApplication];
+    if ([NSThread isMainThread]) {
+        [application performSelector:selector];
+    } else {
+        [application performSelectorOnMainThread:selector withObject:nil waitUntilDone:NO];
+    }
+}
+#endif
+
 - (void)setLoadingCount:(NSUInteger)count {
     if (_loadingCount == 0 && count > 0) {
         RKLogTrace(@"Loading count increasing from 0 to %ld. Firing requestQueueDidBeginLoading", (long) count);
         
         // Transitioning from empty to processing
-        if ([_delegate respondsToSelector:@selector(requestQueueDidBeginLoading:)]) {
-            [_delegate requestQueueDidBeginLoading:self];
-        }
+        [self informDelegateWithSelector:@selector(requestQueueDidBeginLoading:) object:nil object:nil waitUntilDone:NO];
 
 #if TARGET_OS_IPHONE
         if (self.showsNetworkActivityIndicatorWhenBusy) {
-            [[UIApplication sharedApplication] pushNetworkActivity];
+            [self performNetworkActivitySelectorOnMainThread:@selector(pushNetworkActivity)];
         }
 #endif
     } else if (_loadingCount > 0 && count == 0) {
         RKLogTrace(@"Loading count decreasing from %ld to 0. Firing requestQueueDidFinishLoading", (long) _loadingCount);
         
         // Transition from processing to empty
-        if ([_delegate respondsToSelector:@selector(requestQueueDidFinishLoading:)]) {
-            [_delegate requestQueueDidFinishLoading:self];
-        }
+        [self informDelegateWithSelector:@selector(requestQueueDidFinishLoading:) object:nil object:nil waitUntilDone:NO];
         
 #if TARGET_OS_IPHONE
         if (self.showsNetworkActivityIndicatorWhenBusy) {
-            [[UIApplication sharedApplication] popNetworkActivity];
+            [self performNetworkActivitySelectorOnMainThread:@selector(popNetworkActivity)];
         }
 #endif
     }
@@ -240,10 +298,11 @@ static const NSTimeInterval kFlushDelay = 0.3;
 }
 
 - (void)loadNextInQueue {
-    // We always want to dispatch requests from the main thread so the current thread does not terminate
-    // and cause us to lose the delegate callbacks
-    if (! [NSThread isMainThread]) {
-        [self performSelectorOnMainThread:@selector(loadNextInQueue) withObject:nil waitUntilDone:NO];
+    // We always want to dispatch requests from the main thread (or the network thread) so the current
+    // thread does not terminate and cause us to lose the delegate callbacks
+    NSThread* queueThread = [self queueThread];
+    if ([NSThread currentThread] != queueThread) {
+        [self performSelector:@selector(loadNextInQueue) onThread:queueThread withObject:nil waitUntilDone:NO];
         return;
     }
     
@@ -259,24 +318,30 @@ static const NSTimeInterval kFlushDelay = 0.3;
 	NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
 	_queueTimer = nil;
     
-    @synchronized(self) {
-        RKRequest* request = [self nextRequest];
-        while (request && self.loadingCount < _concurrentRequestsLimit) {
-            RKLogTrace(@"Processing request %@ in queue %@", request, self);
-            if ([_delegate respondsToSelector:@selector(requestQueue:willSendRequest:)]) {
-                [_delegate requestQueue:self willSendRequest:request];
+    // Requests are only ever dispatched from the queue thread. The lock guards the request list against
+    // additions from other threads, but is not held while calling out so that waiting on the main thread
+    // for the delegate cannot deadlock against it.
+    while (YES) {
+        RKRequest* request = nil;
+        @synchronized(self) {
+            if (self.loadingCount < _concurrentRequestsLimit) {
+                request = [[[self nextRequest] retain] autorelease];
             }
+        }
+        if (nil == request) {
+            break;
+        }
+        
+        RKLogTrace(@"Processing request %@ in queue %@", request, self);
+        [self informDelegateWithSelector:@selector(requestQueue:willSendRequest:) object:request object:nil waitUntilDone:NO];
 
+        @synchronized(self) {
             self.loadingCount = self.loadingCount + 1;
-            [request sendAsynchronously];
-            RKLogDebug(@"Sent request %@ from queue %@. Loading count = %ld of %ld", request, self, (long) self.loadingCount, (long) _concurrentRequestsLimit);
-
-            if ([_delegate respondsToSelector:@selector(requestQueue:didSendRequest:)]) {
-                [_delegate requestQueue:self didSendRequest:request];
-            }
-
-            request = [self nextRequest];
         }
+        [request sendAsynchronously];
+        RKLogDebug(@"Sent request %@ from queue %@. Loading count = %ld of %ld", request, self, (long) self.loadingCount, (long) _concurrentRequestsLimit);
+
+        [self informDelegateWithSelector:@selector(requestQueue:didSendRequest:) object:request object:nil waitUntilDone:NO];
     }
 
 	if (_requests.count && !_suspended) {
@@ -292,16 +357,12 @@ static const NSTimeInterval kFlushDelay = 0.3;
             RKLogDebug(@"Queue %@ has been suspended", self);
             
             // Becoming suspended
-            if ([_delegate respondsToSelector:@selector(requestQueueWasSuspended:)]) {
-                [_delegate requestQueueWasSuspended:self];
-            }
+            [self informDelegateWithSelector:@selector(requestQueueWasSuspended:) object:nil object:nil waitUntilDone:NO];
         } else {
             RKLogDebug(@"Queue %@ has been unsuspended", self);
             
             // Becoming unsupended
-            if ([_delegate respondsToSelector:@selector(requestQueueWasUnsuspended:)]) {
-                [_delegate requestQueueWasUnsuspended:self];
-            }
+            [self informDelegateWithSelector:@selector(requestQueueWasUnsuspended:) object:nil object:nil waitUntilDone:NO];
         }
     }
 
@@ -309,19 +370,36 @@ static const NSTimeInterval kFlushDelay = 0.3;
 
 	if (!_suspended) {
 		[self loadNextInQueue];
-	} else if (_queueTimer) {
+	} else if (_queueTimer && [NSThread currentThread] == [self queueThread]) {
+        // A timer may only be invalidated from the thread it was scheduled on. Otherwise
+        // the pending timer will find the queue suspended and reschedule itself.
 		[_queueTimer invalidate];
 		_queueTimer = nil;
 	}
 }
 
 - (void)addRequest:(RKRequest*)request {
+    if (_usesNetworkThread) {
+        // Preparing a request may serialize objects that belong to the main thread (such as managed
+        // objects). It is done on the main thread as the request is added, so that the network thread
+        // never has to wait on the main thread when it dispatches the request
+        if (NO == [NSThread isMainThread]) {
+            [self performSelectorOnMainThread:@selector(addRequest:) withObject:request waitUntilDone:NO];
+            return;
+        }
+        if (NO == [request isPreparedForDispatch] && NO == [request prepareURLRequestForDispatch]) {
+            RKLogDebug(@"Declined to add request %@ to queue %@: the request could not be prepared", request, self);
+            return;
+        }
+    }
+    
     RKLogTrace(@"Request %@ added to queue %@", request, self);
 
     @synchronized(self) {
         [_requests addObject:request];
         request.queue = self;
     }
+    request.metrics.enqueueTime = [NSDate timeIntervalSinceReferenceDate];
 
     [[NSNotificationCenter defaultCenter] addObserver:self
                                              selector:@selector(requestFinishedWithNotification:)
@@ -347,8 +425,10 @@ static const NSTimeInterval kFlushDelay = 0.3;
         [[NSNotificationCenter defaultCenter] removeObserver:self name:RKRequestDidFailWithErrorNotification object:request];
         
         if (decrementCounter) {
-            NSAssert(self.loadingCount > 0, @"Attempted to decrement loading count below zero");
-            self.loadingCount = self.loadingCount - 1;
+            @synchronized(self) {
+                NSAssert(self.loadingCount > 0, @"Attempted to decrement loading count below zero");
+                self.loadingCount = self.loadingCount - 1;
+            }
             RKLogTrace(@"Decremented the loading count to %ld", (long) self.loadingCount);
         }
         return YES;
@@ -370,18 +450,14 @@ static const NSTimeInterval kFlushDelay = 0.3;
         [self removeRequest:request decrementCounter:NO];
         request.delegate = nil;
         
-        if ([_delegate respondsToSelector:@selector(requestQueue:didCancelRequest:)]) {
-            [_delegate requestQueue:self didCancelRequest:request];
-        }
+        [self informDelegateWithSelector:@selector(requestQueue:didCancelRequest:) object:request object:nil waitUntilDone:NO];
     } else if ([_requests containsObject:request] && [request isLoading]) {
         RKLogDebug(@"Canceled loading request %@ and removed from queue %@", request, self);
         
 		[request cancel];
 		request.delegate = nil;
         
-        if ([_delegate respondsToSelector:@selector(requestQueue:didCancelRequest:)]) {
-            [_delegate requestQueue:self didCancelRequest:request];
-        }
+        [self informDelegateWithSelector:@selector(requestQueue:didCancelRequest:) object:request object:nil waitUntilDone:NO];
         
         // Decrement the counter
         [self removeRequest:request decrementCounter:YES];
@@ -406,6 +482,18 @@ static const NSTimeInterval kFlushDelay = 0.3;
 			[self cancelRequest:request];
 		}
 	}
+    
+    NSArray* revalidatingRequestsCopy = nil;
+    @synchronized(self) {
+        revalidatingRequestsCopy = [NSArray arrayWithArray:_revalidatingRequests];
+    }
+    for (RKRequest* request in revalidatingRequestsCopy) {
+        if (request.delegate && request.delegate == delegate) {
+            RKLogDebug(@"Canceled revalidation of cached response for request %@", request);
+            request.delegate = nil;
+            [request cancel];
+        }
+    }
 	[pool drain];
 }
 
@@ -417,9 +505,34 @@ static const NSTimeInterval kFlushDelay = 0.3;
 	for (RKRequest* request in requestsCopy) {
 		[self cancelRequest:request loadNext:NO];
 	}
+    
+    NSArray* revalidatingRequestsCopy = nil;
+    @synchronized(self) {
+        revalidatingRequestsCopy = [NSArray arrayWithArray:_revalidatingRequests];
+    }
+    for (RKRequest* request in revalidatingRequestsCopy) {
+        request.delegate = nil;
+        [request cancel];
+    }
 	[pool drain];
 }
 
+- (void)addRevalidatingRequest:(RKRequest*)request {
+    @synchronized(self) {
+        if ([_revalidatingRequests indexOfObjectIdenticalTo:request] == NSNotFound) {
+            [_revalidatingRequests addObject:request];
+        }
+    }
+}
+
+- (void)removeRevalidatingRequest:(RKRequest*)request {
+    // The array may hold the last reference to the request
+    [[request retain] autorelease];
+    @synchronized(self) {
+        [_revalidatingRequests removeObjectIdenticalTo:request];
+    }
+}
+
 - (void)start {
     RKLogDebug(@"Started queue %@", self);
     [self setSuspended:NO];
@@ -432,6 +545,13 @@ static const NSTimeInterval kFlushDelay = 0.3;
 - (void)requestFinishedWithNotification:(NSNotification*)notification {
     NSAssert([notification.object isKindOfClass:[RKRequest class]], @"Notification expected to contain an RKRequest, got a %@", NSStringFromClass([notification.object class]));
     
+    // Completion is processed on the queue thread. The notification retains the request until then
+    NSThread* queueThread = [self queueThread];
+    if ([NSThread currentThread] != queueThread) {
+        [self performSelector:@selector(requestFinishedWithNotification:) onThread:queueThread withObject:notification waitUntilDone:NO];
+        return;
+    }
+    
     RKRequest* request = (RKRequest*)notification.object;
     NSDictionary* userInfo = [notification userInfo];
     if ([self containsRequest:request]) {
@@ -443,9 +563,7 @@ static const NSTimeInterval kFlushDelay = 0.3;
             RKLogDebug(@"Received response for request %@, removing from queue. (Now loading %lu of %lu)", request, (unsigned long) _loadingCount, (unsigned long) _concurrentRequestsLimit);
             
             RKResponse* response = [userInfo objectForKey:RKRequestDidLoadResponseNotificationUserInfoResponseKey];                        
-            if ([_delegate respondsToSelector:@selector(requestQueue:didLoadResponse:)]) {
-                [_delegate requestQueue:self didLoadResponse:response];
-            }            
+            [self informDelegateWithSelector:@selector(requestQueue:didLoadResponse:) object:response object:nil waitUntilDone:NO];
         } else if ([notification.name isEqualToString:RKRequestDidFailWithErrorNotification]) {
             // We failed with an error
             NSError* error = nil;
@@ -457,9 +575,7 @@ static const NSTimeInterval kFlushDelay = 0.3;
                 RKLogWarning(@"Received RKRequestDidFailWithErrorNotification without a userInfo, something is amiss...");
             }
             
-            if ([_delegate respondsToSelector:@selector(requestQueue:didFailRequest:withError:)]) {
-                [_delegate requestQueue:self didFailRequest:request withError:error];
-            }
+            [self informDelegateWithSelector:@selector(requestQueue:didFailRequest:withError:) object:request object:error waitUntilDone:NO];
         }
         
         // Load the next request
@@ -0,0 +1,115 @@
+//
+//  RKRequestTimeoutWheel.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RKRequest;
+
+/**
+ A hashed timer wheel tracking the timeout deadlines for a set of in-flight requests.
+
+ Rather than scheduling an NSTimer per request, the wheel owns a single repeating timer
+ that ticks at a fixed resolution while there are requests to watch. Each request is
+ tracked against three deadlines:
+
+ 1. The connect deadline (the request's timeoutInterval), cleared once a response arrives.
+ 2. The idle deadline (the request's idleTimeoutInterval), pushed back on every chunk of data received.
+ 3. The total deadline (the request's totalTimeoutInterval), fixed when the request is added.
+
+ Deadlines are only ever pushed later while a request is loading, so entries are rescheduled lazily
+ when their slot comes around rather than on every chunk of data. All requests that have expired
+ are sent timeout in a single pass once the tick has finished examining the wheel.
+
+ The wheel does not retain the requests it is tracking. Requests remove themselves when they are
+ finished, cancelled or deallocated.
+
+ @see [RKRequestQueue timeoutWheel]
+ */
+@interface RKRequestTimeoutWheel : NSObject {
+    NSTimeInterval _tickInterval;
+    NSUInteger _slotCount;
+    NSMutableArray *_slots;
+    CFMutableDictionaryRef _entries;
+    NSUInteger _currentSlot;
+    NSTimeInterval _lastTickTime;
+    NSTimer *_tickTimer;
+}
+
+/**
+ The resolution of the wheel. Deadlines fire no later than one tick after they are due.
+
+ **Default**: 0.5 seconds
+ */
+@property (nonatomic, readonly) NSTimeInterval tickInterval;
+
+/**
+ The number of slots on the wheel.
+
+ **Default**: 512
+ */
+@property (nonatomic, readonly) NSUInteger slotCount;
+
+/**
+ Returns the number of requests currently tracked by the wheel
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ Returns the timeout wheel used for requests that are sent without a request queue
+ */
++ (RKRequestTimeoutWheel *)defaultTimeoutWheel;
+
+/**
+ Initializes a wheel with the given tick resolution and number of slots
+ */
+- (id)initWithTickInterval:(NSTimeInterval)tickInterval slotCount:(NSUInteger)slotCount;
+
+/**
+ Begins tracking the connect, idle and total deadlines for the request. Adding
+ a request that is already tracked resets all of its deadlines.
+ */
+- (void)addRequest:(RKRequest *)request;
+
+/**
+ Stops tracking the request
+ */
+- (void)removeRequest:(RKRequest *)request;
+
+/**
+ Returns YES when the request is being tracked by the wheel
+ */
+- (BOOL)containsRequest:(RKRequest *)request;
+
+/**
+ Clears the connect deadline of the request. Invoked when the request receives a response.
+ */
+- (void)requestDidReceiveResponse:(RKRequest *)request;
+
+/**
+ Pushes back the idle deadline of the request. Invoked each time the request receives a chunk of data.
+ */
+- (void)requestDidReceiveData:(RKRequest *)request;
+
+/**
+ Advances the wheel to the current time and sends timeout to every expired request.
+ Invoked by the internal timer; exposed for testing.
+ */
+- (void)tick;
+
+@end
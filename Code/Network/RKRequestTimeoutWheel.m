@@ -0,0 +1,318 @@
+//
+//  RKRequestTimeoutWheel.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKRequestTimeoutWheel.h"
+#import "RKRequest.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitNetworkQueue
+
+static RKRequestTimeoutWheel* defaultTimeoutWheel = nil;
+
+static const NSTimeInterval kDefaultTickInterval = 0.5;
+static const NSUInteger kDefaultSlotCount = 512;
+
+/**
+ Bookkeeping for a single request on the wheel
+ */
+@interface RKRequestTimeoutWheelEntry : NSObject {
+    RKRequest* _request;
+    NSTimeInterval _connectDeadline;
+    NSTimeInterval _idleDeadline;
+    NSTimeInterval _totalDeadline;
+    NSTimeInterval _idleTimeoutInterval;
+    NSUInteger _slot;
+    NSUInteger _rounds;
+}
+
+@property (nonatomic, assign) RKRequest* request;
+@property (nonatomic, assign) NSTimeInterval connectDeadline;
+@property (nonatomic, assign) NSTimeInterval idleDeadline;
+@property (nonatomic, assign) NSTimeInterval totalDeadline;
+@property (nonatomic, assign) NSTimeInterval idleTimeoutInterval;
+@property (nonatomic, assign) NSUInteger slot;
+@property (nonatomic, assign) NSUInteger rounds;
+
+// Returns the earliest active deadline, or 0 if no deadline is active
+- (NSTimeInterval)earliestDeadline;
+
+@end
+
+@implementation RKRequestTimeoutWheelEntry
+
+@synthesize request = _request;
+@synthesize connectDeadline = _connectDeadline;
+@synthesize idleDeadline = _idleDeadline;
+@synthesize totalDeadline = _totalDeadline;
+@synthesize idleTimeoutInterval = _idleTimeoutInterval;
+@synthesize slot = _slot;
+@synthesize rounds = _rounds;
+
+- (NSTimeInterval)earliestDeadline {
+    NSTimeInterval earliest = 0;
+    NSTimeInterval deadlines[3] = { _connectDeadline, _idleDeadline, _totalDeadline };
+    for (int i = 0; i < 3; i++) {
+        if (deadlines[i] > 0 && (earliest == 0 || deadlines[i] < earliest)) {
+            earliest = deadlines[i];
+        }
+    }
+
+    return earliest;
+}
+
+@end
+
+@interface RKRequestTimeoutWheel (Private)
+- (void)scheduleEntry:(RKRequestTimeoutWheelEntry*)entry atTime:(NSTimeInterval)now;
+- (void)unscheduleEntry:(RKRequestTimeoutWheelEntry*)entry;
+- (void)startTickTimerIfNecessary;
+@end
+
+@implementation RKRequestTimeoutWheel
+
+@synthesize tickInterval = _tickInterval;
+@synthesize slotCount = _slotCount;
+
++ (RKRequestTimeoutWheel*)defaultTimeoutWheel {
+    @synchronized(self) {
+        if (nil == defaultTimeoutWheel) {
+            defaultTimeoutWheel = [RKRequestTimeoutWheel new];
+        }
+    }
+
+    return defaultTimeoutWheel;
+}
+
+- (id)init {
+    return [self initWithTickInterval:kDefaultTickInterval slotCount:kDefaultSlotCount];
+}
+
+- (id)initWithTickInterval:(NSTimeInterval)tickInterval slotCount:(NSUInteger)slotCount {
+    NSAssert(tickInterval > 0, @"Timeout wheel tick interval must be greater than zero");
+    NSAssert(slotCount > 0, @"Timeout wheel must have at least one slot");
+    self = [super init];
+    if (self) {
+        _tickInterval = tickInterval;
+        _slotCount = slotCount;
+        _slots = [[NSMutableArray alloc] initWithCapacity:slotCount];
+        for (NSUInteger i = 0; i < slotCount; i++) {
+            [_slots addObject:[NSMutableSet set]];
+        }
+        // Keys are not retained: the wheel never owns the requests it watches
+        _entries = CFDictionaryCreateMutable(NULL, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        _currentSlot = 0;
+        _lastTickTime = [NSDate timeIntervalSinceReferenceDate];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_tickTimer invalidate];
+    _tickTimer = nil;
+    [_slots release];
+    _slots = nil;
+    if (_entries) {
+        CFRelease(_entries);
+        _entries = NULL;
+    }
+
+    [super dealloc];
+}
+
+- (NSUInteger)count {
+    @synchronized(self) {
+        return CFDictionaryGetCount(_entries);
+    }
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p tickInterval=%f slotCount=%lu count=%lu>",
+            NSStringFromClass([self class]), self, _tickInterval, (unsigned long) _slotCount, (unsigned long) [self count]];
+}
+
+#pragma mark - Scheduling
+
+- (void)scheduleEntry:(RKRequestTimeoutWheelEntry*)entry atTime:(NSTimeInterval)now {
+    NSTimeInterval delay = MAX(0, [entry earliestDeadline] - now);
+    NSUInteger ticks = (NSUInteger) ceil(delay / _tickInterval);
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    entry.slot = (_currentSlot + ticks) % _slotCount;
+    entry.rounds = (ticks - 1) / _slotCount;
+    [[_slots objectAtIndex:entry.slot] addObject:entry];
+}
+
+- (void)unscheduleEntry:(RKRequestTimeoutWheelEntry*)entry {
+    [[_slots objectAtIndex:entry.slot] removeObject:entry];
+}
+
+- (void)startTickTimerIfNecessary {
+    if (_tickTimer) {
+        return;
+    }
+
+    if (CFDictionaryGetCount(_entries) == 0) {
+        _currentSlot = 0;
+    }
+    _lastTickTime = [NSDate timeIntervalSinceReferenceDate];
+
+    // Timeouts are delivered on the main run loop in the common modes so that tracking a
+    // scroll view does not hold them up. The timer is invalidated from tick once the wheel drains.
+    _tickTimer = [NSTimer timerWithTimeInterval:_tickInterval target:self selector:@selector(tick) userInfo:nil repeats:YES];
+    CFRunLoopAddTimer(CFRunLoopGetMain(), (CFRunLoopTimerRef)_tickTimer, kCFRunLoopCommonModes);
+    RKLogTrace(@"Started tick timer for timeout wheel %@", self);
+}
+
+#pragma mark - Request Tracking
+
+- (void)addRequest:(RKRequest*)request {
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+
+    @synchronized(self) {
+        RKRequestTimeoutWheelEntry* entry = (RKRequestTimeoutWheelEntry*) CFDictionaryGetValue(_entries, request);
+        if (entry) {
+            [self unscheduleEntry:entry];
+        } else {
+            entry = [[RKRequestTimeoutWheelEntry new] autorelease];
+            entry.request = request;
+        }
+
+        entry.connectDeadline = (request.timeoutInterval > 0) ? now + request.timeoutInterval : 0;
+        entry.idleTimeoutInterval = request.idleTimeoutInterval;
+        entry.idleDeadline = (request.idleTimeoutInterval > 0) ? now + request.idleTimeoutInterval : 0;
+        entry.totalDeadline = (request.totalTimeoutInterval > 0) ? now + request.totalTimeoutInterval : 0;
+
+        if ([entry earliestDeadline] == 0) {
+            RKLogTrace(@"Request %@ has no timeout configured, not tracking on wheel %@", request, self);
+            CFDictionaryRemoveValue(_entries, request);
+            return;
+        }
+
+        CFDictionarySetValue(_entries, request, entry);
+        [self scheduleEntry:entry atTime:now];
+        [self startTickTimerIfNecessary];
+    }
+}
+
+- (void)removeRequest:(RKRequest*)request {
+    @synchronized(self) {
+        RKRequestTimeoutWheelEntry* entry = (RKRequestTimeoutWheelEntry*) CFDictionaryGetValue(_entries, request);
+        if (entry) {
+            [self unscheduleEntry:entry];
+            CFDictionaryRemoveValue(_entries, request);
+        }
+    }
+}
+
+- (BOOL)containsRequest:(RKRequest*)request {
+    @synchronized(self) {
+        return CFDictionaryContainsKey(_entries, request);
+    }
+}
+
+- (void)requestDidReceiveResponse:(RKRequest*)request {
+    @synchronized(self) {
+        RKRequestTimeoutWheelEntry* entry = (RKRequestTimeoutWheelEntry*) CFDictionaryGetValue(_entries, request);
+        if (entry) {
+            entry.connectDeadline = 0;
+            if ([entry earliestDeadline] == 0) {
+                [self unscheduleEntry:entry];
+                CFDictionaryRemoveValue(_entries, request);
+            }
+        }
+    }
+}
+
+- (void)requestDidReceiveData:(RKRequest*)request {
+    @synchronized(self) {
+        RKRequestTimeoutWheelEntry* entry = (RKRequestTimeoutWheelEntry*) CFDictionaryGetValue(_entries, request);
+        if (entry) {
+            // Receiving data implies a response. The slot is left alone: the deadline
+            // only moved later, so the entry is rescheduled when its slot comes around.
+            entry.connectDeadline = 0;
+            if (entry.idleTimeoutInterval > 0) {
+                entry.idleDeadline = [NSDate timeIntervalSinceReferenceDate] + entry.idleTimeoutInterval;
+            }
+            if ([entry earliestDeadline] == 0) {
+                [self unscheduleEntry:entry];
+                CFDictionaryRemoveValue(_entries, request);
+            }
+        }
+    }
+}
+
+#pragma mark - Ticking
+
+- (void)tick {
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+    NSMutableArray* expiredRequests = [NSMutableArray array];
+
+    @synchronized(self) {
+        NSUInteger ticks = (NSUInteger) MAX(1, floor((now - _lastTickTime) / _tickInterval + 0.5));
+        BOOL sweptEntireWheel = (ticks >= _slotCount);
+        if (sweptEntireWheel) {
+            ticks = _slotCount;
+        }
+        _lastTickTime = now;
+
+        for (NSUInteger i = 0; i < ticks; i++) {
+            _currentSlot = (_currentSlot + 1) % _slotCount;
+            NSMutableSet* slot = [_slots objectAtIndex:_currentSlot];
+            if ([slot count] == 0) {
+                continue;
+            }
+
+            for (RKRequestTimeoutWheelEntry* entry in [[slot copy] autorelease]) {
+                if ([entry earliestDeadline] <= now) {
+                    [expiredRequests addObject:entry.request];
+                    [slot removeObject:entry];
+                    CFDictionaryRemoveValue(_entries, entry.request);
+                } else if (entry.rounds > 0 && !sweptEntireWheel) {
+                    entry.rounds = entry.rounds - 1;
+                } else {
+                    // Deadline was pushed back by incoming data. Move the entry to its new slot
+                    [slot removeObject:entry];
+                    [self scheduleEntry:entry atTime:now];
+                }
+            }
+        }
+
+        if (CFDictionaryGetCount(_entries) == 0) {
+            RKLogTrace(@"Timeout wheel %@ is empty, stopping tick timer", self);
+            [_tickTimer invalidate];
+            _tickTimer = nil;
+        }
+    }
+
+    if ([expiredRequests count] > 0) {
+        RKLogDebug(@"Timeout wheel %@ expired %lu requests", self, (unsigned long) [expiredRequests count]);
+    }
+
+    // Fire outside the lock: timing out a request re-enters the wheel and calls out to delegates
+    for (RKRequest* request in expiredRequests) {
+        [request timeout];
+    }
+}
+
+@end
@@ -20,5 +20,15 @@
 
 @interface RKRequest (Internals)
 - (BOOL)prepareURLRequest;
+- (BOOL)prepareURLRequestForDispatch;
+- (BOOL)isPreparedForDispatch;
+- (void)setLoading:(BOOL)loading;
 - (void)didFailLoadWithError:(NSError*)error;
+- (RKResponse*)loadResponseFromCache;
+- (void)didFinishLoadFromNetworkThread:(RKResponse*)response;
+- (void)didFailLoadFromNetworkThreadWithError:(NSError*)error;
+- (void)networkThreadConnectionDidFinish;
+- (void)revalidateCachedResponseIfNecessaryOnQueue:(RKRequestQueue*)queue;
+- (BOOL)finishRevalidationWithResponse:(RKResponse*)response;
+- (BOOL)finishRevalidationWithError:(NSError*)error;
 @end
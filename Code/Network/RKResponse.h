@@ -27,7 +27,7 @@
 @interface RKResponse : NSObject {
 	RKRequest* _request;
 	NSHTTPURLResponse* _httpURLResponse;
-	NSMutableData* _body;
+	NSData* _body;
 	NSError* _failureError;
 	BOOL _loading;
 	NSDictionary* _responseHeaders;
@@ -23,6 +23,10 @@
 #import "RKLog.h"
 #import "RKParserRegistry.h"
 #import "RKClient.h"
+#import "RKRequestTimeoutWheel.h"
+#import "RKRequestMetrics.h"
+#import "RKNetworkThread.h"
+#import "RKRequest_Internals.h"
 
 // Set Logging Component
 #undef RKLogComponent
@@ -32,6 +36,10 @@ extern NSString* cacheResponseCodeKey;
 extern NSString* cacheMIMETypeKey;
 extern NSString* cacheURLKey;
 
+@interface RKResponse (Private)
+- (void)informRequestDelegateWithSelector:(SEL)selector bytes:(NSInteger)bytes totalBytes:(NSInteger)totalBytes expectedBytes:(NSInteger)expectedBytes;
+@end
+
 @implementation RKResponse
 
 @synthesize body = _body, request = _request, failureError = _failureError;
@@ -63,7 +71,8 @@ extern NSString* cacheURLKey;
 	self = [self initWithRequest:request];
 	if (self) {
 		[_body release];
-        _body = [[NSMutableData dataWithData:body] retain];
+        // Cached bodies may be backed by a mapped file, so hold on to them rather than copying
+        _body = [(body ? body : [NSData data]) retain];
 		_responseHeaders = [headers retain];
 	}
 
@@ -179,29 +188,51 @@ extern NSString* cacheURLKey;
 }
 
 - (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
-	[_body appendData:data];
-    [_request invalidateTimeoutTimer];
-    if ([[_request delegate] respondsToSelector:@selector(request:didReceivedData:totalBytesReceived:totalBytesExectedToReceive:)]) {
-        [[_request delegate] request:_request didReceivedData:[data length] totalBytesReceived:[_body length] totalBytesExectedToReceive:_httpURLResponse.expectedContentLength];
+	// Responses loaded from the network always accumulate into the mutable body allocated in init
+	[(NSMutableData*)_body appendData:data];
+    [_request.timeoutWheel requestDidReceiveData:_request];
+    RKRequestMetrics* metrics = _request.metrics;
+    if (metrics.firstByteTime == 0) {
+        metrics.firstByteTime = [NSDate timeIntervalSinceReferenceDate];
     }
+    metrics.bytesReceived += [data length];
+    [self informRequestDelegateWithSelector:@selector(request:didReceivedData:totalBytesReceived:totalBytesExectedToReceive:)
+                                      bytes:[data length] totalBytes:[_body length] expectedBytes:_httpURLResponse.expectedContentLength];
 }
 
 - (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSHTTPURLResponse *)response {	
     RKLogDebug(@"NSHTTPURLResponse Status Code: %ld", (long) [response statusCode]);
     RKLogDebug(@"Headers: %@", [response allHeaderFields]);
 	_httpURLResponse = [response retain];
-    [_request invalidateTimeoutTimer];
+    [_request.timeoutWheel requestDidReceiveResponse:_request];
+    if (_request.metrics.firstByteTime == 0) {
+        _request.metrics.firstByteTime = [NSDate timeIntervalSinceReferenceDate];
+    }
 }
 
 - (void)connectionDidFinishLoading:(NSURLConnection *)connection {
 	RKLogTrace(@"Read response body: %@", [self bodyAsString]);
-	[_request didFinishLoad:self];
+    _request.metrics.lastByteTime = [NSDate timeIntervalSinceReferenceDate];
+    if ([RKNetworkThread isNetworkThread]) {
+        [_request.timeoutWheel removeRequest:_request];
+        [_request performSelectorOnMainThread:@selector(didFinishLoadFromNetworkThread:) withObject:self waitUntilDone:NO];
+        [_request networkThreadConnectionDidFinish];
+    } else {
+        [_request invalidateTimeoutTimer];
+        [_request didFinishLoad:self];
+    }
 }
 
 - (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error {
     _failureError = [error retain];
-    [_request invalidateTimeoutTimer];
-    [_request didFailLoadWithError:_failureError];
+    if ([RKNetworkThread isNetworkThread]) {
+        [_request.timeoutWheel removeRequest:_request];
+        [_request performSelectorOnMainThread:@selector(didFailLoadFromNetworkThreadWithError:) withObject:_failureError waitUntilDone:NO];
+        [_request networkThreadConnectionDidFinish];
+    } else {
+        [_request invalidateTimeoutTimer];
+        [_request didFailLoadWithError:_failureError];
+    }
 }
 
 - (NSInputStream *)connection:(NSURLConnection *)connection needNewBodyStream:(NSURLRequest *)request {
@@ -217,9 +248,30 @@ extern NSString* cacheURLKey;
 // callbacks get called in the correct order.
 - (void)connection:(NSURLConnection *)connection didSendBodyData:(NSInteger)bytesWritten totalBytesWritten:(NSInteger)totalBytesWritten totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite {
 	
-	if ([[_request delegate] respondsToSelector:@selector(request:didSendBodyData:totalBytesWritten:totalBytesExpectedToWrite:)]) {
-		[[_request delegate] request:_request didSendBodyData:bytesWritten totalBytesWritten:totalBytesWritten totalBytesExpectedToWrite:totalBytesExpectedToWrite];
-	}
+    [self informRequestDelegateWithSelector:@selector(request:didSendBodyData:totalBytesWritten:totalBytesExpectedToWrite:)
+                                      bytes:bytesWritten totalBytes:totalBytesWritten expectedBytes:totalBytesExpectedToWrite];
+}
+
+// Progress callbacks for connections running on the network thread are delivered on the main thread
+- (void)informRequestDelegateWithSelector:(SEL)selector bytes:(NSInteger)bytes totalBytes:(NSInteger)totalBytes expectedBytes:(NSInteger)expectedBytes {
+    NSObject<RKRequestDelegate>* delegate = [_request delegate];
+    if (! [delegate respondsToSelector:selector]) {
+        return;
+    }
+    
+    NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:[delegate methodSignatureForSelector:selector]];
+    [invocation setTarget:delegate];
+    [invocation setSelector:selector];
+    [invocation setArgument:&_request atIndex:2];
+    [invocation setArgument:&bytes atIndex:3];
+    [invocation setArgument:&totalBytes atIndex:4];
+    [invocation setArgument:&expectedBytes atIndex:5];
+    if ([RKNetworkThread isNetworkThread]) {
+        [invocation retainArguments];
+        [invocation performSelectorOnMainThread:@selector(invoke) withObject:nil waitUntilDone:NO];
+    } else {
+        [invocation invoke];
+    }
 }
 
 - (NSString*)localizedStatusCodeString {
@@ -258,7 +310,9 @@ extern NSString* cacheURLKey;
         RKLogWarning(@"Unable to parse response body: no parser registered for MIME Type '%@'", [self MIMEType]);
         return nil;
     }
+    _request.metrics.parseStartTime = [NSDate timeIntervalSinceReferenceDate];
     id object = [parser objectFromString:[self bodyAsString] error:error];
+    _request.metrics.parseEndTime = [NSDate timeIntervalSinceReferenceDate];
     if (object == nil) {
         if (error && *error) {
             RKLogError(@"Unable to parse response body: %@", [*error localizedDescription]);
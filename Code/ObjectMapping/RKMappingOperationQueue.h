@@ -18,15 +18,36 @@
  its reliance on threading for concurrent operations. The threading was causing problems
  with managed objects due to MOC being thread specific.
  
- This class is not intended to be thread-safe and is used for queueing non-concurrent
- operations that will be executed within the object mapper only. It is not a general purpose
- work queue.
+ Operations are executed in order on the thread that waits on the queue. Operations added
+ with addThreadSafeOperation: make no use of thread specific state such as a managed object
+ context and may instead be handed to a bounded set of worker threads when workerThreadCount
+ is greater than zero. Dependencies between operations are honored either way: an operation
+ is not started until every operation it depends on has finished. Dependencies that were never
+ added to the queue and have not started are started on the waiting thread. The time each
+ operation takes to execute is recorded for diagnostics.
+ 
+ This class is not intended to be thread-safe and is used for queueing operations that will
+ be executed within the object mapper only. It is not a general purpose work queue.
  */
 @interface RKMappingOperationQueue : NSObject {
  @protected
     NSMutableArray *_operations;
+    NSMutableDictionary *_operationsByKey;
+    NSMutableSet *_threadSafeOperations;
+    NSMutableSet *_dispatchedOperations;
+    NSMutableDictionary *_executionTimes;
+    NSOperationQueue *_workerQueue;
+    NSUInteger _workerThreadCount;
 }
 
+/**
+ The maximum number of worker threads executing thread-safe operations while the queue
+ is waited on. When zero, every operation is executed on the waiting thread.
+ 
+ **Default**: 0
+ */
+@property (nonatomic, assign) NSUInteger workerThreadCount;
+
 /**
  Adds an NSOperation to the queue for later execution
  
@@ -41,6 +62,42 @@
  */
 - (void)addOperationWithBlock:(void (^)(void))block;
 
+/**
+ Adds an NSOperation that can safely execute on any thread to the queue for later execution
+ 
+ @param op The operation to enqueue
+ @see workerThreadCount
+ */
+- (void)addThreadSafeOperation:(NSOperation *)op;
+
+/**
+ Adds an NSBlockOperation that can safely execute on any thread to the queue, configured
+ to execute the block passed
+ 
+ @param block A block to wrap into an operation for later execution
+ */
+- (void)addThreadSafeOperationWithBlock:(void (^)(void))block;
+
+/**
+ Adds an NSOperation to the queue that later work of the same kind can be merged into.
+ The operation executes in the order in which it was added, like any other.
+ 
+ @param op The operation to enqueue
+ @param key A key identifying the kind of work the operation performs
+ @see operationForKey:
+ */
+- (void)addOperation:(NSOperation *)op forKey:(id<NSCopying>)key;
+
+/**
+ Returns the operation previously added for the key, or nil. Work sharing the key can be
+ handed to the returned operation rather than enqueued separately, so that it executes
+ as a single batch.
+ 
+ @param key The key the operation was added for
+ @return The enqueued operation for the key
+ */
+- (NSOperation *)operationForKey:(id)key;
+
 /**
  Returns the collection of operations in the queue
  
@@ -56,8 +113,17 @@
 - (NSUInteger)operationCount;
 
 /**
- Starts the execution of all operations in the queue in the order in which they were added to the queue. The
- current threads execution will be blocked until all enqueued operations have returned.
+ Returns the number of seconds the operation took to execute
+ 
+ @param op An operation in the queue
+ @return The execution time of the operation, or 0 if it has not finished executing
+ */
+- (NSTimeInterval)executionTimeForOperation:(NSOperation *)op;
+
+/**
+ Starts the execution of all operations in the queue in the order in which they were added to the queue,
+ including operations added while the queue is executing. The current threads execution will be blocked
+ until all enqueued operations have returned.
  */
 - (void)waitUntilAllOperationsAreFinished;
 
@@ -7,13 +7,32 @@
 //
 
 #import "RKMappingOperationQueue.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitObjectMapping
+
+@interface RKMappingOperationQueue (Private)
+- (void)performOperation:(NSOperation *)op;
+- (void)dispatchOperation:(NSOperation *)op;
+- (void)resolveDependenciesOfOperation:(NSOperation *)op;
+- (void)startOperation:(NSOperation *)op;
+@end
 
 @implementation RKMappingOperationQueue
 
+@synthesize workerThreadCount = _workerThreadCount;
+
 - (id)init {
     self = [super init];
     if (self) {
         _operations = [NSMutableArray new];
+        _operationsByKey = [NSMutableDictionary new];
+        _threadSafeOperations = [NSMutableSet new];
+        _dispatchedOperations = [NSMutableSet new];
+        _executionTimes = [NSMutableDictionary new];
+        _workerThreadCount = 0;
     }
     
     return self;
@@ -21,6 +40,11 @@
 
 - (void)dealloc {
     [_operations release];
+    [_operationsByKey release];
+    [_threadSafeOperations release];
+    [_dispatchedOperations release];
+    [_executionTimes release];
+    [_workerQueue release];
     [super dealloc];
 }
 
@@ -33,6 +57,24 @@
     [_operations addObject:blockOperation];
 }
 
+- (void)addThreadSafeOperation:(NSOperation *)op {
+    [_operations addObject:op];
+    [_threadSafeOperations addObject:op];
+}
+
+- (void)addThreadSafeOperationWithBlock:(void (^)(void))block {
+    [self addThreadSafeOperation:[NSBlockOperation blockOperationWithBlock:block]];
+}
+
+- (void)addOperation:(NSOperation *)op forKey:(id<NSCopying>)key {
+    [_operations addObject:op];
+    [_operationsByKey setObject:op forKey:key];
+}
+
+- (NSOperation *)operationForKey:(id)key {
+    return [_operationsByKey objectForKey:key];
+}
+
 - (NSArray *)operations {
     return [NSArray arrayWithArray:_operations];
 }
@@ -41,9 +83,100 @@
     return [_operations count];
 }
 
+- (NSTimeInterval)executionTimeForOperation:(NSOperation *)op {
+    @synchronized(_executionTimes) {
+        return [[_executionTimes objectForKey:[NSValue valueWithNonretainedObject:op]] doubleValue];
+    }
+}
+
+#pragma mark - Execution
+
+// Starts the operation on the current thread, recording how long it takes
+- (void)performOperation:(NSOperation *)op {
+    NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+    [op start];
+    NSTimeInterval executionTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
+    RKLogTrace(@"Operation %@ executed in %.4f seconds", op, executionTime);
+    @synchronized(_executionTimes) {
+        [_executionTimes setObject:[NSNumber numberWithDouble:executionTime] forKey:[NSValue valueWithNonretainedObject:op]];
+    }
+}
+
+// Hands a thread-safe operation to the workers. The worker does not start it until everything
+// it depends on has finished, wherever that work executes
+- (void)dispatchOperation:(NSOperation *)op {
+    if ([_dispatchedOperations containsObject:op]) {
+        return;
+    }
+    
+    if (nil == _workerQueue) {
+        _workerQueue = [NSOperationQueue new];
+    }
+    [_workerQueue setMaxConcurrentOperationCount:_workerThreadCount];
+    
+    NSBlockOperation *workerOperation = [NSBlockOperation blockOperationWithBlock:^{
+        [self performOperation:op];
+    }];
+    for (NSOperation *dependency in [op dependencies]) {
+        [workerOperation addDependency:dependency];
+    }
+    [_dispatchedOperations addObject:op];
+    [_workerQueue addOperation:workerOperation];
+}
+
+// Sees to it that every dependency of the operation gets to execute: thread-safe ones are handed to
+// the workers and the rest are started on the current thread. Dependencies that were never added to
+// the queue are started here as well, as nothing else would start them and waiting on them would hang
+- (void)resolveDependenciesOfOperation:(NSOperation *)op {
+    for (NSOperation *dependency in [op dependencies]) {
+        if ([dependency isFinished] || [dependency isExecuting] || [_dispatchedOperations containsObject:dependency]) {
+            continue;
+        }
+        
+        if (_workerThreadCount > 0 && [_threadSafeOperations containsObject:dependency]) {
+            [self resolveDependenciesOfOperation:dependency];
+            [self dispatchOperation:dependency];
+        } else {
+            [self startOperation:dependency];
+        }
+    }
+}
+
+// Starts the operation on the current thread once its dependencies have finished
+- (void)startOperation:(NSOperation *)op {
+    if ([op isFinished] || [op isExecuting]) {
+        return;
+    }
+    
+    [self resolveDependenciesOfOperation:op];
+    for (NSOperation *dependency in [op dependencies]) {
+        [dependency waitUntilFinished];
+    }
+    
+    [self performOperation:op];
+}
+
 - (void)waitUntilAllOperationsAreFinished {
-    for (NSOperation *operation in _operations) {
-        [operation start];
+    // Work enqueued from here on starts a new batch rather than joining one that has run
+    [_operationsByKey removeAllObjects];
+    
+    NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+    // Operations may enqueue further work as they execute, so the count is checked on each pass
+    for (NSUInteger index = 0; index < [_operations count]; index++) {
+        NSOperation *operation = [_operations objectAtIndex:index];
+        if (_workerThreadCount > 0 && [_threadSafeOperations containsObject:operation]) {
+            [self resolveDependenciesOfOperation:operation];
+            [self dispatchOperation:operation];
+        } else {
+            [self startOperation:operation];
+        }
+    }
+    [_workerQueue waitUntilAllOperationsAreFinished];
+    
+    if ([_operations count] > 0) {
+        RKLogDebug(@"Executed %lu mapping operations (%lu on worker threads) in %.4f seconds",
+                   (unsigned long) [_operations count], (unsigned long) [_dispatchedOperations count],
+                   [NSDate timeIntervalSinceReferenceDate] - startTime);
     }
 }
 
@@ -0,0 +1,82 @@
+//
+//  RKMappingThreadPool.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A bounded pool of long-lived threads on which object loaders perform their mapping.
+
+ Work is handed to the pool as a selector and target and executed on the first idle
+ thread. Threads are created lazily up to maximumThreadCount and then live as long as the
+ pool, so thread local state such as the managed object context and primary key cache of
+ RKManagedObjectStore survives from one load to the next. When every thread is busy work
+ waits in FIFO order, bounding the amount of concurrent mapping under bursts of responses.
+
+ @see [RKObjectManager mappingThreadCount]
+ */
+@interface RKMappingThreadPool : NSObject {
+    NSUInteger _maximumThreadCount;
+    NSUInteger _threadCount;
+    NSUInteger _idleThreadCount;
+    NSMutableArray *_pendingInvocations;
+    NSCondition *_condition;
+    BOOL _shutdown;
+}
+
+/**
+ The maximum number of threads the pool will run. Lowering the value retires
+ surplus threads once they finish their current work.
+
+ **Default**: 2
+ */
+@property (nonatomic, assign) NSUInteger maximumThreadCount;
+
+/**
+ The number of threads currently running in the pool
+ */
+@property (nonatomic, readonly) NSUInteger threadCount;
+
+/**
+ The number of invocations waiting for a thread
+ */
+@property (nonatomic, readonly) NSUInteger pendingCount;
+
+/**
+ Returns YES when invoked from one of the threads of any mapping thread pool
+ */
++ (BOOL)isMappingThread;
+
+/**
+ Initializes a pool that runs at most the given number of threads
+ */
+- (id)initWithMaximumThreadCount:(NSUInteger)maximumThreadCount;
+
+/**
+ Sends the selector to the target with the object on the next available pool thread.
+ The target and object are retained until the invocation has completed.
+ */
+- (void)performSelector:(SEL)selector onTarget:(id)target withObject:(id)object;
+
+/**
+ Lets the threads exit once all pending work has been performed. Work submitted
+ after shutdown is performed on a new detached thread.
+ */
+- (void)shutdown;
+
+@end
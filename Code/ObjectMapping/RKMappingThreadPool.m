@@ -0,0 +1,170 @@
+//
+//  RKMappingThreadPool.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKMappingThreadPool.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitObjectMapping
+
+static NSString* const RKMappingThreadPoolThreadDictionaryKey = @"RKMappingThreadPoolThreadDictionaryKey";
+static const NSUInteger RKMappingThreadPoolDefaultMaximumThreadCount = 2;
+
+@interface RKMappingThreadPool (Private)
+- (void)spawnThread;
+- (void)threadMain;
+@end
+
+@implementation RKMappingThreadPool
+
+@synthesize maximumThreadCount = _maximumThreadCount;
+@synthesize threadCount = _threadCount;
+
++ (BOOL)isMappingThread {
+    return [[[NSThread currentThread] threadDictionary] objectForKey:RKMappingThreadPoolThreadDictionaryKey] != nil;
+}
+
+- (id)init {
+    return [self initWithMaximumThreadCount:RKMappingThreadPoolDefaultMaximumThreadCount];
+}
+
+- (id)initWithMaximumThreadCount:(NSUInteger)maximumThreadCount {
+    self = [super init];
+    if (self) {
+        _maximumThreadCount = MAX(1, maximumThreadCount);
+        _pendingInvocations = [NSMutableArray new];
+        _condition = [NSCondition new];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    // Running threads retain the pool, so there is nothing left to wind down here
+    [_pendingInvocations release];
+    _pendingInvocations = nil;
+    [_condition release];
+    _condition = nil;
+
+    [super dealloc];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat:@"<%@: %p threadCount=%lu/%lu pendingCount=%lu>",
+            NSStringFromClass([self class]), self, (unsigned long) self.threadCount,
+            (unsigned long) self.maximumThreadCount, (unsigned long) self.pendingCount];
+}
+
+- (NSUInteger)pendingCount {
+    [_condition lock];
+    NSUInteger pendingCount = [_pendingInvocations count];
+    [_condition unlock];
+
+    return pendingCount;
+}
+
+- (void)setMaximumThreadCount:(NSUInteger)maximumThreadCount {
+    [_condition lock];
+    _maximumThreadCount = MAX(1, maximumThreadCount);
+    while ([_pendingInvocations count] > _idleThreadCount && _threadCount < _maximumThreadCount) {
+        [self spawnThread];
+    }
+    // Wake idle threads so that any surplus can retire
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+- (void)performSelector:(SEL)selector onTarget:(id)target withObject:(id)object {
+    NSMethodSignature* signature = [target methodSignatureForSelector:selector];
+    NSAssert2(signature, @"%@ does not respond to %@", target, NSStringFromSelector(selector));
+    NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:signature];
+    [invocation setTarget:target];
+    [invocation setSelector:selector];
+    if ([signature numberOfArguments] > 2) {
+        [invocation setArgument:&object atIndex:2];
+    }
+    [invocation retainArguments];
+
+    [_condition lock];
+    if (_shutdown) {
+        [_condition unlock];
+        RKLogWarning(@"Mapping thread pool %@ has been shut down. Performing %@ on a detached thread", self, NSStringFromSelector(selector));
+        [NSThread detachNewThreadSelector:@selector(invoke) toTarget:invocation withObject:nil];
+        return;
+    }
+
+    [_pendingInvocations addObject:invocation];
+    if (_idleThreadCount < [_pendingInvocations count] && _threadCount < _maximumThreadCount) {
+        [self spawnThread];
+    }
+    [_condition signal];
+    [_condition unlock];
+}
+
+- (void)shutdown {
+    [_condition lock];
+    _shutdown = YES;
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+// Invoked with the condition locked
+- (void)spawnThread {
+    _threadCount++;
+    NSThread* thread = [[NSThread alloc] initWithTarget:self selector:@selector(threadMain) object:nil];
+    [thread setName:[NSString stringWithFormat:@"org.restkit.mapping.%lu", (unsigned long) _threadCount]];
+    [thread start];
+    [thread release];
+    RKLogDebug(@"Spawned mapping thread %lu of %lu for pool %@", (unsigned long) _threadCount, (unsigned long) _maximumThreadCount, self);
+}
+
+- (void)threadMain {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    [[[NSThread currentThread] threadDictionary] setObject:[NSValue valueWithNonretainedObject:self] forKey:RKMappingThreadPoolThreadDictionaryKey];
+    [pool drain];
+
+    while (YES) {
+        [_condition lock];
+        _idleThreadCount++;
+        while ([_pendingInvocations count] == 0 && !_shutdown && _threadCount <= _maximumThreadCount) {
+            [_condition wait];
+        }
+        _idleThreadCount--;
+
+        BOOL retire = (_threadCount > _maximumThreadCount) || (_shutdown && [_pendingInvocations count] == 0);
+        if (retire) {
+            _threadCount--;
+            [_condition unlock];
+            RKLogDebug(@"Retiring mapping thread %@ from pool %@", [NSThread currentThread], self);
+            break;
+        }
+
+        NSInvocation* invocation = [[_pendingInvocations objectAtIndex:0] retain];
+        [_pendingInvocations removeObjectAtIndex:0];
+        [_condition unlock];
+
+        pool = [[NSAutoreleasePool alloc] init];
+        [invocation invoke];
+        [invocation release];
+        [pool drain];
+    }
+}
+
+@end
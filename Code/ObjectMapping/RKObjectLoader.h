@@ -117,6 +117,7 @@
     NSString* _serializationMIMEType;
     NSObject* _sourceObject;
 	NSObject* _targetObject;
+    NSString* _responseBodyDigest;
 }
 
 /**
@@ -24,11 +24,14 @@
 #import "RKObjectMapperError.h"
 #import "Errors.h"
 #import "RKNotifications.h"
+#import "RKRequestMetrics.h"
 #import "RKParser.h"
 #import "RKObjectLoader_Internals.h"
 #import "RKParserRegistry.h"
 #import "RKRequest_Internals.h"
 #import "RKObjectSerializer.h"
+#import "RKMainThreadInvocationQueue.h"
+#import "NSData+MD5.h"
 
 // Set Logging Component
 #undef RKLogComponent
@@ -74,6 +77,8 @@
 	_objectMapping = nil;
     [_result release];
     _result = nil;
+    [_responseBodyDigest release];
+    _responseBodyDigest = nil;
     [_serializationMIMEType release];
     [_serializationMapping release];
     
@@ -86,6 +91,8 @@
     _response = nil;
     [_result release];
     _result = nil;
+    [_responseBodyDigest release];
+    _responseBodyDigest = nil;
 }
 
 #pragma mark - Response Processing
@@ -93,7 +100,20 @@
 // NOTE: This method is significant because the notifications posted are used by
 // RKRequestQueue to remove requests from the queue. All requests need to be finalized.
 - (void)finalizeLoad:(BOOL)successful error:(NSError*)error {
-	_isLoading = NO;
+    // Finalize on the main thread behind any delegate callbacks this loader has already
+    // handed off, without blocking the mapping thread while the main thread catches up
+    if (![NSThread isMainThread] && !_sentSynchronously) {
+        NSMethodSignature* signature = [self methodSignatureForSelector:@selector(finalizeLoad:error:)];
+        NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:signature];
+        [invocation setTarget:self];
+        [invocation setSelector:@selector(finalizeLoad:error:)];
+        [invocation setArgument:&successful atIndex:2];
+        [invocation setArgument:&error atIndex:3];
+        [[RKMainThreadInvocationQueue sharedQueue] enqueueInvocation:invocation];
+        return;
+    }
+    
+	[self setLoading:NO];
     
 	if (successful) {
 		_isLoaded = YES;
@@ -102,11 +122,17 @@
                                                                                withObject:self waitUntilDone:YES];            
         }
         
-		NSDictionary* userInfo = [NSDictionary dictionaryWithObject:_response 
-                                                             forKey:RKRequestDidLoadResponseNotificationUserInfoResponseKey];
+		NSDictionary* userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+                                  _response, RKRequestDidLoadResponseNotificationUserInfoResponseKey,
+                                  self.metrics, RKRequestDidLoadResponseNotificationUserInfoMetricsKey,
+                                  nil];
+        // The queue lets go of the loader when it receives the notification
+        RKRequestQueue* queue = [[self.queue retain] autorelease];
         [[NSNotificationCenter defaultCenter] postNotificationName:RKRequestDidLoadResponseNotification 
                                                             object:self 
                                                           userInfo:userInfo];
+        
+        [self revalidateCachedResponseIfNecessaryOnQueue:queue];
 	} else {
         NSDictionary* userInfo = [NSDictionary dictionaryWithObject:(error ? error : (NSError*)[NSNull null])
                                                              forKey:RKRequestDidFailWithErrorNotificationUserInfoErrorKey];
@@ -147,7 +173,72 @@
  */
 - (void)processMappingResult:(RKObjectMappingResult*)result {
     NSAssert(_sentSynchronously || ![NSThread isMainThread], @"Mapping result processing should occur on a background thread");
-    [self performSelectorOnMainThread:@selector(informDelegateOfObjectLoadWithResultDictionary:) withObject:[result asDictionary] waitUntilDone:YES];
+    [self rememberResultDictionary:[result asDictionary]];
+    if (_sentSynchronously) {
+        [self performSelectorOnMainThread:@selector(informDelegateOfObjectLoadWithResultDictionary:) withObject:[result asDictionary] waitUntilDone:YES];
+    } else {
+        [[RKMainThreadInvocationQueue sharedQueue] performSelector:@selector(informDelegateOfObjectLoadWithResultDictionary:) 
+                                                          onTarget:self withObject:[result asDictionary]];
+    }
+}
+
+#pragma mark - Unchanged Content
+
+// Only successful GETs to resource paths that have opted in are remembered, see RKObjectMappingResultCache.
+// Mapping onto a target object, or data rewritten by the delegate, yields a result the body alone does not determine
+- (BOOL)canSkipMappingOfUnchangedContent {
+    if (self.targetObject || [self.delegate respondsToSelector:@selector(objectLoader:willMapData:)]) {
+        return NO;
+    }
+    
+    return [self isGET] && [self.response isSuccessful] && [self.objectManager.mappingResultCache containsResourcePath:self.resourcePath];
+}
+
+- (NSString*)responseBodyDigest {
+    if (nil == _responseBodyDigest) {
+        _responseBodyDigest = [[[self.response body] MD5] retain];
+    }
+    
+    return _responseBodyDigest;
+}
+
+- (void)rememberResultDictionary:(NSDictionary*)dictionary {
+    if ([self canSkipMappingOfUnchangedContent]) {
+        [self.objectManager.mappingResultCache setResultDictionary:dictionary
+                                                        bodyDigest:[self responseBodyDigest]
+                                                     objectMapping:self.objectMapping
+                                                   forResourcePath:self.resourcePath];
+    }
+}
+
+/**
+ Overloaded by RKManagedObjectLoader to turn remembered object IDs back into managed objects.
+ Returns NO when the remembered result can no longer be delivered and the body must be mapped.
+ 
+ @protected
+ */
+- (BOOL)processUnchangedResultDictionary:(NSDictionary*)dictionary {
+    [_result release];
+    _result = [[RKObjectMappingResult mappingResultWithDictionary:dictionary] retain];
+    [self processMappingResult:_result];
+    return YES;
+}
+
+// Delivers the result remembered for the resource path when the body is the one it was mapped from
+- (BOOL)processUnchangedContent {
+    if (! [self canSkipMappingOfUnchangedContent]) {
+        return NO;
+    }
+    
+    NSDictionary* dictionary = [self.objectManager.mappingResultCache resultDictionaryForResourcePath:self.resourcePath
+                                                                                           bodyDigest:[self responseBodyDigest]
+                                                                                        objectMapping:self.objectMapping];
+    if (nil == dictionary) {
+        return NO;
+    }
+    
+    RKLogDebug(@"Content at resource path '%@' is unchanged, delivering the previous mapping result", self.resourcePath);
+    return [self processUnchangedResultDictionary:dictionary];
 }
 
 #pragma mark - Response Object Mapping
@@ -156,20 +247,31 @@
     id<RKParser> parser = [[RKParserRegistry sharedRegistry] parserForMIMEType:self.response.MIMEType];
     NSAssert1(parser, @"Cannot perform object load without a parser for MIME Type '%@'", self.response.MIMEType);
     
-    // Check that there is actually content in the response body for mapping. It is possible to get back a 200 response
-    // with the appropriate MIME Type with no content (such as for a successful PUT or DELETE). Make sure we don't generate an error
-    // in these cases
-    id bodyAsString = [self.response bodyAsString];
-    if (bodyAsString == nil || [[bodyAsString stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] length] == 0) {
-        RKLogDebug(@"Mapping attempted on empty response body...");
-        if (self.targetObject) {
-            return [RKObjectMappingResult mappingResultWithDictionary:[NSDictionary dictionaryWithObject:self.targetObject forKey:@""]];
+    // Responses loaded from the cache may have been parsed before, in which case the body is not decoded again
+    self.metrics.parseStartTime = [NSDate timeIntervalSinceReferenceDate];
+    id parsedData = [self.response wasLoadedFromCache] ? [self.cache parsedObjectForRequest:self] : nil;
+    if (nil == parsedData) {
+        // Check that there is actually content in the response body for mapping. It is possible to get back a 200 response
+        // with the appropriate MIME Type with no content (such as for a successful PUT or DELETE). Make sure we don't generate an error
+        // in these cases
+        id bodyAsString = ([[self.response body] length] > 0) ? [self.response bodyAsString] : nil;
+        if (bodyAsString == nil || [[bodyAsString stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] length] == 0) {
+            RKLogDebug(@"Mapping attempted on empty response body...");
+            self.metrics.parseEndTime = [NSDate timeIntervalSinceReferenceDate];
+            if (self.targetObject) {
+                return [RKObjectMappingResult mappingResultWithDictionary:[NSDictionary dictionaryWithObject:self.targetObject forKey:@""]];
+            }
+            
+            return [RKObjectMappingResult mappingResultWithDictionary:[NSDictionary dictionary]];
         }
         
-        return [RKObjectMappingResult mappingResultWithDictionary:[NSDictionary dictionary]];
+        parsedData = [parser objectFromString:bodyAsString error:error];
+        // Only bodies that are, or are about to be, in the cache can be stored against its entry
+        if (parsedData && ([self.response wasLoadedFromCache] || ([self.response isSuccessful] && _cachePolicy != RKRequestCachePolicyNone))) {
+            [self.cache storeParsedObject:parsedData forRequest:self];
+        }
     }
-    
-    id parsedData = [parser objectFromString:bodyAsString error:error];
+    self.metrics.parseEndTime = [NSDate timeIntervalSinceReferenceDate];
     if (parsedData == nil && error) {
         return nil;
     }
@@ -183,7 +285,10 @@
     RKObjectMapper* mapper = [RKObjectMapper mapperWithObject:parsedData mappingProvider:mappingProvider];
     mapper.targetObject = targetObject;
     mapper.delegate = self;
+    mapper.workerThreadCount = self.objectManager.mappingWorkerThreadCount;
+    self.metrics.mappingStartTime = [NSDate timeIntervalSinceReferenceDate];
     RKObjectMappingResult* result = [mapper performMapping];
+    self.metrics.mappingEndTime = [NSDate timeIntervalSinceReferenceDate];
     
     // Log any mapping errors
     if (mapper.errorCount > 0) {
@@ -221,7 +326,7 @@
 - (void)performMappingOnBackgroundThread {
 	NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
     
-	if (self.delegate)
+	if (self.delegate && ! [self processUnchangedContent])
 	{
 		NSError* error = nil;
 		_result = [[self performMapping:&error] retain];
@@ -330,12 +435,16 @@
 }
 
 - (void)didFailLoadWithError:(NSError*)error {
+    if ([self finishRevalidationWithError:error]) {
+        return;
+    }
+    
     NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
     
 	if (_cachePolicy & RKRequestCachePolicyLoadOnError &&
 		[self.cache hasResponseForRequest:self]) {
 
-		[self didFinishLoad:[self.cache responseForRequest:self]];
+		[self didFinishLoad:[self loadResponseFromCache]];
 	} else {
         if ([_delegate respondsToSelector:@selector(request:didFailLoadWithError:)]) {
             [_delegate request:self didFailLoadWithError:error];
@@ -352,12 +461,22 @@
 // NOTE: We do NOT call super here. We are overloading the default behavior from RKRequest
 - (void)didFinishLoad:(RKResponse*)response {
     NSAssert([NSThread isMainThread], @"RKObjectLoaderDelegate callbacks must occur on the main thread");
+    if ([self finishRevalidationWithResponse:response]) {
+        return;
+    }
+    
+    // A revalidated response that has changed replaces the cached response and its mapping result
+    [_response release];
 	_response = [response retain];
+    [_result release];
+    _result = nil;
+    [_responseBodyDigest release];
+    _responseBodyDigest = nil;
 
 	if ((_cachePolicy & RKRequestCachePolicyEtag) && [response isNotModified]) {
 		[_response release];
 		_response = nil;
-		_response = [[self.cache responseForRequest:self] retain];
+		_response = [[self loadResponseFromCache] retain];
         [self updateInternalCacheDate];
 	}
 
@@ -372,6 +491,10 @@
 	if ([self isResponseMappable]) {
         // Determine if we are synchronous here or not.
         if (_sentSynchronously) {
+            if ([self processUnchangedContent]) {
+                return;
+            }
+            
             NSError* error = nil;
             _result = [[self performMapping:&error] retain];
             if (self.result) {
@@ -379,6 +502,8 @@
             } else {
                 [self performSelectorInBackground:@selector(didFailLoadWithError:) withObject:error];
             }
+        } else if (self.objectManager.mappingThreadPool) {
+            [self.objectManager.mappingThreadPool performSelector:@selector(performMappingOnBackgroundThread) onTarget:self withObject:nil];
         } else {
             [self performSelectorInBackground:@selector(performMappingOnBackgroundThread) withObject:nil];
         }
@@ -27,5 +27,8 @@
 - (void)handleTargetObject;
 - (void)informDelegateOfObjectLoadWithInfoDictionary:(NSDictionary*)dictionary;
 - (void)performMappingOnBackgroundThread;
+- (BOOL)canSkipMappingOfUnchangedContent;
+- (void)rememberResultDictionary:(NSDictionary*)dictionary;
+- (BOOL)processUnchangedResultDictionary:(NSDictionary*)dictionary;
 
 @end
@@ -22,6 +22,8 @@
 #import "RKObjectLoader.h"
 #import "RKObjectRouter.h"
 #import "RKObjectMappingProvider.h"
+#import "RKMappingThreadPool.h"
+#import "RKObjectMappingResultCache.h"
 
 @protocol RKParser;
 
@@ -113,6 +115,9 @@ typedef enum {
     RKObjectMappingProvider* _mappingProvider;
     NSString* _serializationMIMEType;
     BOOL _inferMappingsFromObjectTypes;
+    RKMappingThreadPool* _mappingThreadPool;
+    NSUInteger _mappingWorkerThreadCount;
+    RKObjectMappingResultCache* _mappingResultCache;
 }
 
 /// @name Configuring the Shared Manager Instance
@@ -207,6 +212,43 @@ typedef enum {
  */
 @property (nonatomic, assign) BOOL inferMappingsFromObjectTypes;
 
+/**
+ The pool of long-lived threads on which object loaders created by this manager
+ map their responses.
+ 
+ @see mappingThreadCount
+ */
+@property (nonatomic, readonly) RKMappingThreadPool* mappingThreadPool;
+
+/**
+ The maximum number of responses mapped concurrently. Mapping threads are kept alive
+ between loads so that thread local state (such as the managed object context of the
+ object store) is reused rather than rebuilt for every response.
+ 
+ Default: 2
+ */
+@property (nonatomic, assign) NSUInteger mappingThreadCount;
+
+/**
+ The number of worker threads each response mapping may use to map nested objects of
+ plain (not managed) classes. Nested objects are part of the mapping result as soon as
+ they are found, and their values are filled in by the workers before mapping finishes.
+ Relationships of managed objects are always mapped on the mapping thread.
+ 
+ Default: 0
+ */
+@property (nonatomic, assign) NSUInteger mappingWorkerThreadCount;
+
+/**
+ Remembers the last mapping result of the resource paths that have opted in, so that
+ object loaders receiving unchanged content (a 304 or an identical body) deliver it
+ without parsing, mapping or saving again.
+ 
+ Opt a resource path in with [manager.mappingResultCache addResourcePath:@"/articles"].
+ No resource paths are opted in by default.
+ */
+@property (nonatomic, readonly) RKObjectMappingResultCache* mappingResultCache;
+
 ////////////////////////////////////////////////////////
 /// @name Registered Object Loaders
 
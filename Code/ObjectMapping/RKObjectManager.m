@@ -43,6 +43,9 @@ static RKObjectManager* sharedManager = nil;
 @synthesize mappingProvider = _mappingProvider;
 @synthesize serializationMIMEType = _serializationMIMEType;
 @synthesize inferMappingsFromObjectTypes = _inferMappingsFromObjectTypes;
+@synthesize mappingThreadPool = _mappingThreadPool;
+@synthesize mappingWorkerThreadCount = _mappingWorkerThreadCount;
+@synthesize mappingResultCache = _mappingResultCache;
 
 - (id)initWithBaseURL:(NSString*)baseURL {
     self = [super init];
@@ -52,6 +55,8 @@ static RKObjectManager* sharedManager = nil;
 		_client = [[RKClient clientWithBaseURL:baseURL] retain];
         _onlineState = RKObjectManagerOnlineStateUndetermined;
         _inferMappingsFromObjectTypes = NO;
+        _mappingThreadPool = [RKMappingThreadPool new];
+        _mappingResultCache = [RKObjectMappingResultCache new];
         
         self.acceptMIMEType = RKMIMETypeJSON;
         self.serializationMIMEType = RKMIMETypeFormURLEncoded;
@@ -102,10 +107,23 @@ static RKObjectManager* sharedManager = nil;
     _serializationMIMEType = nil;
     [_mappingProvider release];
     _mappingProvider = nil;
+    [_mappingThreadPool shutdown];
+    [_mappingThreadPool release];
+    _mappingThreadPool = nil;
+    [_mappingResultCache release];
+    _mappingResultCache = nil;
     
 	[super dealloc];
 }
 
+- (NSUInteger)mappingThreadCount {
+    return _mappingThreadPool.maximumThreadCount;
+}
+
+- (void)setMappingThreadCount:(NSUInteger)mappingThreadCount {
+    _mappingThreadPool.maximumThreadCount = mappingThreadCount;
+}
+
 - (BOOL)isOnline {
 	return (_onlineState == RKObjectManagerOnlineStateConnected);
 }
@@ -126,6 +144,32 @@ static RKObjectManager* sharedManager = nil;
 	}
 }
 
+- (void)setObjectStore:(RKManagedObjectStore*)objectStore {
+    if (objectStore == _objectStore) {
+        return;
+    }
+    
+    if (_objectStore) {
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:RKManagedObjectStoreDidDeletePersistentStoreNotification object:_objectStore];
+    }
+    [objectStore retain];
+    [_objectStore release];
+    _objectStore = objectStore;
+    if (_objectStore) {
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(objectStoreDidDeletePersistentStore:)
+                                                     name:RKManagedObjectStoreDidDeletePersistentStoreNotification
+                                                   object:_objectStore];
+    }
+    
+    // Remembered results hold the object IDs of another store
+    [_mappingResultCache invalidateAll];
+}
+
+- (void)objectStoreDidDeletePersistentStore:(NSNotification*)notification {
+    [_mappingResultCache invalidateAll];
+}
+
 - (void)setAcceptMIMEType:(NSString*)MIMEType {
     [_client setValue:MIMEType forHTTPHeaderField:@"Accept"];
 }
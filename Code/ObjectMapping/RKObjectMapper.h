@@ -45,6 +45,9 @@
 - (void)objectMapper:(RKObjectMapper*)objectMapper willMapFromObject:(id)sourceObject toObject:(id)destinationObject atKeyPath:(NSString*)keyPath usingMapping:(id<RKObjectMappingDefinition>)objectMapping;
 - (void)objectMapper:(RKObjectMapper*)objectMapper didMapFromObject:(id)sourceObject toObject:(id)destinationObject atKeyPath:(NSString*)keyPath usingMapping:(id<RKObjectMappingDefinition>)objectMapping;
 - (void)objectMapper:(RKObjectMapper*)objectMapper didFailMappingFromObject:(id)sourceObject toObject:(id)destinationObject withError:(NSError*)error atKeyPath:(NSString*)keyPath usingMapping:(id<RKObjectMappingDefinition>)objectMapping;
+
+// Returns what the result holds for an object mapped from a collection, such as a managed object's ID. Not consulted when mapping onto a target object
+- (id)objectMapper:(RKObjectMapper*)objectMapper resultForMappedObject:(id)mappedObject atKeyPath:(NSString*)keyPath;
 @end
 
 @interface RKObjectMapper : NSObject {
@@ -62,6 +65,9 @@
 @property (nonatomic, assign) id<RKObjectMapperDelegate> delegate;
 @property (nonatomic, readonly) NSArray* errors;
 
+// The number of worker threads mapping nested plain objects while the mapper finishes. Default: 0
+@property (nonatomic, assign) NSUInteger workerThreadCount;
+
 + (id)mapperWithObject:(id)object mappingProvider:(RKObjectMappingProvider*)mappingProvider;
 - (id)initWithObject:(id)object mappingProvider:(RKObjectMappingProvider*)mappingProvider;
 
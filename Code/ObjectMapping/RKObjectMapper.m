@@ -57,6 +57,14 @@
     [super dealloc];
 }
 
+- (NSUInteger)workerThreadCount {
+    return _operationQueue.workerThreadCount;
+}
+
+- (void)setWorkerThreadCount:(NSUInteger)workerThreadCount {
+    _operationQueue.workerThreadCount = workerThreadCount;
+}
+
 #pragma mark - Errors
 
 - (NSUInteger)errorCount {
@@ -180,15 +188,23 @@
     }
     
     for (id mappableObject in objectsToMap) {
+        // Drain as we go so that temporaries do not pile up over large collections
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
         id destinationObject = [self objectWithMapping:mapping andData:mappableObject];
         if (! destinationObject) {            
+            [pool drain];
             continue;
         }
         
         BOOL success = [self mapFromObject:mappableObject toObject:destinationObject atKeyPath:keyPath usingMapping:mapping];
         if (success) {
-            [mappedObjects addObject:destinationObject];
+            id resultObject = destinationObject;
+            if (nil == self.targetObject && [self.delegate respondsToSelector:@selector(objectMapper:resultForMappedObject:atKeyPath:)]) {
+                resultObject = [self.delegate objectMapper:self resultForMappedObject:destinationObject atKeyPath:keyPath];
+            }
+            [mappedObjects addObject:resultObject];
         }
+        [pool drain];
     }
     
     return mappedObjects;
@@ -252,6 +268,76 @@
     return nil;
 }
 
+#pragma mark - Preparing Mappings
+
+// Gathers the mappable data each object mapping will be handed by objectWithMapping:andData:,
+// descending into the relationships of each object so that nested collections are included
+- (void)collectMappableData:(id)mappableValue usingMapping:(id<RKObjectMappingDefinition>)mapping intoMappings:(NSMutableArray*)objectMappings mappableData:(NSMutableArray*)mappableDataArrays {
+    NSArray* objectsToCollect = nil;
+    if (mapping.forceCollectionMapping && [mappableValue isKindOfClass:[NSDictionary class]]) {
+        objectsToCollect = [NSMutableArray arrayWithCapacity:[mappableValue count]];
+        for (id key in mappableValue) {
+            [(NSMutableArray*)objectsToCollect addObject:[NSDictionary dictionaryWithObject:[mappableValue valueForKey:key] forKey:key]];
+        }
+    } else if ([mappableValue isKindOfClass:[NSArray class]]) {
+        objectsToCollect = mappableValue;
+    } else if ([mappableValue isKindOfClass:[NSSet class]]) {
+        objectsToCollect = [mappableValue allObjects];
+    } else {
+        objectsToCollect = [NSArray arrayWithObject:mappableValue];
+    }
+    
+    for (id mappableObject in objectsToCollect) {
+        if (NO == [mappableObject isKindOfClass:[NSDictionary class]]) {
+            continue;
+        }
+        
+        RKObjectMapping* objectMapping = nil;
+        if ([mapping isKindOfClass:[RKDynamicObjectMapping class]]) {
+            objectMapping = [(RKDynamicObjectMapping*)mapping objectMappingForDictionary:mappableObject];
+        } else if ([mapping isKindOfClass:[RKObjectMapping class]]) {
+            objectMapping = (RKObjectMapping*)mapping;
+        }
+        if (! objectMapping) {
+            continue;
+        }
+        
+        NSUInteger index = [objectMappings indexOfObjectIdenticalTo:objectMapping];
+        if (index == NSNotFound) {
+            index = [objectMappings count];
+            [objectMappings addObject:objectMapping];
+            [mappableDataArrays addObject:[NSMutableArray array]];
+        }
+        [[mappableDataArrays objectAtIndex:index] addObject:mappableObject];
+        
+        for (RKObjectRelationshipMapping* relationshipMapping in objectMapping.relationshipMappings) {
+            id nestedValue = [mappableObject valueForKeyPath:relationshipMapping.sourceKeyPath];
+            if (nestedValue && nestedValue != [NSNull null] && ! [self isNullCollection:nestedValue]) {
+                [self collectMappableData:nestedValue usingMapping:relationshipMapping.mapping intoMappings:objectMappings mappableData:mappableDataArrays];
+            }
+        }
+    }
+}
+
+// Walks the whole payload ahead of mapping so that each object mapping can look up
+// the existing objects for all of its data at once. See prepareToMapObjectsForData:
+- (void)prepareMappingsByKeyPath:(NSDictionary*)mappingsByKeyPath {
+    NSMutableArray* objectMappings = [NSMutableArray array];
+    NSMutableArray* mappableDataArrays = [NSMutableArray array];
+    for (NSString* keyPath in mappingsByKeyPath) {
+        id mappableValue = [keyPath isEqualToString:@""] ? self.sourceObject : [self.sourceObject valueForKeyPath:keyPath];
+        if (mappableValue == nil || mappableValue == [NSNull null] || [self isNullCollection:mappableValue]) {
+            continue;
+        }
+        
+        [self collectMappableData:mappableValue usingMapping:[mappingsByKeyPath objectForKey:keyPath] intoMappings:objectMappings mappableData:mappableDataArrays];
+    }
+    
+    for (NSUInteger i = 0; i < [objectMappings count]; i++) {
+        [[objectMappings objectAtIndex:i] prepareToMapObjectsForData:[mappableDataArrays objectAtIndex:i]];
+    }
+}
+
 // Primary entry point for the mapper. 
 - (RKObjectMappingResult*)performMapping {
     NSAssert(self.sourceObject != nil, @"Cannot perform object mapping without a source object to map from");
@@ -267,6 +353,7 @@
     BOOL foundMappable = NO;
     NSMutableDictionary* results = [NSMutableDictionary dictionary];
     NSDictionary* mappingsByKeyPath = [[self.mappingProvider mappingsByKeyPath] mutableCopy];
+    [self prepareMappingsByKeyPath:mappingsByKeyPath];
     for (NSString* keyPath in mappingsByKeyPath) {
         id mappingResult;
         id mappableValue;
@@ -24,5 +24,7 @@
 - (NSArray*)mapCollection:(NSArray*)mappableObjects atKeyPath:(NSString*)keyPath usingMapping:(id<RKObjectMappingDefinition>)mapping;
 - (BOOL)mapFromObject:(id)mappableObject toObject:(id)destinationObject atKeyPath:keyPath usingMapping:(id<RKObjectMappingDefinition>)mapping;
 - (id)objectWithMapping:(id<RKObjectMappingDefinition>)objectMapping andData:(id)mappableData;
+- (void)collectMappableData:(id)mappableValue usingMapping:(id<RKObjectMappingDefinition>)mapping intoMappings:(NSMutableArray*)objectMappings mappableData:(NSMutableArray*)mappableDataArrays;
+- (void)prepareMappingsByKeyPath:(NSDictionary*)mappingsByKeyPath;
 
 @end
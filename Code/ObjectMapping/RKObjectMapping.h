@@ -480,6 +480,16 @@ relationship. Relationships are processed using an object mapping as well.
  */
 - (id)mappableObjectForData:(id)mappableData;
 
+/**
+ Invoked by RKObjectMapper with all of the mappable data in a payload this mapping is about
+ to be applied to, including data nested under relationships, before any of it is mapped.
+ Mappings that look up existing objects in mappableObjectForData: can use this to resolve
+ them in bulk rather than one object at a time. The default implementation does nothing.
+
+ @see [RKManagedObjectMapping prepareToMapObjectsForData:]
+ */
+- (void)prepareToMapObjectsForData:(NSArray*)mappableDataArray;
+
 /**
  Returns the class of the attribute or relationship property of the target objectClass
  
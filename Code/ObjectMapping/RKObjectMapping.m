@@ -277,6 +277,9 @@ NSString* const RKObjectMappingNestingAttributeKeyName = @"<RK_NESTING_ATTRIBUTE
     return [[self.objectClass new] autorelease];
 }
 
+- (void)prepareToMapObjectsForData:(NSArray*)mappableDataArray {
+}
+
 - (Class)classForProperty:(NSString*)propertyName {
     return [[RKObjectPropertyInspector sharedInspector] typeForProperty:propertyName ofClass:self.objectClass];
 }
@@ -360,6 +360,32 @@ BOOL RKObjectIsValueEqualToValue(id sourceValue, id destinationValue) {
     return ([value isKindOfClass:[NSSet class]] || [value isKindOfClass:[NSArray class]]);
 }
 
+// Mappings of plain objects that only nest other plain objects can be performed on any thread. Anything
+// that may reach a managed object, or whose mapping is only decided by the data, is not
+- (BOOL)isThreadSafeMapping:(RKObjectMapping*)mapping visitedMappings:(NSMutableSet*)visitedMappings {
+    Class managedObjectClass = NSClassFromString(@"NSManagedObject");
+    Class managedObjectMappingClass = NSClassFromString(@"RKManagedObjectMapping");
+    if (! [mapping isKindOfClass:[RKObjectMapping class]] ||
+        (managedObjectMappingClass && [mapping isKindOfClass:managedObjectMappingClass]) ||
+        (managedObjectClass && [mapping.objectClass isSubclassOfClass:managedObjectClass])) {
+        return NO;
+    }
+    
+    NSValue* mappingValue = [NSValue valueWithNonretainedObject:mapping];
+    if ([visitedMappings containsObject:mappingValue]) {
+        return YES;
+    }
+    [visitedMappings addObject:mappingValue];
+    
+    for (RKObjectRelationshipMapping* relationshipMapping in mapping.relationshipMappings) {
+        if (! [self isThreadSafeMapping:(RKObjectMapping*)relationshipMapping.mapping visitedMappings:visitedMappings]) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
 - (BOOL)mapNestedObject:(id)anObject toObject:(id)anotherObject withRealtionshipMapping:(RKObjectRelationshipMapping*)relationshipMapping {
     NSAssert(anObject, @"Cannot map nested object without a nested source object");
     NSAssert(anotherObject, @"Cannot map nested object without a destination object");
@@ -369,6 +395,22 @@ BOOL RKObjectIsValueEqualToValue(id sourceValue, id destinationValue) {
     RKLogTrace(@"Performing nested object mapping using mapping %@ for data: %@", relationshipMapping, anObject);
     RKObjectMappingOperation* subOperation = [RKObjectMappingOperation mappingOperationFromObject:anObject toObject:anotherObject withMapping:relationshipMapping.mapping];
     subOperation.delegate = self.delegate;
+    
+    // Without a delegate to inform, nested plain objects are mapped on the queue's worker threads.
+    // The object itself is already part of the relationship; only its values are filled in later
+    if (self.queue.workerThreadCount > 0 && nil == self.delegate &&
+        [self isThreadSafeMapping:subOperation.objectMapping visitedMappings:[NSMutableSet set]]) {
+        RKLogTrace(@"Deferring mapping of nested object to a worker thread");
+        [self.queue addThreadSafeOperationWithBlock:^{
+            NSError* nestedError = nil;
+            if (NO == [subOperation performMapping:&nestedError]) {
+                RKLogWarning(@"WARNING: Failed mapping nested object: %@", [nestedError localizedDescription]);
+            }
+        }];
+        
+        return YES;
+    }
+    
     subOperation.queue = self.queue;
     if (NO == [subOperation performMapping:&error]) {
         RKLogWarning(@"WARNING: Failed mapping nested object: %@", [error localizedDescription]);
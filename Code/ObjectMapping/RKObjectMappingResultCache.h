@@ -0,0 +1,89 @@
+//
+//  RKObjectMappingResultCache.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RKObjectMapping;
+
+/**
+ Remembers the mapping result of the last response loaded from a resource path, along
+ with a digest of the response body and the object mapping it was mapped with.
+
+ Resource paths must opt in with addResourcePath:. When an object loader for a GET
+ request to one of these paths receives a body identical to the one it last mapped,
+ it delivers the remembered result to its delegate. This covers a 304 (not modified)
+ served from the request cache as well as a polling endpoint returning the same bytes.
+ The body is not parsed or mapped again, and for managed objects nothing is saved. Local
+ changes made to the objects since they were mapped are therefore not overwritten. Loaders
+ with a target object, or whose delegate implements objectLoader:willMapData:, always map.
+
+ Results holding managed objects are remembered as the object IDs of those objects and
+ are turned back into objects on the main thread on delivery. When any of them has been
+ deleted in the meantime the result is forgotten and the body is mapped again. Results of
+ plain objects keep the objects themselves. The result is forgotten when the persistent
+ store of the object manager is deleted.
+
+ All methods are safe to call from any thread.
+
+ @see [RKObjectManager mappingResultCache]
+ */
+@interface RKObjectMappingResultCache : NSObject {
+    NSMutableSet *_resourcePaths;
+    NSMutableDictionary *_entries;
+}
+
+/**
+ Opts the resource path in to skipping the mapping of unchanged content
+ */
+- (void)addResourcePath:(NSString *)resourcePath;
+
+/**
+ Opts the resource path out and forgets the result remembered for it
+ */
+- (void)removeResourcePath:(NSString *)resourcePath;
+
+/**
+ Returns YES when the resource path has opted in
+ */
+- (BOOL)containsResourcePath:(NSString *)resourcePath;
+
+/**
+ Returns the result dictionary remembered for the resource path if it was mapped from a
+ body with the given digest using the given object mapping, otherwise nil. Pass nil as
+ the object mapping for results mapped with the mapping provider.
+ */
+- (NSDictionary *)resultDictionaryForResourcePath:(NSString *)resourcePath bodyDigest:(NSString *)bodyDigest objectMapping:(RKObjectMapping *)objectMapping;
+
+/**
+ Remembers the result dictionary mapped from a body with the given digest using the given
+ object mapping, which may be nil. Does nothing unless the resource path has opted in.
+ */
+- (void)setResultDictionary:(NSDictionary *)resultDictionary bodyDigest:(NSString *)bodyDigest objectMapping:(RKObjectMapping *)objectMapping forResourcePath:(NSString *)resourcePath;
+
+/**
+ Forgets the result remembered for the resource path, so that the next response is mapped
+ */
+- (void)invalidateResourcePath:(NSString *)resourcePath;
+
+/**
+ Forgets every remembered result
+ */
+- (void)invalidateAll;
+
+@end
@@ -0,0 +1,129 @@
+//
+//  RKObjectMappingResultCache.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKObjectMappingResultCache.h"
+#import "RKLog.h"
+
+// Set Logging Component
+#undef RKLogComponent
+#define RKLogComponent lcl_cRestKitObjectMapping
+
+static NSString* const RKObjectMappingResultCacheDigestKey = @"digest";
+static NSString* const RKObjectMappingResultCacheDictionaryKey = @"dictionary";
+static NSString* const RKObjectMappingResultCacheObjectMappingKey = @"objectMapping";
+
+@implementation RKObjectMappingResultCache
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _resourcePaths = [[NSMutableSet alloc] init];
+        _entries = [[NSMutableDictionary alloc] init];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_resourcePaths release];
+    _resourcePaths = nil;
+    [_entries release];
+    _entries = nil;
+
+    [super dealloc];
+}
+
+- (void)addResourcePath:(NSString*)resourcePath {
+    @synchronized(self) {
+        [_resourcePaths addObject:resourcePath];
+    }
+}
+
+- (void)removeResourcePath:(NSString*)resourcePath {
+    @synchronized(self) {
+        [_resourcePaths removeObject:resourcePath];
+        [_entries removeObjectForKey:resourcePath];
+    }
+}
+
+- (BOOL)containsResourcePath:(NSString*)resourcePath {
+    if (nil == resourcePath) {
+        return NO;
+    }
+
+    @synchronized(self) {
+        return [_resourcePaths containsObject:resourcePath];
+    }
+}
+
+- (NSDictionary*)resultDictionaryForResourcePath:(NSString*)resourcePath bodyDigest:(NSString*)bodyDigest objectMapping:(RKObjectMapping*)objectMapping {
+    if (nil == resourcePath || nil == bodyDigest) {
+        return nil;
+    }
+
+    @synchronized(self) {
+        NSDictionary* entry = [_entries objectForKey:resourcePath];
+        if (! [[entry objectForKey:RKObjectMappingResultCacheDigestKey] isEqualToString:bodyDigest]) {
+            return nil;
+        }
+
+        // Results mapped with another object mapping hold other objects, or other attributes of them
+        if ([entry objectForKey:RKObjectMappingResultCacheObjectMappingKey] != objectMapping) {
+            return nil;
+        }
+
+        return [[[entry objectForKey:RKObjectMappingResultCacheDictionaryKey] retain] autorelease];
+    }
+}
+
+- (void)setResultDictionary:(NSDictionary*)resultDictionary bodyDigest:(NSString*)bodyDigest objectMapping:(RKObjectMapping*)objectMapping forResourcePath:(NSString*)resourcePath {
+    if (nil == resultDictionary || nil == bodyDigest || nil == resourcePath) {
+        return;
+    }
+
+    @synchronized(self) {
+        if (! [_resourcePaths containsObject:resourcePath]) {
+            return;
+        }
+
+        // Copy the dictionary: delivering a result mutates the dictionary handed to the delegate
+        NSMutableDictionary* entry = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                                      bodyDigest, RKObjectMappingResultCacheDigestKey,
+                                      [[resultDictionary copy] autorelease], RKObjectMappingResultCacheDictionaryKey, nil];
+        if (objectMapping) {
+            [entry setObject:objectMapping forKey:RKObjectMappingResultCacheObjectMappingKey];
+        }
+        [_entries setObject:entry forKey:resourcePath];
+        RKLogTrace(@"Remembered mapping result for resource path '%@' with body digest %@", resourcePath, bodyDigest);
+    }
+}
+
+- (void)invalidateResourcePath:(NSString*)resourcePath {
+    @synchronized(self) {
+        [_entries removeObjectForKey:resourcePath];
+    }
+}
+
+- (void)invalidateAll {
+    @synchronized(self) {
+        [_entries removeAllObjects];
+    }
+}
+
+@end
@@ -67,7 +67,11 @@ static RKObjectPropertyInspector* sharedInspector = nil;
 }
 
 - (NSDictionary *)propertyNamesAndTypesForClass:(Class)theClass {
-	NSMutableDictionary* propertyNames = [_cachedPropertyNamesAndTypes objectForKey:theClass];
+	// Nested objects may be mapped on several threads at once, see RKMappingOperationQueue
+	NSMutableDictionary* propertyNames = nil;
+	@synchronized(self) {
+		propertyNames = [[[_cachedPropertyNamesAndTypes objectForKey:theClass] retain] autorelease];
+	}
 	if (propertyNames) {
 		return propertyNames;
 	}
@@ -103,7 +107,9 @@ static RKObjectPropertyInspector* sharedInspector = nil;
 		currentClass = [currentClass superclass];
 	}
 	
-	[_cachedPropertyNamesAndTypes setObject:propertyNames forKey:theClass];
+	@synchronized(self) {
+		[_cachedPropertyNamesAndTypes setObject:propertyNames forKey:theClass];
+	}
     RKLogDebug(@"Cached property names and types for Class '%@': %@", NSStringFromClass(theClass), propertyNames);
 	return propertyNames;
 }
@@ -0,0 +1,73 @@
+//
+//  RKMainThreadInvocationQueue.h
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Delivers invocations to the main thread without blocking the caller.
+
+ Background threads enqueue invocations and carry on immediately. Pending invocations are
+ performed in the order they were enqueued, a small batch per turn of the main run loop, so
+ a burst of callbacks costs a single main thread hop and cannot starve the user interface.
+ Because delivery is FIFO across all callers, callbacks issued by one object in sequence
+ (such as an object loader's delegate messages) are always performed in that sequence.
+
+ Invocations enqueued from the main thread first flush everything that is pending and are
+ then performed immediately, preserving both ordering and synchronous semantics there.
+ */
+@interface RKMainThreadInvocationQueue : NSObject {
+    NSMutableArray *_pendingInvocations;
+    NSUInteger _maximumBatchSize;
+    BOOL _drainScheduled;
+}
+
+/**
+ The maximum number of invocations performed per turn of the main run loop
+
+ **Default**: 16
+ */
+@property (nonatomic, assign) NSUInteger maximumBatchSize;
+
+/**
+ The number of invocations waiting to be performed
+ */
+@property (nonatomic, readonly) NSUInteger pendingCount;
+
+/**
+ Returns the shared queue
+ */
++ (RKMainThreadInvocationQueue *)sharedQueue;
+
+/**
+ Enqueues an invocation to be performed on the main thread. The invocation's
+ arguments are retained until it has been performed.
+ */
+- (void)enqueueInvocation:(NSInvocation *)invocation;
+
+/**
+ Enqueues a message to the target with a single object argument
+ */
+- (void)performSelector:(SEL)selector onTarget:(id)target withObject:(id)object;
+
+/**
+ Performs every pending invocation. Must be called on the main thread.
+ */
+- (void)flush;
+
+@end
@@ -0,0 +1,139 @@
+//
+//  RKMainThreadInvocationQueue.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKMainThreadInvocationQueue.h"
+
+static RKMainThreadInvocationQueue* sharedQueue = nil;
+static const NSUInteger RKMainThreadInvocationQueueDefaultBatchSize = 16;
+
+@interface RKMainThreadInvocationQueue (Private)
+- (void)drain;
+- (void)performInvocationsWithLimit:(NSUInteger)limit;
+@end
+
+@implementation RKMainThreadInvocationQueue
+
+@synthesize maximumBatchSize = _maximumBatchSize;
+
++ (RKMainThreadInvocationQueue*)sharedQueue {
+    @synchronized(self) {
+        if (nil == sharedQueue) {
+            sharedQueue = [RKMainThreadInvocationQueue new];
+        }
+    }
+
+    return sharedQueue;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _pendingInvocations = [NSMutableArray new];
+        _maximumBatchSize = RKMainThreadInvocationQueueDefaultBatchSize;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_pendingInvocations release];
+    _pendingInvocations = nil;
+
+    [super dealloc];
+}
+
+- (NSUInteger)pendingCount {
+    @synchronized(self) {
+        return [_pendingInvocations count];
+    }
+}
+
+- (void)enqueueInvocation:(NSInvocation*)invocation {
+    [invocation retainArguments];
+
+    if ([NSThread isMainThread]) {
+        [self flush];
+        [invocation invoke];
+        return;
+    }
+
+    @synchronized(self) {
+        [_pendingInvocations addObject:invocation];
+        if (_drainScheduled) {
+            return;
+        }
+        _drainScheduled = YES;
+    }
+
+    [self performSelectorOnMainThread:@selector(drain) withObject:nil waitUntilDone:NO];
+}
+
+- (void)performSelector:(SEL)selector onTarget:(id)target withObject:(id)object {
+    NSMethodSignature* signature = [target methodSignatureForSelector:selector];
+    NSAssert2(signature, @"%@ does not respond to %@", target, NSStringFromSelector(selector));
+    NSInvocation* invocation = [NSInvocation invocationWithMethodSignature:signature];
+    [invocation setTarget:target];
+    [invocation setSelector:selector];
+    if ([signature numberOfArguments] > 2) {
+        [invocation setArgument:&object atIndex:2];
+    }
+
+    [self enqueueInvocation:invocation];
+}
+
+- (void)flush {
+    NSAssert([NSThread isMainThread], @"RKMainThreadInvocationQueue can only be flushed on the main thread");
+    [self performInvocationsWithLimit:NSUIntegerMax];
+}
+
+- (void)performInvocationsWithLimit:(NSUInteger)limit {
+    NSUInteger performed = 0;
+    while (performed < limit) {
+        NSInvocation* invocation = nil;
+        @synchronized(self) {
+            if ([_pendingInvocations count] == 0) {
+                break;
+            }
+            invocation = [[_pendingInvocations objectAtIndex:0] retain];
+            [_pendingInvocations removeObjectAtIndex:0];
+        }
+
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        [invocation invoke];
+        [invocation release];
+        [pool drain];
+        performed++;
+    }
+}
+
+- (void)drain {
+    [self performInvocationsWithLimit:MAX(1, _maximumBatchSize)];
+
+    // Leave the rest for the next turn of the run loop
+    BOOL reschedule = NO;
+    @synchronized(self) {
+        reschedule = ([_pendingInvocations count] > 0);
+        _drainScheduled = reschedule;
+    }
+    if (reschedule) {
+        [self performSelectorOnMainThread:@selector(drain) withObject:nil waitUntilDone:NO];
+    }
+}
+
+@end
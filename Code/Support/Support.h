@@ -26,3 +26,4 @@
 #import "RKPathMatcher.h"
 #import "RKDotNetDateFormatter.h"
 #import "RKDirectory.h"
+#import "RKMainThreadInvocationQueue.h"
@@ -107,6 +107,28 @@
     assertThat(human.favoriteCat.name, is(equalTo(@"Asia")));
 }
 
+- (void)testShouldDeliverPrefetchedRelationshipsAsMaterializedObjects {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    RKSpecStubNetworkAvailability(YES);
+    objectManager.objectStore = store;
+    
+    RKObjectMapping* humanMapping = [RKManagedObjectMapping mappingForClass:[RKHuman class]];
+    [humanMapping mapAttributes:@"name", nil];
+    RKObjectMapping* catMapping = [RKManagedObjectMapping mappingForClass:[RKCat class]];
+    [catMapping mapAttributes:@"name", nil];
+    [humanMapping mapKeyPath:@"favorite_cat" toRelationship:@"favoriteCat" withMapping:catMapping];
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKManagedObjectLoader* objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/with_to_one_relationship.json" objectManager:objectManager delegate:responseLoader];
+    objectLoader.relationshipKeyPathsForPrefetching = [NSArray arrayWithObject:@"favoriteCat"];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    RKHuman* human = [responseLoader.objects lastObject];
+    assertThat(human.favoriteCat, isNot(nilValue()));
+    assertThatBool([human.favoriteCat isFault], is(equalToBool(NO)));
+}
+
 - (void)testShouldDeleteObjectsMissingFromPayloadReturnedByObjectCache {
     RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
     RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForEntityWithName:@"RKHuman"];
@@ -235,4 +257,148 @@
 }
 
 
+- (void)testShouldReportTheCountsOfDeletedAndSparedOrphansToTheStoreDelegate {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForEntityWithName:@"RKHuman"];
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapAttributes:@"name", nil];
+    humanMapping.primaryKeyAttribute = @"railsID";
+    
+    [RKHuman truncateAll];
+    RKHuman* blake = [RKHuman createEntity];
+    blake.railsID = [NSNumber numberWithInt:123];
+    RKHuman* deleteOdd = [RKHuman createEntity];
+    deleteOdd.railsID = [NSNumber numberWithInt:9999];
+    RKHuman* spareEven = [RKHuman createEntity];
+    spareEven.railsID = [NSNumber numberWithInt:1000];
+    [store save];
+    
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    RKSpecStubNetworkAvailability(YES);
+    objectManager.objectStore = store;
+    objectManager.objectStore.managedObjectCache = [[[TestCacheRemoveOddOrphans alloc] init] autorelease];
+    id mockDelegate = [OCMockObject niceMockForProtocol:@protocol(RKManagedObjectStoreDelegate)];
+    [[mockDelegate expect] managedObjectStore:store didDeleteOrphanedObjectCount:1 sparedObjectCount:1 forResourcePath:@"/JSON/humans/all.json"];
+    store.delegate = mockDelegate;
+    
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKManagedObjectLoader* objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    store.delegate = nil;
+    
+    [mockDelegate verify];
+    assertThatBool([blake isDeleted], is(equalToBool(NO)));
+    assertThatBool([deleteOdd isDeleted], is(equalToBool(YES)));
+    assertThatBool([spareEven isDeleted], is(equalToBool(NO)));
+}
+
+- (void)testShouldSaveMappedObjectsInBatches {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForEntityWithName:@"RKHuman"];
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapAttributes:@"name", nil];
+    humanMapping.primaryKeyAttribute = @"railsID";
+    [RKHuman truncateAll];
+    [store save];
+    
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    RKSpecStubNetworkAvailability(YES);
+    objectManager.objectStore = store;
+    
+    __block NSUInteger saveCount = 0;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:NSManagedObjectContextDidSaveNotification object:nil queue:nil usingBlock:^(NSNotification* notification) {
+        @synchronized(store) {
+            saveCount++;
+        }
+    }];
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKManagedObjectLoader* objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    objectLoader.saveBatchSize = 1;
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    
+    // One save per human. Nothing is left for the final save to write
+    assertThatUnsignedInteger(saveCount, is(equalToInt(2)));
+    assertThat(responseLoader.objects, hasCountOf(2));
+    assertThatUnsignedInteger([RKHuman count:nil], is(equalToInt(2)));
+    
+    // The result held object IDs while mapping, the delegate is handed the objects
+    RKHuman* human = [responseLoader.objects objectAtIndex:0];
+    assertThat(human, is(instanceOf([RKHuman class])));
+    assertThat(human.name, is(equalTo(@"Blake Watters")));
+}
+
+- (void)testShouldFailTheLoadAndRollBackWhenABatchFailsToSave {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForEntityWithName:@"RKHuman"];
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapAttributes:@"name", nil];
+    humanMapping.primaryKeyAttribute = @"railsID";
+    [RKHuman truncateAll];
+    [store save];
+    
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    RKSpecStubNetworkAvailability(YES);
+    objectManager.objectStore = store;
+    
+    NSError* saveError = [NSError errorWithDomain:RKRestKitErrorDomain code:RKObjectLoaderUnexpectedResponseError userInfo:nil];
+    id mockStore = [OCMockObject partialMockForObject:store];
+    [[[mockStore stub] andReturn:saveError] save];
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKManagedObjectLoader* objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    objectLoader.saveBatchSize = 1;
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    
+    assertThatBool(responseLoader.success, is(equalToBool(NO)));
+    assertThat(responseLoader.failureError, is(equalTo(saveError)));
+    assertThatUnsignedInteger([RKHuman count:nil], is(equalToInt(0)));
+}
+
+- (void)testShouldDeliverTheRememberedObjectsWithoutMappingOrSavingWhenTheContentIsUnchanged {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    RKSpecStubNetworkAvailability(YES);
+    objectManager.objectStore = store;
+    objectManager.client.cachePolicy = RKRequestCachePolicyNone;
+    RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForClass:[RKHuman class]];
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapAttributes:@"name", nil];
+    humanMapping.primaryKeyAttribute = @"railsID";
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    [objectManager.mappingResultCache addResourcePath:@"/JSON/humans/all.json"];
+    
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKManagedObjectLoader* objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    assertThatUnsignedInteger([responseLoader.objects count], is(equalToInt(2)));
+    
+    // The identical body is delivered from the remembered object IDs
+    responseLoader = [RKSpecResponseLoader responseLoader];
+    objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(NO)));
+    assertThatBool(objectLoader.metrics.saveStartTime > 0, is(equalToBool(NO)));
+    assertThatUnsignedInteger([responseLoader.objects count], is(equalToInt(2)));
+    
+    // Deleting a remembered object forces the body to be mapped again
+    RKHuman* human = [responseLoader.objects lastObject];
+    [human deleteEntity];
+    [store save];
+    responseLoader = [RKSpecResponseLoader responseLoader];
+    objectLoader = [RKManagedObjectLoader loaderWithResourcePath:@"/JSON/humans/all.json" objectManager:objectManager delegate:responseLoader];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(YES)));
+    assertThatUnsignedInteger([responseLoader.objects count], is(equalToInt(2)));
+    assertThatUnsignedInteger([RKHuman count:nil], is(equalToInt(2)));
+}
+
 @end
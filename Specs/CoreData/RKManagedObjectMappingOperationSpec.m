@@ -222,4 +222,44 @@
     assertThat(child.father, is(notNilValue()));
 }
 
+- (void)testShouldConnectRelationshipsToTheSameEntityWithOneLookup {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping* parentMapping = [RKManagedObjectMapping mappingForClass:[RKParent class]];
+    [parentMapping mapAttributes:@"parentID", nil];
+    parentMapping.primaryKeyAttribute = @"parentID";
+    
+    RKManagedObjectMapping* childMapping = [RKManagedObjectMapping mappingForClass:[RKChild class]];
+    [childMapping mapAttributes:@"fatherID", @"motherID", nil];
+    [childMapping mapRelationship:@"father" withMapping:parentMapping];
+    [childMapping mapRelationship:@"mother" withMapping:parentMapping];
+    [childMapping connectRelationship:@"father" withObjectForPrimaryKeyAttribute:@"fatherID"];
+    [childMapping connectRelationship:@"mother" withObjectForPrimaryKeyAttribute:@"motherID"];
+    RKObjectMappingProvider *mappingProvider = [[RKObjectMappingProvider new] autorelease];
+    [mappingProvider setMapping:childMapping forKeyPath:@"children"];
+    
+    NSNumber *one = [NSNumber numberWithInt:1], *two = [NSNumber numberWithInt:2], *three = [NSNumber numberWithInt:3];
+    RKParent* father = [RKParent object];
+    father.parentID = one;
+    RKParent* mother = [RKParent object];
+    mother.parentID = two;
+    [objectStore save];
+    
+    NSArray *children = [NSArray arrayWithObjects:
+                         [NSDictionary dictionaryWithKeysAndObjects:@"fatherID", one, @"motherID", two, nil],
+                         [NSDictionary dictionaryWithKeysAndObjects:@"fatherID", two, @"motherID", one, nil],
+                         [NSDictionary dictionaryWithKeysAndObjects:@"fatherID", three, nil], nil];
+    id mockObjectStore = [OCMockObject partialMockForObject:objectStore];
+    [[[mockObjectStore expect] andForwardToRealObject] findInstancesOfEntity:parentMapping.entity withPrimaryKeyAttribute:@"parentID" values:[NSSet setWithObjects:one, two, three, nil]];
+    RKObjectMapper *mapper = [RKObjectMapper mapperWithObject:[NSDictionary dictionaryWithObject:children forKey:@"children"] mappingProvider:mappingProvider];
+    mapper.delegate = [OCMockObject niceMockForProtocol:@protocol(RKObjectMapperDelegate)];
+    NSArray *mappedChildren = [[[mapper performMapping] asDictionary] valueForKey:@"children"];
+    [mockObjectStore verify];
+    
+    assertThat(mappedChildren, hasCountOf(3));
+    assertThat([[mappedChildren objectAtIndex:0] father], is(equalTo(father)));
+    assertThat([[mappedChildren objectAtIndex:0] mother], is(equalTo(mother)));
+    assertThat([[mappedChildren objectAtIndex:1] father], is(equalTo(mother)));
+    assertThat([[mappedChildren objectAtIndex:2] father], is(nilValue()));
+}
+
 @end
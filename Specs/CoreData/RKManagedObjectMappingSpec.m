@@ -21,6 +21,7 @@
 #import "RKSpecEnvironment.h"
 #import "RKManagedObjectMapping.h"
 #import "RKHuman.h"
+#import "RKCat.h"
 #import "RKMappableObject.h"
 
 @interface RKManagedObjectMappingSpec : RKSpec {
@@ -155,4 +156,43 @@
     [mockObjectStore verify];
 }
 
+- (void)testShouldResolvePrimaryKeysForNestedCollectionsWithOneFetchPerEntity {
+    RKManagedObjectStore *objectStore = RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping *catMapping = [RKManagedObjectMapping mappingForClass:[RKCat class]];
+    catMapping.primaryKeyAttribute = @"railsID";
+    [catMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    RKManagedObjectMapping *humanMapping = [RKManagedObjectMapping mappingForClass:[RKHuman class]];
+    humanMapping.primaryKeyAttribute = @"railsID";
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapRelationship:@"cats" withMapping:catMapping];
+    RKObjectMappingProvider *provider = [[RKObjectMappingProvider new] autorelease];
+    [provider setMapping:humanMapping forKeyPath:@"humans"];
+    
+    NSNumber *one = [NSNumber numberWithInt:1], *two = [NSNumber numberWithInt:2];
+    NSNumber *ten = [NSNumber numberWithInt:10], *eleven = [NSNumber numberWithInt:11], *twelve = [NSNumber numberWithInt:12];
+    NSArray *blakesCats = [NSArray arrayWithObjects:[NSDictionary dictionaryWithObject:ten forKey:@"id"], [NSDictionary dictionaryWithObject:eleven forKey:@"id"], nil];
+    NSArray *sarahsCats = [NSArray arrayWithObject:[NSDictionary dictionaryWithObject:twelve forKey:@"id"]];
+    NSArray *humans = [NSArray arrayWithObjects:
+                       [NSDictionary dictionaryWithObjectsAndKeys:one, @"id", blakesCats, @"cats", nil],
+                       [NSDictionary dictionaryWithObjectsAndKeys:two, @"id", sarahsCats, @"cats", nil], nil];
+    
+    id mockObjectStore = [OCMockObject partialMockForObject:objectStore];
+    [[[mockObjectStore expect] andForwardToRealObject] prefetchInstancesOfEntity:humanMapping.entity withPrimaryKeyAttribute:@"railsID" values:[NSSet setWithObjects:one, two, nil]];
+    [[[mockObjectStore expect] andForwardToRealObject] prefetchInstancesOfEntity:catMapping.entity withPrimaryKeyAttribute:@"railsID" values:[NSSet setWithObjects:ten, eleven, twelve, nil]];
+    RKObjectMapper* mapper = [RKObjectMapper mapperWithObject:[NSDictionary dictionaryWithObject:humans forKey:@"humans"] mappingProvider:provider];
+    [mapper performMapping];
+    [mockObjectStore verify];
+}
+
+- (void)testShouldForgetThePrimaryKeyAttributeMappingWhenThePrimaryKeyAttributeChanges {
+    RKSpecNewManagedObjectStore();
+    RKManagedObjectMapping* mapping = [RKManagedObjectMapping mappingForClass:[RKHuman class]];
+    [mapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [mapping mapKeyPath:@"name" toAttribute:@"name"];
+    mapping.primaryKeyAttribute = @"railsID";
+    assertThat([mapping primaryKeyAttributeMapping].sourceKeyPath, is(equalTo(@"id")));
+    mapping.primaryKeyAttribute = @"name";
+    assertThat([mapping primaryKeyAttributeMapping].sourceKeyPath, is(equalTo(@"name")));
+}
+
 @end
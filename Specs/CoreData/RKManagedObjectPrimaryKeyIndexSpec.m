@@ -0,0 +1,84 @@
+//
+//  RKManagedObjectPrimaryKeyIndexSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKHuman.h"
+
+@interface RKManagedObjectPrimaryKeyIndexSpec : RKSpec
+
+@end
+
+@implementation RKManagedObjectPrimaryKeyIndexSpec
+
+- (void)testShouldIndexSavedObjectsForEntitiesThatHaveBeenLookedUp {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKManagedObjectPrimaryKeyIndex* index = objectStore.primaryKeyIndex;
+    [objectStore prefetchInstancesOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" values:[NSArray arrayWithObject:@"1"]];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(equalTo([NSNull null])));
+    
+    NSManagedObject* human = [objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:[NSNumber numberWithInt:1]];
+    [human setValue:[NSNumber numberWithInt:1] forKey:@"railsID"];
+    [objectStore save];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(equalTo([human objectID])));
+    
+    [human deleteEntity];
+    [objectStore save];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(equalTo([NSNull null])));
+}
+
+- (void)testShouldNotOverwriteSavedEntriesWithFetchedEntries {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKManagedObjectPrimaryKeyIndex* index = objectStore.primaryKeyIndex;
+    RKHuman* human = [RKHuman createEntity];
+    human.railsID = [NSNumber numberWithInt:1];
+    [objectStore save];
+    
+    [index addObjectIDs:[NSDictionary dictionaryWithObject:[human objectID] forKey:@"1"] forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:NO];
+    [index addObjectIDs:[NSDictionary dictionaryWithObject:[NSNull null] forKey:@"1"] forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:NO];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(equalTo([human objectID])));
+}
+
+- (void)testShouldEvictTheOldestGenerationOnceATableIsFull {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKManagedObjectPrimaryKeyIndex* index = [[RKManagedObjectPrimaryKeyIndex new] autorelease];
+    index.capacity = 2;
+    NSMutableDictionary* objectIDs = [NSMutableDictionary dictionary];
+    for (int i = 1; i <= 2; i++) {
+        RKHuman* human = [RKHuman createEntity];
+        human.railsID = [NSNumber numberWithInt:i];
+        [objectStore save];
+        [objectIDs setObject:[human objectID] forKey:[human.railsID stringValue]];
+    }
+    [index addObjectIDs:objectIDs forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:YES];
+    assertThatBool([index hasLoadedEntity:[RKHuman entity] primaryKeyAttribute:@"railsID"], is(equalToBool(YES)));
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"3"], is(equalTo([NSNull null])));
+    
+    // Filling the table starts a new generation: the table is no longer complete, but keeps the previous generation
+    [index addObjectIDs:[NSDictionary dictionaryWithObject:[NSNull null] forKey:@"4"] forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:NO];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"3"], is(nilValue()));
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(equalTo([objectIDs objectForKey:@"1"])));
+    assertThatUnsignedInteger(index.count, is(equalToUnsignedInteger(3)));
+    
+    [index addObjectIDs:[NSDictionary dictionaryWithObject:[NSNull null] forKey:@"5"] forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:NO];
+    [index addObjectIDs:[NSDictionary dictionaryWithObject:[NSNull null] forKey:@"6"] forEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" loadedEntity:NO];
+    assertThat([index objectIDForEntity:[RKHuman entity] primaryKeyAttribute:@"railsID" lookupValue:@"1"], is(nilValue()));
+    assertThatUnsignedInteger(index.count, is(equalToUnsignedInteger(3)));
+}
+
+@end
@@ -0,0 +1,95 @@
+//
+//  RKManagedObjectSeederSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKManagedObjectSeeder.h"
+#import "RKManagedObjectMapping.h"
+#import "RKHuman.h"
+#import "NSManagedObject+ActiveRecord.h"
+
+// Records the progress reported by the seeder
+@interface RKSpecSeederDelegate : NSObject <RKManagedObjectSeederDelegate> {
+    NSUInteger _seededObjectCount;
+    NSMutableArray* _savedObjectCounts;
+}
+
+@property (nonatomic, readonly) NSUInteger seededObjectCount;
+@property (nonatomic, readonly) NSMutableArray* savedObjectCounts;
+
+@end
+
+@implementation RKSpecSeederDelegate
+
+@synthesize seededObjectCount = _seededObjectCount;
+@synthesize savedObjectCounts = _savedObjectCounts;
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _savedObjectCounts = [NSMutableArray new];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_savedObjectCounts release];
+    [super dealloc];
+}
+
+- (void)didSeedObject:(NSManagedObject*)object fromFile:(NSString*)fileName {
+    _seededObjectCount++;
+}
+
+- (void)objectSeeder:(RKManagedObjectSeeder*)objectSeeder didSaveObjectCount:(NSUInteger)objectCount fromFile:(NSString*)fileName elapsedTime:(NSTimeInterval)elapsedTime {
+    [_savedObjectCounts addObject:[NSString stringWithFormat:@"%@:%lu", fileName, (unsigned long) objectCount]];
+}
+
+@end
+
+@interface RKManagedObjectSeederSpec : RKSpec
+
+@end
+
+@implementation RKManagedObjectSeederSpec
+
+- (void)testShouldSeedSeveralFilesInBatches {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    objectManager.objectStore = objectStore;
+    RKManagedObjectMapping* humanMapping = [RKManagedObjectMapping mappingForClass:[RKHuman class]];
+    [humanMapping mapKeyPath:@"id" toAttribute:@"railsID"];
+    [humanMapping mapAttributes:@"name", nil];
+
+    RKManagedObjectSeeder* seeder = [RKManagedObjectSeeder objectSeederWithObjectManager:objectManager];
+    RKSpecSeederDelegate* delegate = [[RKSpecSeederDelegate new] autorelease];
+    seeder.delegate = delegate;
+    seeder.batchSize = 2;
+    NSArray* fileNames = [NSArray arrayWithObjects:@"users.json", @"users.json", @"users.json", nil];
+    [seeder seedObjectsFromFileNames:fileNames withObjectMapping:humanMapping bundle:[NSBundle bundleForClass:[RKSpec class]]];
+
+    // Each file holds three users, saved in a batch of two and a batch of one
+    assertThatUnsignedInteger(seeder.seededObjectCount, is(equalToInt(9)));
+    assertThatUnsignedInteger(delegate.seededObjectCount, is(equalToInt(9)));
+    assertThatUnsignedInteger([RKHuman count:nil], is(equalToInt(9)));
+    NSArray* expectedCounts = [NSArray arrayWithObjects:@"users.json:2", @"users.json:3", @"users.json:2", @"users.json:3", @"users.json:2", @"users.json:3", nil];
+    assertThat(delegate.savedObjectCounts, is(equalTo(expectedCounts)));
+}
+
+@end
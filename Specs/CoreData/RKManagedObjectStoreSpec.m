@@ -43,4 +43,80 @@
     assertThat(secondInstance, is(equalTo(firstInstance)));
 }
 
+
+- (void)testShouldFindExistingObjectsWithPrefetchedPrimaryKeys {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKHuman* blake = [RKHuman createEntity];
+    blake.railsID = [NSNumber numberWithInt:1];
+    RKHuman* rachit = [RKHuman createEntity];
+    rachit.railsID = [NSNumber numberWithInt:2];
+    [objectStore save];
+    
+    NSArray* values = [NSArray arrayWithObjects:@"1", [NSNumber numberWithInt:2], [NSNumber numberWithInt:3], nil];
+    [objectStore prefetchInstancesOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" values:values];
+    assertThat([objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:[NSNumber numberWithInt:1]], is(equalTo(blake)));
+    assertThat([objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:@"2"], is(equalTo(rachit)));
+    NSManagedObject* newHuman = [objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:[NSNumber numberWithInt:3]];
+    assertThatBool([newHuman isInserted], is(equalToBool(YES)));
+}
+
+- (void)testShouldFindExistingObjectsWhenLookingUpTheWholeEntity {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    [objectStore setPrimaryKeyLookup:RKManagedObjectStorePrimaryKeyLookupWholeEntity forEntity:[RKHuman entity]];
+    assertThatInt([objectStore primaryKeyLookupForEntity:[RKHuman entity]], is(equalToInt(RKManagedObjectStorePrimaryKeyLookupWholeEntity)));
+    RKHuman* human = [RKHuman createEntity];
+    human.railsID = [NSNumber numberWithInt:1234];
+    [objectStore save];
+    assertThat([objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:@"1234"], is(equalTo(human)));
+}
+
+- (void)testShouldEmptyThePrimaryKeyIndexWhenThePersistentStoreIsDeleted {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKHuman* human = [RKHuman createEntity];
+    human.railsID = [NSNumber numberWithInt:1234];
+    [objectStore save];
+    assertThat([objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:@"1234"], is(equalTo(human)));
+    assertThatUnsignedInteger(objectStore.primaryKeyIndex.count, is(equalToUnsignedInteger(1)));
+    
+    [objectStore deletePersistantStore];
+    assertThatUnsignedInteger(objectStore.primaryKeyIndex.count, is(equalToUnsignedInteger(0)));
+    NSManagedObject* newHuman = [objectStore findOrCreateInstanceOfEntity:[RKHuman entity] withPrimaryKeyAttribute:@"railsID" andValue:@"1234"];
+    assertThatBool([newHuman isInserted], is(equalToBool(YES)));
+}
+
+- (void)renameHumanInBackground:(NSDictionary*)arguments {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    NSConditionLock* lock = [arguments objectForKey:@"lock"];
+    [lock lock];
+    RKManagedObjectStore* objectStore = [arguments objectForKey:@"objectStore"];
+    RKHuman* human = (RKHuman*) [objectStore objectWithID:[arguments objectForKey:@"objectID"]];
+    human.name = @"Renamed";
+    [objectStore save];
+    human.nickName = @"Nicknamed";
+    [objectStore save];
+    [pool drain];
+    [lock unlockWithCondition:1];
+}
+
+- (void)testShouldCoalesceBackgroundSavesIntoOneMergeWithoutBlocking {
+    RKManagedObjectStore* objectStore = RKSpecNewManagedObjectStore();
+    RKHuman* human = [RKHuman createEntity];
+    human.name = @"Blake";
+    [objectStore save];
+    
+    NSConditionLock* lock = [[[NSConditionLock alloc] initWithCondition:0] autorelease];
+    NSDictionary* arguments = [NSDictionary dictionaryWithObjectsAndKeys:objectStore, @"objectStore", [human objectID], @"objectID", lock, @"lock", nil];
+    NSUInteger pendingCount = [[RKMainThreadInvocationQueue sharedQueue] pendingCount];
+    [NSThread detachNewThreadSelector:@selector(renameHumanInBackground:) toTarget:self withObject:arguments];
+    [lock lockWhenCondition:1];
+    [lock unlock];
+    
+    // Both saves completed without waiting on the main thread, and are merged together
+    assertThatUnsignedInteger([[RKMainThreadInvocationQueue sharedQueue] pendingCount], is(equalToUnsignedInteger(pendingCount + 1)));
+    assertThat(human.name, is(equalTo(@"Blake")));
+    [[RKMainThreadInvocationQueue sharedQueue] flush];
+    assertThat(human.name, is(equalTo(@"Renamed")));
+    assertThat(human.nickName, is(equalTo(@"Nicknamed")));
+}
+
 @end
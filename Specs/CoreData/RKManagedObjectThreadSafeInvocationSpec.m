@@ -83,6 +83,31 @@
     assertThat([dictionary valueForKeyPath:@"humans"], is(equalTo(humans)));
 }
 
+- (void)testShouldMaterializeSerializedCollectionsInPlaceWithoutFaulting {
+    RKManagedObjectStore* store = RKSpecNewManagedObjectStore();
+    RKHuman* human1 = [RKHuman object];
+    human1.name = @"Blake";
+    RKHuman* human2 = [RKHuman object];
+    human2.name = @"Rachit";
+    [store save];
+    NSArray* humans = [NSArray arrayWithObjects:human1, human2, nil];
+    NSMutableDictionary* dictionary = [NSMutableDictionary dictionaryWithObject:humans forKey:@"humans"];
+    NSMethodSignature* signature = [self methodSignatureForSelector:@selector(informDelegateWithDictionary:)];
+    RKManagedObjectThreadSafeInvocation* invocation = [RKManagedObjectThreadSafeInvocation invocationWithMethodSignature:signature];
+    invocation.objectStore = store;
+    [invocation serializeManagedObjectsForArgument:dictionary withKeyPaths:[NSSet setWithObject:@"humans"]];
+    NSArray* serializedHumans = [dictionary valueForKeyPath:@"humans"];
+    
+    // Nothing is registered with the context, so the objects have to be fetched
+    [store.managedObjectContext reset];
+    [invocation deserializeManagedObjectIDsForArgument:dictionary withKeyPaths:[NSSet setWithObject:@"humans"]];
+    assertThat([dictionary valueForKeyPath:@"humans"], is(sameInstance(serializedHumans)));
+    NSManagedObject* human = [serializedHumans objectAtIndex:0];
+    assertThatBool([human isFault], is(equalToBool(NO)));
+    assertThat([human valueForKey:@"name"], is(equalTo(@"Blake")));
+    assertThat([[serializedHumans lastObject] valueForKey:@"name"], is(equalTo(@"Rachit")));
+}
+
 - (void)informDelegateWithDictionary:(NSDictionary*)results {
     assertThatBool([NSThread isMainThread], equalToBool(YES));
     assertThat(results, isNot(nilValue()));
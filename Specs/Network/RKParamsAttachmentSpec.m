@@ -57,4 +57,25 @@
     assertThat([attachment MD5], is(equalTo(@"db6cb9d879b58e7e15a595632af345cd")));
 }
 
+- (void)testShouldFingerprintFilesByTheirAttributes {
+    NSBundle *testBundle = [NSBundle bundleWithIdentifier:@"org.restkit.unit-tests"];
+    NSString *filePath = [[RKDirectory cachesDirectory] stringByAppendingPathComponent:@"RKParamsAttachmentSpec.png"];
+    [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    [[NSFileManager defaultManager] copyItemAtPath:[testBundle pathForResource:@"blake" ofType:@"png"] toPath:filePath error:nil];
+    RKParamsAttachment *attachment = [[[RKParamsAttachment alloc] initWithName:@"foo" file:filePath] autorelease];
+    NSString *fingerprint = [attachment fingerprint];
+    assertThat(fingerprint, isNot(equalTo([attachment MD5])));
+    assertThat([attachment fingerprint], is(equalTo(fingerprint)));
+    
+    [[@"changed" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:filePath atomically:YES];
+    assertThat([attachment fingerprint], isNot(equalTo(fingerprint)));
+    assertThat([attachment MD5], isNot(equalTo(@"db6cb9d879b58e7e15a595632af345cd")));
+    [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+}
+
+- (void)testShouldFingerprintValuesByTheirMD5 {
+    RKParamsAttachment *attachment = [[[RKParamsAttachment alloc] initWithName:@"foo" value:@"bar"] autorelease];
+    assertThat([attachment fingerprint], is(equalTo(@"37b51d194a7513e45b56f6524f2d51f2")));
+}
+
 @end
@@ -0,0 +1,89 @@
+//
+//  RKRequestCacheEntrySpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestCacheEntry.h"
+
+@interface RKRequestCacheEntrySpec : RKSpec {
+}
+
+@end
+
+@implementation RKRequestCacheEntrySpec
+
+- (RKRequestCacheEntry*)entry {
+    RKRequestCacheEntry* entry = [[RKRequestCacheEntry new] autorelease];
+    entry.statusCode = 200;
+    entry.MIMEType = @"application/json";
+    entry.URL = @"http://restkit.org/humans/1";
+    entry.ETag = @"\"686897696a7c876b7e\"";
+    entry.cacheDate = [NSDate dateWithTimeIntervalSinceReferenceDate:1000];
+    entry.lastModifiedDate = [NSDate dateWithTimeIntervalSinceReferenceDate:500];
+    entry.headers = [NSDictionary dictionaryWithObjectsAndKeys:@"application/json", @"Content-Type", @"\"686897696a7c876b7e\"", @"ETag", nil];
+    entry.body = [@"{\"human\": {\"name\": \"Blake\"}}" dataUsingEncoding:NSUTF8StringEncoding];
+    return entry;
+}
+
+- (NSString*)entryPath {
+    return [[RKDirectory cachesDirectory] stringByAppendingPathComponent:@"RKRequestCacheEntrySpec"];
+}
+
+- (void)testShouldRoundTripEveryField {
+    RKRequestCacheEntry* entry = [self entry];
+    RKRequestCacheEntry* decoded = [[[RKRequestCacheEntry alloc] initWithData:[entry data]] autorelease];
+    assertThatInt((int)decoded.statusCode, is(equalToInt(200)));
+    assertThat(decoded.MIMEType, is(equalTo(entry.MIMEType)));
+    assertThat(decoded.URL, is(equalTo(entry.URL)));
+    assertThat(decoded.ETag, is(equalTo(entry.ETag)));
+    assertThat(decoded.cacheDate, is(equalTo(entry.cacheDate)));
+    assertThat(decoded.lastModifiedDate, is(equalTo(entry.lastModifiedDate)));
+    assertThat(decoded.expirationDate, is(nilValue()));
+    assertThat(decoded.headers, is(equalTo(entry.headers)));
+    assertThat(decoded.body, is(equalTo(entry.body)));
+}
+
+- (void)testShouldRejectTruncatedData {
+    NSData* data = [[self entry] data];
+    NSData* truncated = [data subdataWithRange:NSMakeRange(0, [data length] - 1)];
+    assertThat([[[RKRequestCacheEntry alloc] initWithData:truncated] autorelease], is(nilValue()));
+    assertThat([[[RKRequestCacheEntry alloc] initWithData:[@"not an entry" dataUsingEncoding:NSUTF8StringEncoding]] autorelease], is(nilValue()));
+}
+
+- (void)testShouldReadAnEntryWrittenToDisk {
+    NSString* path = [self entryPath];
+    NSError* error = nil;
+    assertThatBool([[self entry] writeToFile:path error:&error], is(equalToBool(YES)));
+    assertThatBool([RKRequestCacheEntry isEntryAtPath:path], is(equalToBool(YES)));
+    RKRequestCacheEntry* entry = [RKRequestCacheEntry entryWithContentsOfFile:path];
+    assertThat(entry.body, is(equalTo([self entry].body)));
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testShouldUpdateTheCacheDateInPlace {
+    NSString* path = [self entryPath];
+    [[self entry] writeToFile:path error:nil];
+    NSDate* cacheDate = [NSDate dateWithTimeIntervalSinceReferenceDate:2000];
+    assertThatBool([RKRequestCacheEntry setCacheDate:cacheDate forEntryAtPath:path], is(equalToBool(YES)));
+    RKRequestCacheEntry* entry = [RKRequestCacheEntry entryWithContentsOfFile:path];
+    assertThat(entry.cacheDate, is(equalTo(cacheDate)));
+    assertThat(entry.body, is(equalTo([self entry].body)));
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
@@ -0,0 +1,129 @@
+//
+//  RKRequestCacheIndexSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestCacheIndex.h"
+
+@interface RKRequestCacheIndexSpec : RKSpec {
+    NSString* _indexPath;
+}
+
+@end
+
+@implementation RKRequestCacheIndexSpec
+
+- (void)setUp {
+    _indexPath = [[[RKDirectory cachesDirectory] stringByAppendingPathComponent:@"RKRequestCacheIndexSpec"] retain];
+    [[NSFileManager defaultManager] removeItemAtPath:_indexPath error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:[_indexPath stringByAppendingPathExtension:@"journal"] error:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_indexPath error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:[_indexPath stringByAppendingPathExtension:@"journal"] error:nil];
+    [_indexPath release];
+    _indexPath = nil;
+}
+
+- (RKRequestCacheIndexEntry*)entryForKey:(NSString*)cacheKey {
+    RKRequestCacheIndexEntry* entry = [[RKRequestCacheIndexEntry new] autorelease];
+    entry.cacheKey = cacheKey;
+    entry.storagePolicy = RKRequestCacheStoragePolicyPermanently;
+    entry.ETag = @"\"1234\"";
+    entry.cacheDate = [NSDate dateWithTimeIntervalSinceReferenceDate:1000];
+    entry.size = 512;
+    entry.accessCount = 3;
+    entry.lastAccessTime = 2000;
+    return entry;
+}
+
+- (RKRequestCacheIndex*)reopenedIndex {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    [index load];
+    return index;
+}
+
+- (void)testShouldNotLoadWhenNothingHasBeenPersisted {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    assertThatBool([index load], is(equalToBool(NO)));
+}
+
+- (void)testShouldReplayTheJournalWhenLoaded {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    [index setEntry:[self entryForKey:@"first"]];
+    [index setEntry:[self entryForKey:@"second"]];
+    [index removeEntryForKey:@"first"];
+    assertThatBool(index.hasUnsynchronizedChanges, is(equalToBool(YES)));
+    [index synchronize];
+    assertThatBool(index.hasUnsynchronizedChanges, is(equalToBool(NO)));
+    
+    RKRequestCacheIndex* reopenedIndex = [self reopenedIndex];
+    assertThatInt((int)reopenedIndex.count, is(equalToInt(1)));
+    assertThat([reopenedIndex entryForKey:@"first"], is(nilValue()));
+    RKRequestCacheIndexEntry* entry = [reopenedIndex entryForKey:@"second"];
+    assertThat(entry.ETag, is(equalTo(@"\"1234\"")));
+    assertThat(entry.cacheDate, is(equalTo([NSDate dateWithTimeIntervalSinceReferenceDate:1000])));
+    assertThatInt((int)entry.size, is(equalToInt(512)));
+    assertThatInt((int)entry.accessCount, is(equalToInt(3)));
+    assertThatInt((int)[reopenedIndex sizeOfEntriesWithStoragePolicy:RKRequestCacheStoragePolicyPermanently], is(equalToInt(512)));
+}
+
+- (void)testShouldLoadACompactedSnapshot {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    [index setEntry:[self entryForKey:@"first"]];
+    [index recordAccessForKey:@"first"];
+    [index compact];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[_indexPath stringByAppendingPathExtension:@"journal"]], is(equalToBool(NO)));
+    
+    RKRequestCacheIndexEntry* entry = [[self reopenedIndex] entryForKey:@"first"];
+    assertThatInt((int)entry.accessCount, is(equalToInt(4)));
+}
+
+- (void)testShouldIgnoreATruncatedJournalRecord {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    [index setEntry:[self entryForKey:@"first"]];
+    [index synchronize];
+    [index setEntry:[self entryForKey:@"second"]];
+    [index synchronize];
+    
+    NSString* journalPath = [_indexPath stringByAppendingPathExtension:@"journal"];
+    NSData* journal = [NSData dataWithContentsOfFile:journalPath];
+    [[journal subdataWithRange:NSMakeRange(0, [journal length] - 4)] writeToFile:journalPath atomically:YES];
+    
+    RKRequestCacheIndex* reopenedIndex = [self reopenedIndex];
+    assertThat([reopenedIndex entryForKey:@"first"], isNot(nilValue()));
+    assertThat([reopenedIndex entryForKey:@"second"], is(nilValue()));
+}
+
+- (void)testShouldRemoveEntriesByStoragePolicy {
+    RKRequestCacheIndex* index = [[[RKRequestCacheIndex alloc] initWithPath:_indexPath] autorelease];
+    RKRequestCacheIndexEntry* sessionEntry = [self entryForKey:@"session"];
+    sessionEntry.storagePolicy = RKRequestCacheStoragePolicyForDurationOfSession;
+    [index setEntry:sessionEntry];
+    [index setEntry:[self entryForKey:@"permanent"]];
+    [index removeEntriesWithStoragePolicy:RKRequestCacheStoragePolicyForDurationOfSession];
+    [index synchronize];
+    
+    RKRequestCacheIndex* reopenedIndex = [self reopenedIndex];
+    assertThat([reopenedIndex entryForKey:@"session"], is(nilValue()));
+    assertThat([reopenedIndex entryForKey:@"permanent"], isNot(nilValue()));
+    assertThatInt((int)[[reopenedIndex entriesWithStoragePolicy:RKRequestCacheStoragePolicyForDurationOfSession] count], is(equalToInt(0)));
+}
+
+@end
@@ -0,0 +1,361 @@
+//
+//  RKRequestCacheSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestCache.h"
+#import "RKRequestCacheEntry.h"
+
+@interface RKRequestCacheSpec : RKSpec {
+    NSString* _cachePath;
+}
+
+@end
+
+@implementation RKRequestCacheSpec
+
+- (void)setUp {
+    _cachePath = [[[RKDirectory cachesDirectory] stringByAppendingPathComponent:@"RKRequestCacheSpec"] retain];
+    [[NSFileManager defaultManager] removeItemAtPath:_cachePath error:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_cachePath error:nil];
+    [_cachePath release];
+    _cachePath = nil;
+}
+
+- (RKRequestCache*)permanentCache {
+    return [[[RKRequestCache alloc] initWithCachePath:_cachePath storagePolicy:RKRequestCacheStoragePolicyPermanently] autorelease];
+}
+
+- (RKRequest*)requestForPath:(NSString*)path {
+    NSURL* URL = [NSURL URLWithString:[@"http://restkit.org" stringByAppendingString:path]];
+    return [RKRequest requestWithURL:URL delegate:nil];
+}
+
+- (RKResponse*)responseForRequest:(RKRequest*)request body:(NSString*)body {
+    NSInteger statusCode = 200;
+    id URLResponse = [OCMockObject niceMockForClass:[NSHTTPURLResponse class]];
+    [[[URLResponse stub] andReturn:[NSDictionary dictionaryWithObject:@"text/plain" forKey:@"Content-Type"]] allHeaderFields];
+    [[[URLResponse stub] andReturnValue:OCMOCK_VALUE(statusCode)] statusCode];
+    [[[URLResponse stub] andReturn:@"text/plain"] MIMEType];
+    [[[URLResponse stub] andReturn:request.URL] URL];
+    NSData* data = [body dataUsingEncoding:NSUTF8StringEncoding];
+    return [[[RKResponse alloc] initWithSynchronousRequest:request URLResponse:URLResponse body:data error:nil] autorelease];
+}
+
+- (void)storeRequest:(RKRequest*)request inCache:(RKRequestCache*)cache {
+    [cache storeResponse:[self responseForRequest:request body:[[request URL] absoluteString]] forRequest:request];
+}
+
+- (void)testShouldShardPermanentEntriesIntoTwoLevelsOfDirectories {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    NSString* cacheKey = [request cacheKey];
+    NSArray* pathComponents = [[cache pathForRequest:request] pathComponents];
+    NSArray* expectedComponents = [NSArray arrayWithObjects:@"PermanentStore", [cacheKey substringToIndex:2],
+                                   [cacheKey substringWithRange:NSMakeRange(2, 2)], cacheKey, nil];
+    assertThat([pathComponents subarrayWithRange:NSMakeRange([pathComponents count] - 4, 4)], is(equalTo(expectedComponents)));
+    
+    [self storeRequest:request inCache:cache];
+    [cache flush];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[cache pathForRequest:request]], is(equalToBool(YES)));
+    assertThat([[cache responseForRequest:request] bodyAsString], is(equalTo(@"http://restkit.org/humans/1")));
+}
+
+- (void)testShouldMigrateFlatPermanentEntriesIntoShardedDirectories {
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    NSString* storePath = [_cachePath stringByAppendingPathComponent:@"PermanentStore"];
+    NSString* flatPath = [storePath stringByAppendingPathComponent:[request cacheKey]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:storePath withIntermediateDirectories:YES attributes:nil error:nil];
+    [[@"legacy" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:flatPath atomically:YES];
+    [[NSDictionary dictionaryWithObject:@"text/plain" forKey:@"Content-Type"] writeToFile:[flatPath stringByAppendingPathExtension:@"headers"] atomically:YES];
+    
+    RKRequestCache* cache = [self permanentCache];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:flatPath], is(equalToBool(NO)));
+    assertThatBool([cache hasResponseForRequest:request], is(equalToBool(YES)));
+    assertThat([[cache responseForRequest:request] bodyAsString], is(equalTo(@"legacy")));
+}
+
+- (void)testShouldEvictTheLeastRecentlyUsedEntryWhenOverTheEntryLimit {
+    RKRequestCache* cache = [self permanentCache];
+    cache.maximumPermanentStoreEntryCount = 2;
+    RKRequest* first = [self requestForPath:@"/first"];
+    RKRequest* second = [self requestForPath:@"/second"];
+    RKRequest* third = [self requestForPath:@"/third"];
+    [self storeRequest:first inCache:cache];
+    [self storeRequest:second inCache:cache];
+    [cache responseForRequest:first];
+    [self storeRequest:third inCache:cache];
+    
+    assertThatInt((int)cache.permanentStoreEntryCount, is(equalToInt(2)));
+    assertThatBool([cache hasResponseForRequest:first], is(equalToBool(YES)));
+    assertThatBool([cache hasResponseForRequest:second], is(equalToBool(NO)));
+    assertThatBool([cache hasResponseForRequest:third], is(equalToBool(YES)));
+}
+
+- (void)testShouldEvictTheLeastFrequentlyUsedEntryWhenConfigured {
+    RKRequestCache* cache = [self permanentCache];
+    cache.evictionPolicy = RKRequestCacheEvictionPolicyLeastFrequentlyUsed;
+    cache.maximumPermanentStoreEntryCount = 10;
+    RKRequest* first = [self requestForPath:@"/first"];
+    RKRequest* second = [self requestForPath:@"/second"];
+    [self storeRequest:first inCache:cache];
+    [self storeRequest:second inCache:cache];
+    [cache responseForRequest:first];
+    [cache responseForRequest:first];
+    [cache responseForRequest:second];
+    cache.maximumPermanentStoreEntryCount = 1;
+    
+    assertThatBool([cache hasResponseForRequest:first], is(equalToBool(YES)));
+    assertThatBool([cache hasResponseForRequest:second], is(equalToBool(NO)));
+}
+
+- (void)testShouldNotEvictTheNewestEntryUnderLeastFrequentlyUsedEviction {
+    RKRequestCache* cache = [self permanentCache];
+    cache.evictionPolicy = RKRequestCacheEvictionPolicyLeastFrequentlyUsed;
+    cache.maximumPermanentStoreEntryCount = 2;
+    RKRequest* first = [self requestForPath:@"/first"];
+    RKRequest* second = [self requestForPath:@"/second"];
+    RKRequest* third = [self requestForPath:@"/third"];
+    RKRequest* fourth = [self requestForPath:@"/fourth"];
+    RKRequest* fifth = [self requestForPath:@"/fifth"];
+    [self storeRequest:first inCache:cache];
+    [self storeRequest:second inCache:cache];
+    [cache responseForRequest:first];
+    [cache responseForRequest:second];
+    [cache responseForRequest:second];
+    
+    // The new entry has the lowest count but is kept, the least used established entry goes
+    [self storeRequest:third inCache:cache];
+    assertThatBool([cache hasResponseForRequest:first], is(equalToBool(NO)));
+    assertThatBool([cache hasResponseForRequest:second], is(equalToBool(YES)));
+    assertThatBool([cache hasResponseForRequest:third], is(equalToBool(YES)));
+    
+    // Entries stored after an eviction start at the evicted count, so a once popular entry is eventually evicted
+    [self storeRequest:fourth inCache:cache];
+    [self storeRequest:fifth inCache:cache];
+    assertThatInt((int)cache.permanentStoreEntryCount, is(equalToInt(2)));
+    assertThatBool([cache hasResponseForRequest:second], is(equalToBool(NO)));
+    assertThatBool([cache hasResponseForRequest:fourth], is(equalToBool(YES)));
+    assertThatBool([cache hasResponseForRequest:fifth], is(equalToBool(YES)));
+}
+
+- (void)testShouldEvictEntriesWhenOverTheSizeLimit {
+    RKRequestCache* cache = [self permanentCache];
+    [self storeRequest:[self requestForPath:@"/first"] inCache:cache];
+    [self storeRequest:[self requestForPath:@"/second"] inCache:cache];
+    cache.maximumPermanentStoreSize = 1;
+    assertThatInt((int)cache.permanentStoreEntryCount, is(equalToInt(0)));
+    assertThatInt((int)cache.permanentStoreSize, is(equalToInt(0)));
+}
+
+- (void)testShouldRemoveShardedEntriesWhenInvalidated {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    [cache invalidateAll];
+    assertThatBool([cache hasResponseForRequest:request], is(equalToBool(NO)));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[cache pathForRequest:request]], is(equalToBool(NO)));
+}
+
+- (void)testShouldStoreEachEntryInASingleFile {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    [cache flush];
+    NSString* cachePath = [cache pathForRequest:request];
+    assertThatBool([RKRequestCacheEntry isEntryAtPath:cachePath], is(equalToBool(YES)));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[cachePath stringByAppendingPathExtension:@"headers"]], is(equalToBool(NO)));
+    
+    RKRequestCache* reopenedCache = [self permanentCache];
+    RKResponse* response = [reopenedCache responseForRequest:request];
+    assertThatBool([response wasLoadedFromCache], is(equalToBool(YES)));
+    assertThatInt((int)response.statusCode, is(equalToInt(200)));
+    assertThat(response.MIMEType, is(equalTo(@"text/plain")));
+    assertThat([response bodyAsString], is(equalTo(@"http://restkit.org/humans/1")));
+}
+
+- (void)testShouldMigrateLegacyEntriesWhenRead {
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    NSString* cachePath = [[self permanentCache] pathForRequest:request];
+    [[NSFileManager defaultManager] removeItemAtPath:_cachePath error:nil];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cachePath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    [[@"legacy" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:cachePath atomically:YES];
+    NSDictionary* legacyHeaders = [NSDictionary dictionaryWithObjectsAndKeys:
+                                   @"\"1234\"", @"ETag",
+                                   [NSNumber numberWithInt:200], @"X-RESTKIT-CACHED-RESPONSE-CODE",
+                                   @"text/plain", @"X-RESTKIT-CACHED-MIME-TYPE",
+                                   @"http://restkit.org/humans/1", @"X-RESTKIT-CACHED-URL", nil];
+    [legacyHeaders writeToFile:[cachePath stringByAppendingPathExtension:@"headers"] atomically:YES];
+    
+    RKRequestCache* cache = [self permanentCache];
+    assertThat([cache etagForRequest:request], is(equalTo(@"\"1234\"")));
+    assertThat([[cache responseForRequest:request] bodyAsString], is(equalTo(@"legacy")));
+    assertThatBool([RKRequestCacheEntry isEntryAtPath:cachePath], is(equalToBool(YES)));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[cachePath stringByAppendingPathExtension:@"headers"]], is(equalToBool(NO)));
+}
+
+- (void)testShouldServeStoredResponsesBeforeTheyAreWrittenToDisk {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    assertThatBool([cache hasResponseForRequest:request], is(equalToBool(YES)));
+    assertThat([[cache responseForRequest:request] bodyAsString], is(equalTo(@"http://restkit.org/humans/1")));
+    [cache flush];
+    assertThatInt((int)cache.pendingWriteCount, is(equalToInt(0)));
+    assertThatBool([RKRequestCacheEntry isEntryAtPath:[cache pathForRequest:request]], is(equalToBool(YES)));
+}
+
+- (void)testShouldNotWriteEntriesInvalidatedBeforeTheyReachDisk {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    [cache invalidateRequest:request];
+    assertThatBool([cache hasResponseForRequest:request], is(equalToBool(NO)));
+    [cache flush];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[cache pathForRequest:request]], is(equalToBool(NO)));
+}
+
+- (void)testShouldAnswerValidatorsFromTheIndexAfterReopening {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    NSDate* cacheDate = [cache cacheDateForRequest:request];
+    [cache flush];
+    
+    RKRequestCache* reopenedCache = [self permanentCache];
+    assertThatBool([reopenedCache hasResponseForRequest:request], is(equalToBool(YES)));
+    assertThat([reopenedCache cacheDateForRequest:request], is(equalTo(cacheDate)));
+    assertThatInt((int)reopenedCache.permanentStoreEntryCount, is(equalToInt(1)));
+}
+
+- (void)testShouldRebuildTheIndexFromThePermanentStoreWhenItIsMissing {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    [cache flush];
+    [[NSFileManager defaultManager] removeItemAtPath:[_cachePath stringByAppendingPathComponent:@"CacheIndex"] error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:[_cachePath stringByAppendingPathComponent:@"CacheIndex.journal"] error:nil];
+    
+    RKRequestCache* reopenedCache = [self permanentCache];
+    assertThatBool([reopenedCache hasResponseForRequest:request], is(equalToBool(YES)));
+    assertThatInt((int)reopenedCache.permanentStoreEntryCount, is(equalToInt(1)));
+    assertThat([[reopenedCache responseForRequest:request] bodyAsString], is(equalTo(@"http://restkit.org/humans/1")));
+}
+
+- (void)testShouldDropSessionEntriesFromTheIndexWhenReopened {
+    RKRequestCache* cache = [[[RKRequestCache alloc] initWithCachePath:_cachePath storagePolicy:RKRequestCacheStoragePolicyForDurationOfSession] autorelease];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    assertThatBool([cache hasResponseForRequest:request], is(equalToBool(YES)));
+    [cache flush];
+    
+    RKRequestCache* reopenedCache = [[[RKRequestCache alloc] initWithCachePath:_cachePath storagePolicy:RKRequestCacheStoragePolicyForDurationOfSession] autorelease];
+    assertThatBool([reopenedCache hasResponseForRequest:request], is(equalToBool(NO)));
+}
+
+
+- (void)formatDateInBackground:(NSMutableDictionary*)arguments {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    NSConditionLock* lock = [arguments objectForKey:@"lock"];
+    [lock lock];
+    [arguments setObject:[RKRequestCache rfc1123DateFormatter] forKey:@"formatter"];
+    [arguments setObject:[[RKRequestCache rfc1123DateFormatter] stringFromDate:[NSDate dateWithTimeIntervalSince1970:0]] forKey:@"string"];
+    [pool drain];
+    [lock unlockWithCondition:1];
+}
+
+- (void)testShouldFormatHTTPDatesWithAFormatterForEachThread {
+    NSDateFormatter* formatter = [RKRequestCache rfc1123DateFormatter];
+    assertThat([RKRequestCache rfc1123DateFormatter], is(sameInstance(formatter)));
+    assertThat([[formatter locale] localeIdentifier], is(equalTo(@"en_US_POSIX")));
+    
+    NSConditionLock* lock = [[[NSConditionLock alloc] initWithCondition:0] autorelease];
+    NSMutableDictionary* arguments = [NSMutableDictionary dictionaryWithObject:lock forKey:@"lock"];
+    [NSThread detachNewThreadSelector:@selector(formatDateInBackground:) toTarget:self withObject:arguments];
+    [lock lockWhenCondition:1];
+    [lock unlock];
+    assertThat([arguments objectForKey:@"formatter"], isNot(sameInstance(formatter)));
+    assertThat([arguments objectForKey:@"string"], is(equalTo(@"Thu, 01 Jan 1970 00:00:00 GMT")));
+}
+
+- (void)testShouldPreferMaxAgeOverExpiresWhenDeterminingTheExpirationDate {
+    NSDate* date = [NSDate dateWithTimeIntervalSinceReferenceDate:1000];
+    NSDictionary* headers = [NSDictionary dictionaryWithObjectsAndKeys:
+                             @"public, max-age=60", @"Cache-Control",
+                             @"Thu, 01 Dec 1994 16:00:00 GMT", @"Expires", nil];
+    NSDate* expirationDate = [RKRequestCache expirationDateForResponseHeaders:headers fromDate:date];
+    assertThatDouble([expirationDate timeIntervalSinceDate:date], is(equalToDouble(60)));
+}
+
+- (void)testShouldExpireImmediatelyWhenTheResponseIsNotCacheable {
+    NSDate* date = [NSDate dateWithTimeIntervalSinceReferenceDate:1000];
+    NSDictionary* headers = [NSDictionary dictionaryWithObject:@"no-cache, max-age=60" forKey:@"Cache-Control"];
+    assertThat([RKRequestCache expirationDateForResponseHeaders:headers fromDate:date], is(equalTo(date)));
+    headers = [NSDictionary dictionaryWithObject:@"0" forKey:@"Expires"];
+    assertThat([RKRequestCache expirationDateForResponseHeaders:headers fromDate:date], is(equalTo(date)));
+    assertThat([RKRequestCache expirationDateForResponseHeaders:[NSDictionary dictionary] fromDate:date], is(nilValue()));
+}
+
+- (void)testShouldUpdateTheExpirationDateOfAStoredResponse {
+    RKRequestCache* cache = [self permanentCache];
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    assertThat([cache expirationDateForRequest:request], is(nilValue()));
+    
+    NSDate* expirationDate = [NSDate dateWithTimeIntervalSinceNow:300];
+    [cache setCacheDate:[NSDate date] expirationDate:expirationDate forRequest:request];
+    [cache flush];
+    
+    RKRequestCache* reopenedCache = [self permanentCache];
+    assertThatDouble([[reopenedCache expirationDateForRequest:request] timeIntervalSinceDate:expirationDate], closeTo(0, 0.001));
+}
+
+
+- (void)testShouldStoreParsedObjectsForTheCachedResponse {
+    RKRequestCache* cache = [self permanentCache];
+    cache.cachesParsedObjects = YES;
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    NSDictionary* parsedObject = [NSDictionary dictionaryWithObjectsAndKeys:@"Blake", @"name", [NSNull null], @"age", nil];
+    [cache storeParsedObject:parsedObject forRequest:request];
+    [cache flush];
+    
+    RKRequestCache* reopenedCache = [self permanentCache];
+    assertThat([reopenedCache parsedObjectForRequest:request], is(nilValue()));
+    reopenedCache.cachesParsedObjects = YES;
+    assertThat([reopenedCache parsedObjectForRequest:request], is(equalTo(parsedObject)));
+}
+
+- (void)testShouldDiscardParsedObjectsWhenTheCachedResponseIsReplaced {
+    RKRequestCache* cache = [self permanentCache];
+    cache.cachesParsedObjects = YES;
+    RKRequest* request = [self requestForPath:@"/humans/1"];
+    [self storeRequest:request inCache:cache];
+    [cache storeParsedObject:[NSArray arrayWithObject:@"Blake"] forRequest:request];
+    [cache flush];
+    assertThat([cache parsedObjectForRequest:request], is(equalTo([NSArray arrayWithObject:@"Blake"])));
+    
+    [cache storeResponse:[self responseForRequest:request body:@"Changed"] forRequest:request];
+    [cache flush];
+    assertThat([cache parsedObjectForRequest:request], is(nilValue()));
+}
+
+@end
@@ -0,0 +1,94 @@
+//
+//  RKRequestMemoryCacheSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestMemoryCache.h"
+
+@interface RKRequestMemoryCacheSpec : RKSpec {
+}
+
+@end
+
+@implementation RKRequestMemoryCacheSpec
+
+- (NSDictionary*)headers {
+    return [NSDictionary dictionaryWithObject:@"\"etag\"" forKey:@"ETag"];
+}
+
+- (NSData*)bodyOfLength:(NSUInteger)length {
+    return [NSMutableData dataWithLength:length];
+}
+
+- (void)testShouldReturnTheStoredHeadersAndBody {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:4096] autorelease];
+    NSData* body = [@"body" dataUsingEncoding:NSUTF8StringEncoding];
+    [cache setHeaders:[self headers] body:body forKey:@"key"];
+    assertThatBool([cache containsEntryForKey:@"key"], is(equalToBool(YES)));
+    assertThat([cache headersForKey:@"key"], is(equalTo([self headers])));
+    assertThat([cache bodyForKey:@"key"], is(equalTo(body)));
+}
+
+- (void)testShouldEvictTheLeastRecentlyUsedEntryWhenOverCapacity {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:2500] autorelease];
+    [cache setHeaders:[self headers] body:[self bodyOfLength:1000] forKey:@"first"];
+    [cache setHeaders:[self headers] body:[self bodyOfLength:1000] forKey:@"second"];
+    [cache headersForKey:@"first"];
+    [cache setHeaders:[self headers] body:[self bodyOfLength:1000] forKey:@"third"];
+    assertThatBool([cache containsEntryForKey:@"first"], is(equalToBool(YES)));
+    assertThatBool([cache containsEntryForKey:@"second"], is(equalToBool(NO)));
+    assertThatBool([cache containsEntryForKey:@"third"], is(equalToBool(YES)));
+    assertThatInt((int)cache.currentSize, is(lessThanOrEqualTo([NSNumber numberWithInt:2500])));
+}
+
+- (void)testShouldKeepOnlyTheHeadersOfLargeResponses {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:4096] autorelease];
+    cache.maximumBodySize = 100;
+    [cache setHeaders:[self headers] body:[self bodyOfLength:1000] forKey:@"key"];
+    assertThat([cache headersForKey:@"key"], is(notNilValue()));
+    assertThat([cache bodyForKey:@"key"], is(nilValue()));
+}
+
+- (void)testShouldEvictEntriesWhenTheCapacityIsLowered {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:4096] autorelease];
+    [cache setHeaders:[self headers] body:[self bodyOfLength:1000] forKey:@"key"];
+    cache.capacity = 0;
+    assertThatInt((int)cache.count, is(equalToInt(0)));
+    assertThatInt((int)cache.currentSize, is(equalToInt(0)));
+}
+
+- (void)testShouldRemoveEntriesByKeyPrefix {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:4096] autorelease];
+    [cache setHeaders:[self headers] body:nil forKey:@"/cache/SessionStore/a"];
+    [cache setHeaders:[self headers] body:nil forKey:@"/cache/PermanentStore/b"];
+    [cache removeEntriesWithKeyPrefix:@"/cache/SessionStore"];
+    assertThatBool([cache containsEntryForKey:@"/cache/SessionStore/a"], is(equalToBool(NO)));
+    assertThatBool([cache containsEntryForKey:@"/cache/PermanentStore/b"], is(equalToBool(YES)));
+}
+
+- (void)testShouldKeepTheBodyWhenUpdatingHeaders {
+    RKRequestMemoryCache* cache = [[[RKRequestMemoryCache alloc] initWithCapacity:4096] autorelease];
+    NSData* body = [@"body" dataUsingEncoding:NSUTF8StringEncoding];
+    [cache setHeaders:[self headers] body:body forKey:@"key"];
+    NSDictionary* updatedHeaders = [NSDictionary dictionaryWithObject:@"\"updated\"" forKey:@"ETag"];
+    [cache updateHeaders:updatedHeaders forKey:@"key"];
+    assertThat([cache headersForKey:@"key"], is(equalTo(updatedHeaders)));
+    assertThat([cache bodyForKey:@"key"], is(equalTo(body)));
+}
+
+@end
@@ -0,0 +1,112 @@
+//
+//  RKRequestMetricsCollectorSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestMetricsCollector.h"
+
+@interface RKRequestMetricsCollectorSpec : RKSpec {
+}
+
+@end
+
+@implementation RKRequestMetricsCollectorSpec
+
+- (void)testShouldComputePhaseDurationsFromTimestamps {
+    RKRequestMetrics* metrics = [[RKRequestMetrics new] autorelease];
+    metrics.enqueueTime = 100;
+    metrics.dispatchTime = 101;
+    metrics.firstByteTime = 103;
+    metrics.lastByteTime = 104;
+    metrics.mappingStartTime = 104.5;
+    metrics.mappingEndTime = 106;
+    assertThatDouble([metrics queueDuration], is(equalToDouble(1)));
+    assertThatDouble([metrics timeToFirstByte], is(equalToDouble(2)));
+    assertThatDouble([metrics transferDuration], is(equalToDouble(1)));
+    assertThatDouble([metrics mappingDuration], is(equalToDouble(1.5)));
+    assertThatDouble([metrics totalDuration], is(equalToDouble(6)));
+    assertThat([metrics durations], isNot(hasKey(@"save")));
+}
+
+- (void)testShouldEstimatePercentilesFromTheHistogramBuckets {
+    RKLatencyHistogram* histogram = [[RKLatencyHistogram new] autorelease];
+    for (int i = 0; i < 9; i++) {
+        [histogram recordDuration:0.004];
+    }
+    [histogram recordDuration:0.7];
+    assertThatInt((int)histogram.count, is(equalToInt(10)));
+    assertThatDouble([histogram percentile:50], is(equalToDouble(0.005)));
+    assertThatDouble([histogram percentile:99], is(equalToDouble(0.7)));
+    assertThatDouble(histogram.max, is(equalToDouble(0.7)));
+}
+
+- (void)testShouldRecordMetricsPerResourcePath {
+    RKRequestMetricsCollector* collector = [[RKRequestMetricsCollector new] autorelease];
+    RKRequestMetrics* metrics = [[RKRequestMetrics new] autorelease];
+    metrics.dispatchTime = 10;
+    metrics.firstByteTime = 10.25;
+    [collector recordMetrics:metrics forResourcePath:@"/humans"];
+    [collector recordMetrics:metrics forResourcePath:@"/humans"];
+    RKLatencyHistogram* histogram = [[collector histogramsForResourcePath:@"/humans"] objectForKey:@"timeToFirstByte"];
+    assertThatInt((int)histogram.count, is(equalToInt(2)));
+    assertThat(collector.resourcePaths, contains(@"/humans", nil));
+    [collector reset];
+    assertThat(collector.resourcePaths, is(empty()));
+}
+
+- (void)testShouldRecordResourcePathsMatchingAPatternTogether {
+    RKRequestMetricsCollector* collector = [[RKRequestMetricsCollector new] autorelease];
+    [collector addResourcePathPattern:@"/humans/:humanID"];
+    RKRequestMetrics* metrics = [[RKRequestMetrics new] autorelease];
+    metrics.dispatchTime = 10;
+    metrics.firstByteTime = 10.25;
+    [collector recordMetrics:metrics forResourcePath:@"/humans/1"];
+    [collector recordMetrics:metrics forResourcePath:@"/humans/2"];
+    RKLatencyHistogram* histogram = [[collector histogramsForResourcePath:@"/humans/:humanID"] objectForKey:@"timeToFirstByte"];
+    assertThatInt((int)histogram.count, is(equalToInt(2)));
+    assertThat(collector.resourcePaths, contains(@"/humans/:humanID", nil));
+}
+
+- (void)testShouldRecordResourcePathsBeyondTheMaximumTogether {
+    RKRequestMetricsCollector* collector = [[RKRequestMetricsCollector new] autorelease];
+    collector.maximumResourcePathCount = 1;
+    RKRequestMetrics* metrics = [[RKRequestMetrics new] autorelease];
+    metrics.dispatchTime = 10;
+    metrics.firstByteTime = 10.25;
+    [collector recordMetrics:metrics forResourcePath:@"/humans/1"];
+    [collector recordMetrics:metrics forResourcePath:@"/humans/2"];
+    [collector recordMetrics:metrics forResourcePath:@"/humans/3"];
+    assertThat(collector.resourcePaths, containsInAnyOrder(@"/humans/1", RKRequestMetricsCollectorOtherResourcePaths, nil));
+    RKLatencyHistogram* histogram = [[collector histogramsForResourcePath:RKRequestMetricsCollectorOtherResourcePaths] objectForKey:@"timeToFirstByte"];
+    assertThatInt((int)histogram.count, is(equalToInt(2)));
+}
+
+- (void)testShouldCollectMetricsFromLoadedRequests {
+    RKRequestMetricsCollector* collector = [[RKRequestMetricsCollector new] autorelease];
+    collector.enabled = YES;
+    RKClient* client = RKSpecNewClient();
+    RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+    [client get:@"/humans/1" delegate:loader];
+    [loader waitForResponse];
+    NSDictionary* histograms = [collector histogramsForResourcePath:@"/humans/1"];
+    assertThat([histograms objectForKey:@"timeToFirstByte"], is(notNilValue()));
+    assertThat([histograms objectForKey:@"total"], is(notNilValue()));
+    collector.enabled = NO;
+}
+
+@end
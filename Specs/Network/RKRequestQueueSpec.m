@@ -122,6 +122,65 @@
     [delegateMock verify];
 }
 
+- (void)testShouldLoadRequestsOnTheNetworkThreadWhenAsked {
+    RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+    NSString* url = [NSString stringWithFormat:@"%@/ok-with-delay/0.3", RKSpecGetBaseURL()];
+    RKRequest* request = [[RKRequest alloc] initWithURL:[NSURL URLWithString:url]];
+    request.delegate = loader;
+
+    RKRequestQueue* queue = [RKRequestQueue new];
+    queue.usesNetworkThread = YES;
+    [queue addRequest:request];
+    [request release];
+    [queue start];
+    [loader waitForResponse];
+    assertThatBool(loader.success, is(equalToBool(YES)));
+    assertThat(loader.response, is(notNilValue()));
+
+    // Queue bookkeeping completes on the network thread
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    assertThatInt((int)queue.count, is(equalToInt(0)));
+    assertThatInt((int)queue.loadingCount, is(equalToInt(0)));
+    [queue release];
+}
+
+- (void)testShouldPrepareRequestsWhenTheyAreAddedToANetworkThreadQueue {
+    NSString* url = [NSString stringWithFormat:@"%@/ok-with-delay/0.3", RKSpecGetBaseURL()];
+    RKRequest* request = [[[RKRequest alloc] initWithURL:[NSURL URLWithString:url]] autorelease];
+    request.method = RKRequestMethodPOST;
+    assertThat([request.URLRequest HTTPMethod], is(equalTo(@"GET")));
+    
+    // The queue is suspended, so the request is only prepared, not dispatched
+    RKRequestQueue* queue = [[RKRequestQueue new] autorelease];
+    queue.usesNetworkThread = YES;
+    [queue addRequest:request];
+    assertThat([request.URLRequest HTTPMethod], is(equalTo(@"POST")));
+    assertThatBool([request isLoading], is(equalToBool(NO)));
+    [queue cancelRequest:request];
+}
+
+- (void)testShouldInformTheDelegateOnTheMainThreadWhenUsingTheNetworkThread {
+    OCMockObject* delegateMock = [OCMockObject niceMockForProtocol:@protocol(RKRequestQueueDelegate)];
+    RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+    NSString* url = [NSString stringWithFormat:@"%@/ok-with-delay/0.3", RKSpecGetBaseURL()];
+    RKRequest* request = [[RKRequest alloc] initWithURL:[NSURL URLWithString:url]];
+    request.delegate = loader;
+
+    RKRequestQueue* queue = [RKRequestQueue new];
+    queue.usesNetworkThread = YES;
+    queue.delegate = (NSObject<RKRequestQueueDelegate>*) delegateMock;
+    [[[delegateMock expect] andDo:^(NSInvocation* invocation) {
+        assertThatBool([NSThread isMainThread], is(equalToBool(YES)));
+    }] requestQueueDidFinishLoading:queue];
+    [queue addRequest:request];
+    [request release];
+    [queue start];
+    [loader waitForResponse];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    [delegateMock verify];
+    [queue release];
+}
+
 // TODO: These tests cannot pass in the unit testing environment... Need to migrate to an integration
 // testing area
 //- (void)testShouldBeginSpinningTheNetworkActivityIfAsked {
@@ -177,6 +236,43 @@
 //    assertThatBool([UIApplication sharedApplication].networkActivityIndicatorVisible, is(equalToBool(NO)));
 //}
 
+- (void)testShouldCancelTheRevalidationOfACachedResponseWithTheRequestsOfItsDelegate {
+    NSString* cachePath = [[RKDirectory cachesDirectory] stringByAppendingPathComponent:@"RKRequestQueueSpecRevalidation"];
+    RKRequestCache* cache = [[[RKRequestCache alloc] initWithCachePath:cachePath storagePolicy:RKRequestCacheStoragePolicyPermanently] autorelease];
+    [cache invalidateAll];
+    NSString* url = [NSString stringWithFormat:@"%@/ok-with-delay/2.0", RKSpecGetBaseURL()];
+    RKRequest* request = [[[RKRequest alloc] initWithURL:[NSURL URLWithString:url]] autorelease];
+    request.cachePolicy = RKRequestCachePolicyStaleWhileRevalidate;
+    request.cache = cache;
+    
+    // Store a response that has already expired
+    NSInteger statusCode = 200;
+    id URLResponse = [OCMockObject niceMockForClass:[NSHTTPURLResponse class]];
+    [[[URLResponse stub] andReturn:[NSDictionary dictionaryWithObject:@"no-cache" forKey:@"Cache-Control"]] allHeaderFields];
+    [[[URLResponse stub] andReturnValue:OCMOCK_VALUE(statusCode)] statusCode];
+    [[[URLResponse stub] andReturn:request.URL] URL];
+    NSData* body = [@"Cached" dataUsingEncoding:NSUTF8StringEncoding];
+    RKResponse* response = [[[RKResponse alloc] initWithSynchronousRequest:request URLResponse:URLResponse body:body error:nil] autorelease];
+    [cache storeResponse:response forRequest:request];
+    
+    RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+    request.delegate = loader;
+    RKRequestQueue* queue = [[RKRequestQueue new] autorelease];
+    [queue addRequest:request];
+    [queue start];
+    [loader waitForResponse];
+    assertThatBool([loader.response wasLoadedFromCache], is(equalToBool(YES)));
+    assertThatInt((int)queue.count, is(equalToInt(0)));
+    
+    // The request has left the queue, but the queue still cancels its revalidation
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    assertThatBool([request isRevalidating], is(equalToBool(YES)));
+    [queue cancelRequestsWithDelegate:loader];
+    assertThatBool([request isRevalidating], is(equalToBool(NO)));
+    assertThatBool([request isLoading], is(equalToBool(NO)));
+    assertThat(request.delegate, is(nilValue()));
+}
+
 - (void)testShouldLetYouReturnAQueueByName {
     RKRequestQueue* queue = [RKRequestQueue requestQueueWithName:@"Images"];
     assertThat(queue, isNot(nilValue()));
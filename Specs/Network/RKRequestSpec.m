@@ -355,6 +355,44 @@
     }
 }
 
+- (void)testShouldLoadFromCacheWhenWeRecieveA304ForALastModifiedDate {
+    NSString* baseURL = RKSpecGetBaseURL();
+    NSString* cacheDirForClient = [NSString stringWithFormat:@"RKClientRequestCache-%@",
+								   [[NSURL URLWithString:baseURL] host]];
+	NSString* cachePath = [[RKDirectory cachesDirectory]
+						   stringByAppendingPathComponent:cacheDirForClient];
+    RKRequestCache* cache = [[RKRequestCache alloc] initWithCachePath:cachePath
+                                storagePolicy:RKRequestCacheStoragePolicyPermanently];
+    [cache invalidateWithStoragePolicy:RKRequestCacheStoragePolicyPermanently];
+    NSURL* URL = [NSURL URLWithString:[NSString stringWithFormat:@"%@/etags/last_modified", RKSpecGetBaseURL()]];
+    {
+        RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+        RKRequest* request = [[RKRequest alloc] initWithURL:URL];
+        request.cachePolicy = RKRequestCachePolicyEtag;
+        request.cache = cache;
+        request.delegate = loader;
+        [request sendAsynchronously];
+        [loader waitForResponse];
+        assertThatBool([loader success], is(equalToBool(YES)));
+        assertThat([cache etagForRequest:request], is(nilValue()));
+        assertThat([cache lastModifiedDateForRequest:request], isNot(nilValue()));
+        assertThatBool([loader.response wasLoadedFromCache], is(equalToBool(NO)));
+    }
+    {
+        RKSpecResponseLoader* loader = [RKSpecResponseLoader responseLoader];
+        RKRequest* request = [[RKRequest alloc] initWithURL:URL];
+        request.cachePolicy = RKRequestCachePolicyEtag;
+        request.cache = cache;
+        request.delegate = loader;
+        [request sendAsynchronously];
+        [loader waitForResponse];
+        assertThatBool([loader success], is(equalToBool(YES)));
+        assertThat([[request.URLRequest allHTTPHeaderFields] valueForKey:@"If-Modified-Since"], is(equalTo(@"Sat, 01 Oct 2011 12:00:00 GMT")));
+        assertThat([loader.response bodyAsString], is(equalTo(@"This Should Get Cached By Date")));
+        assertThatBool([loader.response wasLoadedFromCache], is(equalToBool(YES)));
+    }
+}
+
 - (void)testShouldUpdateTheInternalCacheDateWhenWeRecieveA304 {
     NSString* baseURL = RKSpecGetBaseURL();
     NSString* cacheDirForClient = [NSString stringWithFormat:@"RKClientRequestCache-%@",
@@ -722,6 +760,49 @@
     assertThat(cacheFile, is(equalTo(@"SessionStore/4ba47367884760141da2e38fda525a1f")));
 }
 
+- (void)testShouldHashTheRawBytesOfTheBodyIntoTheCacheKey {
+    RKRequest *request = [RKRequest requestWithURL:[NSURL URLWithString:@"http://restkit.org/humans"] delegate:nil];
+    request.method = RKRequestMethodPOST;
+    request.params = [NSDictionary dictionaryWithObject:@"foo" forKey:@"bar"];
+    assertThat([request cacheKey], is(equalTo(@"13c4bef2e525b4a60a3594f8e4d1987f")));
+}
+
+- (void)testShouldRecomputeTheCacheKeyWhenTheRequestChanges {
+    RKRequest *request = [RKRequest requestWithURL:[NSURL URLWithString:@"http://restkit.org/humans"] delegate:nil];
+    NSString *cacheKey = [request cacheKey];
+    assertThat([request cacheKey], is(equalTo(cacheKey)));
+    
+    request.method = RKRequestMethodPOST;
+    NSString *POSTCacheKey = [request cacheKey];
+    assertThat(POSTCacheKey, isNot(equalTo(cacheKey)));
+    
+    request.params = [NSDictionary dictionaryWithObject:@"foo" forKey:@"bar"];
+    NSString *paramsCacheKey = [request cacheKey];
+    assertThat(paramsCacheKey, isNot(equalTo(POSTCacheKey)));
+    
+    request.URL = [NSURL URLWithString:@"http://restkit.org/humans/1"];
+    assertThat([request cacheKey], isNot(equalTo(paramsCacheKey)));
+}
+
+- (void)testShouldRecomputeTheCacheKeyWhenTheParamsAreMutatedInPlace {
+    RKRequest *request = [RKRequest requestWithURL:[NSURL URLWithString:@"http://restkit.org/humans"] delegate:nil];
+    request.method = RKRequestMethodPOST;
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithObject:@"foo" forKey:@"bar"];
+    request.params = dictionary;
+    NSString *cacheKey = [request cacheKey];
+    [dictionary setObject:@"baz" forKey:@"bar"];
+    NSString *dictionaryCacheKey = [request cacheKey];
+    assertThat(dictionaryCacheKey, isNot(equalTo(cacheKey)));
+    assertThat([request cacheKey], is(equalTo(dictionaryCacheKey)));
+    
+    RKParams *params = [RKParams params];
+    [params setValue:@"foo" forParam:@"bar"];
+    request.params = params;
+    NSString *paramsCacheKey = [request cacheKey];
+    [params setValue:@"baz" forParam:@"qux"];
+    assertThat([request cacheKey], isNot(equalTo(paramsCacheKey)));
+}
+
 - (void)testShouldReturnNilForCachePathWhenTheRequestIsADELETE {
     RKParams *params = [RKParams params];
     [params setValue:@"foo" forParam:@"bar"];
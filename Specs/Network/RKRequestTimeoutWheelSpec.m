@@ -0,0 +1,101 @@
+//
+//  RKRequestTimeoutWheelSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKRequestTimeoutWheel.h"
+
+@interface RKRequestTimeoutWheelSpec : RKSpec {
+}
+
+@end
+
+@implementation RKRequestTimeoutWheelSpec
+
+- (void)testShouldTrackAddedRequests {
+    RKRequestTimeoutWheel* wheel = [[RKRequestTimeoutWheel alloc] initWithTickInterval:0.1 slotCount:8];
+    RKRequest* request = [RKRequest requestWithURL:[NSURL URLWithString:RKSpecGetBaseURL()] delegate:nil];
+    request.timeoutInterval = 5.0;
+    [wheel addRequest:request];
+    assertThatBool([wheel containsRequest:request], is(equalToBool(YES)));
+    assertThatInt((int)wheel.count, is(equalToInt(1)));
+    [wheel removeRequest:request];
+    assertThatBool([wheel containsRequest:request], is(equalToBool(NO)));
+    assertThatInt((int)wheel.count, is(equalToInt(0)));
+    [wheel release];
+}
+
+- (void)testShouldNotTrackRequestsWithoutATimeout {
+    RKRequestTimeoutWheel* wheel = [[RKRequestTimeoutWheel alloc] initWithTickInterval:0.1 slotCount:8];
+    RKRequest* request = [RKRequest requestWithURL:[NSURL URLWithString:RKSpecGetBaseURL()] delegate:nil];
+    request.timeoutInterval = 0;
+    [wheel addRequest:request];
+    assertThatInt((int)wheel.count, is(equalToInt(0)));
+    [wheel release];
+}
+
+- (void)testShouldStopTrackingAConnectTimeoutOnceTheResponseArrives {
+    RKRequestTimeoutWheel* wheel = [[RKRequestTimeoutWheel alloc] initWithTickInterval:0.1 slotCount:8];
+    RKRequest* request = [RKRequest requestWithURL:[NSURL URLWithString:RKSpecGetBaseURL()] delegate:nil];
+    request.timeoutInterval = 5.0;
+    [wheel addRequest:request];
+    [wheel requestDidReceiveResponse:request];
+    assertThatBool([wheel containsRequest:request], is(equalToBool(NO)));
+    [wheel release];
+}
+
+- (void)testShouldKeepTrackingTheTotalDeadlineOnceTheResponseArrives {
+    RKRequestTimeoutWheel* wheel = [[RKRequestTimeoutWheel alloc] initWithTickInterval:0.1 slotCount:8];
+    RKRequest* request = [RKRequest requestWithURL:[NSURL URLWithString:RKSpecGetBaseURL()] delegate:nil];
+    request.timeoutInterval = 5.0;
+    request.totalTimeoutInterval = 30.0;
+    [wheel addRequest:request];
+    [wheel requestDidReceiveResponse:request];
+    assertThatBool([wheel containsRequest:request], is(equalToBool(YES)));
+    [wheel removeRequest:request];
+    [wheel release];
+}
+
+- (void)testShouldTimeoutAllExpiredRequestsInASingleTick {
+    RKRequestTimeoutWheel* wheel = [[RKRequestTimeoutWheel alloc] initWithTickInterval:0.1 slotCount:4];
+    NSURL* URL = [NSURL URLWithString:RKSpecGetBaseURL()];
+    RKRequest* firstRequest = [RKRequest requestWithURL:URL delegate:nil];
+    firstRequest.timeoutInterval = 0.05;
+    RKRequest* secondRequest = [RKRequest requestWithURL:URL delegate:nil];
+    secondRequest.timeoutInterval = 0.05;
+    RKRequest* thirdRequest = [RKRequest requestWithURL:URL delegate:nil];
+    thirdRequest.timeoutInterval = 60.0;
+    id firstMock = [OCMockObject partialMockForObject:firstRequest];
+    id secondMock = [OCMockObject partialMockForObject:secondRequest];
+    [[firstMock expect] timeout];
+    [[secondMock expect] timeout];
+    [wheel addRequest:firstRequest];
+    [wheel addRequest:secondRequest];
+    [wheel addRequest:thirdRequest];
+    
+    // Sleep rather than run the run loop, so that the wheel's timer cannot tick in between
+    [NSThread sleepForTimeInterval:0.15];
+    [wheel tick];
+    [firstMock verify];
+    [secondMock verify];
+    assertThatBool([wheel containsRequest:thirdRequest], is(equalToBool(YES)));
+    [wheel removeRequest:thirdRequest];
+    [wheel release];
+}
+
+@end
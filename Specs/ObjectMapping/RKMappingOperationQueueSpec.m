@@ -0,0 +1,202 @@
+//
+//  RKMappingOperationQueueSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKMappingOperationQueue.h"
+#import "RKObjectMapper.h"
+
+// Remembers the thread its name was mapped on
+@interface RKSpecMappingWorkerFriend : NSObject {
+    NSString* _name;
+    NSArray* _friends;
+    NSThread* _mappingThread;
+}
+
+@property (nonatomic, retain) NSString* name;
+@property (nonatomic, retain) NSArray* friends;
+@property (nonatomic, readonly) NSThread* mappingThread;
+
+@end
+
+@implementation RKSpecMappingWorkerFriend
+
+@synthesize name = _name;
+@synthesize friends = _friends;
+@synthesize mappingThread = _mappingThread;
+
+- (void)dealloc {
+    [_name release];
+    [_friends release];
+    [_mappingThread release];
+    [super dealloc];
+}
+
+- (void)setName:(NSString*)name {
+    [name retain];
+    [_name release];
+    _name = name;
+    [_mappingThread release];
+    _mappingThread = [[NSThread currentThread] retain];
+}
+
+@end
+
+@interface RKMappingOperationQueueSpec : RKSpec {
+}
+
+@end
+
+@implementation RKMappingOperationQueueSpec
+
+- (void)testShouldExecuteOperationsInOrderOnTheWaitingThread {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    NSMutableArray* order = [NSMutableArray array];
+    NSThread* thread = [NSThread currentThread];
+    __block BOOL executedOnWaitingThread = YES;
+    for (int i = 0; i < 3; i++) {
+        [queue addOperationWithBlock:^{
+            executedOnWaitingThread = executedOnWaitingThread && ([NSThread currentThread] == thread);
+            [order addObject:[NSNumber numberWithInt:i]];
+        }];
+    }
+    [queue waitUntilAllOperationsAreFinished];
+    assertThat(order, is(equalTo([NSArray arrayWithObjects:[NSNumber numberWithInt:0], [NSNumber numberWithInt:1], [NSNumber numberWithInt:2], nil])));
+    assertThatBool(executedOnWaitingThread, is(equalToBool(YES)));
+}
+
+- (void)testShouldExecuteThreadSafeOperationsOnWorkerThreads {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    queue.workerThreadCount = 2;
+    NSThread* thread = [NSThread currentThread];
+    __block BOOL executedOnWorkerThread = NO;
+    __block BOOL serialOperationExecutedOnWaitingThread = NO;
+    NSBlockOperation* threadSafeOperation = [NSBlockOperation blockOperationWithBlock:^{
+        executedOnWorkerThread = ([NSThread currentThread] != thread);
+    }];
+    [queue addThreadSafeOperation:threadSafeOperation];
+    [queue addOperationWithBlock:^{
+        serialOperationExecutedOnWaitingThread = ([NSThread currentThread] == thread);
+    }];
+    [queue waitUntilAllOperationsAreFinished];
+    assertThatBool([threadSafeOperation isFinished], is(equalToBool(YES)));
+    assertThatBool(executedOnWorkerThread, is(equalToBool(YES)));
+    assertThatBool(serialOperationExecutedOnWaitingThread, is(equalToBool(YES)));
+}
+
+- (void)testShouldNotStartAnOperationBeforeItsDependencies {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    queue.workerThreadCount = 2;
+    NSMutableArray* order = [NSMutableArray array];
+    NSBlockOperation* first = [NSBlockOperation blockOperationWithBlock:^{
+        [NSThread sleepForTimeInterval:0.1];
+        @synchronized(order) { [order addObject:@"first"]; }
+    }];
+    NSBlockOperation* second = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) { [order addObject:@"second"]; }
+    }];
+    NSBlockOperation* third = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) { [order addObject:@"third"]; }
+    }];
+    [third addDependency:second];
+    [second addDependency:first];
+    [queue addOperation:third];
+    [queue addThreadSafeOperation:second];
+    [queue addThreadSafeOperation:first];
+    [queue waitUntilAllOperationsAreFinished];
+    assertThat(order, is(equalTo([NSArray arrayWithObjects:@"first", @"second", @"third", nil])));
+}
+
+- (void)testShouldStartDependenciesThatWereNeverAddedToTheQueue {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    queue.workerThreadCount = 2;
+    NSMutableArray* order = [NSMutableArray array];
+    NSBlockOperation* external = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) { [order addObject:@"external"]; }
+    }];
+    NSBlockOperation* serial = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) { [order addObject:@"serial"]; }
+    }];
+    NSBlockOperation* threadSafe = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) { [order addObject:@"threadSafe"]; }
+    }];
+    [serial addDependency:external];
+    [threadSafe addDependency:external];
+    [queue addOperation:serial];
+    [queue addThreadSafeOperation:threadSafe];
+    [queue waitUntilAllOperationsAreFinished];
+    assertThatBool([external isFinished], is(equalToBool(YES)));
+    assertThatBool([threadSafe isFinished], is(equalToBool(YES)));
+    assertThat(order, hasCountOf(3));
+    assertThat([order objectAtIndex:0], is(equalTo(@"external")));
+}
+
+- (void)testShouldMapNestedPlainObjectsOnWorkerThreads {
+    RKObjectMapping* friendMapping = [RKObjectMapping mappingForClass:[RKSpecMappingWorkerFriend class]];
+    [friendMapping mapAttributes:@"name", nil];
+    [friendMapping mapKeyPath:@"friends" toRelationship:@"friends" withMapping:friendMapping];
+    RKObjectMappingProvider* provider = [[RKObjectMappingProvider new] autorelease];
+    [provider setMapping:friendMapping forKeyPath:@""];
+    
+    id userInfo = RKSpecParseFixture(@"user.json");
+    RKObjectMapper* mapper = [RKObjectMapper mapperWithObject:userInfo mappingProvider:provider];
+    mapper.delegate = [OCMockObject niceMockForProtocol:@protocol(RKObjectMapperDelegate)];
+    mapper.workerThreadCount = 2;
+    RKSpecMappingWorkerFriend* user = [[mapper performMapping] asObject];
+    assertThat(user.name, is(equalTo(@"Blake Watters")));
+    assertThat(user.mappingThread, is(sameInstance([NSThread currentThread])));
+    NSArray* names = [NSArray arrayWithObjects:@"Jeremy Ellison", @"Rachit Shukla", nil];
+    assertThat([user.friends valueForKey:@"name"], is(equalTo(names)));
+    for (RKSpecMappingWorkerFriend* friend in user.friends) {
+        assertThat(friend.mappingThread, isNot(sameInstance([NSThread currentThread])));
+    }
+}
+
+- (void)testShouldExecuteOperationsAddedWhileExecuting {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    __block BOOL executedAddedOperation = NO;
+    [queue addOperationWithBlock:^{
+        [queue addOperationWithBlock:^{
+            executedAddedOperation = YES;
+        }];
+    }];
+    [queue waitUntilAllOperationsAreFinished];
+    assertThatBool(executedAddedOperation, is(equalToBool(YES)));
+}
+
+- (void)testShouldRecordTheExecutionTimeOfEachOperation {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    NSBlockOperation* operation = [NSBlockOperation blockOperationWithBlock:^{
+        [NSThread sleepForTimeInterval:0.05];
+    }];
+    [queue addOperation:operation];
+    assertThatDouble([queue executionTimeForOperation:operation], is(equalToDouble(0)));
+    [queue waitUntilAllOperationsAreFinished];
+    assertThatDouble([queue executionTimeForOperation:operation], is(greaterThanOrEqualTo([NSNumber numberWithDouble:0.05])));
+}
+
+- (void)testShouldReturnTheOperationAddedForAKeyUntilTheQueueExecutes {
+    RKMappingOperationQueue* queue = [[RKMappingOperationQueue new] autorelease];
+    NSOperation* operation = [[NSOperation new] autorelease];
+    [queue addOperation:operation forKey:@"connections"];
+    assertThat([queue operationForKey:@"connections"], is(sameInstance(operation)));
+    [queue waitUntilAllOperationsAreFinished];
+    assertThat([queue operationForKey:@"connections"], is(nilValue()));
+}
+
+@end
@@ -0,0 +1,105 @@
+//
+//  RKMappingThreadPoolSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKMappingThreadPool.h"
+
+@interface RKSpecThreadRecorder : NSObject {
+    NSMutableArray* _threads;
+}
+
+@property (nonatomic, readonly) NSArray* threads;
+
+- (void)recordThread:(id)object;
+
+@end
+
+@implementation RKSpecThreadRecorder
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _threads = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_threads release];
+    [super dealloc];
+}
+
+- (NSArray*)threads {
+    @synchronized(self) {
+        return [NSArray arrayWithArray:_threads];
+    }
+}
+
+- (void)recordThread:(id)object {
+    if (! [RKMappingThreadPool isMappingThread]) {
+        return;
+    }
+    [NSThread sleepForTimeInterval:0.01];
+    @synchronized(self) {
+        [_threads addObject:[NSThread currentThread]];
+    }
+}
+
+@end
+
+@interface RKMappingThreadPoolSpec : RKSpec {
+}
+
+@end
+
+@implementation RKMappingThreadPoolSpec
+
+- (void)testShouldPerformWorkOffTheMainThread {
+    RKMappingThreadPool* pool = [[RKMappingThreadPool alloc] initWithMaximumThreadCount:1];
+    RKSpecThreadRecorder* recorder = [[RKSpecThreadRecorder new] autorelease];
+    [pool performSelector:@selector(recordThread:) onTarget:recorder withObject:nil];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    assertThatInt((int)[recorder.threads count], is(equalToInt(1)));
+    assertThatBool([[recorder.threads lastObject] isMainThread], is(equalToBool(NO)));
+    [pool shutdown];
+    [pool release];
+}
+
+- (void)testShouldReuseItsThreadsAcrossInvocations {
+    RKMappingThreadPool* pool = [[RKMappingThreadPool alloc] initWithMaximumThreadCount:2];
+    RKSpecThreadRecorder* recorder = [[RKSpecThreadRecorder new] autorelease];
+    for (int i = 0; i < 10; i++) {
+        [pool performSelector:@selector(recordThread:) onTarget:recorder withObject:nil];
+    }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    assertThatInt((int)[recorder.threads count], is(equalToInt(10)));
+    assertThatInt((int)[[NSSet setWithArray:recorder.threads] count], is(lessThanOrEqualTo([NSNumber numberWithInt:2])));
+    assertThatInt((int)pool.threadCount, is(lessThanOrEqualTo([NSNumber numberWithInt:2])));
+    [pool shutdown];
+    [pool release];
+}
+
+- (void)testShouldConfigureTheMappingThreadCountOnTheObjectManager {
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    assertThat(objectManager.mappingThreadPool, is(notNilValue()));
+    objectManager.mappingThreadCount = 4;
+    assertThatInt((int)objectManager.mappingThreadPool.maximumThreadCount, is(equalToInt(4)));
+}
+
+@end
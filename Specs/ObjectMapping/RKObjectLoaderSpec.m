@@ -520,4 +520,73 @@
     assertThat(responseLoader.objects, is(empty()));
 }
 
+#pragma mark - Unchanged Content
+
+- (void)testShouldDeliverThePreviousResultWithoutMappingWhenTheContentIsUnchanged {
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    objectManager.client.cachePolicy = RKRequestCachePolicyNone;
+    [objectManager setMappingProvider:[self providerForComplexUser]];
+    [objectManager.mappingResultCache addResourcePath:@"/JSON/ComplexNestedUser.json"];
+    
+    RKSpecResponseLoader* firstLoader = [RKSpecResponseLoader responseLoader];
+    RKObjectLoader* objectLoader = [objectManager objectLoaderWithResourcePath:@"/JSON/ComplexNestedUser.json" delegate:firstLoader];
+    [objectLoader send];
+    [firstLoader waitForResponse];
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(YES)));
+    
+    RKSpecResponseLoader* secondLoader = [RKSpecResponseLoader responseLoader];
+    objectLoader = [objectManager objectLoaderWithResourcePath:@"/JSON/ComplexNestedUser.json" delegate:secondLoader];
+    [objectLoader send];
+    [secondLoader waitForResponse];
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(NO)));
+    assertThatUnsignedInteger([secondLoader.objects count], is(equalToInt(1)));
+    assertThat([secondLoader.objects lastObject], is(sameInstance([firstLoader.objects lastObject])));
+}
+
+- (void)testShouldDeliverThePreviousResultWithoutMappingWhenTheResponseIsNotModified {
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    objectManager.client.cachePolicy = RKRequestCachePolicyEtag;
+    [objectManager.client.requestCache invalidateAll];
+    RKObjectMapping* humanMapping = [RKObjectMapping mappingForClass:[NSMutableDictionary class]];
+    [humanMapping mapAttributes:@"name", nil];
+    [objectManager.mappingProvider setMapping:humanMapping forKeyPath:@"human"];
+    [objectManager.mappingResultCache addResourcePath:@"/etags/human"];
+    
+    RKSpecResponseLoader* firstLoader = [RKSpecResponseLoader responseLoader];
+    RKObjectLoader* objectLoader = [objectManager objectLoaderWithResourcePath:@"/etags/human" delegate:firstLoader];
+    [objectLoader send];
+    [firstLoader waitForResponse];
+    [objectManager.client.requestCache flush];
+    assertThat([[firstLoader.objects lastObject] valueForKey:@"name"], is(equalTo(@"Blake Watters")));
+    
+    RKSpecResponseLoader* secondLoader = [RKSpecResponseLoader responseLoader];
+    objectLoader = [objectManager objectLoaderWithResourcePath:@"/etags/human" delegate:secondLoader];
+    [objectLoader send];
+    [secondLoader waitForResponse];
+    assertThatBool([secondLoader.response wasLoadedFromCache], is(equalToBool(YES)));
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(NO)));
+    assertThat([secondLoader.objects lastObject], is(sameInstance([firstLoader.objects lastObject])));
+}
+
+- (void)testShouldMapUnchangedContentOntoTheTargetObject {
+    RKObjectManager* objectManager = RKSpecNewObjectManager();
+    objectManager.client.cachePolicy = RKRequestCachePolicyNone;
+    [objectManager setMappingProvider:[self providerForComplexUser]];
+    [objectManager.mappingResultCache addResourcePath:@"/JSON/ComplexNestedUser.json"];
+    
+    RKSpecResponseLoader* responseLoader = [RKSpecResponseLoader responseLoader];
+    RKObjectLoader* objectLoader = [objectManager objectLoaderWithResourcePath:@"/JSON/ComplexNestedUser.json" delegate:responseLoader];
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    
+    RKSpecComplexUser* user = [[RKSpecComplexUser new] autorelease];
+    responseLoader = [RKSpecResponseLoader responseLoader];
+    objectLoader = [objectManager objectLoaderWithResourcePath:@"/JSON/ComplexNestedUser.json" delegate:responseLoader];
+    objectLoader.targetObject = user;
+    [objectLoader send];
+    [responseLoader waitForResponse];
+    assertThatBool(objectLoader.metrics.mappingStartTime > 0, is(equalToBool(YES)));
+    assertThat(user.firstname, is(equalTo(@"Diego")));
+}
+
 @end
@@ -332,4 +332,12 @@
     assertThat(loader.params, is(equalTo(myParams)));
 }
 
+- (void)testShouldForgetRememberedMappingResultsWhenThePersistentStoreIsDeleted {
+    [_objectManager.mappingResultCache addResourcePath:@"/humans"];
+    NSDictionary* dictionary = [NSDictionary dictionaryWithObject:@"Blake" forKey:@"name"];
+    [_objectManager.mappingResultCache setResultDictionary:dictionary bodyDigest:@"abc" objectMapping:nil forResourcePath:@"/humans"];
+    [_objectManager.objectStore deletePersistantStore];
+    assertThat([_objectManager.mappingResultCache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:nil], is(nilValue()));
+}
+
 @end
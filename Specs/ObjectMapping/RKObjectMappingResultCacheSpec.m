@@ -0,0 +1,66 @@
+//
+//  RKObjectMappingResultCacheSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKObjectMappingResultCache.h"
+
+@interface RKObjectMappingResultCacheSpec : RKSpec
+
+@end
+
+@implementation RKObjectMappingResultCacheSpec
+
+- (void)testShouldOnlyRememberResultsForResourcePathsThatHaveOptedIn {
+    RKObjectMappingResultCache* cache = [[RKObjectMappingResultCache new] autorelease];
+    NSDictionary* dictionary = [NSDictionary dictionaryWithObject:@"Blake" forKey:@"name"];
+    [cache setResultDictionary:dictionary bodyDigest:@"abc" objectMapping:nil forResourcePath:@"/humans"];
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:nil], is(nilValue()));
+    
+    [cache addResourcePath:@"/humans"];
+    [cache setResultDictionary:dictionary bodyDigest:@"abc" objectMapping:nil forResourcePath:@"/humans"];
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:nil], is(equalTo(dictionary)));
+    assertThat([cache resultDictionaryForResourcePath:@"/humans/1" bodyDigest:@"abc" objectMapping:nil], is(nilValue()));
+}
+
+- (void)testShouldNotReturnTheResultWhenTheBodyHasChanged {
+    RKObjectMappingResultCache* cache = [[RKObjectMappingResultCache new] autorelease];
+    [cache addResourcePath:@"/humans"];
+    [cache setResultDictionary:[NSDictionary dictionaryWithObject:@"Blake" forKey:@"name"] bodyDigest:@"abc" objectMapping:nil forResourcePath:@"/humans"];
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"def" objectMapping:nil], is(nilValue()));
+    
+    [cache invalidateResourcePath:@"/humans"];
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:nil], is(nilValue()));
+    assertThatBool([cache containsResourcePath:@"/humans"], is(equalToBool(YES)));
+    
+    [cache removeResourcePath:@"/humans"];
+    assertThatBool([cache containsResourcePath:@"/humans"], is(equalToBool(NO)));
+}
+
+- (void)testShouldNotReturnTheResultMappedWithAnotherObjectMapping {
+    RKObjectMappingResultCache* cache = [[RKObjectMappingResultCache new] autorelease];
+    RKObjectMapping* mapping = [RKObjectMapping mappingForClass:[NSMutableDictionary class]];
+    NSDictionary* dictionary = [NSDictionary dictionaryWithObject:@"Blake" forKey:@"name"];
+    [cache addResourcePath:@"/humans"];
+    [cache setResultDictionary:dictionary bodyDigest:@"abc" objectMapping:mapping forResourcePath:@"/humans"];
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:mapping], is(equalTo(dictionary)));
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:nil], is(nilValue()));
+    assertThat([cache resultDictionaryForResourcePath:@"/humans" bodyDigest:@"abc" objectMapping:[RKObjectMapping mappingForClass:[NSMutableDictionary class]]], is(nilValue()));
+}
+
+@end
@@ -16,6 +16,29 @@ module RestKit
           "This Should Get Cached"
         end
       end
+      
+      get '/etags/human' do
+        tag = "2c1f6e8d9a4b7c3e5f"
+        content_type 'application/json'
+        if tag == request.env["HTTP_IF_NONE_MATCH"]
+          status 304
+          ""
+        else
+          headers "ETag" => tag
+          {:human => {:name => "Blake Watters", :id => 1}}.to_json
+        end
+      end
+      
+      get '/etags/last_modified' do
+        last_modified = "Sat, 01 Oct 2011 12:00:00 GMT"
+        if last_modified == request.env["HTTP_IF_MODIFIED_SINCE"]
+          status 304
+          ""
+        else
+          headers "Last-Modified" => last_modified
+          "This Should Get Cached By Date"
+        end
+      end
           
     end
   end
@@ -0,0 +1,113 @@
+//
+//  RKMainThreadInvocationQueueSpec.m
+//  RestKit
+//
+//  Copyright 2011 RestKit
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "RKSpecEnvironment.h"
+#import "RKMainThreadInvocationQueue.h"
+
+@interface RKSpecInvocationRecorder : NSObject {
+    NSMutableArray* _values;
+    BOOL _performedOnMainThread;
+}
+
+@property (nonatomic, readonly) NSArray* values;
+@property (nonatomic, readonly) BOOL performedOnMainThread;
+
+- (void)recordValue:(id)value;
+- (void)enqueueValuesOnQueue:(RKMainThreadInvocationQueue*)queue;
+
+@end
+
+@implementation RKSpecInvocationRecorder
+
+@synthesize performedOnMainThread = _performedOnMainThread;
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _values = [NSMutableArray new];
+        _performedOnMainThread = YES;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_values release];
+    [super dealloc];
+}
+
+- (NSArray*)values {
+    return [NSArray arrayWithArray:_values];
+}
+
+- (void)recordValue:(id)value {
+    _performedOnMainThread = _performedOnMainThread && [NSThread isMainThread];
+    [_values addObject:value];
+}
+
+- (void)enqueueValuesOnQueue:(RKMainThreadInvocationQueue*)queue {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    for (int i = 0; i < 50; i++) {
+        [queue performSelector:@selector(recordValue:) onTarget:self withObject:[NSNumber numberWithInt:i]];
+    }
+    [pool drain];
+}
+
+@end
+
+@interface RKMainThreadInvocationQueueSpec : RKSpec {
+}
+
+@end
+
+@implementation RKMainThreadInvocationQueueSpec
+
+- (void)testShouldPerformInvocationsEnqueuedOnTheMainThreadImmediately {
+    RKMainThreadInvocationQueue* queue = [[RKMainThreadInvocationQueue new] autorelease];
+    RKSpecInvocationRecorder* recorder = [[RKSpecInvocationRecorder new] autorelease];
+    [queue performSelector:@selector(recordValue:) onTarget:recorder withObject:@"value"];
+    assertThat(recorder.values, is(equalTo([NSArray arrayWithObject:@"value"])));
+    assertThatInt((int)queue.pendingCount, is(equalToInt(0)));
+}
+
+- (void)testShouldDeliverInvocationsFromABackgroundThreadInOrderOnTheMainThread {
+    RKMainThreadInvocationQueue* queue = [[RKMainThreadInvocationQueue new] autorelease];
+    RKSpecInvocationRecorder* recorder = [[RKSpecInvocationRecorder new] autorelease];
+    [NSThread detachNewThreadSelector:@selector(enqueueValuesOnQueue:) toTarget:recorder withObject:queue];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    assertThatInt((int)[recorder.values count], is(equalToInt(50)));
+    for (int i = 0; i < 50; i++) {
+        assertThat([recorder.values objectAtIndex:i], is(equalTo([NSNumber numberWithInt:i])));
+    }
+    assertThatBool(recorder.performedOnMainThread, is(equalToBool(YES)));
+}
+
+- (void)testShouldPerformPendingInvocationsWhenFlushed {
+    RKMainThreadInvocationQueue* queue = [[RKMainThreadInvocationQueue new] autorelease];
+    queue.maximumBatchSize = 1;
+    RKSpecInvocationRecorder* recorder = [[RKSpecInvocationRecorder new] autorelease];
+    [recorder performSelectorInBackground:@selector(enqueueValuesOnQueue:) withObject:queue];
+    while (queue.pendingCount + [recorder.values count] < 50) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    [queue flush];
+    assertThatInt((int)[recorder.values count], is(equalToInt(50)));
+    assertThatInt((int)queue.pendingCount, is(equalToInt(0)));
+}
+
+@end